@@ -0,0 +1,1581 @@
+/*
+ * BamDamBatch - Traitement en lot de ruches SYSTEM collectées (ligne de commande, sans GUI)
+ *
+ * Usage : BamDamBatch [-j N] [-o sortie] [-f csv|jsonl|bdcol] [-q] [--precision s|ms|us|100ns] [--iso]
+ *                    [--tz utc|hive] [--sid-cache fichier | --no-sid-cache] [--rules fichier]
+ *                    [--snapshot index [--compact] | --history] [--chunk N] [--carve]
+ *                    [--timeline [--timeline-memory Mo] [--spill dossier]]
+ *                    [--query requête | --query - [--limit N]] [--sort clés] [--save-case cas]
+ *                    [--rarity rapport [--rarity-k N]] [--log journal] [--metrics fichier]
+ *                    <dossier | @manifeste | image> ...
+ *        BamDamBatch --case cas [--verify] [-o sortie] [-f ...] [--query ...] [--sort clés] [--rarity rapport]
+ *                    [--log journal]
+ *        BamDamBatch --watch dossier ... [-o dossier] [--ledger registre] [--settle s] [--rescan s] [--rotate s]
+ *                    [--queue N] [-j N] [-f ...] [--tz ...] [--rules ...] [--carve] [--log ...] [--metrics ...]
+ *
+ * - Dossier : recherche récursive des fichiers nommés SYSTEM
+ * - Fichier commençant par un boot sector NTFS, un MBR ou un en-tête GPT (argument ou manifeste) : image
+ *   disque brute, SYSTEM et ses journaux lus directement dans le volume NTFS Windows (voir NtfsImage.h),
+ *   sans extraction ; hôte = nom de l'image, SOFTWARE et SAM de l'image utilisés pour la résolution des SIDs
+ * - Manifeste : une ruche par ligne, "chemin" ou "hôte<TAB>chemin" (# = commentaire)
+ * - Hôte déduit de l'arborescence (<hôte>\Windows\System32\config\SYSTEM) si non fourni
+ * - Pool work-stealing sur tous les cœurs ; chaque ruche parsée part aussitôt vers l'export
+ *   (CSV, JSON Lines ou BDCOL en colonnes) sur des threads dédiés, dans l'ordre de fin de parsing
+ * - Débit par ruche et global (ruches/s, Mo/s) sur stderr
+ * - SIDs résolus hors-ligne : ProfileList (SOFTWARE) et comptes locaux (SAM) voisins de chaque
+ *   ruche SYSTEM, chargés pour toute la flotte avant le parsing, plus un cache persistant sur disque
+ * - Chemins classés par un fichier de règles (--rules, voir PathRules.h), jeu historique par défaut
+ * - Ruches non consolidées : journaux .LOG1/.LOG2 voisins appliqués en mémoire (voir RegfHive.h)
+ * - Timestamps formatés à l'écriture seulement, en UTC ou à l'heure locale de chaque ruche
+ * - Collecte incrémentale (--snapshot, voir SnapshotIndex.h) : seules les entrées nouvelles ou dont
+ *   le FILETIME a avancé depuis la collecte précédente sont émises, les clés SID inchangées ne sont
+ *   pas lues. L'index n'est mis à jour qu'une fois la sortie écrite.
+ * - Historique multi-versions (--history, voir HiveHistory.h) : les ruches d'un même hôte (RegBack,
+ *   clichés VSS, collectes successives) sont fusionnées en une ligne par (service, SID, chemin) avec
+ *   première et dernière observation ; seules les clés SID au contenu nouveau sont parsées
+ * - Carving (--carve, voir BamDamCarve.h) : valeurs BAM/DAM supprimées retrouvées dans l'espace libre de
+ *   chaque ruche, source "recovered", SID inconnu ; valeurs encore vivantes écartées
+ * - Export en flux (--chunk N, voir BamDamStream.h) : chaque ruche part vers l'export par blocs de N
+ *   lignes au plus, pendant son parcours ; la mémoire ne croît plus avec la taille des ruches
+ * - Chronologie de flotte (--timeline, voir Timeline.h) : toutes les lignes dans l'ordre des FILETIME,
+ *   par tri externe (runs triés par ruche, déversés sur disque au-delà de --timeline-memory, fusion
+ *   k-voies) ; timestamps en UTC, l'heure locale de chaque ruche n'ayant pas de sens dans un ordre global
+ * - Requêtes (--query, voir EntryQuery.h) : les lignes de la flotte sont rassemblées en mémoire et indexées
+ *   (FILETIME, utilisateurs/SIDs/hôtes, trie des chemins) ; seules les lignes satisfaisant la requête sont
+ *   exportées, par FILETIME croissant. "--query -" lit les requêtes sur l'entrée standard, une par ligne,
+ *   et affiche le nombre de lignes, la durée et les --limit premières, sans fichier de sortie
+ * - Tri (--sort, voir EntrySort.h) : "host,-time,path" remplace l'ordre des FILETIME pour les lignes d'une
+ *   requête ou l'export complet d'un cas ; le store entier est trié une fois, chaque requête en filtre l'ordre
+ * - Fichier de cas (--save-case, voir CaseFile.h) : lignes de la flotte et index enregistrés en binaire ;
+ *   --case le rouvre par projection mémoire, sans parsing ni désérialisation, pour exporter ou interroger
+ * - Rareté (--rarity, voir Rarity.h) : chaque worker résume ses lignes en sketches (HyperLogLog, count-min,
+ *   candidats bornés), fusionnés à la fin en un rapport CSV des chemins vus sur le moins d'hôtes et des plus
+ *   exécutés ; mémoire bornée quelle que soit la taille de la flotte
+ * - Surveillance (--watch, voir IngestWatch.h) : processus sans fin sur des dossiers de dépôt. Chaque entrée
+ *   de premier niveau est un lot (dossier d'hôte, ruche SYSTEM ou image) ; une ruche est mise en file une
+ *   fois sa signature (taille, date, journaux) stable pendant --settle s. File bornée vers un nombre fixe de
+ *   workers (lecture → parsing → enrichissement, mêmes étapes que ParseBamDamHive) puis export borné :
+ *   une file pleine bloque l'étape précédente jusqu'à l'observateur. Contenu déjà exporté (empreinte des
+ *   hbin) ignoré, y compris d'un lancement à l'autre (--ledger). Sortie en segments renommés toutes les
+ *   --rotate s ; --metrics réécrit périodiquement (profondeur des files, quantiles de latence, débits).
+ *   Arrêt propre sur SIGINT / SIGTERM : file vidée, segment fermé, registre validé.
+ * - Messages via AsyncLogger (voir Telemetry.h) : les workers ne se disputent pas stderr, copie
+ *   horodatée dans --log ; erreurs et avertissements jamais perdus, informations perdues (sortie trop
+ *   lente) comptées dans le bilan final ; durées par étape et compteurs dans --metrics (JSON, ou
+ *   Prometheus si .prom)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "BamDamCarve.h"
+#include "BamDamHive.h"
+#include "BamDamStream.h"
+#include "CaseFile.h"
+#include "EntryExport.h"
+#include "EntryQuery.h"
+#include "EntrySort.h"
+#include "HiveHistory.h"
+#include "IngestWatch.h"
+#include "NtfsImage.h"
+#include "Rarity.h"
+#include "SidResolver.h"
+#include "SnapshotIndex.h"
+#include "Telemetry.h"
+#include "Timeline.h"
+#include "VolumeMap.h"
+#include "WorkStealingPool.h"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct HiveJob {
+    fs::path path;
+    std::string host;    // UTF-8
+    uint64_t size = 0;   // Image disque : taille de la ruche, connue après ouverture
+    bool image = false;  // Image disque brute : ruche lue dans le volume NTFS
+};
+
+struct HiveResult {
+    size_t rowCount = 0;
+    size_t skippedKeys = 0;  // Collecte incrémentale : clés SID inchangées
+    size_t skippedRows = 0;  // Collecte incrémentale : entrées déjà émises
+    double seconds = 0;
+    bool ok = false;
+    int32_t utcOffset = 0;  // Minutes, lu dans TimeZoneInformation si --tz hive
+    bool dirty = false;      // Ruche non consolidée
+    size_t logEntries = 0;   // Entrées HvLE appliquées depuis .LOG1/.LOG2
+    size_t logPages = 0;
+    size_t newKeys = 0;      // Historique : clés SID au contenu encore jamais vu
+    size_t recoveredRows = 0;  // --carve : valeurs supprimées récupérées, comprises dans rowCount
+    uint64_t volumeOffset = 0;    // Image disque : offset du volume Windows
+    uint64_t imageBytesRead = 0;  // Image disque : octets de l'image lus
+    std::string error;
+};
+
+// Historique : versions d'un même hôte, dans l'ordre des entrées
+struct HostGroup {
+    std::string host;
+    std::vector<size_t> jobs;
+    uint64_t size = 0;
+    size_t rowCount = 0;
+};
+
+struct BatchOptions {
+    unsigned threads = 0;
+    fs::path output = "bamdam_batch.csv";  // --watch : dossier des segments (défaut : bamdam_ingest)
+    bool outputGiven = false;
+    bool formatGiven = false;
+    ExportFormat format = ExportFormat::Csv;
+    bool quiet = false;
+    bool hiveTimeZone = false;
+    bool sidCacheEnabled = true;
+    fs::path sidCache;  // Vide : bamdam_sids.tsv à côté de la sortie
+    fs::path rules;     // Vide : PathClassifier::Default()
+    fs::path snapshot;  // Vide : collecte complète
+    bool compact = false;
+    bool history = false;
+    bool carve = false;
+    size_t chunkRows = 0;  // 0 : une ruche entière par store
+    bool timeline = false;
+    size_t timelineMemory = size_t{ 256 } << 20;
+    fs::path spill;     // Vide : répertoire temporaire du système
+    std::string query;  // UTF-8 ; "-" : requêtes lues sur l'entrée standard
+    size_t queryLimit = 20;
+    std::vector<SortField> sortFields;  // --sort ; vide : FILETIME croissant (requête) ou ordre du cas
+    fs::path saveCase;  // Vide : pas de fichier de cas
+    fs::path openCase;  // Non vide : cas rouvert au lieu de ruches
+    bool verifyCase = false;
+    fs::path rarity;    // Vide : pas de rapport de rareté
+    size_t rarityCount = 100;
+    fs::path log;       // Vide : stderr seulement
+    fs::path metrics;   // Vide : pas d'export des compteurs
+    std::vector<fs::path> watch;  // Non vide : mode surveillance
+    fs::path ledger;    // Vide : bamdam_ingest.ledger dans le dossier de sortie
+    double settleSeconds = 2;
+    unsigned rescanSeconds = 60;  // 0 : inventaire au démarrage et après débordement seulement
+    unsigned rotateSeconds = 60;
+    size_t queueDepth = 0;  // 0 : 4 ruches par worker
+    TimeFormat timeFormat;
+    std::vector<std::string> inputs;
+};
+
+bool EqualsNoCase(const std::string& a, const char* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i]; i++) {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return i == a.size() && b[i] == 0;
+}
+
+std::vector<HostGroup> GroupByHost(const std::vector<HiveJob>& jobs) {
+    std::vector<HostGroup> groups;
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        auto inserted = index.emplace(jobs[i].host, groups.size());
+        if (inserted.second) {
+            groups.emplace_back();
+            groups.back().host = jobs[i].host;
+        }
+        HostGroup& group = groups[inserted.first->second];
+        group.jobs.push_back(i);
+        group.size += jobs[i].size;
+    }
+    return groups;
+}
+
+void AddJob(std::vector<HiveJob>& jobs, const fs::path& path, const std::string& host) {
+    std::error_code ec;
+    HiveJob job;
+    job.path = path;
+    job.image = NtfsImage::LooksLikeImage(path);
+    job.host = !host.empty() ? host : job.image ? path.stem().u8string() : HiveHostName(path);
+    job.size = job.image ? 0 : fs::file_size(path, ec);
+    if (ec) job.size = 0;
+    jobs.push_back(std::move(job));
+}
+
+bool CollectJobs(const std::string& input, std::vector<HiveJob>& jobs) {
+    if (!input.empty() && input[0] == '@') {
+        std::ifstream manifest(fs::u8path(input.substr(1)));
+        if (!manifest.is_open()) {
+            std::fprintf(stderr, "Manifeste illisible : %s\n", input.c_str() + 1);
+            return false;
+        }
+        std::string line;
+        while (std::getline(manifest, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            size_t tab = line.find('\t');
+            if (tab == std::string::npos) {
+                AddJob(jobs, fs::u8path(line), std::string());
+            } else {
+                AddJob(jobs, fs::u8path(line.substr(tab + 1)), line.substr(0, tab));
+            }
+        }
+        return true;
+    }
+
+    fs::path root = fs::u8path(input);
+    std::error_code ec;
+    if (fs::is_regular_file(root, ec)) {
+        AddJob(jobs, root, std::string());
+        return true;
+    }
+    if (!fs::is_directory(root, ec)) {
+        std::fprintf(stderr, "Entrée introuvable : %s\n", input.c_str());
+        return false;
+    }
+
+    for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+         it != end; it.increment(ec)) {
+        if (ec) break;
+        if (it->is_regular_file(ec) && EqualsNoCase(it->path().filename().u8string(), "SYSTEM")) {
+            AddJob(jobs, it->path(), std::string());
+        }
+    }
+    return true;
+}
+
+// Ruche SYSTEM d'une tâche, journaux rejoués ; image doit survivre à hive
+bool OpenJobHive(HiveJob& job, NtfsImage& image, RegfHive& hive, HiveResult& result) {
+    if (!job.image) {
+        if (hive.Open(job.path)) return true;
+        result.error = hive.LastError();
+        return false;
+    }
+    if (!image.Open(job.path) || !image.OpenHive(u"SYSTEM", hive)) {
+        result.error = image.LastError();
+        return false;
+    }
+    job.size = hive.size();
+    result.volumeOffset = image.Volume().Offset();
+    result.imageBytesRead = image.Volume().BytesRead();
+    return true;
+}
+
+// Source de la ruche pour les messages : "  image : volume @offset, N Mo lus sur M Go"
+void DescribeImage(const HiveJob& job, const HiveResult& result, const NtfsImage& image, char* out, size_t size) {
+    if (!job.image) {
+        out[0] = 0;
+        return;
+    }
+    const bool large = image.ImageSize() >= (uint64_t{ 1 } << 30);
+    std::snprintf(out, size, "  image : volume @%llu, %.1f Mo lus sur %.1f %s",
+                  static_cast<unsigned long long>(result.volumeOffset), result.imageBytesRead / 1048576.0,
+                  image.ImageSize() / (large ? 1073741824.0 : 1048576.0), large ? "Go" : "Mo");
+}
+
+// printf vers le journal asynchrone (texte au-delà de RECORD_TEXT tronqué)
+template <class... Args>
+void LogFormat(AsyncLogger& log, LogLevel level, const char* format, Args... args) {
+    char line[1024];
+    const int n = std::snprintf(line, sizeof(line), format, args...);
+    if (n > 0) log.Log(level, std::string_view(line, std::min(static_cast<size_t>(n), sizeof(line) - 1)));
+}
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage : BamDamBatch [-j N] [-o sortie] [-f csv|jsonl|bdcol] [-q] [--precision s|ms|us|100ns]\n"
+                 "                    [--iso] [--tz utc|hive] [--sid-cache fichier | --no-sid-cache]\n"
+                 "                    [--rules fichier] [--snapshot index [--compact] | --history] [--chunk N]\n"
+                 "                    [--carve]\n"
+                 "                    [--timeline [--timeline-memory Mo] [--spill dossier]]\n"
+                 "                    [--query requête | --query - [--limit N]] [--sort clés] [--save-case cas]\n"
+                 "                    [--rarity rapport [--rarity-k N]] [--log journal] [--metrics fichier]\n"
+                 "                    <dossier | @manifeste | image> ...\n"
+                 "        BamDamBatch --case cas [--verify] [-o sortie] [-f ...] [--query ...] [--sort clés]\n"
+                 "                    [--rarity rapport] [--log journal]\n"
+                 "        BamDamBatch --watch dossier ... [-o dossier] [--ledger registre] [--settle s] [--rescan s]\n"
+                 "                    [--rotate s] [--queue N] [-j N] [-f ...] [--tz ...] [--rules ...] [--carve]\n"
+                 "                    [--log journal] [--metrics fichier]\n"
+                 "  image        image disque brute (dd) : ruches lues dans le volume NTFS, sans extraction\n"
+                 "  -j N         nombre de threads (défaut : tous les cœurs)\n"
+                 "  -o           fichier de sortie combiné (défaut : bamdam_batch.csv)\n"
+                 "  -f           format de sortie (défaut : d'après l'extension de -o)\n"
+                 "  -q           pas de ligne par ruche\n"
+                 "  --precision  précision des timestamps (défaut : us)\n"
+                 "  --iso        timestamps ISO 8601 au lieu de JJ/MM/AAAA\n"
+                 "  --tz         UTC (défaut) ou heure locale lue dans chaque ruche\n"
+                 "  --sid-cache  cache SID -> compte persistant (défaut : bamdam_sids.tsv près de la sortie)\n"
+                 "  --rules      règles de classification des chemins (défaut : Temp et Downloads)\n"
+                 "  --snapshot   index des collectes précédentes : n'émet que les nouveautés\n"
+                 "  --compact    fusionne le journal de l'index dans sa base\n"
+                 "  --history    ruches d'un même hôte = versions : une ligne par entrée, première et\n"
+                 "               dernière observation\n"
+                 "  --chunk N    export en flux par blocs de N lignes (mémoire bornée par ruche)\n"
+                 "  --carve      récupère aussi les valeurs supprimées (cellules libres), source \"recovered\"\n"
+                 "  --timeline   toutes les lignes par FILETIME croissant, tri externe (UTC uniquement)\n"
+                 "  --timeline-memory  budget mémoire du tri en Mo (défaut : 256)\n"
+                 "  --spill      répertoire des runs déversés (défaut : répertoire temporaire)\n"
+                 "  --query      n'exporte que les lignes de la requête, par FILETIME croissant (UTC) ;\n"
+                 "               ex. \"user:jdoe time:2024-03-01..2024-03-07 path:\\Users\\*\\AppData\\\"\n"
+                 "               \"-\" : requêtes interactives sur l'entrée standard, une par ligne\n"
+                 "  --limit      lignes affichées par requête interactive (défaut : 20)\n"
+                 "  --sort       ordre des lignes de --query ou de --case : clés host, sid, user, path, raw, time,\n"
+                 "               first, source séparées par des virgules, '-' = décroissant ; ex. host,-time,path\n"
+                 "  --save-case  enregistre les lignes de la flotte et leur index dans un fichier de cas\n"
+                 "  --case       rouvre un fichier de cas (projection mémoire, sans parsing) : export ou requêtes\n"
+                 "  --verify     vérifie les sommes de contrôle du cas avant de s'en servir (lit tout le fichier)\n"
+                 "  --rarity     rapport CSV des chemins vus sur le moins d'hôtes et des plus exécutés (sketches)\n"
+                 "  --rarity-k   chemins rares rapportés (défaut : 100)\n"
+                 "  --log        copie horodatée des messages\n"
+                 "  --metrics    durées par étape et compteurs (JSON, texte Prometheus si .prom)\n"
+                 "  --watch      surveille un dossier de dépôt (répétable) ; -o = dossier des segments\n"
+                 "               (défaut : bamdam_ingest), arrêt par Ctrl+C ou SIGTERM\n"
+                 "  --ledger     registre des ruches déjà exportées (défaut : bamdam_ingest.ledger dans -o)\n"
+                 "  --settle     secondes sans changement avant de lire une ruche (défaut : 2)\n"
+                 "  --rescan     inventaire complet des dossiers toutes les s secondes (défaut : 60, 0 = jamais)\n"
+                 "  --rotate     durée d'un segment de sortie en secondes (défaut : 60)\n"
+                 "  --queue N    ruches en attente au plus avant de bloquer l'observateur (défaut : 4 par thread)\n");
+}
+
+bool ParseArgs(const std::vector<std::string>& args, BatchOptions& options) {
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        if (arg == "-j" && i + 1 < args.size()) {
+            options.threads = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+        } else if (arg == "-o" && i + 1 < args.size()) {
+            options.output = fs::u8path(args[++i]);
+            options.outputGiven = true;
+        } else if (arg == "-f" && i + 1 < args.size()) {
+            const std::string& value = args[++i];
+            if (value == "csv") options.format = ExportFormat::Csv;
+            else if (value == "jsonl") options.format = ExportFormat::JsonLines;
+            else if (value == "bdcol") options.format = ExportFormat::Columnar;
+            else return false;
+            options.formatGiven = true;
+        } else if (arg == "-q") {
+            options.quiet = true;
+        } else if (arg == "--precision" && i + 1 < args.size()) {
+            const std::string& value = args[++i];
+            if (value == "s") options.timeFormat.precision = TimePrecision::Seconds;
+            else if (value == "ms") options.timeFormat.precision = TimePrecision::Milliseconds;
+            else if (value == "us") options.timeFormat.precision = TimePrecision::Microseconds;
+            else if (value == "100ns") options.timeFormat.precision = TimePrecision::Ticks100ns;
+            else return false;
+        } else if (arg == "--iso") {
+            options.timeFormat.style = TimeStyle::Iso8601;
+        } else if (arg == "--tz" && i + 1 < args.size()) {
+            const std::string& value = args[++i];
+            if (value == "hive") options.hiveTimeZone = true;
+            else if (value != "utc") return false;
+        } else if (arg == "--sid-cache" && i + 1 < args.size()) {
+            options.sidCache = fs::u8path(args[++i]);
+        } else if (arg == "--rules" && i + 1 < args.size()) {
+            options.rules = fs::u8path(args[++i]);
+        } else if (arg == "--snapshot" && i + 1 < args.size()) {
+            options.snapshot = fs::u8path(args[++i]);
+        } else if (arg == "--log" && i + 1 < args.size()) {
+            options.log = fs::u8path(args[++i]);
+        } else if (arg == "--metrics" && i + 1 < args.size()) {
+            options.metrics = fs::u8path(args[++i]);
+        } else if (arg == "--compact") {
+            options.compact = true;
+        } else if (arg == "--history") {
+            options.history = true;
+        } else if (arg == "--carve") {
+            options.carve = true;
+        } else if (arg == "--chunk" && i + 1 < args.size()) {
+            options.chunkRows = static_cast<size_t>(std::strtoull(args[++i].c_str(), nullptr, 10));
+            if (options.chunkRows == 0) return false;
+        } else if (arg == "--timeline") {
+            options.timeline = true;
+        } else if (arg == "--timeline-memory" && i + 1 < args.size()) {
+            options.timelineMemory = static_cast<size_t>(std::strtoull(args[++i].c_str(), nullptr, 10)) << 20;
+            if (options.timelineMemory == 0) return false;
+        } else if (arg == "--spill" && i + 1 < args.size()) {
+            options.spill = fs::u8path(args[++i]);
+        } else if (arg == "--query" && i + 1 < args.size()) {
+            options.query = args[++i];
+            if (options.query.empty()) return false;
+        } else if (arg == "--limit" && i + 1 < args.size()) {
+            options.queryLimit = static_cast<size_t>(std::strtoull(args[++i].c_str(), nullptr, 10));
+        } else if (arg == "--sort" && i + 1 < args.size()) {
+            std::string error;
+            if (!ParseSortFields(args[++i], options.sortFields, error)) {
+                std::fprintf(stderr, "--sort : %s\n", error.c_str());
+                return false;
+            }
+        } else if (arg == "--save-case" && i + 1 < args.size()) {
+            options.saveCase = fs::u8path(args[++i]);
+        } else if (arg == "--case" && i + 1 < args.size()) {
+            options.openCase = fs::u8path(args[++i]);
+        } else if (arg == "--verify") {
+            options.verifyCase = true;
+        } else if (arg == "--rarity" && i + 1 < args.size()) {
+            options.rarity = fs::u8path(args[++i]);
+        } else if (arg == "--rarity-k" && i + 1 < args.size()) {
+            options.rarityCount = static_cast<size_t>(std::strtoull(args[++i].c_str(), nullptr, 10));
+            if (options.rarityCount == 0) return false;
+        } else if (arg == "--watch" && i + 1 < args.size()) {
+            options.watch.push_back(fs::u8path(args[++i]));
+        } else if (arg == "--ledger" && i + 1 < args.size()) {
+            options.ledger = fs::u8path(args[++i]);
+        } else if (arg == "--settle" && i + 1 < args.size()) {
+            options.settleSeconds = std::strtod(args[++i].c_str(), nullptr);
+            if (!(options.settleSeconds >= 0)) return false;
+        } else if (arg == "--rescan" && i + 1 < args.size()) {
+            options.rescanSeconds = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+        } else if (arg == "--rotate" && i + 1 < args.size()) {
+            options.rotateSeconds = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+            if (options.rotateSeconds == 0) return false;
+        } else if (arg == "--queue" && i + 1 < args.size()) {
+            options.queueDepth = static_cast<size_t>(std::strtoull(args[++i].c_str(), nullptr, 10));
+            if (options.queueDepth == 0) return false;
+        } else if (arg == "--no-sid-cache") {
+            options.sidCacheEnabled = false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    if (!options.watch.empty()) {
+        // Sortie = dossier : format CSV sauf -f, cache SID et registre rangés avec les segments
+        if (!options.outputGiven) options.output = "bamdam_ingest";
+        if (options.sidCache.empty()) options.sidCache = options.output / "bamdam_sids.tsv";
+        if (options.ledger.empty()) options.ledger = options.output / "bamdam_ingest.ledger";
+        return options.inputs.empty() && options.openCase.empty() && options.snapshot.empty() && !options.compact &&
+               !options.history && !options.chunkRows && !options.timeline && options.query.empty() &&
+               options.saveCase.empty() && options.rarity.empty() && !options.verifyCase &&
+               options.sortFields.empty();
+    }
+    if (!options.formatGiven) {
+        options.format = ExportFormatFromPath(options.output);
+    }
+    if (options.sidCache.empty()) {
+        options.sidCache = options.output.parent_path() / "bamdam_sids.tsv";
+    }
+    if (!options.openCase.empty()) {
+        return options.inputs.empty() && options.snapshot.empty() && !options.history && !options.timeline &&
+               options.saveCase.empty() && !options.hiveTimeZone && !options.carve;
+    }
+    return !options.inputs.empty() && options.ledger.empty() && (!options.compact || !options.snapshot.empty()) &&
+           !(options.history && !options.snapshot.empty()) && !(options.history && options.chunkRows) &&
+           !(options.carve && (options.history || !options.snapshot.empty())) &&
+           !(options.timeline && options.hiveTimeZone) && !options.verifyCase &&
+           (options.query.empty() || (options.snapshot.empty() && !options.timeline && !options.hiveTimeZone)) &&
+           (options.sortFields.empty() || !options.query.empty()) &&
+           (options.saveCase.empty() || !options.timeline) && (options.rarity.empty() || options.snapshot.empty());
+}
+
+// --sort : permutation de tout le store, calculée une fois pour toutes les requêtes ; vide sans --sort
+std::vector<uint32_t> SortStore(const EntryStore& store, const BatchOptions& options, AsyncLogger& log) {
+    std::vector<uint32_t> order;
+    if (options.sortFields.empty()) return order;
+    const auto start = std::chrono::steady_clock::now();
+    EntrySorter sorter(options.threads);
+    sorter.Sort(store, options.sortFields, order);
+    std::string keys;
+    for (const SortField& field : options.sortFields) {
+        if (!keys.empty()) keys += ',';
+        if (field.descending) keys += '-';
+        keys += SortKeyName(field.key);
+    }
+    LogFormat(log, LogLevel::Info, "Tri : %s, %zu lignes en %.3f s", keys.c_str(), order.size(),
+              std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return order;
+}
+
+// Lignes sélectionnées dans l'ordre de --sort (sorted), sinon par FILETIME croissant ; limit premières au plus
+std::vector<uint32_t> SelectRows(const EntryIndex& index, const RowBitmap& selection,
+                                 const std::vector<uint32_t>& sorted, size_t limit = SIZE_MAX) {
+    if (sorted.empty()) return index.OrderByTime(selection, limit);
+    std::vector<uint32_t> rows;
+    for (size_t i = 0; i < sorted.size() && rows.size() < limit; i++) {
+        if (selection.Test(sorted[i])) rows.push_back(sorted[i]);
+    }
+    return rows;
+}
+
+// Requêtes lues sur stdin, une par ligne : nombre de lignes, durée, premières lignes par FILETIME ou --sort
+void RunInteractiveQueries(const EntryIndex& index, const std::vector<uint32_t>& sorted,
+                           const BatchOptions& options) {
+    const EntryStore& store = *index.Store();
+    TimeFormat format = options.timeFormat;
+    format.style = TimeStyle::Iso8601;
+    std::string line;
+    std::string text;
+    EntryQuery query;
+    std::fprintf(stdout, "> ");
+    std::fflush(stdout);
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line == "quit" || line == "exit") break;
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            // Ligne vide : nouvelle invite
+        } else if (!query.Parse(line)) {
+            std::fprintf(stdout, "Erreur : %s\n", query.LastError().c_str());
+        } else {
+            const auto t0 = std::chrono::steady_clock::now();
+            const RowBitmap selection = query.Evaluate(index);
+            const size_t count = selection.Count();
+            const std::vector<uint32_t> rows = SelectRows(index, selection, sorted, options.queryLimit);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            std::fprintf(stdout, "%zu lignes sur %zu (%.2f ms)\n", count, index.Rows(), ms);
+            for (size_t i = 0; i < rows.size(); i++) {
+                const uint32_t row = rows[i];
+                char stamp[FILETIME_TEXT_MAX];
+                FormatFileTime(store.FileTime(row), format, stamp);
+                text.clear();
+                AppendUtf8(text, store.Host(row));
+                text += "  ";
+                AppendUtf8(text, store.User(row));
+                text += "  ";
+                AppendUtf8(text, SourceName(store.Source(row)));
+                text += "  ";
+                AppendUtf8(text, store.NormalizedPath(row));
+                if (!store.Note(row).empty()) {
+                    text += "  [";
+                    AppendUtf8(text, store.Note(row));
+                    text += "]";
+                }
+                std::fprintf(stdout, "  %s  %s\n", stamp, text.c_str());
+            }
+            if (count > rows.size()) std::fprintf(stdout, "  ...\n");
+        }
+        std::fprintf(stdout, "> ");
+        std::fflush(stdout);
+    }
+    std::fprintf(stdout, "\n");
+}
+
+// Requête unique : lignes par FILETIME croissant ou dans l'ordre de --sort, copiées dans un store confié à l'export
+void ExportQuery(const EntryIndex& index, const EntryQuery& query, const std::vector<uint32_t>& sorted,
+                 ExportPipeline& exporter, const TimeFormat& format, AsyncLogger& log) {
+    const auto queryStart = std::chrono::steady_clock::now();
+    const RowBitmap selection = query.Evaluate(index);
+    const std::vector<uint32_t> rows = SelectRows(index, selection, sorted);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - queryStart).count();
+    LogFormat(log, LogLevel::Info, "Requête : %zu lignes sur %zu (%.2f ms)", rows.size(), index.Rows(), ms);
+    auto result = std::make_unique<EntryStore>();
+    result->Append(*index.Store(), rows.data(), rows.size());
+    exporter.Submit(std::move(result), format);
+}
+
+// Sketches fusionnés : rapport écrit et résumé dans le journal
+bool WriteRarity(const RaritySketch& sketch, const BatchOptions& options, AsyncLogger& log) {
+    const RarityReport report = sketch.Report();
+    if (!report.Write(options.rarity, options.timeFormat)) {
+        LogFormat(log, LogLevel::Error, "Impossible d'écrire %s", options.rarity.u8string().c_str());
+        return false;
+    }
+    size_t single = 0;
+    for (const RarityRow& row : report.rare) {
+        if (row.hosts == 1 && row.hostsKind == RarityCount::Exact) single++;
+    }
+    LogFormat(log, LogLevel::Info,
+              "Rareté : %s, %llu lignes, ~%.0f hôtes et ~%.0f chemins distincts (±%.1f %%), %zu chemins rares "
+              "dont %zu sur un seul hôte, sketches %.1f Mo (erreur count-min ≤ %llu)",
+              options.rarity.u8string().c_str(), static_cast<unsigned long long>(report.rows), report.hosts,
+              report.paths, report.fleetError * 100.0, report.rare.size(), single, sketch.MemoryBytes() / 1048576.0,
+              static_cast<unsigned long long>(report.sightingsError));
+    return true;
+}
+
+// Cas rouvert (--case) : store et index projetés depuis le fichier, puis export complet ou requêtes
+int RunCase(const BatchOptions& options) {
+    AsyncLogger log;
+    if (options.log.empty() ? !log.Open(stderr) : !log.Open(options.log, stderr)) {
+        std::fprintf(stderr, "%s\n", log.LastError().c_str());
+        return 1;
+    }
+    const bool interactive = options.query == "-";
+    EntryQuery query;
+    if (!options.query.empty() && !interactive && !query.Parse(options.query)) {
+        LogFormat(log, LogLevel::Error, "Requête invalide : %s", query.LastError().c_str());
+        return 2;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    CaseFile caseFile;
+    EntryStore store;
+    EntryIndex index;
+    if (!caseFile.Open(options.openCase, store, options.query.empty() ? nullptr : &index)) {
+        LogFormat(log, LogLevel::Error, "Cas %s : %s", options.openCase.u8string().c_str(),
+                  caseFile.LastError().c_str());
+        return 1;
+    }
+    LogFormat(log, LogLevel::Info, "Cas : %s, %zu lignes, %zu sections (%.1f Mo)%s, ouvert en %.2f ms",
+              options.openCase.u8string().c_str(), store.size(), caseFile.Sections(),
+              caseFile.FileBytes() / 1048576.0, caseFile.HasIndex() ? ", index compris" : "",
+              std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    if (options.verifyCase) {
+        const auto verifyStart = std::chrono::steady_clock::now();
+        if (!caseFile.Verify()) {
+            LogFormat(log, LogLevel::Error, "Cas %s : %s", options.openCase.u8string().c_str(),
+                      caseFile.LastError().c_str());
+            return 1;
+        }
+        LogFormat(log, LogLevel::Info, "Sommes de contrôle vérifiées en %.3f s",
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - verifyStart).count());
+    }
+    if (!options.rarity.empty()) {
+        RarityOptions rarityOptions;
+        rarityOptions.rare = options.rarityCount;
+        RaritySketch sketch(rarityOptions);
+        sketch.Add(store);
+        if (!WriteRarity(sketch, options, log)) return 1;
+    }
+    if (!options.query.empty() && !caseFile.HasIndex()) {
+        const auto indexStart = std::chrono::steady_clock::now();
+        index.Build(store);
+        LogFormat(log, LogLevel::Info, "Index absent du cas, construit en %.3f s",
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - indexStart).count());
+    }
+    const std::vector<uint32_t> sorted = SortStore(store, options, log);
+    if (interactive) {
+        log.Flush();
+        RunInteractiveQueries(index, sorted, options);
+        return 0;
+    }
+
+    ExportPipeline exporter(options.format, 64, store.HasFirstSeen());
+    if (!exporter.Open(options.output)) {
+        LogFormat(log, LogLevel::Error, "Impossible d'écrire %s", options.output.u8string().c_str());
+        return 1;
+    }
+    if (!options.query.empty()) {
+        ExportQuery(index, query, sorted, exporter, options.timeFormat, log);
+    } else if (!sorted.empty()) {
+        auto result = std::make_unique<EntryStore>();
+        result->Append(store, sorted.data(), sorted.size());
+        exporter.Submit(std::move(result), options.timeFormat);
+    } else {
+        exporter.Write(store, 0, store.size(), options.timeFormat);
+    }
+    if (!exporter.Close()) {
+        LogFormat(log, LogLevel::Error, "Impossible d'écrire %s", options.output.u8string().c_str());
+        return 1;
+    }
+    LogFormat(log, LogLevel::Info, "Sortie : %s (%llu lignes, %.1f Mo) en %.3f s", options.output.u8string().c_str(),
+              static_cast<unsigned long long>(exporter.RowsWritten()), exporter.BytesWritten() / 1048576.0,
+              std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}
+
+// Surveillance : arrêt demandé par SIGINT / SIGTERM, relu par la boucle principale
+volatile std::sig_atomic_t stopRequested = 0;
+
+extern "C" void OnStopSignal(int) {
+    stopRequested = 1;
+}
+
+// Ruche en attente d'un worker
+struct IngestItem {
+    HiveJob job;
+    uint64_t signature = 0;
+    std::chrono::steady_clock::time_point queued;
+};
+
+// Ruche vue par un inventaire ou après des événements : mise en file si sa signature n'a pas bougé
+// pendant --settle (copie terminée)
+struct IngestCandidate {
+    HiveJob job;
+    uint64_t signature = 0;
+    std::chrono::steady_clock::time_point seen;
+};
+
+const char* SegmentExtension(ExportFormat format) {
+    switch (format) {
+    case ExportFormat::JsonLines: return ".jsonl";
+    case ExportFormat::Columnar: return ".bdcol";
+    default: return ".csv";
+    }
+}
+
+// Sortie de la surveillance : segments <dossier>/bamdam-AAAAMMJJ-HHMMSS-N.<ext> (UTC), écrits sous .part,
+// ouverts à la première ruche et renommés à la rotation ; le registre n'enregistre les ruches d'un segment
+// qu'une fois celui-ci renommé
+class IngestSegments {
+public:
+    IngestSegments(const BatchOptions& options, IngestLedger& ledger, size_t maxPendingStores)
+        : options(options), ledger(ledger), maxPending(maxPendingStores) {}
+
+    // Bloque si la file de l'export est pleine (contre-pression vers les workers)
+    bool Submit(std::unique_ptr<EntryStore> store, const TimeFormat& format, const IngestRecord& record,
+                std::string& error) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!pipeline && !OpenSegment(error)) return false;
+        pipeline->Submit(std::move(store), format);
+        ledger.AddExported(record);
+        hives++;
+        Telemetry::SetGauge(TelemetryGauge::ExportQueue, static_cast<int64_t>(pipeline->Pending()));
+        return true;
+    }
+
+    // Segment ouvert depuis au moins --rotate s (ou force) : fermé, renommé, registre validé ; sans
+    // segment ouvert, seuls les doublons en attente sont enregistrés
+    bool Rotate(AsyncLogger& log, bool force) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!pipeline) {
+            if (ledger.Commit(std::string())) return true;
+            LogFormat(log, LogLevel::Error, "Registre : %s", ledger.LastError().c_str());
+            return false;
+        }
+        if (!force && std::chrono::steady_clock::now() - opened < std::chrono::seconds(options.rotateSeconds)) {
+            return true;
+        }
+        const bool written = pipeline->Close();
+        const uint64_t rows = pipeline->RowsWritten();
+        const uint64_t bytes = pipeline->BytesWritten();
+        pipeline.reset();
+        Telemetry::SetGauge(TelemetryGauge::ExportQueue, 0);
+
+        std::error_code ec;
+        if (written) fs::rename(partPath, finalPath, ec);
+        if (!written || ec) {
+            ledger.Abandon();
+            LogFormat(log, LogLevel::Error, "Segment %s perdu, ses %zu ruches seront relues",
+                      finalPath.u8string().c_str(), hives);
+            return false;
+        }
+        const std::string name = finalPath.filename().u8string();
+        if (!ledger.Commit(name)) {
+            LogFormat(log, LogLevel::Error, "Registre : %s", ledger.LastError().c_str());
+            return false;
+        }
+        rowsWritten += rows;
+        segments++;
+        LogFormat(log, LogLevel::Info, "[SEGMENT] %s  %zu ruches, %llu lignes, %.1f Mo", name.c_str(), hives,
+                  static_cast<unsigned long long>(rows), bytes / 1048576.0);
+        return true;
+    }
+
+    size_t Segments() const { return segments; }
+    uint64_t RowsWritten() const { return rowsWritten; }
+
+private:
+    bool OpenSegment(std::string& error) {
+        char stamp[32];
+        const std::time_t now = std::time(nullptr);
+        std::tm utc = {};
+#ifdef _WIN32
+        gmtime_s(&utc, &now);
+#else
+        gmtime_r(&now, &utc);
+#endif
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &utc);
+        char name[64];
+        std::snprintf(name, sizeof(name), "bamdam-%s-%zu%s", stamp, ++sequence, SegmentExtension(options.format));
+        finalPath = options.output / name;
+        partPath = finalPath;
+        partPath += ".part";
+
+        pipeline = std::make_unique<ExportPipeline>(options.format, maxPending);
+        if (!pipeline->Open(partPath)) {
+            pipeline.reset();
+            error = "Impossible d'écrire " + partPath.u8string();
+            return false;
+        }
+        opened = std::chrono::steady_clock::now();
+        hives = 0;
+        return true;
+    }
+
+    const BatchOptions& options;
+    IngestLedger& ledger;
+    const size_t maxPending;
+    std::mutex lock;
+    std::unique_ptr<ExportPipeline> pipeline;
+    fs::path partPath;
+    fs::path finalPath;
+    std::chrono::steady_clock::time_point opened;
+    size_t hives = 0;
+    size_t sequence = 0;
+    size_t segments = 0;
+    uint64_t rowsWritten = 0;
+};
+
+// Lot de premier niveau contenant path (dossier d'hôte, ruche ou image déposée à la racine) ; vide si
+// path est une racine ou hors des racines
+fs::path BundleOf(const std::vector<fs::path>& roots, const fs::path& path) {
+    for (const fs::path& root : roots) {
+        const fs::path relative = path.lexically_relative(root);
+        if (relative.empty() || *relative.begin() == "." || *relative.begin() == "..") continue;
+        return root / *relative.begin();
+    }
+    return fs::path();
+}
+
+// Copies en cours (.part, .tmp, fichiers cachés) et sorties rangées dans un dossier surveillé : ignorées
+bool IgnoredEntry(const fs::path& entry, const fs::path& output) {
+    const std::string name = entry.filename().u8string();
+    if (name.empty() || name[0] == '.') return true;
+    const std::string ext = entry.extension().u8string();
+    if (EqualsNoCase(ext, ".part") || EqualsNoCase(ext, ".tmp")) return true;
+    std::error_code ec;
+    return fs::equivalent(entry, output, ec);
+}
+
+// Ruches d'un lot : SYSTEM de l'arborescence, ou fichier déposé à la racine (SYSTEM ou image disque)
+void CollectBundle(const fs::path& bundle, std::vector<HiveJob>& jobs) {
+    std::error_code ec;
+    if (fs::is_directory(bundle, ec)) {
+        CollectJobs(bundle.u8string(), jobs);
+    } else if (fs::is_regular_file(bundle, ec) &&
+               (EqualsNoCase(bundle.filename().u8string(), "SYSTEM") || NtfsImage::LooksLikeImage(bundle))) {
+        AddJob(jobs, bundle, std::string());
+    }
+}
+
+// Mode surveillance (--watch) : voir l'en-tête
+int RunWatch(const BatchOptions& options) {
+    AsyncLogger log;
+    if (options.log.empty() ? !log.Open(stderr) : !log.Open(options.log, stderr)) {
+        std::fprintf(stderr, "%s\n", log.LastError().c_str());
+        return 1;
+    }
+    PathClassifier customRules;
+    if (!options.rules.empty()) {
+        if (!customRules.LoadFile(options.rules) || !customRules.Compile()) {
+            LogFormat(log, LogLevel::Error, "Règles invalides : %s", customRules.LastError().c_str());
+            return 2;
+        }
+    }
+    const PathClassifier& classifier = options.rules.empty() ? PathClassifier::Default() : customRules;
+
+    std::error_code ec;
+    fs::create_directories(options.output, ec);
+    if (!fs::is_directory(options.output, ec)) {
+        LogFormat(log, LogLevel::Error, "Dossier de sortie impossible : %s", options.output.u8string().c_str());
+        return 1;
+    }
+    IngestLedger ledger;
+    if (!ledger.Open(options.ledger)) {
+        LogFormat(log, LogLevel::Error, "%s", ledger.LastError().c_str());
+        return 1;
+    }
+    SidCache sids;
+    if (options.sidCacheEnabled) sids.Load(options.sidCache);
+    const SidResolveFn resolveUser = [&sids](std::u16string_view sid) { return sids.Resolve(sid); };
+
+    DirectoryWatcher watcher;
+    for (const fs::path& root : options.watch) {
+        if (!watcher.Add(root)) {
+            LogFormat(log, LogLevel::Error, "%s", watcher.LastError().c_str());
+            return 1;
+        }
+    }
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    BoundedQueue<IngestItem> queue(options.queueDepth ? options.queueDepth : size_t{ threads } * 4);
+    IngestSegments segments(options, ledger, size_t{ threads } * 4);
+    LogFormat(log, LogLevel::Info,
+              "Surveillance : %zu dossiers, %zu sous-dossiers suivis, %u workers, file de %zu ruches, "
+              "registre %s (%zu ruches déjà exportées), %zu comptes SID connus",
+              options.watch.size(), watcher.Watches(), threads, queue.Capacity(),
+              options.ledger.u8string().c_str(), ledger.Count(), sids.Count());
+    if (!watcher.Native()) {
+        LogFormat(log, LogLevel::Warning, "Pas d'événements (%s) : inventaire toutes les %u s",
+                  watcher.LastError().empty() ? "plateforme" : watcher.LastError().c_str(),
+                  options.rescanSeconds ? options.rescanSeconds : 60u);
+    }
+
+    std::atomic<int64_t> inFlight{ 0 };
+    const auto process = [&](IngestItem& item) {
+        HiveJob& job = item.job;
+        HiveResult result;
+        NtfsImage image;
+        RegfHive hive;
+        IngestRecord record;
+        record.signature = item.signature;
+        record.host = job.host;
+        record.path = job.path;
+        const std::u16string host = Utf8ToU16(job.host);
+        {
+            ScopedSpan read(TelemetrySpan::IngestRead);
+            if (!OpenJobHive(job, image, hive, result)) {
+                Telemetry::Add(TelemetryCounter::IngestFailures);
+                LogFormat(log, LogLevel::Error, "[ERREUR] %s  %s  %s", job.host.c_str(), job.path.u8string().c_str(),
+                          result.error.c_str());
+                return;
+            }
+            record.hash = HiveContentHash(hive);
+            read.SetItems(hive.HbinsSize());
+            if (!ledger.Claim(record.hash)) {
+                ledger.AddDuplicate(record);
+                Telemetry::Add(TelemetryCounter::IngestDuplicates);
+                if (!options.quiet) {
+                    LogFormat(log, LogLevel::Info, "[DÉJÀ VU] %s  %s  %016llx", job.host.c_str(),
+                              job.path.u8string().c_str(), static_cast<unsigned long long>(record.hash));
+                }
+                return;
+            }
+            // Comptes de l'hôte chargés avant le parsing, comme en lot
+            if (!job.image) {
+                sids.ImportHostHives(job.path.parent_path(), host);
+            } else {
+                RegfHive software;
+                RegfHive sam;
+                const bool hasSoftware = image.OpenHive(u"SOFTWARE", software);
+                const bool hasSam = image.OpenHive(u"SAM", sam);
+                sids.ImportHives(hasSoftware ? &software : nullptr, hasSam ? &sam : nullptr, host);
+            }
+        }
+
+        // Mêmes étapes que ParseBamDamHive, chronométrées séparément
+        auto store = std::make_unique<EntryStore>();
+        const uint32_t hostId = store->hosts.Intern(host);
+        {
+            ScopedSpan parse(TelemetrySpan::IngestParse);
+            BamDamRowAppender(hive, resolveUser).Append(*store, hostId, SIZE_MAX);
+            parse.SetItems(store->size());
+        }
+        TimeFormat format = options.timeFormat;
+        {
+            ScopedSpan enrich(TelemetrySpan::IngestEnrich);
+            VolumeMap volumes;
+            volumes.Load(hive);
+            ResolveRowPaths(*store, 0, volumes, classifier);
+            if (options.carve) result.recoveredRows = CarveBamDamHive(hive, *store, hostId, classifier);
+            if (options.hiveTimeZone) ReadHiveUtcOffset(hive, result.utcOffset);
+            format.offsetMinutes = result.utcOffset;
+            enrich.SetItems(store->size());
+        }
+        const size_t rows = store->size();
+        std::string error;
+        bool submitted = false;
+        {
+            ScopedSpan exportSpan(TelemetrySpan::IngestExport, rows);
+            submitted = segments.Submit(std::move(store), format, record, error);
+        }
+        if (!submitted) {
+            ledger.Release(record.hash);
+            ledger.Remember(job.path, 0);  // Relue au prochain inventaire
+            Telemetry::Add(TelemetryCounter::IngestFailures);
+            LogFormat(log, LogLevel::Error, "[ERREUR] %s  %s  %s", job.host.c_str(), job.path.u8string().c_str(),
+                      error.c_str());
+            return;
+        }
+        const auto latency = std::chrono::steady_clock::now() - item.queued;
+        if (Telemetry::Enabled()) {
+            Telemetry::Record(TelemetrySpan::IngestLatency, static_cast<uint64_t>(
+                                  std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()), rows);
+        }
+        Telemetry::Add(TelemetryCounter::IngestHives);
+        if (!options.quiet) {
+            char recovered[48] = "";
+            if (options.carve) {
+                std::snprintf(recovered, sizeof(recovered), " (%zu récupérées)", result.recoveredRows);
+            }
+            LogFormat(log, LogLevel::Info, "[OK] %s  %s  %zu entrées%s  %016llx  %.2f ms depuis la mise en file",
+                      job.host.c_str(), job.path.u8string().c_str(), rows, recovered,
+                      static_cast<unsigned long long>(record.hash),
+                      std::chrono::duration<double, std::milli>(latency).count());
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < threads; w++) {
+        workers.emplace_back([&] {
+            IngestItem item;
+            while (queue.Pop(item)) {
+                Telemetry::SetGauge(TelemetryGauge::IngestQueue, static_cast<int64_t>(queue.Size()));
+                Telemetry::SetGauge(TelemetryGauge::IngestInFlight, ++inFlight);
+                process(item);
+                Telemetry::SetGauge(TelemetryGauge::IngestInFlight, --inFlight);
+            }
+        });
+    }
+
+    stopRequested = 0;
+    std::signal(SIGINT, OnStopSignal);
+    std::signal(SIGTERM, OnStopSignal);
+
+    using Clock = std::chrono::steady_clock;
+    const auto settle =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.settleSeconds));
+    const auto rescanPeriod = std::chrono::seconds(options.rescanSeconds ? options.rescanSeconds
+                                                   : watcher.Native() ? 0 : 60);
+    const fs::path outputDir = options.output;
+    std::unordered_map<std::string, Clock::time_point> dirty;  // Lot → dernier événement
+    std::unordered_map<std::string, IngestCandidate> candidates;  // Chemin de ruche → dernière signature
+    Clock::time_point lastRescan;
+    Clock::time_point lastMetrics = Clock::now();
+    Clock::time_point lastStatus = Clock::now();
+    uint64_t statusHives = 0;
+    bool rescan = true;  // Inventaire initial : ruches déposées pendant l'arrêt
+
+    // Rotation, métriques et état périodiques ; aussi appelé pendant une attente de place dans la file
+    const auto maintain = [&] {
+        const Clock::time_point now = Clock::now();
+        segments.Rotate(log, false);
+        if (!options.metrics.empty() && now - lastMetrics >= std::chrono::seconds(10)) {
+            lastMetrics = now;
+            std::string error;
+            if (!Telemetry::WriteFile(options.metrics, error)) LogFormat(log, LogLevel::Warning, "%s", error.c_str());
+        }
+        if (now - lastStatus >= std::chrono::minutes(1)) {
+            lastStatus = now;
+            const TelemetrySnapshot snapshot = Telemetry::Capture();
+            const uint64_t hives = snapshot.counters[static_cast<size_t>(TelemetryCounter::IngestHives)];
+            if (hives != statusHives) {
+                const TelemetrySpanStats& latency = snapshot.spans[static_cast<size_t>(TelemetrySpan::IngestLatency)];
+                LogFormat(log, LogLevel::Info,
+                          "Surveillance : %llu ruches en 1 min, file %zu/%zu, latence p50 %.0f ms, p90 %.0f ms, "
+                          "p99 %.0f ms",
+                          static_cast<unsigned long long>(hives - statusHives), queue.Size(), queue.Capacity(),
+                          TelemetryQuantileNs(latency, 0.5) / 1e6, TelemetryQuantileNs(latency, 0.9) / 1e6,
+                          TelemetryQuantileNs(latency, 0.99) / 1e6);
+                statusHives = hives;
+            }
+        }
+    };
+
+    std::vector<fs::path> changed;
+    std::vector<HiveJob> jobs;
+    while (!stopRequested) {
+        changed.clear();
+        bool overflow = false;
+        watcher.Wait(250, changed, overflow);
+        Clock::time_point now = Clock::now();
+        for (const fs::path& path : changed) {
+            const fs::path bundle = BundleOf(options.watch, path);
+            if (!bundle.empty()) dirty[bundle.u8string()] = now;
+        }
+        if (overflow) {
+            LogFormat(log, LogLevel::Warning, "Événements perdus : inventaire complet");
+            rescan = true;
+        }
+        if (rescan || (rescanPeriod.count() && now - lastRescan >= rescanPeriod)) {
+            rescan = false;
+            lastRescan = now;
+            Telemetry::Add(TelemetryCounter::IngestRescans);
+            for (const fs::path& root : options.watch) {
+                for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+                    dirty.emplace(it->path().u8string(), now - settle);
+                }
+            }
+        }
+
+        // Lots sans événement depuis --settle : leurs ruches deviennent candidates
+        for (auto it = dirty.begin(); it != dirty.end();) {
+            if (now - it->second < settle) {
+                ++it;
+                continue;
+            }
+            const fs::path bundle = fs::u8path(it->first);
+            it = dirty.erase(it);
+            if (IgnoredEntry(bundle, outputDir)) continue;
+            jobs.clear();
+            CollectBundle(bundle, jobs);
+            for (HiveJob& job : jobs) {
+                const uint64_t signature = HiveFileSignature(job.path, job.image);
+                if (!signature || ledger.Unchanged(job.path, signature)) continue;
+                IngestCandidate& candidate = candidates[job.path.u8string()];
+                if (candidate.signature != signature) {
+                    candidate.job = std::move(job);
+                    candidate.signature = signature;
+                    candidate.seen = now;
+                }
+            }
+        }
+
+        // Signature stable depuis --settle : copie terminée, ruche mise en file (bloque si la file est pleine)
+        for (auto it = candidates.begin(); it != candidates.end() && !stopRequested;) {
+            IngestCandidate& candidate = it->second;
+            if (now - candidate.seen < settle) {
+                ++it;
+                continue;
+            }
+            const uint64_t signature = HiveFileSignature(candidate.job.path, candidate.job.image);
+            if (signature != candidate.signature) {
+                candidate.signature = signature;
+                candidate.seen = now;
+                if (!signature) {
+                    it = candidates.erase(it);
+                } else {
+                    ++it;
+                }
+                continue;
+            }
+            ledger.Remember(candidate.job.path, signature);
+            IngestItem item;
+            item.job = std::move(candidate.job);
+            item.signature = signature;
+            item.queued = Clock::now();
+            while (!queue.Push(item, std::chrono::milliseconds(250)) && !stopRequested) {
+                maintain();
+            }
+            Telemetry::SetGauge(TelemetryGauge::IngestQueue, static_cast<int64_t>(queue.Size()));
+            it = candidates.erase(it);
+            now = Clock::now();
+        }
+        maintain();
+    }
+
+    LogFormat(log, LogLevel::Info, "Arrêt demandé : %zu ruches en file terminées avant fermeture", queue.Size());
+    queue.Close();
+    for (std::thread& worker : workers) worker.join();
+    const bool closed = segments.Rotate(log, true);
+    if (options.sidCacheEnabled && !sids.Save(options.sidCache)) {
+        LogFormat(log, LogLevel::Warning, "Cache SID non enregistré : %s", options.sidCache.u8string().c_str());
+    }
+    const TelemetrySnapshot snapshot = Telemetry::Capture();
+    LogFormat(log, LogLevel::Info,
+              "Terminé : %llu ruches exportées, %llu déjà vues, %llu échecs, %llu lignes en %zu segments, "
+              "%llu messages de journal perdus",
+              static_cast<unsigned long long>(snapshot.counters[static_cast<size_t>(TelemetryCounter::IngestHives)]),
+              static_cast<unsigned long long>(
+                  snapshot.counters[static_cast<size_t>(TelemetryCounter::IngestDuplicates)]),
+              static_cast<unsigned long long>(snapshot.counters[static_cast<size_t>(TelemetryCounter::IngestFailures)]),
+              static_cast<unsigned long long>(segments.RowsWritten()), segments.Segments(),
+              static_cast<unsigned long long>(log.Dropped()));
+    if (!options.metrics.empty()) {
+        std::string error;
+        if (!Telemetry::WriteFile(options.metrics, error)) {
+            LogFormat(log, LogLevel::Warning, "Métriques non enregistrées : %s", error.c_str());
+        }
+    }
+    return closed ? 0 : 1;
+}
+
+int RunBatch(const std::vector<std::string>& args) {
+    BatchOptions options;
+    if (!ParseArgs(args, options)) {
+        PrintUsage();
+        return 2;
+    }
+    if (!options.openCase.empty()) {
+        return RunCase(options);
+    }
+    if (!options.watch.empty()) {
+        return RunWatch(options);
+    }
+
+    std::vector<HiveJob> jobs;
+    for (const auto& input : options.inputs) {
+        CollectJobs(input, jobs);
+    }
+    if (jobs.empty()) {
+        std::fprintf(stderr, "Aucune ruche SYSTEM trouvée\n");
+        return 1;
+    }
+
+    AsyncLogger log;
+    if (options.log.empty() ? !log.Open(stderr) : !log.Open(options.log, stderr)) {
+        std::fprintf(stderr, "%s\n", log.LastError().c_str());
+        return 1;
+    }
+
+    PathClassifier customRules;
+    if (!options.rules.empty()) {
+        if (!customRules.LoadFile(options.rules) || !customRules.Compile()) {
+            LogFormat(log, LogLevel::Error, "Règles invalides : %s", customRules.LastError().c_str());
+            return 2;
+        }
+        LogFormat(log, LogLevel::Info, "%zu règles, automate de %zu états", customRules.RuleCount(),
+                  customRules.StateCount());
+    }
+    const PathClassifier& classifier = options.rules.empty() ? PathClassifier::Default() : customRules;
+
+    // Requête compilée avant le parsing : une erreur de syntaxe ne coûte pas un passage sur la flotte
+    const bool interactive = options.query == "-";
+    EntryQuery query;
+    if (!options.query.empty() && !interactive && !query.Parse(options.query)) {
+        LogFormat(log, LogLevel::Error, "Requête invalide : %s", query.LastError().c_str());
+        return 2;
+    }
+
+    SnapshotIndex snapshot;
+    if (!options.snapshot.empty()) {
+        if (!snapshot.Open(options.snapshot)) {
+            LogFormat(log, LogLevel::Error, "Index %s : %s", options.snapshot.u8string().c_str(),
+                      snapshot.LastError().c_str());
+            return 1;
+        }
+        LogFormat(log, LogLevel::Info, "Index : %zu clés en base, %zu dans le journal", snapshot.BaseCount(),
+                  snapshot.JournalRecords());
+    }
+
+    WorkStealingPool pool(options.threads);
+    LogFormat(log, LogLevel::Info, "%zu ruches, %u threads", jobs.size(), pool.Threads());
+
+    std::vector<uint64_t> weights(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        weights[i] = jobs[i].size;
+    }
+
+    ExportPipeline exporter(options.format, pool.Threads() * 4, options.history);
+    if (!interactive && !exporter.Open(options.output)) {
+        LogFormat(log, LogLevel::Error, "Impossible d'écrire %s", options.output.u8string().c_str());
+        return 1;
+    }
+
+    // Chronologie : les stores des workers deviennent des runs triés, exportés après la fusion
+    TimelineOptions timelineOptions;
+    timelineOptions.memoryBytes = options.timelineMemory;
+    timelineOptions.spillDirectory = options.spill;
+    timelineOptions.history = options.history;
+    TimelineBuilder timeline(timelineOptions);
+    if (options.timeline && !timeline.Open()) {
+        LogFormat(log, LogLevel::Error, "Chronologie : %s", timeline.LastError().c_str());
+        return 1;
+    }
+    // Requête ou cas : toutes les lignes rassemblées dans un store de flotte, indexé après le parsing
+    const bool gather = !options.query.empty() || !options.saveCase.empty();
+    EntryStore fleet;
+    std::mutex fleetLock;
+    // Rareté : un sketch par worker, sans verrou, fusionnés après le parsing
+    RarityOptions rarityOptions;
+    rarityOptions.rare = options.rarityCount;
+    std::vector<RaritySketch> sketches(options.rarity.empty() ? 0 : pool.Threads(), RaritySketch(rarityOptions));
+    const auto submit = [&](unsigned worker, std::unique_ptr<EntryStore> store, const TimeFormat& format) {
+        if (!sketches.empty()) sketches[worker].Add(*store);
+        if (options.timeline) {
+            timeline.Add(*store);  // Échec de déversement remonté par Merge
+            return;
+        }
+        if (gather) {
+            std::lock_guard<std::mutex> guard(fleetLock);
+            fleet.Append(*store);
+        }
+        if (options.query.empty()) exporter.Submit(std::move(store), format);
+    };
+
+    std::vector<HiveResult> results(jobs.size());
+    const auto start = std::chrono::steady_clock::now();
+
+    // Comptes de toute la flotte chargés avant le parsing : la résolution ne dépend pas de l'ordre des ruches
+    SidCache sids;
+    size_t cachedSids = 0;
+    if (options.sidCacheEnabled && sids.Load(options.sidCache)) {
+        cachedSids = sids.Count();
+    }
+    pool.Run(weights, [&](size_t task, unsigned) {
+        if (!jobs[task].image) {
+            sids.ImportHostHives(jobs[task].path.parent_path(), Utf8ToU16(jobs[task].host));
+            return;
+        }
+        NtfsImage image;
+        RegfHive software;
+        RegfHive sam;
+        if (!image.Open(jobs[task].path)) return;
+        const bool hasSoftware = image.OpenHive(u"SOFTWARE", software);
+        const bool hasSam = image.OpenHive(u"SAM", sam);
+        sids.ImportHives(hasSoftware ? &software : nullptr, hasSam ? &sam : nullptr, Utf8ToU16(jobs[task].host));
+    });
+    LogFormat(log, LogLevel::Info, "SIDs : %zu comptes connus (%zu depuis le cache)", sids.Count(), cachedSids);
+    const SidResolveFn resolveUser = [&sids](std::u16string_view sid) { return sids.Resolve(sid); };
+
+    const auto parseHive = [&](size_t task, unsigned worker) {
+        const auto t0 = std::chrono::steady_clock::now();
+        HiveResult& result = results[task];
+
+        NtfsImage image;
+        RegfHive hive;
+        if (OpenJobHive(jobs[task], image, hive, result)) {
+            result.dirty = hive.IsDirty();
+            result.logEntries = hive.LogEntriesApplied();
+            result.logPages = hive.LogPagesApplied();
+            if (options.hiveTimeZone) {
+                ReadHiveUtcOffset(hive, result.utcOffset);
+            }
+            TimeFormat format = options.timeFormat;
+            format.offsetMinutes = result.utcOffset;
+            const std::u16string host = Utf8ToU16(jobs[task].host);
+            std::optional<SnapshotFilter> filter;
+            if (!options.snapshot.empty()) filter.emplace(snapshot, host);
+            BamDamFilter* const rowFilter = filter ? &*filter : nullptr;
+
+            if (options.chunkRows) {
+                BamDamStreamOptions stream;
+                stream.chunkRows = options.chunkRows;
+                stream.resolveUser = resolveUser;
+                stream.classifier = &classifier;
+                stream.filter = rowFilter;
+                result.rowCount = StreamBamDamHive(hive, host, [&](std::unique_ptr<EntryStore> chunk) {
+                    submit(worker, std::move(chunk), format);
+                }, stream);
+                if (options.carve) {
+                    // Un bloc de plus : les valeurs récupérées sont bornées par l'espace libre de la ruche
+                    auto carved = std::make_unique<EntryStore>();
+                    const uint32_t hostId = carved->hosts.Intern(host);
+                    result.recoveredRows = CarveBamDamHive(hive, *carved, hostId, classifier);
+                    if (result.recoveredRows) submit(worker, std::move(carved), format);
+                }
+            } else {
+                auto store = std::make_unique<EntryStore>();
+                uint32_t hostId = store->hosts.Intern(host);
+                result.rowCount = ParseBamDamHive(hive, *store, hostId, resolveUser, classifier, rowFilter);
+                if (options.carve) result.recoveredRows = CarveBamDamHive(hive, *store, hostId, classifier);
+                submit(worker, std::move(store), format);
+            }
+            result.rowCount += result.recoveredRows;
+            if (filter) {
+                result.skippedKeys = filter->SkippedKeys();
+                result.skippedRows = filter->SkippedRows();
+            }
+            result.ok = true;
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        if (!options.quiet) {
+            const double mb = jobs[task].size / 1048576.0;
+            if (result.ok) {
+                char logs[96] = "";
+                if (result.logEntries) {
+                    std::snprintf(logs, sizeof(logs), "  journaux : %zu entrées, %zu pages", result.logEntries,
+                                  result.logPages);
+                } else if (result.dirty) {
+                    std::snprintf(logs, sizeof(logs), "  non consolidée, journaux absents ou invalides");
+                }
+                char recovered[48] = "";
+                if (options.carve) {
+                    std::snprintf(recovered, sizeof(recovered), " (%zu récupérées)", result.recoveredRows);
+                }
+                char source[128];
+                DescribeImage(jobs[task], result, image, source, sizeof(source));
+                LogFormat(log, LogLevel::Info, "[OK] %s  %s  %zu entrées%s  %.2f ms  %.1f Mo/s%s%s",
+                          jobs[task].host.c_str(), jobs[task].path.u8string().c_str(), result.rowCount, recovered,
+                          result.seconds * 1000.0, result.seconds > 0 ? mb / result.seconds : 0.0, logs, source);
+            } else {
+                LogFormat(log, LogLevel::Error, "[ERREUR] %s  %s  %s", jobs[task].host.c_str(),
+                          jobs[task].path.u8string().c_str(), result.error.c_str());
+            }
+        }
+    };
+
+    // Une tâche par hôte : ses versions partagent les empreintes des clés SID déjà parsées
+    std::vector<HostGroup> groups;
+    const auto parseHistory = [&](size_t task, unsigned worker) {
+        const auto t0 = std::chrono::steady_clock::now();
+        HostGroup& group = groups[task];
+        HiveHistory history(Utf8ToU16(group.host), classifier);
+        int32_t utcOffset = 0;
+        size_t failedVersions = 0;
+
+        for (size_t job : group.jobs) {
+            const auto versionStart = std::chrono::steady_clock::now();
+            HiveResult& result = results[job];
+            NtfsImage image;
+            RegfHive hive;
+            if (!OpenJobHive(jobs[job], image, hive, result)) {
+                failedVersions++;
+                if (!options.quiet) {
+                    LogFormat(log, LogLevel::Error, "[ERREUR] %s  %s  %s", group.host.c_str(),
+                              jobs[job].path.u8string().c_str(), result.error.c_str());
+                }
+                continue;
+            }
+            result.ok = true;
+            result.dirty = hive.IsDirty();
+            result.logEntries = hive.LogEntriesApplied();
+            result.logPages = hive.LogPagesApplied();
+            result.newKeys = history.AddVersion(hive, resolveUser);
+            if (options.hiveTimeZone) {
+                ReadHiveUtcOffset(hive, utcOffset);
+            }
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - versionStart).count();
+            if (!options.quiet) {
+                char source[128];
+                DescribeImage(jobs[job], result, image, source, sizeof(source));
+                LogFormat(log, LogLevel::Info, "[OK] %s  %s  %zu clés SID nouvelles  %.2f ms%s", group.host.c_str(),
+                          jobs[job].path.u8string().c_str(), result.newKeys, result.seconds * 1000.0, source);
+            }
+        }
+
+        const size_t parsed = history.KeysParsed();
+        const size_t reused = history.KeysReused();
+        const size_t versions = history.Versions();
+        const size_t identical = history.IdenticalVersions();
+        std::unique_ptr<EntryStore> store = history.Finish();
+        group.rowCount = store->size();
+        if (versions > 0) {
+            TimeFormat format = options.timeFormat;
+            format.offsetMinutes = utcOffset;
+            submit(worker, std::move(store), format);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        LogFormat(log, LogLevel::Info,
+                  "[HISTORIQUE] %s  %zu versions (%zu sans nouveauté, %zu échecs)  clés SID : %zu parsées, "
+                  "%zu déjà vues  %zu entrées  %.2f ms",
+                  group.host.c_str(), versions, identical, failedVersions, parsed, reused, group.rowCount,
+                  seconds * 1000.0);
+    };
+
+    if (options.history) {
+        groups = GroupByHost(jobs);
+        std::vector<uint64_t> groupWeights(groups.size());
+        for (size_t i = 0; i < groups.size(); i++) {
+            groupWeights[i] = groups[i].size;
+        }
+        pool.Run(groupWeights, parseHistory);
+    } else {
+        pool.Run(weights, parseHive);
+    }
+
+    const double parseElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (options.timeline) {
+        const bool merged = timeline.Merge(options.chunkRows ? options.chunkRows : 65536,
+                                           [&](std::unique_ptr<EntryStore> chunk) {
+                                               exporter.Submit(std::move(chunk), options.timeFormat);
+                                           });
+        if (!merged) {
+            exporter.Close();
+            LogFormat(log, LogLevel::Error, "Chronologie : %s", timeline.LastError().c_str());
+            return 1;
+        }
+        LogFormat(log, LogLevel::Info, "Chronologie : %llu lignes, %zu runs déversés (%.1f Mo), %zu passes",
+                  static_cast<unsigned long long>(timeline.Rows()), timeline.RunsSpilled(),
+                  timeline.BytesSpilled() / 1048576.0, timeline.MergePasses());
+    }
+    bool rarityWritten = true;
+    if (!sketches.empty()) {
+        for (size_t w = 1; w < sketches.size(); w++) sketches[0].Merge(sketches[w]);
+        rarityWritten = WriteRarity(sketches[0], options, log);
+    }
+    bool caseSaved = true;
+    if (gather) {
+        const auto indexStart = std::chrono::steady_clock::now();
+        EntryIndex index;
+        index.Build(fleet);
+        LogFormat(log, LogLevel::Info, "Index : %zu lignes, %zu chemins distincts (%zu nœuds), %.1f Mo en %.3f s",
+                  index.Rows(), index.PathCount(), index.NodeCount(), index.MemoryBytes() / 1048576.0,
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - indexStart).count());
+        if (!options.saveCase.empty()) {
+            const auto saveStart = std::chrono::steady_clock::now();
+            CaseFile caseFile;
+            caseSaved = caseFile.Save(options.saveCase, fleet, &index);
+            if (caseSaved) {
+                LogFormat(log, LogLevel::Info, "Cas : %s (%zu lignes, index compris) enregistré en %.3f s",
+                          options.saveCase.u8string().c_str(), fleet.size(),
+                          std::chrono::duration<double>(std::chrono::steady_clock::now() - saveStart).count());
+            } else {
+                LogFormat(log, LogLevel::Error, "Cas non enregistré : %s", caseFile.LastError().c_str());
+            }
+        }
+        const std::vector<uint32_t> sorted = SortStore(fleet, options, log);  // --sort exige --query
+        if (interactive) {
+            log.Flush();
+            RunInteractiveQueries(index, sorted, options);
+        } else if (!options.query.empty()) {
+            ExportQuery(index, query, sorted, exporter, options.timeFormat, log);
+        }
+    }
+    const bool written = exporter.Close();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0;
+    size_t totalEntries = 0;
+    size_t skippedKeys = 0;
+    size_t skippedRows = 0;
+    size_t recoveredRows = 0;
+    uint64_t totalBytes = 0;
+    for (const HostGroup& group : groups) {
+        totalEntries += group.rowCount;
+    }
+    for (size_t i = 0; i < jobs.size(); i++) {
+        totalBytes += jobs[i].size;
+        totalEntries += results[i].rowCount;
+        skippedKeys += results[i].skippedKeys;
+        skippedRows += results[i].skippedRows;
+        recoveredRows += results[i].recoveredRows;
+        if (!results[i].ok) failed++;
+    }
+
+    if (options.sidCacheEnabled && !sids.Save(options.sidCache)) {
+        LogFormat(log, LogLevel::Warning, "Cache SID non enregistré : %s", options.sidCache.u8string().c_str());
+    }
+
+    if (!written) {
+        LogFormat(log, LogLevel::Error, "Impossible d'écrire %s", options.output.u8string().c_str());
+        return 1;
+    }
+
+    // Sortie écrite : les nouveautés émises peuvent être enregistrées (au pire réémises après un arrêt)
+    if (!options.snapshot.empty()) {
+        size_t advanced = snapshot.PendingRecords();
+        if (!snapshot.Commit()) {
+            LogFormat(log, LogLevel::Error, "Index non mis à jour : %s", snapshot.LastError().c_str());
+            return 1;
+        }
+        LogFormat(log, LogLevel::Info,
+                  "Index : %zu clés avancées, %zu clés SID inchangées, %zu entrées déjà connues", advanced,
+                  skippedKeys, skippedRows);
+        if (options.compact || snapshot.NeedsCompaction()) {
+            if (!snapshot.Compact()) {
+                LogFormat(log, LogLevel::Error, "Compaction de l'index impossible : %s",
+                          snapshot.LastError().c_str());
+                return 1;
+            }
+            LogFormat(log, LogLevel::Info, "Index compacté : %zu clés", snapshot.BaseCount());
+        }
+    }
+
+    const double mb = totalBytes / 1048576.0;
+    LogFormat(log, LogLevel::Info,
+              "Terminé : %zu ruches (%zu échecs), %zu entrées, %.1f Mo en %.3f s -> %.1f ruches/s, %.1f Mo/s, "
+              "%llu messages de journal perdus",
+              jobs.size(), failed, totalEntries, mb, elapsed, elapsed > 0 ? jobs.size() / elapsed : 0.0,
+              elapsed > 0 ? mb / elapsed : 0.0, static_cast<unsigned long long>(log.Dropped()));
+    if (options.carve) {
+        LogFormat(log, LogLevel::Info, "Carving : %zu valeurs supprimées récupérées (source recovered)",
+                  recoveredRows);
+    }
+    const double outMb = exporter.BytesWritten() / 1048576.0;
+    if (!interactive) {
+        LogFormat(log, LogLevel::Info,
+                  "Sortie : %s (%.1f Mo, parsing %.3f s, export terminé %.3f s plus tard, %.1f Mo/s écrits)",
+                  options.output.u8string().c_str(), outMb, parseElapsed, elapsed - parseElapsed,
+                  elapsed > 0 ? outMb / elapsed : 0.0);
+    }
+
+    if (!options.metrics.empty()) {
+        std::string error;
+        if (Telemetry::WriteFile(options.metrics, error)) {
+            LogFormat(log, LogLevel::Info, "Métriques : %s", options.metrics.u8string().c_str());
+        } else {
+            LogFormat(log, LogLevel::Warning, "Métriques non enregistrées : %s", error.c_str());
+        }
+    }
+    return failed == jobs.size() || !caseSaved || !rarityWritten ? 1 : 0;
+}
+
+}  // namespace
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t* argv[]) {
+    SetConsoleOutputCP(CP_UTF8);
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        int len = WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, nullptr, 0, nullptr, nullptr);
+        std::string arg(len > 0 ? len - 1 : 0, '\0');
+        if (len > 1) WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, &arg[0], len, nullptr, nullptr);
+        args.push_back(std::move(arg));
+    }
+    return RunBatch(args);
+}
+#else
+int main(int argc, char* argv[]) {
+    return RunBatch(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
@@ -0,0 +1,267 @@
+/*
+ * BamDamCarve - Implémentation de la récupération des valeurs BAM/DAM supprimées
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "BamDamCarve.h"
+
+#include "BamDamHive.h"
+#include "FileTimeFormat.h"
+#include "Telemetry.h"
+#include "VolumeMap.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BAMDAM_CARVE_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+constexpr uint32_t REGF_PAGE_SIZE = 4096;
+constexpr uint32_t HBIN_HEADER_SIZE = 32;
+constexpr uint32_t CARVE_DATA_MAX = 1024;  // Données BAM : FILETIME + quelques champs ; au-delà, autre chose
+
+// Nom d'une valeur BAM/DAM : chemin de volume, comparé sans casse
+constexpr std::string_view VOLUME_PREFIX = "\\Device\\HarddiskVolume";
+
+// FILETIME plausibles pour une exécution : du 01/01/2000 au 01/01/2100
+constexpr uint64_t DaysToFileTime(int64_t days) {
+    return static_cast<uint64_t>(days + FILETIME_EPOCH_DAYS) * 86400ULL * FILETIME_TICKS_PER_SECOND;
+}
+constexpr uint64_t CARVE_TIME_MIN = DaysToFileTime(CivilToDays(2000, 1, 1));
+constexpr uint64_t CARVE_TIME_MAX = DaysToFileTime(CivilToDays(2100, 1, 1));
+
+#ifdef BAMDAM_CARVE_SSE2
+inline unsigned CountTrailingZeros(uint32_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(bits));
+#endif
+}
+#endif
+
+bool SameName(const RegfName& a, const RegfName& b) {
+    const size_t length = a.Length();
+    if (b.Length() != length) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (a.At(i) != b.At(i)) return false;
+    }
+    return true;
+}
+
+class Carver {
+public:
+    Carver(const RegfHive& hive, const CarvedValueFn& fn, CarveStats& stats) : hive(hive), fn(fn), stats(stats) {}
+
+    bool Run() {
+        const uint64_t total = hive.HbinsSize();
+        uint64_t offset = 0;
+        while (offset < total) {
+            uint64_t available = 0;
+            const uint8_t* bin = hive.HbinData(static_cast<uint32_t>(offset), available);
+            if (!bin || available < REGF_PAGE_SIZE) break;
+
+            const uint32_t binOffset = static_cast<uint32_t>(offset);
+            const uint32_t size = RegfRead32(bin + 8);
+            if (std::memcmp(bin, "hbin", 4) == 0 && RegfRead32(bin + 4) == binOffset && size >= REGF_PAGE_SIZE &&
+                size % REGF_PAGE_SIZE == 0 && size <= available) {
+                if (!WalkCells(bin, binOffset, size)) return false;
+                offset += size;
+            } else {
+                // Page sans en-tête hbin valide (ruche tronquée, hbin écrasé) : fouillée entière
+                if (!Scan(bin, binOffset, 0, REGF_PAGE_SIZE)) return false;
+                offset += REGF_PAGE_SIZE;
+            }
+        }
+        return true;
+    }
+
+private:
+    // Cellules du hbin : seules les libres sont fouillées ; chaîne rompue → reste du hbin fouillé
+    bool WalkCells(const uint8_t* bin, uint32_t binOffset, uint32_t size) {
+        uint32_t pos = HBIN_HEADER_SIZE;
+        while (pos + 4 <= size) {
+            const int32_t raw = static_cast<int32_t>(RegfRead32(bin + pos));
+            const uint64_t cellSize = raw < 0 ? static_cast<uint64_t>(-static_cast<int64_t>(raw))
+                                              : static_cast<uint64_t>(raw);
+            if (cellSize < 8 || cellSize % 8 != 0 || cellSize > size - pos) return Scan(bin, binOffset, pos, size);
+            if (raw > 0) {
+                stats.freeCells++;
+                if (!Scan(bin, binOffset, pos, pos + static_cast<uint32_t>(cellSize))) return false;
+            }
+            pos += static_cast<uint32_t>(cellSize);
+        }
+        return true;
+    }
+
+    // [begin, end) relatifs au hbin, begin multiple de 8 : emplacements de cellule s, vk en s + 4,
+    // premier caractère du nom en s + 24
+    bool Scan(const uint8_t* bin, uint32_t binOffset, uint32_t begin, uint32_t end) {
+        stats.scannedBytes += end - begin;
+        uint32_t s = begin;
+#ifdef BAMDAM_CARVE_SSE2
+        // Mots de 16 bits 2 et 6 du bloc en s : "vk" des emplacements s et s + 8 ; octets 4 et 12 du bloc
+        // en s + 20 : premiers caractères de leurs noms. Bits 4 et 12 des deux masques, quatre emplacements
+        // par itération (deux blocs décalés de 16 octets).
+        const __m128i signature = _mm_set1_epi16(0x6B76);
+        const __m128i backslash = _mm_set1_epi8('\\');
+        for (; s + 52 <= end; s += 32) {
+            const uint8_t* p = bin + s;
+            const __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i w1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+            const __m128i n0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 20));
+            const __m128i n1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 36));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(w0, signature)) &
+                                                  _mm_movemask_epi8(_mm_cmpeq_epi8(n0, backslash)));
+            mask |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(w1, signature)) &
+                                          _mm_movemask_epi8(_mm_cmpeq_epi8(n1, backslash)))
+                    << 16;
+            mask &= 0x10101010u;
+            while (mask) {
+                const uint32_t slot = s + CountTrailingZeros(mask) - 4;
+                if (!Check(bin + slot + 4, end - (slot + 4), binOffset + slot)) return false;
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; s + 8 <= end; s += 8) {
+            const uint8_t* p = bin + s;
+            if (s + 24 < end && p[4] == 'v' && p[5] == 'k' && p[24] == '\\') {
+                if (!Check(p + 4, end - (s + 4), binOffset + s)) return false;
+            }
+        }
+        return true;
+    }
+
+    bool Check(const uint8_t* vk, uint64_t available, uint32_t cell) {
+        stats.candidates++;
+        RegfValue value;
+        if (!hive.ParseValueRecord(vk, available, value)) return true;
+        if (value.type != REGF_TYPE_BINARY || value.dataSize < 8 || value.dataSize > CARVE_DATA_MAX) return true;
+        if (RegfRead32(vk + 4) & 0x80000000u) return true;  // Résidente : 4 octets au plus
+        if (!value.name.compressed && value.name.byteLength % 2 != 0) return true;
+
+        const size_t length = value.name.Length();
+        if (length <= VOLUME_PREFIX.size()) return true;
+        RegfName prefix = value.name;
+        prefix.byteLength = static_cast<uint32_t>(VOLUME_PREFIX.size() * (prefix.compressed ? 1 : 2));
+        if (!prefix.EqualsNoCase(VOLUME_PREFIX)) return true;
+        for (size_t i = VOLUME_PREFIX.size(); i < length; i++) {
+            if (value.name.At(i) < 0x20) return true;
+        }
+
+        CarvedValue carved;
+        carved.path = value.name;
+        carved.cell = cell;
+        uint64_t fileTime = 0;
+        if (DecodeBamDamFileTime(value.type, value.data, value.dataSize, fileTime) && fileTime >= CARVE_TIME_MIN &&
+            fileTime < CARVE_TIME_MAX) {
+            carved.fileTime = fileTime;
+        } else {
+            // Cellule de données réallouée ou écrasée : le chemin reste une trace
+            carved.flags = ENTRY_FLAG_INVALID_DATA;
+            stats.invalidData++;
+        }
+        stats.recovered++;
+        return fn(carved);
+    }
+
+    const RegfHive& hive;
+    const CarvedValueFn& fn;
+    CarveStats& stats;
+};
+
+}  // namespace
+
+void CarveStats::Merge(const CarveStats& other) {
+    scannedBytes += other.scannedBytes;
+    freeCells += other.freeCells;
+    candidates += other.candidates;
+    recovered += other.recovered;
+    duplicates += other.duplicates;
+    invalidData += other.invalidData;
+}
+
+bool CarveBamDamValues(const RegfHive& hive, const CarvedValueFn& fn, CarveStats* stats) {
+    CarveStats local;
+    CarveStats& out = stats ? *stats : local;
+    const uint64_t scanned = out.scannedBytes;
+    ScopedSpan span(TelemetrySpan::HiveCarve);
+    const bool completed = Carver(hive, fn, out).Run();
+    span.AddItems(out.scannedBytes - scanned);
+    return completed;
+}
+
+size_t CarveBamDamHive(const RegfHive& hive, EntryStore& store, uint32_t hostId, const PathClassifier& classifier,
+                       CarveStats* stats) {
+    CarveStats local;
+    CarveStats& out = stats ? *stats : local;
+    const size_t before = store.size();
+
+    // Copies d'une même valeur (même chemin, même FILETIME) dans l'espace libre : une seule gardée
+    std::vector<CarvedValue> carved;
+    std::unordered_multimap<uint64_t, size_t> byTime;
+    CarveBamDamValues(hive, [&](const CarvedValue& value) {
+        const auto range = byTime.equal_range(value.fileTime);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (SameName(carved[it->second].path, value.path)) {
+                out.duplicates++;
+                return true;
+            }
+        }
+        byTime.emplace(value.fileTime, carved.size());
+        carved.push_back(value);
+        return true;
+    }, &out);
+    if (carved.empty()) return 0;
+
+    // Valeurs encore vivantes : une vk libérée puis réécrite ailleurs (valeur mise à jour) n'est pas une
+    // suppression. Seuls les FILETIME récupérés sont comparés, sans copier les noms ; les chemins
+    // \Windows\System32\ vivants ancrent le volume système comme dans ParseBamDamHive.
+    std::vector<uint8_t> live(carved.size(), 0);
+    std::vector<std::u16string> systemPaths;
+    std::u16string path;
+    WalkBamDam(hive, [&](EntrySource, const RegfName&, const RegfValue& value) {
+        uint64_t fileTime = 0;
+        if (!DecodeBamDamFileTime(value.type, value.data, value.dataSize, fileTime)) fileTime = 0;
+        const auto range = byTime.equal_range(fileTime);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (SameName(carved[it->second].path, value.name)) live[it->second] = 1;
+        }
+        path.clear();
+        value.name.AppendTo(path);
+        if (!VolumeMap::SystemDevice(path).empty()) systemPaths.push_back(path);
+        return true;
+    });
+
+    const uint32_t sidId = store.sids.Intern(std::u16string_view());
+    const uint32_t userId = store.users.Intern(u"<Inconnu>");
+    for (size_t i = 0; i < carved.size(); i++) {
+        if (live[i]) {
+            out.duplicates++;
+            continue;
+        }
+        store.Add(hostId, sidId, userId, store.paths.Intern(carved[i].path), carved[i].fileTime,
+                  EntrySource::Recovered, ENTRY_NO_MATCH, carved[i].flags);
+    }
+
+    VolumeMap volumes;
+    volumes.Load(hive);
+    volumes.AnchorSystemVolume(std::vector<std::u16string_view>(systemPaths.begin(), systemPaths.end()));
+    ResolveRowPaths(store, before, volumes, classifier);
+    return store.size() - before;
+}
@@ -0,0 +1,65 @@
+/*
+ * BamDamCarve - Récupération des valeurs BAM/DAM supprimées dans l'espace libre d'une ruche
+ *
+ * Le parcours normal (RegEnumValueW, ParseBamDamHive) ne voit que les valeurs vivantes. Une entrée BAM
+ * purgée (exécutable disparu, nettoyage volontaire) laisse souvent sa cellule vk et sa cellule de
+ * données intactes dans l'espace libre : c'est précisément la trace qu'un attaquant cherche à effacer.
+ *
+ * - Parcours séquentiel des hbin de la ruche projetée (journaux appliqués) : cellules libres, et reste
+ *   d'un hbin dont la chaîne de cellules est rompue ; une page sans en-tête hbin valide est fouillée entière
+ * - Recherche de signature vectorisée (SSE2, scalaire ailleurs) : une cellule commence sur 8 octets, la
+ *   signature "vk" est donc 4 octets après un multiple de 8 ; deux emplacements par itération, le
+ *   premier caractère du nom ('\') testé dans le même masque
+ * - Validation peu coûteuse : nom \Device\HarddiskVolume... (casse ignorée, sans caractère de contrôle),
+ *   REG_BINARY non résidente de 8 à 1024 octets ; la cellule de données (libre ou réallouée) doit
+ *   contenir un FILETIME plausible (2000-2100), sinon ligne "Données invalides"
+ * - Doublons écartés : valeur encore vivante (même chemin, même FILETIME) ou copie déjà récupérée
+ * - Lignes étiquetées EntrySource::Recovered ; la clé SID d'origine est perdue (SID vide, "<Inconnu>")
+ *
+ * Débit : la recherche lit chaque octet une fois, au rythme de la lecture séquentielle ; seuls les
+ * candidats (rares) sont décodés.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+#include "PathRules.h"
+#include "RegfHive.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+struct CarveStats {
+    uint64_t scannedBytes = 0;  // Cellules libres et zones hors chaîne fouillées
+    uint64_t freeCells = 0;
+    uint64_t candidates = 0;  // Signatures vk trouvées
+    uint64_t recovered = 0;  // Valeurs BAM/DAM validées (doublons compris)
+    uint64_t duplicates = 0;  // Encore vivantes ou déjà récupérées (CarveBamDamHive)
+    uint64_t invalidData = 0;  // Récupérées sans FILETIME plausible
+
+    void Merge(const CarveStats& other);
+};
+
+// Une valeur récupérée, vue sur la ruche projetée
+struct CarvedValue {
+    RegfName path;
+    uint64_t fileTime = 0;  // 0 si données invalides
+    uint8_t flags = 0;  // ENTRY_FLAG_INVALID_DATA
+    uint32_t cell = REGF_NO_CELL;  // Offset de la vk (relatif aux hbin, comme une cellule)
+};
+
+// fn(const CarvedValue& value) -> bool (false = arrêt) ; ordre des offsets croissants
+using CarvedValueFn = std::function<bool(const CarvedValue& value)>;
+
+// Toutes les vk BAM/DAM de l'espace libre, sans dédoublonnage ; false si fn a demandé l'arrêt
+bool CarveBamDamValues(const RegfHive& hive, const CarvedValueFn& fn, CarveStats* stats = nullptr);
+
+// Ajoute au store les valeurs récupérées, étiquetées avec hostId, hors doublons ; chemins normalisés
+// (MountedDevices, volume système ancré sur les valeurs vivantes d'abord) et classés comme ParseBamDamHive.
+// Retourne le nombre de lignes ajoutées.
+size_t CarveBamDamHive(const RegfHive& hive, EntryStore& store, uint32_t hostId,
+                       const PathClassifier& classifier = PathClassifier::Default(), CarveStats* stats = nullptr);
@@ -6,10 +6,16 @@
  * - Registry : HKLM\SYSTEM\CurrentControlSet\Services\bam\State\UserSettings\{SID}
  * - Registry : HKLM\SYSTEM\CurrentControlSet\Services\dam\State\UserSettings\{SID}
  * - Parse valeurs : nom = chemin exécutable, data = FILETIME (8 bytes)
- * - Conversion FILETIME → timestamp lisible (précision microsecondes)
+ * - Conversion FILETIME → timestamp lisible (précision microsecondes), formatée à l'affichage seulement
  * - Association SID → username via LookupAccountSid
+ * - Mode hors-ligne : ruche SYSTEM collectée (regf projeté en mémoire, Select\Current)
+ * - Hors-ligne : valeurs supprimées récupérées dans les cellules libres (source "recovered")
  * - Timeline ultra-précise dernières exécutions
+ * - Tri par clic sur les colonnes (Maj+clic : clé secondaire), par permutation sans déplacer les lignes
  * - Export CSV UTF-8 avec logging complet
+ * - Cas BamDam (.bdcase) : résultats enregistrés puis rouverts par projection, sans re-parsing
+ * - Journal asynchrone (écriture sur un thread dédié) et durées par étape dans
+ *   BamDamForensics.metrics.json après chaque parsing (voir Telemetry.h)
  *
  * APIs : advapi32.lib, comctl32.lib
  * Auteur : WinToolsSuite
@@ -28,11 +34,21 @@
 #include <sddl.h>
 #include <vector>
 #include <string>
-#include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <map>
+#include <cstdlib>
+
+#include "BamDamCarve.h"
+#include "BamDamHive.h"
+#include "CaseFile.h"
+#include "EntryExport.h"
+#include "EntrySort.h"
+#include "SidResolver.h"
+#include "Telemetry.h"
+#include "VolumeMap.h"
 
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "shlwapi.lib")
@@ -53,17 +69,18 @@ constexpr int IDC_BTN_SORT = 1003;
 constexpr int IDC_BTN_FILTER = 1004;
 constexpr int IDC_BTN_EXPORT = 1005;
 constexpr int IDC_STATUS = 1006;
+constexpr int IDC_BTN_OPENHIVE = 1007;
+constexpr int IDC_BTN_OPENCASE = 1008;
+constexpr int IDC_BTN_SAVECASE = 1009;
 
-// Structure d'entrée BAM/DAM
-struct BamDamEntry {
-    std::wstring timestamp;
-    std::wstring sid;
-    std::wstring username;
-    std::wstring executablePath;
-    std::wstring source;  // "BAM" ou "DAM"
-    std::wstring notes;
-    ULONGLONG fileTimeRaw;
-};
+// wchar_t et char16_t partagent la même représentation UTF-16 sous Windows
+inline std::u16string_view AsU16(const wchar_t* text, size_t length) {
+    return { reinterpret_cast<const char16_t*>(text), length };
+}
+
+inline const wchar_t* AsWide(const char16_t* text) {
+    return reinterpret_cast<const wchar_t*>(text);
+}
 
 // RAII pour clé registry
 class RegKey {
@@ -79,20 +96,33 @@ public:
 class BamDamForensics {
 private:
     HWND hwndMain, hwndList, hwndStatus;
-    std::vector<BamDamEntry> entries;
-    std::wofstream logFile;
+    CaseFile caseFile;  // Cas ouvert : entries y est adossé (déclaré avant, détruit après)
+    EntryStore entries;
+    EntrySorter sorter;
+    std::vector<SortField> sortFields;
+    std::vector<uint32_t> displayOrder;  // Ligne du store affichée à chaque position ; vide : ordre du store
+    AsyncLogger logger;
     HANDLE hWorkerThread;
     volatile bool stopProcessing;
+    std::wstring hivePath;  // Vide : registre live ; sinon ruche SYSTEM hors-ligne
+    TimeFormat displayFormat;  // UTC, microsecondes
+    wchar_t timestampBuffer[FILETIME_TEXT_MAX];
+    SidCache sidCache;            // Partagé live / hors-ligne, persisté à côté du journal
+    std::wstring sidCachePath;
+    std::wstring metricsPath;
+    PathClassifier pathRules;     // BamDamRules.txt à côté de l'exécutable, sinon jeu par défaut
+    VolumeMap volumes;            // Live : \Device\HarddiskVolumeN → lettre, d'après QueryDosDeviceW
+    std::u16string normalizedPath;
+
+    // Copie dans l'anneau du journal ; horodatage et écriture sur le thread de vidage
+    void Log(const std::wstring& message, LogLevel level = LogLevel::Info) {
+        logger.Log(level, AsU16(message.c_str(), message.size()));
+    }
 
-    void Log(const std::wstring& message) {
-        if (logFile.is_open()) {
-            SYSTEMTIME st;
-            GetLocalTime(&st);
-            wchar_t timeStr[64];
-            swprintf_s(timeStr, L"[%02d/%02d/%04d %02d:%02d:%02d] ",
-                      st.wDay, st.wMonth, st.wYear, st.wHour, st.wMinute, st.wSecond);
-            logFile << timeStr << message << std::endl;
-            logFile.flush();
+    void SaveMetrics() {
+        std::string error;
+        if (!Telemetry::WriteFile(metricsPath, error)) {
+            Log(L"Métriques non enregistrées : " + ToWide(Utf8ToU16(error)), LogLevel::Warning);
         }
     }
 
@@ -101,26 +131,18 @@ private:
         Log(text);
     }
 
-    std::wstring FileTimeToStringPrecise(ULONGLONG fileTime) {
-        if (fileTime == 0) {
-            return L"N/A";
+    // Bien connu, puis cache (ruches hors-ligne, exécutions précédentes), puis LookupAccountSidW
+    std::wstring SidToUsername(const std::wstring& sidString) {
+        std::u16string_view sid = AsU16(sidString.c_str(), sidString.size());
+        std::u16string known;
+        if (WellKnownSidName(sid, known)) {
+            return AsWide(known.c_str());
         }
-
-        FILETIME ft;
-        ft.dwLowDateTime = static_cast<DWORD>(fileTime & 0xFFFFFFFF);
-        ft.dwHighDateTime = static_cast<DWORD>(fileTime >> 32);
-
-        SYSTEMTIME st;
-        if (FileTimeToSystemTime(&ft, &st)) {
-            wchar_t buf[128];
-            swprintf_s(buf, L"%02d/%02d/%04d %02d:%02d:%02d.%03d",
-                      st.wDay, st.wMonth, st.wYear, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
-            return buf;
+        std::u16string_view cached;
+        if (sidCache.Find(sid, cached)) {
+            return std::wstring(cached.begin(), cached.end());
         }
-        return L"Invalide";
-    }
 
-    std::wstring SidToUsername(const std::wstring& sidString) {
         PSID pSid = nullptr;
         if (!ConvertStringSidToSidW(sidString.c_str(), &pSid)) {
             return L"<SID inconnu>";
@@ -134,17 +156,16 @@ private:
 
         if (LookupAccountSidW(nullptr, pSid, name, &nameSize, domain, &domainSize, &sidType)) {
             LocalFree(pSid);
-            if (wcslen(domain) > 0) {
-                return std::wstring(domain) + L"\\" + name;
-            }
-            return name;
+            std::wstring account = wcslen(domain) > 0 ? std::wstring(domain) + L"\\" + name : std::wstring(name);
+            sidCache.Insert(sid, AsU16(account.c_str(), account.size()), SidOrigin::Live);
+            return account;
         }
 
         LocalFree(pSid);
         return L"<Inconnu>";
     }
 
-    bool ParseBamDamKey(const wchar_t* service, const wchar_t* sid) {
+    bool ParseBamDamKey(const wchar_t* service, EntrySource source, const wchar_t* sid, uint32_t hostId) {
         wchar_t subkey[512];
         swprintf_s(subkey, L"SYSTEM\\CurrentControlSet\\Services\\%s\\State\\UserSettings\\%s", service, sid);
 
@@ -156,7 +177,13 @@ private:
         RegKey key(hKey);
 
         // Résolution SID → Username une seule fois
-        std::wstring username = SidToUsername(sid);
+        std::wstring username;
+        {
+            ScopedSpan resolution(TelemetrySpan::SidResolution, 1);
+            username = SidToUsername(sid);
+        }
+        uint32_t sidId = entries.sids.Intern(AsU16(sid, wcslen(sid)));
+        uint32_t userId = entries.users.Intern(AsU16(username.c_str(), username.size()));
 
         DWORD index = 0;
         wchar_t valueName[16384];
@@ -166,6 +193,7 @@ private:
         DWORD type;
 
         int count = 0;
+        ScopedSpan decode(TelemetrySpan::ValueDecode);
 
         while (true) {
             valueNameSize = 16384;
@@ -188,42 +216,67 @@ private:
                 continue;
             }
 
-            BamDamEntry entry;
-            entry.sid = sid;
-            entry.username = username;
-            entry.executablePath = valueName;
-            entry.source = service;
+            uint32_t pathId = entries.paths.Intern(AsU16(valueName, valueNameSize));
 
             // Parse FILETIME (8 bytes)
-            if (dataSize >= 8 && type == REG_BINARY) {
-                entry.fileTimeRaw = *reinterpret_cast<ULONGLONG*>(data);
-                entry.timestamp = FileTimeToStringPrecise(entry.fileTimeRaw);
-            } else {
-                entry.fileTimeRaw = 0;
-                entry.timestamp = L"Données invalides";
+            uint64_t fileTime = 0;
+            uint8_t flags = 0;
+            if (!DecodeBamDamFileTime(type, data, dataSize, fileTime)) {
+                fileTime = 0;
+                flags |= ENTRY_FLAG_INVALID_DATA;
+                Telemetry::Add(TelemetryCounter::InvalidValues);
             }
 
-            // Notes : ajouter des observations
-            if (entry.executablePath.find(L"\\Temp\\") != std::wstring::npos ||
-                entry.executablePath.find(L"\\Downloads\\") != std::wstring::npos) {
-                entry.notes = L"Emplacement suspect";
-            } else {
-                entry.notes = L"";
+            // Forme avec lettre de lecteur ; les règles voient les deux formes
+            uint32_t normalizedId = ENTRY_SAME_PATH;
+            std::u16string_view alternate;
+            if (volumes.Normalize(entries.paths.View(pathId), normalizedPath)) {
+                normalizedId = entries.paths.Intern(normalizedPath);
+                alternate = normalizedPath;
             }
 
-            entries.push_back(entry);
+            // Notes : règles de classification
+            uint32_t match = pathRules.Classify(entries.paths.View(pathId), alternate, entries.matches);
+
+            entries.Add(hostId, sidId, userId, pathId, fileTime, source, match, flags, normalizedId);
             count++;
             index++;
         }
+        decode.SetItems(count);
 
         return count > 0;
     }
 
+    // Correspondance exacte des volumes montés ; les cibles réseau (\Device\LanmanRedirector\;Z:...)
+    // ne désignent pas un volume entier et sont ignorées
+    void LoadLiveVolumes() {
+        volumes.Clear();
+        wchar_t drive[] = L"A:";
+        wchar_t target[MAX_PATH];
+        for (wchar_t letter = L'A'; letter <= L'Z'; letter++) {
+            drive[0] = letter;
+            const DWORD length = QueryDosDeviceW(drive, target, MAX_PATH);
+            if (length == 0) continue;
+            std::u16string_view device;
+            std::u16string_view rest;
+            if (VolumeMap::SplitDevicePath(AsU16(target, wcslen(target)), device, rest) && rest.empty()) {
+                volumes.Add(device, AsU16(drive, 2));
+            }
+        }
+    }
+
     bool ParseBamDam() {
-        entries.clear();
+        entries.Clear();
+        LoadLiveVolumes();
+
+        wchar_t computerName[MAX_COMPUTERNAME_LENGTH + 1] = {};
+        DWORD computerNameSize = MAX_COMPUTERNAME_LENGTH + 1;
+        GetComputerNameW(computerName, &computerNameSize);
+        uint32_t hostId = entries.hosts.Intern(AsU16(computerName, computerNameSize));
 
         // Énumérer tous les SIDs dans BAM et DAM
         const wchar_t* services[] = { L"bam", L"dam" };
+        ScopedSpan enumeration(TelemetrySpan::KeyEnumeration);
 
         for (int svcIdx = 0; svcIdx < 2; svcIdx++) {
             const wchar_t* service = services[svcIdx];
@@ -258,7 +311,8 @@ private:
                 }
 
                 // Parser ce SID
-                ParseBamDamKey(service, sidName);
+                enumeration.AddItems(1);
+                ParseBamDamKey(service, BAMDAM_SOURCES[svcIdx], sidName, hostId);
 
                 index++;
             }
@@ -268,23 +322,81 @@ private:
         return !entries.empty();
     }
 
-    void PopulateListView() {
-        ListView_DeleteAllItems(hwndList);
+    bool ParseBamDamOffline() {
+        entries.Clear();
 
-        for (size_t i = 0; i < entries.size(); i++) {
-            LVITEMW lvi = {};
-            lvi.mask = LVIF_TEXT;
-            lvi.iItem = static_cast<int>(i);
+        RegfHive hive;
+        if (!hive.Open(hivePath)) {
+            UpdateStatus(L"Ouverture ruche impossible : " + hivePath);
+            return false;
+        }
+        if (hive.LogEntriesApplied()) {
+            Log(L"Ruche non consolidée : " + std::to_wstring(hive.LogEntriesApplied()) + L" entrées de journal (" +
+                std::to_wstring(hive.LogPagesApplied()) + L" pages) appliquées en mémoire");
+        } else if (hive.IsDirty()) {
+            Log(L"Ruche non consolidée (séquences différentes), journaux .LOG1/.LOG2 absents : " + hivePath);
+        }
+        int32_t utcOffset = 0;
+        if (ReadHiveUtcOffset(hive, utcOffset)) {
+            Log(L"Fuseau de la machine : UTC" + std::wstring(utcOffset < 0 ? L"-" : L"+") +
+                std::to_wstring(std::abs(utcOffset) / 60) + L"h" + std::to_wstring(std::abs(utcOffset) % 60) +
+                L" (affichage en UTC)");
+        }
 
-            lvi.iSubItem = 0;
-            lvi.pszText = const_cast<LPWSTR>(entries[i].timestamp.c_str());
-            ListView_InsertItem(hwndList, &lvi);
+        // Comptes de la même machine : SOFTWARE (ProfileList) et SAM du même dossier config
+        std::u16string computerName;
+        ReadHiveComputerName(hive, computerName);
+        size_t accounts = sidCache.ImportHostHives(std::filesystem::path(hivePath).parent_path(), computerName);
+        Log(L"Comptes lus dans SOFTWARE/SAM : " + std::to_wstring(accounts));
+
+        // Hôte = nom de la machine, comme en mode batch (requêtes host:, cas enregistrés) ; chemin à défaut
+        uint32_t hostId = entries.hosts.Intern(computerName.empty() ? AsU16(hivePath.c_str(), hivePath.size())
+                                                                     : std::u16string_view(computerName));
+        ParseBamDamHive(hive, entries, hostId, [this](std::u16string_view sid) {
+            std::u16string known;
+            if (WellKnownSidName(sid, known)) return known;
+            std::u16string_view cached;
+            if (sidCache.Find(sid, cached)) return std::u16string(cached);
+            // Pas de LookupAccountSidW : le SID appartient à une autre machine
+            return std::u16string(u"<Inconnu>");
+        }, pathRules);
+
+        // Valeurs supprimées encore présentes dans les cellules libres (hors-ligne seulement : le registre
+        // live n'expose que les valeurs vivantes)
+        CarveStats carve;
+        size_t recovered = CarveBamDamHive(hive, entries, hostId, pathRules, &carve);
+        Log(L"Valeurs récupérées dans l'espace libre : " + std::to_wstring(recovered) + L" (" +
+            std::to_wstring(carve.duplicates) + L" encore vivantes ou en double, " +
+            std::to_wstring(carve.scannedBytes / 1024) + L" Ko fouillés)");
+
+        UpdateStatus(L"Parsing hors-ligne terminé : " + std::to_wstring(entries.size()) + L" entrées trouvées");
+        return !entries.empty();
+    }
+
+    // ListView virtuelle (LVS_OWNERDATA) : seules les lignes visibles sont formatées
+    void PopulateListView() {
+        ListView_SetItemCountEx(hwndList, static_cast<int>(entries.size()), LVSICF_NOSCROLL);
+        InvalidateRect(hwndList, nullptr, TRUE);
+    }
 
-            ListView_SetItemText(hwndList, i, 1, const_cast<LPWSTR>(entries[i].sid.c_str()));
-            ListView_SetItemText(hwndList, i, 2, const_cast<LPWSTR>(entries[i].username.c_str()));
-            ListView_SetItemText(hwndList, i, 3, const_cast<LPWSTR>(entries[i].executablePath.c_str()));
-            ListView_SetItemText(hwndList, i, 4, const_cast<LPWSTR>(entries[i].source.c_str()));
-            ListView_SetItemText(hwndList, i, 5, const_cast<LPWSTR>(entries[i].notes.c_str()));
+    void OnGetDispInfo(NMLVDISPINFOW* info) {
+        LVITEMW& item = info->item;
+        if (!(item.mask & LVIF_TEXT) || item.iItem < 0 || static_cast<size_t>(item.iItem) >= entries.size()) {
+            return;
+        }
+
+        const size_t row = displayOrder.empty() ? static_cast<size_t>(item.iItem) : displayOrder[item.iItem];
+        switch (item.iSubItem) {
+            case 0:
+                FormatEntryTimestamp(entries.FileTime(row), entries.Flags(row), displayFormat, timestampBuffer);
+                item.pszText = timestampBuffer;
+                break;
+            case 1: item.pszText = const_cast<LPWSTR>(AsWide(entries.sids.CStr(entries.SidId(row)))); break;
+            case 2: item.pszText = const_cast<LPWSTR>(AsWide(entries.users.CStr(entries.UserId(row)))); break;
+            case 3: item.pszText = const_cast<LPWSTR>(AsWide(entries.paths.CStr(entries.NormalizedPathId(row)))); break;
+            case 4: item.pszText = const_cast<LPWSTR>(AsWide(SourceName(entries.Source(row)))); break;
+            case 5: item.pszText = const_cast<LPWSTR>(AsWide(entries.matches.NoteCStr(entries.MatchId(row)))); break;
+            case 6: item.pszText = const_cast<LPWSTR>(AsWide(entries.paths.CStr(entries.PathId(row)))); break;
         }
     }
 
@@ -293,22 +405,103 @@ private:
 
         pThis->UpdateStatus(L"Parsing BAM/DAM en cours...");
 
-        if (pThis->ParseBamDam()) {
+        bool found = pThis->hivePath.empty() ? pThis->ParseBamDam() : pThis->ParseBamDamOffline();
+        pThis->SaveMetrics();
+        if (found) {
             PostMessage(pThis->hwndMain, WM_USER + 1, 0, 0);
         } else {
             pThis->UpdateStatus(L"Aucune donnée BAM/DAM trouvée");
+            PostMessage(pThis->hwndMain, WM_USER + 1, 0, 0);
         }
 
         return 0;
     }
 
     void OnParse() {
+        hivePath.clear();
+        StartWorker();
+    }
+
+    void OnOpenHive() {
+        OPENFILENAMEW ofn = {};
+        wchar_t fileName[MAX_PATH] = L"SYSTEM";
+
+        ofn.lStructSize = sizeof(OPENFILENAMEW);
+        ofn.hwndOwner = hwndMain;
+        ofn.lpstrFilter = L"Ruche SYSTEM\0SYSTEM*\0All Files (*.*)\0*.*\0";
+        ofn.lpstrFile = fileName;
+        ofn.nMaxFile = MAX_PATH;
+        ofn.lpstrTitle = L"Ouvrir une ruche SYSTEM";
+        ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+
+        if (GetOpenFileNameW(&ofn)) {
+            hivePath = fileName;
+            Log(L"Ruche hors-ligne : " + hivePath);
+            StartWorker();
+        }
+    }
+
+    void StartWorker() {
+        if (hWorkerThread) {
+            return;
+        }
+        // La ListView lit directement le store : la vider avant que le worker ne le modifie
+        ListView_SetItemCountEx(hwndList, 0, 0);
+        ResetSort();
+        entries.Clear();
+        caseFile.Close();
         stopProcessing = false;
         hWorkerThread = CreateThread(nullptr, 0, ParseThreadProc, this, 0, nullptr);
 
         if (hWorkerThread) {
             EnableWindow(GetDlgItem(hwndMain, IDC_BTN_PARSE), FALSE);
+            EnableWindow(GetDlgItem(hwndMain, IDC_BTN_OPENHIVE), FALSE);
+        }
+    }
+
+    void ResetSort() {
+        sorter.Reset();
+        sortFields.clear();
+        displayOrder.clear();
+    }
+
+    // Ordre affiché recopié dans le store (export, enregistrement du cas) ; l'affichage reste identique
+    void ApplyDisplayOrder() {
+        if (displayOrder.empty()) {
+            return;
         }
+        entries.Permute(displayOrder);
+        displayOrder.clear();
+    }
+
+    void ApplySort() {
+        const auto t0 = std::chrono::steady_clock::now();
+        sorter.Sort(entries, sortFields, displayOrder);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        PopulateListView();
+
+        std::wstring keys;
+        for (const SortField& field : sortFields) {
+            if (!keys.empty()) keys += L", ";
+            keys += SortColumnName(field.key);
+            keys += field.descending ? L" ↓" : L" ↑";
+        }
+        UpdateStatus(L"Trié par " + keys + L" (" + std::to_wstring(entries.size()) + L" lignes en " +
+                     std::to_wstring(static_cast<int>(ms)) + L" ms)");
+    }
+
+    static const wchar_t* SortColumnName(SortKey key) {
+        switch (key) {
+            case SortKey::Host: return L"Hôte";
+            case SortKey::Sid: return L"SID";
+            case SortKey::User: return L"Username";
+            case SortKey::Path: return L"Chemin Exec";
+            case SortKey::RawPath: return L"Chemin brut";
+            case SortKey::Time: return L"Timestamp";
+            case SortKey::FirstSeen: return L"Première observation";
+            case SortKey::Source: return L"Source";
+        }
+        return L"?";
     }
 
     void OnSort() {
@@ -316,17 +509,51 @@ private:
             MessageBoxW(hwndMain, L"Aucune donnée à trier", L"Information", MB_ICONINFORMATION);
             return;
         }
+        if (hWorkerThread) {
+            return;
+        }
 
         // Trier par timestamp (plus récent en premier)
-        std::sort(entries.begin(), entries.end(), [](const BamDamEntry& a, const BamDamEntry& b) {
-            return a.fileTimeRaw > b.fileTimeRaw;
-        });
-
-        PopulateListView();
-        UpdateStatus(L"Trié par date (plus récent en premier)");
+        sortFields.assign(1, SortField{ SortKey::Time, true });
+        ApplySort();
         Log(L"Tri chronologique effectué");
     }
 
+    // Colonne de la ListView → clé de tri ; false pour Notes
+    static bool ColumnSortKey(int column, SortKey& key) {
+        switch (column) {
+            case 0: key = SortKey::Time; return true;
+            case 1: key = SortKey::Sid; return true;
+            case 2: key = SortKey::User; return true;
+            case 3: key = SortKey::Path; return true;
+            case 4: key = SortKey::Source; return true;
+            case 6: key = SortKey::RawPath; return true;
+        }
+        return false;
+    }
+
+    // Clic : tri sur la colonne, sens inversé si elle est déjà la clé principale ; Maj+clic : clé ajoutée
+    // (ou son sens inversé) derrière les clés courantes
+    void OnColumnClick(int column) {
+        SortKey key;
+        if (entries.empty() || hWorkerThread || !ColumnSortKey(column, key)) {
+            return;
+        }
+        const bool secondary = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
+        const auto it = std::find_if(sortFields.begin(), sortFields.end(),
+                                     [key](const SortField& field) { return field.key == key; });
+        if (secondary && it != sortFields.end()) {
+            it->descending = !it->descending;
+        } else if (secondary) {
+            sortFields.push_back(SortField{ key, key == SortKey::Time });
+        } else if (it == sortFields.begin() && it != sortFields.end()) {
+            sortFields.assign(1, SortField{ key, !it->descending });
+        } else {
+            sortFields.assign(1, SortField{ key, key == SortKey::Time });  // Date : plus récent en premier
+        }
+        ApplySort();
+    }
+
     void OnFilter() {
         if (entries.empty()) {
             MessageBoxW(hwndMain, L"Parsez d'abord BAM/DAM", L"Information", MB_ICONINFORMATION);
@@ -334,10 +561,16 @@ private:
         }
 
         // Filtrer par utilisateur (simple démo : compter par user)
-        std::map<std::wstring, int> userCounts;
+        std::vector<int> countsById(entries.users.Count(), 0);
+        for (size_t i = 0; i < entries.size(); i++) {
+            countsById[entries.UserId(i)]++;
+        }
 
-        for (const auto& entry : entries) {
-            userCounts[entry.username]++;
+        std::map<std::wstring, int> userCounts;
+        for (uint32_t id = 0; id < countsById.size(); id++) {
+            if (countsById[id] > 0) {
+                userCounts[AsWide(entries.users.CStr(id))] = countsById[id];
+            }
         }
 
         std::wstringstream report;
@@ -362,7 +595,7 @@ private:
 
         ofn.lStructSize = sizeof(OPENFILENAMEW);
         ofn.hwndOwner = hwndMain;
-        ofn.lpstrFilter = L"CSV Files (*.csv)\0*.csv\0All Files (*.*)\0*.*\0";
+        ofn.lpstrFilter = L"CSV (*.csv)\0*.csv\0JSON Lines (*.jsonl)\0*.jsonl\0Colonnes BDCOL (*.bdcol)\0*.bdcol\0";
         ofn.lpstrFile = fileName;
         ofn.nMaxFile = MAX_PATH;
         ofn.lpstrTitle = L"Exporter BAM/DAM";
@@ -370,31 +603,91 @@ private:
         ofn.lpstrDefExt = L"csv";
 
         if (GetSaveFileNameW(&ofn)) {
-            std::wofstream csv(fileName, std::ios::binary);
-            if (!csv.is_open()) {
-                MessageBoxW(hwndMain, L"Impossible de créer le fichier CSV", L"Erreur", MB_ICONERROR);
+            // Format choisi dans le filtre (1 = CSV, 2 = JSON Lines, 3 = BDCOL), sinon d'après l'extension
+            ExportFormat format = ExportFormatFromPath(fileName);
+            if (ofn.nFilterIndex == 2) format = ExportFormat::JsonLines;
+            else if (ofn.nFilterIndex == 3) format = ExportFormat::Columnar;
+
+            ExportPipeline exporter(format);
+            if (!exporter.Open(fileName)) {
+                MessageBoxW(hwndMain, L"Impossible de créer le fichier d'export", L"Erreur", MB_ICONERROR);
+                return;
+            }
+            ApplyDisplayOrder();
+            exporter.Write(entries, 0, entries.size(), displayFormat);
+            if (!exporter.Close()) {
+                MessageBoxW(hwndMain, L"Erreur d'écriture pendant l'export", L"Erreur", MB_ICONERROR);
                 return;
             }
 
-            // BOM UTF-8
-            unsigned char bom[] = { 0xEF, 0xBB, 0xBF };
-            csv.write(reinterpret_cast<wchar_t*>(bom), sizeof(bom) / sizeof(wchar_t));
+            UpdateStatus(L"Export réussi : " + std::wstring(fileName));
+            Log(L"Export : " + std::wstring(fileName) + L" (" + std::to_wstring(exporter.RowsWritten()) +
+                L" lignes, " + std::to_wstring(exporter.BytesWritten() / 1024) + L" Ko)");
+            MessageBoxW(hwndMain, L"Export réussi !", L"Succès", MB_ICONINFORMATION);
+        }
+    }
 
-            csv << L"Timestamp,SID,Username,CheminExec,Source,Notes\n";
+    void OnOpenCase() {
+        if (hWorkerThread) {
+            return;
+        }
+        OPENFILENAMEW ofn = {};
+        wchar_t fileName[MAX_PATH] = L"";
 
-            for (const auto& entry : entries) {
-                csv << L"\"" << entry.timestamp << L"\",\""
-                    << entry.sid << L"\",\""
-                    << entry.username << L"\",\""
-                    << entry.executablePath << L"\",\""
-                    << entry.source << L"\",\""
-                    << entry.notes << L"\"\n";
+        ofn.lStructSize = sizeof(OPENFILENAMEW);
+        ofn.hwndOwner = hwndMain;
+        ofn.lpstrFilter = L"Cas BamDam (*.bdcase)\0*.bdcase\0All Files (*.*)\0*.*\0";
+        ofn.lpstrFile = fileName;
+        ofn.nMaxFile = MAX_PATH;
+        ofn.lpstrTitle = L"Ouvrir un cas";
+        ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+
+        if (GetOpenFileNameW(&ofn)) {
+            ListView_SetItemCountEx(hwndList, 0, 0);
+            ResetSort();
+            entries.Clear();
+            const auto t0 = std::chrono::steady_clock::now();
+            if (!caseFile.Open(fileName, entries)) {
+                MessageBoxW(hwndMain, ToWide(Utf8ToU16(caseFile.LastError())).c_str(), L"Erreur", MB_ICONERROR);
+                Log(L"Échec d'ouverture du cas : " + std::wstring(fileName));
+                return;
             }
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            PopulateListView();
+            UpdateStatus(L"Cas ouvert : " + std::to_wstring(entries.size()) + L" entrées en " +
+                         std::to_wstring(static_cast<int>(ms)) + L" ms");
+            Log(L"Cas ouvert : " + std::wstring(fileName) + L" (" + std::to_wstring(entries.size()) + L" lignes)");
+        }
+    }
 
-            csv.close();
-            UpdateStatus(L"Export réussi : " + std::wstring(fileName));
-            Log(L"Export CSV : " + std::wstring(fileName));
-            MessageBoxW(hwndMain, L"Export CSV réussi !", L"Succès", MB_ICONINFORMATION);
+    void OnSaveCase() {
+        if (entries.empty()) {
+            MessageBoxW(hwndMain, L"Aucune donnée à enregistrer", L"Information", MB_ICONINFORMATION);
+            return;
+        }
+
+        OPENFILENAMEW ofn = {};
+        wchar_t fileName[MAX_PATH] = L"bamdamforensics.bdcase";
+
+        ofn.lStructSize = sizeof(OPENFILENAMEW);
+        ofn.hwndOwner = hwndMain;
+        ofn.lpstrFilter = L"Cas BamDam (*.bdcase)\0*.bdcase\0";
+        ofn.lpstrFile = fileName;
+        ofn.nMaxFile = MAX_PATH;
+        ofn.lpstrTitle = L"Enregistrer le cas";
+        ofn.Flags = OFN_OVERWRITEPROMPT;
+        ofn.lpstrDefExt = L"bdcase";
+
+        if (GetSaveFileNameW(&ofn)) {
+            // Le cas ouvert lui-même ne peut être remplacé tant qu'il est projeté (renommage refusé)
+            CaseFile out;
+            ApplyDisplayOrder();
+            if (!out.Save(fileName, entries)) {
+                MessageBoxW(hwndMain, ToWide(Utf8ToU16(out.LastError())).c_str(), L"Erreur", MB_ICONERROR);
+                return;
+            }
+            UpdateStatus(L"Cas enregistré : " + std::wstring(fileName));
+            Log(L"Cas enregistré : " + std::wstring(fileName) + L" (" + std::to_wstring(entries.size()) + L" lignes)");
         }
     }
 
@@ -416,9 +709,21 @@ private:
                      MARGIN + (BUTTON_WIDTH + 10) * 3, btnY, BUTTON_WIDTH, BUTTON_HEIGHT, hwnd,
                      (HMENU)IDC_BTN_EXPORT, nullptr, nullptr);
 
+        CreateWindowW(L"BUTTON", L"Ouvrir Ruche SYSTEM", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                     MARGIN + (BUTTON_WIDTH + 10) * 4, btnY, BUTTON_WIDTH, BUTTON_HEIGHT, hwnd,
+                     (HMENU)IDC_BTN_OPENHIVE, nullptr, nullptr);
+
+        CreateWindowW(L"BUTTON", L"Ouvrir Cas", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                     MARGIN + (BUTTON_WIDTH + 10) * 5, btnY, BUTTON_WIDTH, BUTTON_HEIGHT, hwnd,
+                     (HMENU)IDC_BTN_OPENCASE, nullptr, nullptr);
+
+        CreateWindowW(L"BUTTON", L"Enregistrer Cas", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                     MARGIN + (BUTTON_WIDTH + 10) * 6, btnY, BUTTON_WIDTH, BUTTON_HEIGHT, hwnd,
+                     (HMENU)IDC_BTN_SAVECASE, nullptr, nullptr);
+
         // ListView
         hwndList = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, L"",
-                                  WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL,
+                                  WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | LVS_OWNERDATA,
                                   MARGIN, btnY + BUTTON_HEIGHT + 10,
                                   WINDOW_WIDTH - MARGIN * 2 - 20,
                                   WINDOW_HEIGHT - btnY - BUTTON_HEIGHT - 80,
@@ -448,6 +753,9 @@ private:
         lvc.cx = 180; lvc.pszText = const_cast<LPWSTR>(L"Notes");
         ListView_InsertColumn(hwndList, 5, &lvc);
 
+        lvc.cx = 400; lvc.pszText = const_cast<LPWSTR>(L"Chemin brut");
+        ListView_InsertColumn(hwndList, 6, &lvc);
+
         // Status bar
         hwndStatus = CreateWindowExW(0, L"STATIC",
                                      L"Prêt - Cliquez sur 'Parser BAM/DAM' (nécessite admin)",
@@ -480,12 +788,26 @@ private:
                         case IDC_BTN_SORT: pThis->OnSort(); break;
                         case IDC_BTN_FILTER: pThis->OnFilter(); break;
                         case IDC_BTN_EXPORT: pThis->OnExport(); break;
+                        case IDC_BTN_OPENHIVE: pThis->OnOpenHive(); break;
+                        case IDC_BTN_OPENCASE: pThis->OnOpenCase(); break;
+                        case IDC_BTN_SAVECASE: pThis->OnSaveCase(); break;
                     }
                     return 0;
 
+                case WM_NOTIFY: {
+                    auto* header = reinterpret_cast<NMHDR*>(lParam);
+                    if (header->idFrom == IDC_LISTVIEW && header->code == LVN_GETDISPINFOW) {
+                        pThis->OnGetDispInfo(reinterpret_cast<NMLVDISPINFOW*>(lParam));
+                    } else if (header->idFrom == IDC_LISTVIEW && header->code == LVN_COLUMNCLICK) {
+                        pThis->OnColumnClick(reinterpret_cast<NMLISTVIEW*>(lParam)->iSubItem);
+                    }
+                    return 0;
+                }
+
                 case WM_USER + 1: // Parsing terminé
                     pThis->PopulateListView();
                     EnableWindow(GetDlgItem(hwnd, IDC_BTN_PARSE), TRUE);
+                    EnableWindow(GetDlgItem(hwnd, IDC_BTN_OPENHIVE), TRUE);
                     if (pThis->hWorkerThread) {
                         CloseHandle(pThis->hWorkerThread);
                         pThis->hWorkerThread = nullptr;
@@ -514,16 +836,42 @@ public:
         PathRemoveFileSpecW(logPath);
         PathAppendW(logPath, L"BamDamForensics.log");
 
-        logFile.open(logPath, std::ios::app);
-        logFile.imbue(std::locale(std::locale(), new std::codecvt_utf8<wchar_t>));
+        logger.Open(std::filesystem::path(logPath));
         Log(L"=== BamDamForensics démarré ===");
+
+        PathRemoveFileSpecW(logPath);
+        PathAppendW(logPath, L"BamDamForensics.metrics.json");
+        metricsPath = logPath;
+
+        PathRemoveFileSpecW(logPath);
+        PathAppendW(logPath, L"BamDamForensics.sids.tsv");
+        sidCachePath = logPath;
+        if (sidCache.Load(sidCachePath)) {
+            Log(L"Cache SID : " + std::to_wstring(sidCache.Count()) + L" comptes");
+        }
+
+        PathRemoveFileSpecW(logPath);
+        PathAppendW(logPath, L"BamDamRules.txt");
+        if (PathFileExistsW(logPath) && pathRules.LoadFile(logPath) && pathRules.Compile()) {
+            Log(L"Règles de classification : " + std::to_wstring(pathRules.RuleCount()));
+        } else {
+            if (PathFileExistsW(logPath)) {
+                Log(L"Règles ignorées (" + std::wstring(logPath) + L") : " + ToWide(Utf8ToU16(pathRules.LastError())),
+                    LogLevel::Warning);
+            }
+            pathRules = PathClassifier();
+            pathRules.AddDefaultRules();
+            pathRules.Compile();
+        }
     }
 
     ~BamDamForensics() {
-        Log(L"=== BamDamForensics terminé ===");
-        if (logFile.is_open()) {
-            logFile.close();
+        if (!sidCache.Save(sidCachePath)) {
+            Log(L"Cache SID non enregistré : " + sidCachePath, LogLevel::Warning);
         }
+        SaveMetrics();
+        Log(L"=== BamDamForensics terminé ===");
+        logger.Close();
     }
 
     int Run(HINSTANCE hInstance, int nCmdShow) {
@@ -0,0 +1,89 @@
+/*
+ * BamDamHive - Implémentation de l'extraction BAM/DAM hors-ligne
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "BamDamHive.h"
+
+#include "BamDamStream.h"
+#include "VolumeMap.h"
+
+#include <cstdint>
+#include <vector>
+
+std::wstring FileTimeToStringPrecise(uint64_t fileTime, const TimeFormat& format) {
+    wchar_t buf[FILETIME_TEXT_MAX];
+    size_t length = FormatFileTime(fileTime, format, buf);
+    return std::wstring(buf, length);
+}
+
+bool ReadHiveUtcOffset(const RegfHive& hive, int32_t& offsetMinutes) {
+    uint32_t timeZone = hive.OpenKey(hive.CurrentControlSet(), "Control\\TimeZoneInformation");
+    if (timeZone == REGF_NO_CELL) return false;
+
+    uint32_t bias = 0;
+    if (!hive.ReadDword(timeZone, "ActiveTimeBias", bias) && !hive.ReadDword(timeZone, "Bias", bias)) {
+        return false;
+    }
+    // Bias : UTC = local + bias (minutes, signé)
+    offsetMinutes = -static_cast<int32_t>(bias);
+    return true;
+}
+
+bool ReadHiveComputerName(const RegfHive& hive, std::u16string& name) {
+    uint32_t key = hive.OpenKey(hive.CurrentControlSet(), "Control\\ComputerName\\ComputerName");
+    return key != REGF_NO_CELL && hive.ReadString(key, "ComputerName", name) && !name.empty();
+}
+
+size_t ParseBamDamHive(const RegfHive& hive, EntryStore& store, uint32_t hostId,
+                       const SidResolveFn& resolveUser, const PathClassifier& classifier, BamDamFilter* filter) {
+    const size_t before = store.size();
+    BamDamRowAppender appender(hive, resolveUser, filter);
+    appender.Append(store, hostId, SIZE_MAX);
+
+    VolumeMap volumes;
+    volumes.Load(hive);
+    ResolveRowPaths(store, before, volumes, classifier);
+
+    return store.size() - before;
+}
+
+void ResolveRowPaths(EntryStore& store, size_t firstRow, VolumeMap& volumes, const PathClassifier& classifier,
+                     bool anchorVolumes) {
+    std::vector<uint32_t> pathMatch;  // pathId → id de combinaison, UINT32_MAX = chemin pas encore vu
+    std::vector<uint32_t> distinct;   // Chemins des lignes, dans l'ordre d'apparition
+    for (size_t row = firstRow; row < store.size(); row++) {
+        const uint32_t pathId = store.PathId(row);
+        if (pathId >= pathMatch.size()) pathMatch.resize(pathId + 1, UINT32_MAX);
+        if (pathMatch[pathId] == UINT32_MAX) {
+            pathMatch[pathId] = ENTRY_NO_MATCH;
+            distinct.push_back(pathId);
+        }
+    }
+
+    if (anchorVolumes) {
+        std::vector<std::u16string_view> rawPaths(distinct.size());
+        for (size_t i = 0; i < distinct.size(); i++) rawPaths[i] = store.paths.View(distinct[i]);
+        volumes.AnchorSystemVolume(rawPaths);
+    }
+
+    // Les règles voient la forme brute et la forme avec lettre de lecteur
+    std::vector<uint32_t> pathNormalized(pathMatch.size());
+    std::u16string normalized;
+    for (uint32_t pathId : distinct) {
+        uint32_t normalizedId = pathId;
+        if (volumes.Normalize(store.paths.View(pathId), normalized)) {
+            normalizedId = store.paths.Intern(normalized);
+        }
+        pathNormalized[pathId] = normalizedId;
+        pathMatch[pathId] = classifier.Classify(store.paths.View(pathId), store.paths.View(normalizedId),
+                                                store.matches);
+    }
+    for (size_t row = firstRow; row < store.size(); row++) {
+        const uint32_t pathId = store.PathId(row);
+        store.SetNormalizedPathId(row, pathNormalized[pathId]);
+        store.SetMatchId(row, pathMatch[pathId]);
+    }
+}
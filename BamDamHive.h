@@ -0,0 +1,138 @@
+/*
+ * BamDamHive - Extraction BAM/DAM depuis une ruche SYSTEM hors-ligne
+ *
+ * - ControlSet courant via Select\Current
+ * - Services\{bam,dam}\State\UserSettings\{SID}
+ * - Même sémantique que le parcours live (RegEnumValueW) : valeur "Version" ignorée,
+ *   FILETIME lu sur les 8 premiers octets d'une valeur REG_BINARY
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+#include "FileTimeFormat.h"
+#include "PathRules.h"
+#include "RegfHive.h"
+#include "VolumeMap.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Services parcourus, dans l'ordre du parcours live
+constexpr const char* BAMDAM_SERVICES_A[] = { "bam", "dam" };
+constexpr EntrySource BAMDAM_SOURCES[] = { EntrySource::Bam, EntrySource::Dam };
+
+// FILETIME → "JJ/MM/AAAA HH:MM:SS.ffffff" (UTC par défaut), "N/A" si nul, "Invalide" si hors plage.
+// Réservé à l'affichage ponctuel : les exports formatent directement dans leurs buffers.
+std::wstring FileTimeToStringPrecise(uint64_t fileTime, const TimeFormat& format = TimeFormat());
+
+// Texte de la colonne Timestamp d'une ligne du store
+inline std::wstring EntryTimestampText(uint64_t fileTime, uint8_t flags, const TimeFormat& format = TimeFormat()) {
+    return (flags & ENTRY_FLAG_INVALID_DATA) ? std::wstring(L"Données invalides")
+                                             : FileTimeToStringPrecise(fileTime, format);
+}
+
+// Écrit le texte Timestamp d'une ligne dans un buffer (FILETIME_TEXT_MAX), retourne sa longueur
+template <class Char>
+size_t FormatEntryTimestamp(uint64_t fileTime, uint8_t flags, const TimeFormat& format, Char* out) {
+    if (flags & ENTRY_FLAG_INVALID_DATA) {
+        size_t length = 0;
+        if constexpr (sizeof(Char) == 1) {
+            const char* text = "Donn\xC3\xA9" "es invalides";  // UTF-8
+            for (; text[length]; length++) out[length] = static_cast<Char>(text[length]);
+        } else {
+            const char16_t* text = u"Données invalides";
+            for (; text[length]; length++) out[length] = static_cast<Char>(text[length]);
+        }
+        out[length] = 0;
+        return length;
+    }
+    return FormatFileTime(fileTime, format, out);
+}
+
+// Valeur ignorée lors du parcours (présente mais non pertinente)
+inline bool IsIgnoredBamDamValue(const RegfName& name) { return name.Equals("Version"); }
+
+// FILETIME = 8 premiers octets d'une valeur REG_BINARY
+inline bool DecodeBamDamFileTime(uint32_t type, const uint8_t* data, uint32_t size, uint64_t& out) {
+    if (!data || size < 8 || type != REGF_TYPE_BINARY) return false;
+    out = RegfRead64(data);
+    return true;
+}
+
+// fn(EntrySource source, uint32_t sidKey, const RegfName& sid) -> bool (false = arrêt)
+template <class F>
+bool WalkBamDamKeys(const RegfHive& hive, F&& fn) {
+    uint32_t controlSet = hive.CurrentControlSet();
+    if (controlSet == REGF_NO_CELL) return false;
+
+    bool stopped = false;
+    for (size_t svcIdx = 0; svcIdx < 2 && !stopped; svcIdx++) {
+        std::string path = std::string("Services\\") + BAMDAM_SERVICES_A[svcIdx] + "\\State\\UserSettings";
+        uint32_t userSettings = hive.OpenKey(controlSet, path);
+        if (userSettings == REGF_NO_CELL) {
+            // BAM ou DAM peut ne pas exister (DAM seulement sur Desktop Windows 10)
+            continue;
+        }
+
+        hive.ForEachSubkey(userSettings, [&](uint32_t sidKey) {
+            RegfName sid;
+            if (!hive.KeyName(sidKey, sid)) return true;
+            if (!fn(BAMDAM_SOURCES[svcIdx], sidKey, sid)) stopped = true;
+            return !stopped;
+        });
+    }
+    return true;
+}
+
+// fn(EntrySource source, const RegfName& sid, const RegfValue& value) -> bool (false = arrêt)
+template <class F>
+bool WalkBamDam(const RegfHive& hive, F&& fn) {
+    return WalkBamDamKeys(hive, [&](EntrySource source, uint32_t sidKey, const RegfName& sid) {
+        bool keepGoing = true;
+        hive.ForEachValue(sidKey, [&](const RegfValue& value) {
+            if (IsIgnoredBamDamValue(value.name)) return true;
+            keepGoing = fn(source, sid, value);
+            return keepGoing;
+        });
+        return keepGoing;
+    });
+}
+
+// Décalage horaire local de la machine (minutes, local = UTC + offset), lu dans
+// ControlSet courant\Control\TimeZoneInformation (ActiveTimeBias, sinon Bias)
+bool ReadHiveUtcOffset(const RegfHive& hive, int32_t& offsetMinutes);
+
+// Nom NetBIOS de la machine (ControlSet courant\Control\ComputerName\ComputerName)
+bool ReadHiveComputerName(const RegfHive& hive, std::u16string& name);
+
+// Résolution SID → nom d'utilisateur (optionnelle, "<Inconnu>" par défaut)
+using SidResolveFn = std::function<std::u16string(std::u16string_view sid)>;
+
+// Collecte incrémentale (optionnelle) : clés SID inchangées sautées sans lire leurs valeurs,
+// lignes déjà connues écartées. Voir SnapshotIndex.
+class BamDamFilter {
+public:
+    virtual ~BamDamFilter() = default;
+    // false : la clé n'a pas changé depuis la dernière collecte
+    virtual bool VisitSidKey(EntrySource source, std::u16string_view sid, uint64_t lastWrite) = 0;
+    // false : (SID, chemin) déjà connu avec un FILETIME au moins aussi récent
+    virtual bool KeepRow(std::u16string_view sid, std::u16string_view path, uint64_t fileTime) = 0;
+};
+
+// Lignes [firstRow, size) : chaque chemin distinct est normalisé (volumes, ancrés sur ces chemins
+// sauf si anchorVolumes = false) et classé une seule fois, sur ses deux formes
+void ResolveRowPaths(EntryStore& store, size_t firstRow, VolumeMap& volumes, const PathClassifier& classifier,
+                     bool anchorVolumes = true);
+
+// Ajoute au store les valeurs BAM/DAM de la ruche, étiquetées avec hostId ; chaque chemin
+// distinct est normalisé (MountedDevices) et classé une seule fois. Retourne le nombre de lignes ajoutées.
+size_t ParseBamDamHive(const RegfHive& hive, EntryStore& store, uint32_t hostId,
+                       const SidResolveFn& resolveUser = nullptr,
+                       const PathClassifier& classifier = PathClassifier::Default(),
+                       BamDamFilter* filter = nullptr);
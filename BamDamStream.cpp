@@ -0,0 +1,171 @@
+/*
+ * BamDamStream - Implémentation du curseur BAM/DAM et de la livraison par blocs
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "BamDamStream.h"
+
+#include "Telemetry.h"
+#include "VolumeMap.h"
+
+#include <optional>
+#include <unordered_set>
+#include <utility>
+
+BamDamCursor::BamDamCursor(const RegfHive& hive) : hive(hive) {
+    WalkBamDamKeys(hive, [&](EntrySource source, uint32_t sidKey, const RegfName& sid) {
+        keys.push_back({ source, sidKey, sid });
+        return true;
+    });
+}
+
+void BamDamCursor::Reset() {
+    nextKey = 0;
+    current = nullptr;
+    valueList = nullptr;
+    valueCount = valueIndex = 0;
+}
+
+bool BamDamCursor::NextKey(BamDamKeyView& key) {
+    current = nullptr;
+    if (nextKey >= keys.size()) return false;
+    current = &keys[nextKey++];
+    // Liste de valeurs invalide : clé vide, comme ForEachValue
+    if (!hive.ValueList(current->cell, valueList, valueCount)) valueCount = 0;
+    valueIndex = 0;
+    key = *current;
+    return true;
+}
+
+bool BamDamCursor::NextInKey(BamDamEntryView& out) {
+    if (!current) return false;
+    while (valueIndex < valueCount) {
+        RegfValue value;
+        if (!hive.ValueAt(valueList, valueIndex++, value) || IsIgnoredBamDamValue(value.name)) continue;
+
+        out.source = current->source;
+        out.sidKey = current->cell;
+        out.sid = current->sid;
+        out.path = value.name;
+        out.flags = 0;
+        if (!DecodeBamDamFileTime(value.type, value.data, value.dataSize, out.fileTime)) {
+            out.fileTime = 0;
+            out.flags = ENTRY_FLAG_INVALID_DATA;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool BamDamCursor::Next(BamDamEntryView& out) {
+    BamDamKeyView key;
+    while (!NextInKey(out)) {
+        if (!NextKey(key)) return false;
+    }
+    return true;
+}
+
+BamDamRowAppender::BamDamRowAppender(const RegfHive& hive, const SidResolveFn& resolveUser, BamDamFilter* filter)
+    : hive(hive), cursor(hive), resolveUser(resolveUser), filter(filter) {}
+
+bool BamDamRowAppender::Append(EntryStore& store, uint32_t hostId, size_t maxRows) {
+    const size_t start = store.size();
+    // Identifiants de la clé courante dans ce store (internés à la première ligne gardée)
+    uint32_t sidId = UINT32_MAX;
+    uint32_t userId = UINT32_MAX;
+
+    ScopedSpan enumeration(TelemetrySpan::KeyEnumeration);
+    std::optional<ScopedSpan> decode;
+    if (inKey) decode.emplace(TelemetrySpan::ValueDecode);
+
+    while (store.size() - start < maxRows) {
+        if (!inKey) {
+            decode.reset();
+            if (!cursor.NextKey(key)) return false;
+            enumeration.AddItems(1);
+            sidText.clear();
+            key.sid.AppendTo(sidText);
+            if (filter && !filter->VisitSidKey(key.source, sidText, hive.KeyLastWrite(key.cell))) continue;
+
+            // Résolution SID → Username une seule fois par clé SID
+            if (resolveUser) {
+                ScopedSpan resolution(TelemetrySpan::SidResolution, 1);
+                userName = resolveUser(sidText);
+            } else {
+                userName = u"<Inconnu>";
+            }
+            sidId = userId = UINT32_MAX;
+            inKey = true;
+            decode.emplace(TelemetrySpan::ValueDecode);
+        }
+
+        BamDamEntryView entry;
+        if (!cursor.NextInKey(entry)) {
+            inKey = false;
+            continue;
+        }
+        decode->AddItems(1);
+        if (entry.flags & ENTRY_FLAG_INVALID_DATA) Telemetry::Add(TelemetryCounter::InvalidValues);
+        if (filter) {
+            pathText.clear();
+            entry.path.AppendTo(pathText);
+            if (!filter->KeepRow(sidText, pathText, entry.fileTime)) continue;
+        }
+
+        if (sidId == UINT32_MAX) {
+            sidId = store.sids.Intern(key.sid);
+            userId = store.users.Intern(userName);
+        }
+        const uint32_t pathId = store.paths.Intern(entry.path);
+        store.Add(hostId, sidId, userId, pathId, entry.fileTime, entry.source, ENTRY_NO_MATCH, entry.flags);
+    }
+    return true;
+}
+
+namespace {
+
+// Ancrage du volume système sur toute la ruche avant le premier bloc : un bloc sans chemin
+// \Windows\System32\ ne doit pas sortir avec des chemins \Device\ que le suivant aurait résolus.
+// Seuls les chemins de volume passant par System32 sont copiés (dédoublonnés, comme ResolveRowPaths).
+void AnchorFromCursor(const RegfHive& hive, VolumeMap& volumes) {
+    if (!volumes.SystemLetter()) return;
+
+    std::unordered_set<std::u16string> systemPaths;
+    std::u16string path;
+    BamDamCursor cursor(hive);
+    BamDamEntryView entry;
+    while (cursor.Next(entry)) {
+        path.clear();
+        entry.path.AppendTo(path);
+        if (!VolumeMap::SystemDevice(path).empty()) systemPaths.insert(path);
+    }
+    std::vector<std::u16string_view> views(systemPaths.begin(), systemPaths.end());
+    volumes.AnchorSystemVolume(views);
+}
+
+}  // namespace
+
+size_t StreamBamDamHive(const RegfHive& hive, std::u16string_view host, const EntryChunkFn& sink,
+                        const BamDamStreamOptions& options) {
+    const PathClassifier& classifier = options.classifier ? *options.classifier : PathClassifier::Default();
+    const size_t chunkRows = options.chunkRows ? options.chunkRows : 1;
+    VolumeMap volumes;
+    volumes.Load(hive);
+    AnchorFromCursor(hive, volumes);
+    BamDamRowAppender appender(hive, options.resolveUser, options.filter);
+
+    size_t rows = 0;
+    bool more = true;
+    while (more) {
+        auto chunk = std::make_unique<EntryStore>();
+        const uint32_t hostId = chunk->hosts.Intern(host);
+        more = appender.Append(*chunk, hostId, chunkRows);
+        if (chunk->size() == 0) continue;
+        ResolveRowPaths(*chunk, 0, volumes, classifier, false);
+        rows += chunk->size();
+        sink(std::move(chunk));
+    }
+    return rows;
+}
@@ -0,0 +1,143 @@
+/*
+ * BamDamStream - Parcours BAM/DAM en flux : curseur pull sur une ruche, blocs de lignes bornés
+ *
+ * ParseBamDamHive remplit un EntryStore avec toute la ruche avant que l'export, les filtres ou les
+ * agrégations ne commencent. Pour les consommateurs qui n'ont pas besoin de tout garder :
+ *
+ * - BamDamCursor : itérateur pull à deux niveaux (NextKey / NextInKey, ou Next, ou range-for).
+ *   Chaque entrée est une vue : SID et chemin = RegfName dans la ruche projetée, FILETIME brut.
+ *   Aucune allocation par entrée ; état = cellules des clés SID (quelques dizaines d'entiers),
+ *   indépendant du nombre de valeurs. Les vues restent valides tant que la ruche vit.
+ * - BamDamRowAppender : lignes du curseur vers des EntryStore successifs, mêmes règles que
+ *   ParseBamDamHive (valeur "Version" ignorée, données invalides marquées, SID résolu une fois par
+ *   clé, BamDamFilter appliqué) ; une clé SID entamée reprend dans le store suivant
+ * - StreamBamDamHive : EntryStore de chunkRows lignes au plus, chacun passé au consommateur dès qu'il
+ *   est plein (ExportPipeline::Submit bloque quand la file est pleine : mémoire bornée par
+ *   chunkRows × file d'export). Chemins normalisés et classés par bloc, table de volumes partagée ;
+ *   le volume système est ancré avant le premier bloc, par un premier passage du curseur sur les
+ *   chemins \Windows\System32\ de toute la ruche (filtre non appliqué).
+ *
+ * Pas de coroutines : le projet reste en C++17, le curseur garde son état explicitement.
+ * Un curseur par thread ; plusieurs curseurs peuvent lire la même ruche en parallèle.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "BamDamHive.h"
+#include "EntryStore.h"
+#include "PathRules.h"
+#include "RegfHive.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Clé Services\{bam,dam}\State\UserSettings\{SID}
+struct BamDamKeyView {
+    EntrySource source = EntrySource::Bam;
+    uint32_t cell = REGF_NO_CELL;
+    RegfName sid;
+};
+
+// Une valeur BAM/DAM, sans copie
+struct BamDamEntryView {
+    EntrySource source = EntrySource::Bam;
+    uint32_t sidKey = REGF_NO_CELL;
+    RegfName sid;
+    RegfName path;
+    uint64_t fileTime = 0;  // 0 si données invalides
+    uint8_t flags = 0;      // ENTRY_FLAG_INVALID_DATA
+};
+
+class BamDamCursor {
+public:
+    // Les clés SID sont relevées ici ; leurs valeurs ne sont lues qu'à la demande
+    explicit BamDamCursor(const RegfHive& hive);
+
+    // Passe à la clé SID suivante (les valeurs restantes de la clé courante sont abandonnées)
+    bool NextKey(BamDamKeyView& key);
+    // Valeur suivante de la clé courante ; false en fin de clé
+    bool NextInKey(BamDamEntryView& out);
+    // Les deux niveaux enchaînés ; false en fin de ruche
+    bool Next(BamDamEntryView& out);
+    // Retour avant la première clé
+    void Reset();
+
+    size_t KeyCount() const { return keys.size(); }
+
+    // for (const BamDamEntryView& entry : cursor) : itérateur d'entrée, un seul passage
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = BamDamEntryView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const BamDamEntryView*;
+        using reference = const BamDamEntryView&;
+
+        Iterator() = default;
+        explicit Iterator(BamDamCursor* cursor) : cursor(cursor) { ++*this; }
+        reference operator*() const { return entry; }
+        pointer operator->() const { return &entry; }
+        Iterator& operator++() {
+            if (cursor && !cursor->Next(entry)) cursor = nullptr;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return cursor == other.cursor; }
+        bool operator!=(const Iterator& other) const { return cursor != other.cursor; }
+
+    private:
+        BamDamCursor* cursor = nullptr;
+        BamDamEntryView entry;
+    };
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return Iterator(); }
+
+private:
+    const RegfHive& hive;
+    std::vector<BamDamKeyView> keys;
+    size_t nextKey = 0;
+    const BamDamKeyView* current = nullptr;
+    const uint8_t* valueList = nullptr;
+    uint32_t valueCount = 0;
+    uint32_t valueIndex = 0;
+};
+
+class BamDamRowAppender {
+public:
+    BamDamRowAppender(const RegfHive& hive, const SidResolveFn& resolveUser = nullptr,
+                      BamDamFilter* filter = nullptr);
+
+    // Ajoute au plus maxRows lignes étiquetées hostId (chemins ni normalisés ni classés : voir
+    // ResolveRowPaths) ; false une fois la ruche épuisée
+    bool Append(EntryStore& store, uint32_t hostId, size_t maxRows);
+
+private:
+    const RegfHive& hive;
+    BamDamCursor cursor;
+    SidResolveFn resolveUser;
+    BamDamFilter* filter;
+    BamDamKeyView key;
+    bool inKey = false;
+    std::u16string sidText;
+    std::u16string userName;  // Résolu une fois par clé
+    std::u16string pathText;
+};
+
+struct BamDamStreamOptions {
+    size_t chunkRows = 65536;
+    SidResolveFn resolveUser;
+    const PathClassifier* classifier = nullptr;  // nullptr : PathClassifier::Default()
+    BamDamFilter* filter = nullptr;
+};
+
+// Livre les lignes de la ruche par blocs (un host par bloc) ; retourne le nombre total de lignes
+size_t StreamBamDamHive(const RegfHive& hive, std::u16string_view host, const EntryChunkFn& sink,
+                        const BamDamStreamOptions& options = BamDamStreamOptions());
@@ -0,0 +1,363 @@
+/*
+ * CaseFile - Implémentation de l'écriture des sections, de la projection et des sommes de contrôle
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "CaseFile.h"
+
+#include "EntryQuery.h"
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char CASE_MAGIC[8] = { 'B', 'D', 'C', 'A', 'S', 'E', 1, 0 };
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t HEADER_SIZE = 64;
+constexpr size_t ENTRY_SIZE = 64;
+constexpr size_t NAME_SIZE = 40;
+constexpr size_t SECTION_ALIGN = 64;
+constexpr size_t WRITE_BUFFER = 4u << 20;
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+uint64_t HashBytes(const uint8_t* data, size_t size) {
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t Rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t Load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t Round(uint64_t lane, uint64_t word) {
+    return Rotl(lane + word * PRIME2, 31) * PRIME1;
+}
+
+template <class T>
+void Put(std::vector<uint8_t>& out, T value) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <class T>
+T Get(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+bool SyncAndClose(FILE* file) {
+    bool ok = std::fflush(file) == 0;
+#ifdef _WIN32
+    ok = _commit(_fileno(file)) == 0 && ok;
+#else
+    ok = fsync(fileno(file)) == 0 && ok;
+#endif
+    return std::fclose(file) == 0 && ok;
+}
+
+}  // namespace
+
+void SectionChecksum::Update(const uint8_t* data, size_t size) {
+    total += size;
+    if (pendingSize) {
+        const size_t take = std::min(size, sizeof(pending) - pendingSize);
+        std::memcpy(pending + pendingSize, data, take);
+        pendingSize += take;
+        data += take;
+        size -= take;
+        if (pendingSize < sizeof(pending)) return;
+        for (int k = 0; k < 4; k++) lanes[k] = Round(lanes[k], Load64(pending + 8 * k));
+        pendingSize = 0;
+    }
+    // Quatre voies indépendantes : les multiplications se recouvrent dans le pipeline
+    for (; size >= 32; data += 32, size -= 32) {
+        lanes[0] = Round(lanes[0], Load64(data));
+        lanes[1] = Round(lanes[1], Load64(data + 8));
+        lanes[2] = Round(lanes[2], Load64(data + 16));
+        lanes[3] = Round(lanes[3], Load64(data + 24));
+    }
+    std::memcpy(pending, data, size);
+    pendingSize = size;
+}
+
+uint64_t SectionChecksum::Finish() const {
+    uint64_t hash = Rotl(lanes[0], 1) + Rotl(lanes[1], 7) + Rotl(lanes[2], 12) + Rotl(lanes[3], 18);
+    hash ^= total;
+    for (size_t i = 0; i < pendingSize; i++) hash = Rotl(hash ^ (pending[i] * PRIME1), 11) * PRIME2;
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+CaseWriter::~CaseWriter() {
+    if (file) std::fclose(file);
+}
+
+bool CaseWriter::Open(const fs::path& path, uint64_t rowCount) {
+#ifdef _WIN32
+    file = _wfopen(path.c_str(), L"wb");
+#else
+    file = std::fopen(path.c_str(), "wb");
+#endif
+    if (!file) return false;
+    rows = rowCount;
+    buffer.reserve(WRITE_BUFFER);
+    buffer.assign(HEADER_SIZE, 0);  // En-tête écrit par Close, une fois la table connue
+    offset = HEADER_SIZE;
+    return true;
+}
+
+void CaseWriter::Flush() {
+    if (!buffer.empty() && !failed && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        failed = true;
+    }
+    buffer.clear();
+}
+
+void CaseWriter::BeginSection(const std::string& name) {
+    const size_t padding = static_cast<size_t>((SECTION_ALIGN - offset % SECTION_ALIGN) % SECTION_ALIGN);
+    buffer.insert(buffer.end(), padding, 0);
+    offset += padding;
+    entries.push_back(Entry{ name, offset, 0, 0 });
+    checksum = SectionChecksum();
+}
+
+void CaseWriter::Write(const void* data, size_t bytes) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    checksum.Update(p, bytes);
+    offset += bytes;
+    if (buffer.size() + bytes > WRITE_BUFFER) Flush();
+    if (bytes >= WRITE_BUFFER) {
+        // Colonne entière : écrite directement, sans passer par le tampon
+        if (!failed && std::fwrite(p, 1, bytes, file) != bytes) failed = true;
+        return;
+    }
+    buffer.insert(buffer.end(), p, p + bytes);
+}
+
+void CaseWriter::EndSection() {
+    Entry& entry = entries.back();
+    entry.bytes = offset - entry.offset;
+    entry.checksum = checksum.Finish();
+}
+
+bool CaseWriter::Close() {
+    if (!file) return false;
+
+    std::vector<uint8_t> table;
+    table.reserve(entries.size() * ENTRY_SIZE);
+    for (const Entry& entry : entries) {
+        char name[NAME_SIZE] = {};
+        std::memcpy(name, entry.name.data(), std::min(entry.name.size(), NAME_SIZE - 1));
+        table.insert(table.end(), name, name + NAME_SIZE);
+        Put<uint64_t>(table, entry.offset);
+        Put<uint64_t>(table, entry.bytes);
+        Put<uint64_t>(table, entry.checksum);
+    }
+    const size_t padding = static_cast<size_t>((SECTION_ALIGN - offset % SECTION_ALIGN) % SECTION_ALIGN);
+    buffer.insert(buffer.end(), padding, 0);
+    const uint64_t tableOffset = offset + padding;
+    buffer.insert(buffer.end(), table.begin(), table.end());
+    Flush();
+
+    SectionChecksum tableChecksum;
+    tableChecksum.Update(table.data(), table.size());
+    std::vector<uint8_t> header(CASE_MAGIC, CASE_MAGIC + sizeof(CASE_MAGIC));
+    Put<uint32_t>(header, BYTE_ORDER_MARK);
+    Put<uint32_t>(header, 0);
+    Put<uint64_t>(header, rows);
+    Put<uint64_t>(header, entries.size());
+    Put<uint64_t>(header, tableOffset);
+    Put<uint64_t>(header, tableChecksum.Finish());
+    Put<uint64_t>(header, HashBytes(header.data(), header.size()));
+    Put<uint64_t>(header, 0);
+    if (!failed && (std::fseek(file, 0, SEEK_SET) != 0 ||
+                    std::fwrite(header.data(), 1, header.size(), file) != header.size())) {
+        failed = true;
+    }
+    const bool closed = SyncAndClose(file);
+    file = nullptr;
+    return closed && !failed;
+}
+
+bool CaseFile::Save(const fs::path& path, const EntryStore& store, const EntryIndex* index) {
+    // Nouveau cas complet et synchronisé avant le renommage : un arrêt laisse l'ancien intact
+    fs::path temp = path;
+    temp += ".tmp";
+    std::error_code ec;
+    {
+        CaseWriter out;
+        if (!out.Open(temp, store.size())) {
+            lastError = "Écriture impossible : " + temp.u8string();
+            return false;
+        }
+        store.Save(out);
+        if (index) index->Save(out);
+        if (!out.Close()) {
+            lastError = "Écriture interrompue : " + temp.u8string();
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    fs::rename(temp, path, ec);
+    if (ec) {
+        lastError = "Renommage impossible vers " + path.u8string() + " (cas ouvert ?)";
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool CaseFile::Open(const fs::path& path, EntryStore& store, EntryIndex* index) {
+    Close();
+    if (!file.Open(path)) {
+        lastError = file.LastError();
+        return false;
+    }
+    const uint8_t* data = file.data();
+    const size_t size = file.size();
+    if (size < HEADER_SIZE || std::memcmp(data, CASE_MAGIC, sizeof(CASE_MAGIC)) != 0) {
+        lastError = "Signature de cas invalide";
+        Close();
+        return false;
+    }
+    if (Get<uint32_t>(data + 8) != BYTE_ORDER_MARK) {
+        lastError = "Cas écrit sur une machine d'un autre ordre des octets";
+        Close();
+        return false;
+    }
+    if (HashBytes(data, 48) != Get<uint64_t>(data + 48)) {
+        lastError = "En-tête de cas corrompu";
+        Close();
+        return false;
+    }
+
+    const uint64_t count = Get<uint64_t>(data + 24);
+    const uint64_t tableOffset = Get<uint64_t>(data + 32);
+    if (tableOffset < HEADER_SIZE || tableOffset > size || count > (size - tableOffset) / ENTRY_SIZE) {
+        lastError = "Table des sections hors limites";
+        Close();
+        return false;
+    }
+    SectionChecksum tableChecksum;
+    tableChecksum.Update(data + tableOffset, static_cast<size_t>(count * ENTRY_SIZE));
+    if (tableChecksum.Finish() != Get<uint64_t>(data + 40)) {
+        lastError = "Table des sections corrompue";
+        Close();
+        return false;
+    }
+
+    sections.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; i++) {
+        const uint8_t* entry = data + tableOffset + i * ENTRY_SIZE;
+        const char* name = reinterpret_cast<const char*>(entry);
+        Section section{ std::string(name, strnlen(name, NAME_SIZE)), Get<uint64_t>(entry + NAME_SIZE),
+                         Get<uint64_t>(entry + NAME_SIZE + 8), Get<uint64_t>(entry + NAME_SIZE + 16) };
+        // Sections alignées, avant la table : tableaux lisibles en place
+        if (section.offset % SECTION_ALIGN != 0 || section.offset < HEADER_SIZE || section.offset > tableOffset ||
+            section.bytes > tableOffset - section.offset) {
+            lastError = "Section hors limites : " + section.name;
+            Close();
+            return false;
+        }
+        sections.push_back(std::move(section));
+    }
+    std::sort(sections.begin(), sections.end(), [](const Section& a, const Section& b) { return a.name < b.name; });
+    for (size_t i = 1; i < sections.size(); i++) {
+        if (sections[i].name == sections[i - 1].name) {
+            lastError = "Section en double : " + sections[i].name;
+            Close();
+            return false;
+        }
+    }
+    rows = Get<uint64_t>(data + 16);
+    if (rows > UINT32_MAX) {
+        lastError = "Nombre de lignes invalide";
+        Close();
+        return false;
+    }
+
+    if (!store.Attach(*this)) {
+        lastError = "Cas invalide, " + lastError;
+        Close();
+        return false;
+    }
+    if (index && Has("index.timeOrder")) {
+        if (!index->Attach(*this, store)) {
+            store.Clear();
+            lastError = "Index invalide, " + lastError;
+            Close();
+            return false;
+        }
+        indexAttached = true;
+    }
+    return true;
+}
+
+void CaseFile::Close() {
+    file.Close();
+    sections.clear();
+    rows = 0;
+    indexAttached = false;
+}
+
+bool CaseFile::Verify() {
+    for (const Section& section : sections) {
+        SectionChecksum sum;
+        sum.Update(file.data() + section.offset, static_cast<size_t>(section.bytes));
+        if (sum.Finish() != section.checksum) {
+            lastError = "Somme de contrôle invalide : " + section.name;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CaseFile::Has(const std::string& name) const {
+    const uint8_t* data = nullptr;
+    uint64_t bytes = 0;
+    return FindBytes(name, data, bytes);
+}
+
+bool CaseFile::Invalid(const std::string& name) const {
+    lastError = "section absente ou invalide : " + name;
+    return false;
+}
+
+bool CaseFile::FindBytes(const std::string& name, const uint8_t*& data, uint64_t& bytes) const {
+    const auto it = std::lower_bound(sections.begin(), sections.end(), name,
+                                     [](const Section& section, const std::string& key) { return section.name < key; });
+    if (it == sections.end() || it->name != name) return false;
+    data = file.data() + it->offset;
+    bytes = it->bytes;
+    return true;
+}
@@ -0,0 +1,168 @@
+/*
+ * CaseFile - Fichier de cas binaire projeté en mémoire : réouverture d'une analyse sans re-parsing
+ *
+ * Un cas de 50 millions de lignes exporté en CSV se relit en minutes ; enregistré ici, il se rouvre en
+ * projetant le fichier : les colonnes de l'EntryStore, ses tables de chaînes et l'EntryIndex (s'il est
+ * enregistré) pointent directement dans la projection, sans passe de désérialisation ni copie.
+ *
+ * - Sections = tableaux bruts tels qu'en mémoire (ordre des octets de la machine, marqueur vérifié à
+ *   l'ouverture), alignées sur 64 octets ; chaque section porte sa somme de contrôle
+ * - Open : en-tête, table des sections et dimensions vérifiés, puis une passe sur les offsets des tables
+ *   de chaînes, les colonnes d'ids et l'index (listes, rangs, nœuds du trie) : un fichier altéré est refusé,
+ *   jamais lu hors limites ;
+ *   Verify : sommes de contrôle de toutes les sections, à faire avant de se fier à un fichier d'origine
+ *   inconnue (lit tout le fichier)
+ * - Save : fichier temporaire écrit en une passe séquentielle, synchronisé puis renommé (un arrêt laisse
+ *   l'ancien cas intact)
+ * - Store adossé : modifiable (tri, ajouts), chaque colonne touchée étant alors recopiée en mémoire ; le
+ *   CaseFile doit rester ouvert tant que le store ou l'index s'en servent (jusqu'à leur Clear)
+ *
+ * Format (ordre des octets de la machine qui l'écrit) :
+ *   En-tête (64 octets) : "BDCASE\x01\0" | u32 0x01020304 (ordre des octets) | u32 réservé | u64 lignes
+ *                         | u64 sections | u64 offset de la table | u64 somme de la table
+ *                         | u64 FNV-1a des 48 octets précédents | u64 réservé
+ *   Sections            : données, chacune alignée sur 64 octets (bourrage à zéro)
+ *   Table (64 octets par section) : nom (40 octets, complété par des zéros) | u64 offset | u64 octets
+ *                                   | u64 somme de contrôle
+ *   Noms : "hosts.*", "sids.*", "users.*", "paths.*" (StringPool), "match.*" (MatchTable),
+ *          "store.*" (colonnes), "index.*" (EntryIndex, facultatif)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class EntryIndex;
+
+// Somme de contrôle des sections : quatre voies de mots de 64 bits (multiplication, rotation), calculable
+// par morceaux de tailles quelconques
+class SectionChecksum {
+public:
+    void Update(const uint8_t* data, size_t size);
+    uint64_t Finish() const;
+
+private:
+    uint64_t lanes[4] = { 0x9E3779B185EBCA87ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL,
+                          0x85EBCA77C2B2AE63ULL };
+    uint8_t pending[32] = {};
+    size_t pendingSize = 0;
+    uint64_t total = 0;
+};
+
+// Écriture séquentielle des sections (CaseFile::Save, puis Save des stores et index)
+class CaseWriter {
+public:
+    CaseWriter() = default;
+    ~CaseWriter();
+    CaseWriter(const CaseWriter&) = delete;
+    CaseWriter& operator=(const CaseWriter&) = delete;
+
+    bool Open(const std::filesystem::path& path, uint64_t rows);
+
+    void BeginSection(const std::string& name);
+    void Write(const void* data, size_t bytes);
+    void EndSection();
+    template <class T>
+    void Section(const std::string& name, const T* items, size_t count) {
+        BeginSection(name);
+        Write(items, count * sizeof(T));
+        EndSection();
+    }
+
+    // Table et en-tête écrits, fichier synchronisé et fermé ; false si une écriture a échoué
+    bool Close();
+    uint64_t BytesWritten() const { return offset; }
+
+private:
+    struct Entry {
+        std::string name;
+        uint64_t offset;
+        uint64_t bytes;
+        uint64_t checksum;
+    };
+
+    void Flush();
+
+    FILE* file = nullptr;
+    std::vector<uint8_t> buffer;
+    uint64_t offset = 0;  // Octets émis (écrits ou en tampon)
+    uint64_t rows = 0;
+    bool failed = false;
+    std::vector<Entry> entries;
+    SectionChecksum checksum;
+};
+
+class CaseFile {
+public:
+    CaseFile() = default;
+    CaseFile(const CaseFile&) = delete;
+    CaseFile& operator=(const CaseFile&) = delete;
+
+    // Enregistre store, et index s'il est fourni (construit sur ce store) ; indépendant du cas ouvert
+    bool Save(const std::filesystem::path& path, const EntryStore& store, const EntryIndex* index = nullptr);
+
+    // Projette le cas et y adosse store, et index si demandé et présent dans le fichier
+    bool Open(const std::filesystem::path& path, EntryStore& store, EntryIndex* index = nullptr);
+    void Close();
+    bool HasIndex() const { return indexAttached; }
+    bool Verify();
+
+    uint64_t Rows() const { return rows; }
+    size_t Sections() const { return sections.size(); }
+    uint64_t FileBytes() const { return file.size(); }
+    const std::string& LastError() const { return lastError; }
+
+    // Section name vue comme tableau de T ; expected (si différent de SIZE_MAX) = nombre d'éléments exigé
+    template <class T>
+    bool Find(const std::string& name, const T*& items, size_t& count, size_t expected = SIZE_MAX) const {
+        const uint8_t* data = nullptr;
+        uint64_t bytes = 0;
+        if (!FindBytes(name, data, bytes) || bytes % sizeof(T) != 0 ||
+            reinterpret_cast<uintptr_t>(data) % alignof(T) != 0 ||
+            (expected != SIZE_MAX && bytes / sizeof(T) != expected)) {
+            return Invalid(name);
+        }
+        items = reinterpret_cast<const T*>(data);
+        count = static_cast<size_t>(bytes / sizeof(T));
+        return true;
+    }
+    template <class T>
+    bool Attach(const std::string& name, Column<T>& column, size_t expected = SIZE_MAX) const {
+        const T* items = nullptr;
+        size_t count = 0;
+        if (!Find(name, items, count, expected)) return false;
+        column.Attach(items, count);
+        return true;
+    }
+    bool Has(const std::string& name) const;
+    // Message "section absente ou invalide" dans LastError ; toujours false
+    bool Invalid(const std::string& name) const;
+
+private:
+    struct Section {
+        std::string name;
+        uint64_t offset;
+        uint64_t bytes;
+        uint64_t checksum;
+    };
+
+    bool FindBytes(const std::string& name, const uint8_t*& data, uint64_t& bytes) const;
+
+    MappedFile file;
+    std::vector<Section> sections;  // Triées par nom
+    uint64_t rows = 0;
+    bool indexAttached = false;
+    mutable std::string lastError;
+};
@@ -0,0 +1,478 @@
+/*
+ * EntryExport - Implémentation des sérialiseurs CSV / JSON Lines / BDCOL et du pipeline d'export
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "EntryExport.h"
+
+#include "BamDamHive.h"
+#include "Telemetry.h"
+#include "Transcode.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+// Nombre de lignes sérialisées entre deux vérifications du remplissage du buffer
+constexpr size_t ROWS_PER_SLICE = 4096;
+// Lignes maximum par bloc BDCOL
+constexpr size_t COLUMNAR_BLOCK_ROWS = 65536;
+// Octet 6 de l'en-tête BDCOL : colonne de première observation présente
+constexpr char COLUMNAR_FIRST_SEEN = 0x01;
+
+// UTF-16 → UTF-8 avec échappement en une seule passe (Transcode) ; substituts isolés → U+FFFD
+template <Utf8Escape escape>
+void AppendEscaped(ByteBuffer& out, std::u16string_view text) {
+    char* p = out.Tail(Utf8MaxBytes(text.size(), escape));
+    out.SetEnd(Utf16ToUtf8(text.data(), text.size(), p, escape));
+}
+
+void AppendTimestamp(ByteBuffer& out, uint64_t fileTime, uint8_t flags, const TimeFormat& format) {
+    char* p = out.Tail(FILETIME_TEXT_MAX);
+    out.Advance(FormatEntryTimestamp(fileTime, flags, format, p));
+}
+
+void AppendTimestamp(ByteBuffer& out, const EntryStore& store, size_t row, const TimeFormat& format) {
+    AppendTimestamp(out, store.FileTime(row), store.Flags(row), format);
+}
+
+void AppendUInt(ByteBuffer& out, uint64_t value) {
+    char* p = out.Tail(20);
+    out.SetEnd(std::to_chars(p, p + 20, value).ptr);
+}
+
+void AppendVarint(ByteBuffer& out, uint64_t value) {
+    char* p = out.Tail(10);
+    while (value >= 0x80) {
+        *p++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<char>(value);
+    out.SetEnd(p);
+}
+
+void AppendU32(ByteBuffer& out, uint32_t value) { out.Append(&value, 4); }
+void AppendU64(ByteBuffer& out, uint64_t value) { out.Append(&value, 8); }
+
+class CsvSerializer : public EntrySerializer {
+public:
+    explicit CsvSerializer(bool history) : history(history) {}
+
+    void Begin(ByteBuffer& out) override {
+        out.Append(history ? "\xEF\xBB\xBF" "Host,Timestamp,PremiereObservation,SID,Username,CheminExec,"
+                             "CheminNormalise,Source,Notes\n"
+                           : "\xEF\xBB\xBF" "Host,Timestamp,SID,Username,CheminExec,CheminNormalise,Source,Notes\n");
+    }
+
+    void Append(const EntryStore& store, size_t first, size_t count, const TimeFormat& format,
+                ByteBuffer& out) override {
+        for (size_t row = first; row < first + count; row++) {
+            out.Push('"');
+            AppendEscaped<Utf8Escape::Csv>(out, store.Host(row));
+            out.Append("\",\"");
+            AppendTimestamp(out, store, row, format);
+            out.Append("\",\"");
+            if (history) {
+                AppendTimestamp(out, store.FirstSeen(row), store.Flags(row), format);
+                out.Append("\",\"");
+            }
+            AppendEscaped<Utf8Escape::Csv>(out, store.Sid(row));
+            out.Append("\",\"");
+            AppendEscaped<Utf8Escape::Csv>(out, store.User(row));
+            out.Append("\",\"");
+            AppendEscaped<Utf8Escape::Csv>(out, store.Path(row));
+            out.Append("\",\"");
+            AppendEscaped<Utf8Escape::Csv>(out, store.NormalizedPath(row));
+            out.Append("\",\"");
+            AppendEscaped<Utf8Escape::Csv>(out, SourceName(store.Source(row)));
+            out.Append("\",\"");
+            AppendEscaped<Utf8Escape::Csv>(out, store.Note(row));
+            out.Append("\"\n");
+        }
+    }
+
+    void End(ByteBuffer&) override {}
+
+private:
+    bool history;
+};
+
+class JsonLinesSerializer : public EntrySerializer {
+public:
+    explicit JsonLinesSerializer(bool history) : history(history) {}
+
+    void Begin(ByteBuffer&) override {}
+
+    void Append(const EntryStore& store, size_t first, size_t count, const TimeFormat& format,
+                ByteBuffer& out) override {
+        for (size_t row = first; row < first + count; row++) {
+            out.Append("{\"host\":\"");
+            AppendEscaped<Utf8Escape::Json>(out, store.Host(row));
+            if (store.Flags(row) & ENTRY_FLAG_INVALID_DATA) {
+                out.Append(history ? "\",\"timestamp\":null,\"filetime\":null,\"first_seen\":null,"
+                                     "\"first_filetime\":null,\"sid\":\""
+                                   : "\",\"timestamp\":null,\"filetime\":null,\"sid\":\"");
+            } else {
+                out.Append("\",\"timestamp\":\"");
+                AppendTimestamp(out, store, row, format);
+                out.Append("\",\"filetime\":");
+                AppendUInt(out, store.FileTime(row));
+                if (history) {
+                    out.Append(",\"first_seen\":\"");
+                    AppendTimestamp(out, store.FirstSeen(row), 0, format);
+                    out.Append("\",\"first_filetime\":");
+                    AppendUInt(out, store.FirstSeen(row));
+                }
+                out.Append(",\"sid\":\"");
+            }
+            AppendEscaped<Utf8Escape::Json>(out, store.Sid(row));
+            out.Append("\",\"user\":\"");
+            AppendEscaped<Utf8Escape::Json>(out, store.User(row));
+            out.Append("\",\"path\":\"");
+            AppendEscaped<Utf8Escape::Json>(out, store.Path(row));
+            out.Append("\",\"normalized_path\":\"");
+            AppendEscaped<Utf8Escape::Json>(out, store.NormalizedPath(row));
+            out.Append("\",\"source\":\"");
+            AppendEscaped<Utf8Escape::Json>(out, SourceName(store.Source(row)));
+            out.Append("\",\"notes\":\"");
+            AppendEscaped<Utf8Escape::Json>(out, store.Note(row));
+            out.Append("\",\"rules\":[");
+            bool first = true;
+            store.matches.ForEachRule(store.MatchId(row), [&](uint32_t rule) {
+                if (!first) out.Push(',');
+                AppendUInt(out, rule);
+                first = false;
+            });
+            out.Append("]}\n");
+        }
+    }
+
+    void End(ByteBuffer&) override {}
+
+private:
+    bool history;
+};
+
+// Lignes accumulées entre les appels (tranches, stores successifs) : un bloc est écrit dès qu'il atteint
+// COLUMNAR_BLOCK_ROWS lignes, et le dernier, incomplet, par End
+class ColumnarSerializer : public EntrySerializer {
+public:
+    explicit ColumnarSerializer(bool history) : history(history) {}
+
+    void Begin(ByteBuffer& out) override {
+        const char header[8] = { 'B', 'D', 'C', 'O', 'L', 2, history ? COLUMNAR_FIRST_SEEN : '\0', 0 };
+        out.Append(header, 8);
+    }
+
+    void BeginStore(const EntryStore& store) override {
+        // Correspondance ids du store → ids globaux du fichier, remplie à la demande, valable pour tout le store
+        const StringPool* storePools[DICT_COUNT] = { &store.hosts, &store.sids, &store.users, &store.paths,
+                                                     &store.matches.Notes() };
+        for (int d = 0; d < DICT_COUNT; d++) {
+            pools[d] = storePools[d];
+            remap[d].assign(pools[d]->Count(), UNMAPPED);
+        }
+    }
+
+    void Append(const EntryStore& store, size_t first, size_t count, const TimeFormat&,
+                ByteBuffer& out) override {
+        for (size_t row = first; row < first + count; row++) {
+            const uint32_t local[ID_COLUMNS] = { store.HostId(row), store.SidId(row), store.UserId(row),
+                                                 store.PathId(row), store.NormalizedPathId(row),
+                                                 store.matches.NoteId(store.MatchId(row)) };
+            for (int c = 0; c < ID_COLUMNS; c++) {
+                const int d = COLUMN_DICT[c];
+                ids[c].push_back(GlobalId(d, local[c]));
+            }
+            const uint64_t time = store.FileTime(row);
+            times.push_back(time);
+            if (history) firstSeenDeltas.push_back(time - store.FirstSeen(row));
+            sources.push_back(static_cast<char>(store.Source(row)));
+            flags.push_back(static_cast<char>(store.Flags(row)));
+            if (times.size() == COLUMNAR_BLOCK_ROWS) WriteBlock(out);
+        }
+    }
+
+    void End(ByteBuffer& out) override {
+        if (!times.empty()) WriteBlock(out);
+        out.Append("END1", 4);
+        AppendU64(out, totalRows);
+        for (int d = 0; d < DICT_COUNT; d++) {
+            AppendU32(out, static_cast<uint32_t>(dictionaries[d].Count()));
+        }
+    }
+
+private:
+    static constexpr int DICT_COUNT = 5;
+    // Colonnes d'ids : hôte, SID, utilisateur, chemin, chemin normalisé, note
+    static constexpr int ID_COLUMNS = 6;
+    static constexpr int COLUMN_DICT[ID_COLUMNS] = { 0, 1, 2, 3, 3, 4 };
+    static constexpr uint32_t UNMAPPED = 0xFFFFFFFF;
+
+    // Mot nouveau pour le fichier : ajouté au dictionnaire du bloc en cours. Dictionnaires internés en
+    // UTF-16 (StringPool : ids dans l'ordre d'apparition), transcodés une seule fois, à l'ajout.
+    uint32_t GlobalId(int d, uint32_t localId) {
+        uint32_t& mapped = remap[d][localId];
+        if (mapped != UNMAPPED) return mapped;
+
+        const std::u16string_view word = pools[d]->View(localId);
+        const size_t known = dictionaries[d].Count();
+        mapped = dictionaries[d].Intern(word);
+        if (dictionaries[d].Count() != known) {
+            scratch.clear();
+            AppendUtf8(scratch, word);
+            AppendVarint(addedWords[d], scratch.size());
+            addedWords[d].Append(scratch);
+            addedCounts[d]++;
+        }
+        return mapped;
+    }
+
+    void WriteBlock(ByteBuffer& out) {
+        const size_t rows = times.size();
+        block.clear();
+        for (int d = 0; d < DICT_COUNT; d++) {
+            AppendVarint(block, addedCounts[d]);
+            block.Append(addedWords[d].data(), addedWords[d].size());
+            addedWords[d].clear();
+            addedCounts[d] = 0;
+        }
+        for (int c = 0; c < ID_COLUMNS; c++) {
+            for (uint32_t id : ids[c]) AppendVarint(block, id);
+            ids[c].clear();
+        }
+        uint64_t previous = 0;
+        for (uint64_t time : times) {
+            const int64_t delta = static_cast<int64_t>(time - previous);
+            AppendVarint(block, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+            previous = time;
+        }
+        for (uint64_t delta : firstSeenDeltas) AppendVarint(block, delta);
+        block.Append(sources.data(), sources.size());
+        block.Append(flags.data(), flags.size());
+        times.clear();
+        firstSeenDeltas.clear();
+        sources.clear();
+        flags.clear();
+
+        out.Append("BLK1", 4);
+        AppendU32(out, static_cast<uint32_t>(rows));
+        AppendU32(out, static_cast<uint32_t>(block.size()));
+        out.Append(block.data(), block.size());
+        totalRows += rows;
+    }
+
+    bool history;
+    StringPool dictionaries[DICT_COUNT];
+    const StringPool* pools[DICT_COUNT] = {};
+    std::vector<uint32_t> remap[DICT_COUNT];
+    // Bloc en cours : mots nouveaux (varint longueur + UTF-8) et colonnes
+    ByteBuffer addedWords[DICT_COUNT];
+    size_t addedCounts[DICT_COUNT] = {};
+    std::vector<uint32_t> ids[ID_COLUMNS];
+    std::vector<uint64_t> times;
+    std::vector<uint64_t> firstSeenDeltas;
+    std::string sources;
+    std::string flags;
+    std::string scratch;
+    ByteBuffer block;
+    uint64_t totalRows = 0;
+};
+
+bool ExtensionIs(const std::filesystem::path& path, const char* extension) {
+    std::string ext = path.extension().u8string();
+    if (ext.size() != std::strlen(extension)) return false;
+    for (size_t i = 0; i < ext.size(); i++) {
+        char c = ext[i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c + 32);
+        if (c != extension[i]) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+ExportFormat ExportFormatFromPath(const std::filesystem::path& path) {
+    if (ExtensionIs(path, ".jsonl") || ExtensionIs(path, ".json")) return ExportFormat::JsonLines;
+    if (ExtensionIs(path, ".bdcol")) return ExportFormat::Columnar;
+    return ExportFormat::Csv;
+}
+
+void ByteBuffer::Reserve(size_t capacityNeeded) {
+    if (capacityNeeded <= capacity) return;
+    std::unique_ptr<char[]> grown(new char[capacityNeeded]);
+    if (length) std::memcpy(grown.get(), bytes.get(), length);
+    bytes.swap(grown);
+    capacity = capacityNeeded;
+}
+
+void ByteBuffer::Append(const void* src, size_t n) {
+    if (n == 0) return;
+    std::memcpy(Tail(n), src, n);
+    length += n;
+}
+
+std::unique_ptr<EntrySerializer> EntrySerializer::Create(ExportFormat format, bool history) {
+    switch (format) {
+        case ExportFormat::JsonLines: return std::make_unique<JsonLinesSerializer>(history);
+        case ExportFormat::Columnar: return std::make_unique<ColumnarSerializer>(history);
+        case ExportFormat::Csv: break;
+    }
+    return std::make_unique<CsvSerializer>(history);
+}
+
+bool BufferedFileWriter::Open(const std::filesystem::path& path) {
+    Close();
+    file.rdbuf()->pubsetbuf(nullptr, 0);  // Les buffers sont déjà gros : pas de double copie
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    closing = false;
+    failed = false;
+    bytesWritten = 0;
+    buffersOut = 0;
+    freeBuffers.clear();
+    for (size_t i = 0; i < BUFFER_COUNT; i++) {
+        freeBuffers.push_back(std::make_unique<ByteBuffer>(BUFFER_SIZE + BUFFER_SIZE / 4));
+    }
+    open = true;
+    writer = std::thread(&BufferedFileWriter::WriterMain, this);
+    return true;
+}
+
+std::unique_ptr<ByteBuffer> BufferedFileWriter::Acquire() {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] { return !freeBuffers.empty(); });
+    std::unique_ptr<ByteBuffer> buffer = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    buffersOut++;
+    return buffer;
+}
+
+void BufferedFileWriter::Submit(std::unique_ptr<ByteBuffer> buffer) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        pending.push_back(std::move(buffer));
+    }
+    changed.notify_all();
+}
+
+void BufferedFileWriter::WriterMain() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        changed.wait(guard, [this] { return closing || !pending.empty(); });
+        if (pending.empty()) break;
+
+        std::unique_ptr<ByteBuffer> buffer = std::move(pending.front());
+        pending.pop_front();
+        guard.unlock();
+
+        if (!buffer->empty() && !failed) {
+            ScopedSpan span(TelemetrySpan::ExportWrite, buffer->size());
+            file.write(buffer->data(), static_cast<std::streamsize>(buffer->size()));
+            if (!file) failed = true;
+        }
+        const size_t written = buffer->size();
+        buffer->clear();
+
+        guard.lock();
+        bytesWritten += written;
+        freeBuffers.push_back(std::move(buffer));
+        buffersOut--;
+        changed.notify_all();
+    }
+}
+
+bool BufferedFileWriter::Close() {
+    if (!open) return !failed;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        closing = true;
+    }
+    changed.notify_all();
+    writer.join();
+    file.close();
+    open = false;
+    return !failed && !file.fail();
+}
+
+ExportPipeline::ExportPipeline(ExportFormat format, size_t maxPendingStores, bool history)
+    : serializer(EntrySerializer::Create(format, history)), maxPending(std::max<size_t>(1, maxPendingStores)) {}
+
+bool ExportPipeline::Open(const std::filesystem::path& path) {
+    if (!writer.Open(path)) return false;
+    current = writer.Acquire();
+    serializer->Begin(*current);
+    closing = false;
+    open = true;
+    rowsWritten = 0;
+    serializerThread = std::thread(&ExportPipeline::SerializerMain, this);
+    return true;
+}
+
+void ExportPipeline::Submit(std::unique_ptr<EntryStore> store, const TimeFormat& format) {
+    std::unique_lock<std::mutex> guard(queueLock);
+    queueChanged.wait(guard, [this] { return queue.size() < maxPending; });
+    queue.push_back(Job{ std::move(store), format });
+    queueChanged.notify_all();
+}
+
+size_t ExportPipeline::Pending() const {
+    std::lock_guard<std::mutex> guard(queueLock);
+    return queue.size();
+}
+
+void ExportPipeline::Write(const EntryStore& store, size_t first, size_t count, const TimeFormat& format) {
+    Serialize(store, first, count, format);
+}
+
+void ExportPipeline::SerializerMain() {
+    std::unique_lock<std::mutex> guard(queueLock);
+    while (true) {
+        queueChanged.wait(guard, [this] { return closing || !queue.empty(); });
+        if (queue.empty()) break;
+
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        queueChanged.notify_all();
+        guard.unlock();
+
+        Serialize(*job.store, 0, job.store->size(), job.format);
+        job.store.reset();
+
+        guard.lock();
+    }
+}
+
+void ExportPipeline::Serialize(const EntryStore& store, size_t first, size_t count, const TimeFormat& format) {
+    std::lock_guard<std::mutex> guard(serializeLock);
+    ScopedSpan span(TelemetrySpan::ExportSerialize, count);
+    serializer->BeginStore(store);
+    for (size_t slice = first; slice < first + count; slice += ROWS_PER_SLICE) {
+        const size_t rows = std::min(ROWS_PER_SLICE, first + count - slice);
+        serializer->Append(store, slice, rows, format, *current);
+        if (current->size() >= BufferedFileWriter::BUFFER_SIZE) {
+            writer.Submit(std::move(current));
+            current = writer.Acquire();
+        }
+    }
+    rowsWritten += count;
+}
+
+bool ExportPipeline::Close() {
+    if (!open) return true;
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        closing = true;
+    }
+    queueChanged.notify_all();
+    serializerThread.join();
+
+    serializer->End(*current);
+    writer.Submit(std::move(current));
+    open = false;
+    return writer.Close();
+}
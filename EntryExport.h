@@ -0,0 +1,185 @@
+/*
+ * EntryExport - Export haut débit des entrées BAM/DAM (CSV, JSON Lines, binaire en colonnes)
+ *
+ * - Transcodage UTF-16 → UTF-8 et échappement en une passe, directement dans de gros buffers réutilisés
+ * - CSV RFC 4180 (guillemets doublés) avec BOM UTF-8, JSON Lines (échappement complet,
+ *   "rules" = numéros des règles de classification déclenchées) ; chemin brut et chemin
+ *   normalisé (lettre de lecteur, voir VolumeMap) côte à côte
+ * - Historique multi-versions (HiveHistory) : première observation en plus, Timestamp = dernière
+ *   (CSV PremiereObservation, JSONL first_seen / first_filetime)
+ * - Format colonnes "BDCOL" pour l'ingestion timeline : chemins, utilisateurs, SIDs et hôtes
+ *   encodés par dictionnaire, FILETIME encodés en delta zigzag varint
+ * - ExportPipeline : sérialisation et écriture disque sur deux threads dédiés, les workers
+ *   de parsing soumettent leurs stores et continuent (file bornée = contre-pression)
+ *
+ * Format BDCOL (little-endian) :
+ *   En-tête : "BDCOL\x02" | u8 drapeaux (0x01 = première observation) | "\0"
+ *   Bloc    : "BLK1" | u32 lignes (65536, le dernier moins ; un bloc peut réunir plusieurs stores)
+ *             | u32 octets de charge utile | charge utile
+ *             charge utile = 5 dictionnaires (hôtes, SIDs, utilisateurs, chemins, notes), chacun :
+ *                            varint n nouveaux mots, puis n x (varint longueur, UTF-8) ;
+ *                            ids globaux attribués dans l'ordre d'apparition
+ *                          + colonnes : hôte, SID, utilisateur, chemin, chemin normalisé, note (varint id
+ *                            global ; le chemin normalisé partage le dictionnaire des chemins),
+ *                            FILETIME (varint zigzag du delta avec la ligne précédente du bloc),
+ *                            [drapeau 0x01 : varint FILETIME - première observation],
+ *                            source, drapeaux (1 octet chacun)
+ *   Pied    : "END1" | u64 lignes totales | 5 x u32 tailles de dictionnaire
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+#include "FileTimeFormat.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class ExportFormat : uint8_t { Csv, JsonLines, Columnar };
+
+// Déduit le format de l'extension (.csv, .jsonl/.json, .bdcol) ; CSV par défaut
+ExportFormat ExportFormatFromPath(const std::filesystem::path& path);
+
+// Buffer d'octets sans initialisation à l'agrandissement
+class ByteBuffer {
+public:
+    explicit ByteBuffer(size_t initialCapacity = 0) { Reserve(initialCapacity); }
+
+    const char* data() const { return bytes.get(); }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    void clear() { length = 0; }
+
+    void Reserve(size_t capacityNeeded);
+    // Garantit n octets libres et retourne le pointeur d'écriture ; Advance() valide
+    char* Tail(size_t n) {
+        if (length + n > capacity) Reserve(std::max(length + n, capacity * 2));
+        return bytes.get() + length;
+    }
+    void Advance(size_t n) { length += n; }
+    void SetEnd(const char* end) { length = static_cast<size_t>(end - bytes.get()); }
+
+    void Append(const void* src, size_t n);
+    void Append(std::string_view text) { Append(text.data(), text.size()); }
+    void Push(char c) { *Tail(1) = c; length++; }
+    char* At(size_t offset) { return bytes.get() + offset; }
+
+private:
+    std::unique_ptr<char[]> bytes;
+    size_t length = 0;
+    size_t capacity = 0;
+};
+
+// Sérialiseur d'un format : écrit en-tête, lignes et pied dans un ByteBuffer
+class EntrySerializer {
+public:
+    virtual ~EntrySerializer() = default;
+    // history : colonne de première observation en plus (stores de HiveHistory)
+    static std::unique_ptr<EntrySerializer> Create(ExportFormat format, bool history = false);
+
+    virtual void Begin(ByteBuffer& out) = 0;
+    // Avant les Append d'un store (nouveau, ou modifié depuis) : état propre à ses ids remis à zéro
+    virtual void BeginStore(const EntryStore&) {}
+    // Lignes [first, first + count) du store ; un format par blocs peut en garder une partie jusqu'à End
+    virtual void Append(const EntryStore& store, size_t first, size_t count, const TimeFormat& format,
+                        ByteBuffer& out) = 0;
+    virtual void End(ByteBuffer& out) = 0;
+};
+
+// Écriture disque sur un thread dédié, buffers recyclés (pas d'allocation en régime établi)
+class BufferedFileWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 4u << 20;
+    static constexpr size_t BUFFER_COUNT = 4;
+
+    BufferedFileWriter() = default;
+    ~BufferedFileWriter() { Close(); }
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    bool Open(const std::filesystem::path& path);
+    // Buffer vide prêt à remplir (bloque si tous les buffers sont en cours d'écriture)
+    std::unique_ptr<ByteBuffer> Acquire();
+    // Confie un buffer plein au thread d'écriture
+    void Submit(std::unique_ptr<ByteBuffer> buffer);
+    // Vide la file et ferme ; false si une écriture a échoué
+    bool Close();
+
+    uint64_t BytesWritten() const { return bytesWritten; }
+
+private:
+    void WriterMain();
+
+    std::ofstream file;
+    std::thread writer;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::unique_ptr<ByteBuffer>> pending;
+    std::vector<std::unique_ptr<ByteBuffer>> freeBuffers;
+    size_t buffersOut = 0;
+    bool closing = false;
+    bool failed = false;
+    bool open = false;
+    uint64_t bytesWritten = 0;
+};
+
+// Étage d'export : sérialisation (thread dédié) → écriture (thread dédié)
+class ExportPipeline {
+public:
+    explicit ExportPipeline(ExportFormat format, size_t maxPendingStores = 64, bool history = false);
+    ~ExportPipeline() { Close(); }
+    ExportPipeline(const ExportPipeline&) = delete;
+    ExportPipeline& operator=(const ExportPipeline&) = delete;
+
+    bool Open(const std::filesystem::path& path);
+
+    // Asynchrone, thread-safe : le store est libéré une fois sérialisé ; bloque si la file est pleine
+    void Submit(std::unique_ptr<EntryStore> store, const TimeFormat& format);
+    // Synchrone : sérialise sur le thread appelant (le store reste à l'appelant)
+    void Write(const EntryStore& store, size_t first, size_t count, const TimeFormat& format);
+
+    bool Close();
+
+    uint64_t RowsWritten() const { return rowsWritten; }
+    uint64_t BytesWritten() const { return writer.BytesWritten(); }
+    // Stores soumis pas encore sérialisés (jauge de contre-pression)
+    size_t Pending() const;
+
+private:
+    struct Job {
+        std::unique_ptr<EntryStore> store;
+        TimeFormat format;
+    };
+
+    void SerializerMain();
+    void Serialize(const EntryStore& store, size_t first, size_t count, const TimeFormat& format);
+
+    std::unique_ptr<EntrySerializer> serializer;
+    BufferedFileWriter writer;
+    std::unique_ptr<ByteBuffer> current;
+    std::mutex serializeLock;
+
+    std::thread serializerThread;
+    mutable std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::deque<Job> queue;
+    size_t maxPending;
+    bool closing = false;
+    bool open = false;
+    uint64_t rowsWritten = 0;
+};
@@ -0,0 +1,918 @@
+/*
+ * EntryQuery - Implémentation des index (temps, postings, trie des chemins) et du langage de requête
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "EntryQuery.h"
+
+#include "CaseFile.h"
+#include "FileTimeFormat.h"
+#include "PathRules.h"
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+#include <string>
+#include <type_traits>
+
+void RowBitmap::Reset(size_t rowCount, bool all) {
+    rows = rowCount;
+    words.assign((rows + 63) / 64, all ? ~uint64_t{ 0 } : 0);
+    if (all && rows % 64) words.back() = (uint64_t{ 1 } << (rows % 64)) - 1;
+}
+
+void RowBitmap::And(const RowBitmap& other) {
+    for (size_t w = 0; w < words.size(); w++) words[w] &= other.words[w];
+}
+
+void RowBitmap::AndNot(const RowBitmap& other) {
+    for (size_t w = 0; w < words.size(); w++) words[w] &= ~other.words[w];
+}
+
+void RowBitmap::Or(const RowBitmap& other) {
+    for (size_t w = 0; w < words.size(); w++) words[w] |= other.words[w];
+}
+
+void RowBitmap::Invert() {
+    for (uint64_t& word : words) word = ~word;
+    if (rows % 64) words.back() &= (uint64_t{ 1 } << (rows % 64)) - 1;
+}
+
+size_t RowBitmap::Count() const {
+    size_t count = 0;
+    for (uint64_t bits : words) {
+        // Population par additions parallèles (pas d'intrinsèque requise)
+        bits -= (bits >> 1) & 0x5555555555555555ULL;
+        bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+        bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        count += static_cast<size_t>((bits * 0x0101010101010101ULL) >> 56);
+    }
+    return count;
+}
+
+namespace {
+
+constexpr uint32_t NO_NODE = UINT32_MAX;
+
+// Repli de casse avec raccourci ASCII (l'essentiel des chemins)
+inline char16_t Fold(char16_t c) {
+    if (c < 0x80) return (c >= u'A' && c <= u'Z') ? static_cast<char16_t>(c + 32) : c;
+    return FoldCase(c);
+}
+
+std::u16string Fold(std::u16string_view text) {
+    std::u16string folded(text);
+    for (char16_t& c : folded) c = Fold(c);
+    return folded;
+}
+
+// Motif replié (* = suite quelconque, ? = un caractère) contre un texte, replié ici si FoldText
+template <bool FoldText>
+bool GlobMatch(std::u16string_view pattern, std::u16string_view text) {
+    size_t p = 0;
+    size_t t = 0;
+    size_t starPattern = std::u16string_view::npos;
+    size_t starText = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && pattern[p] == u'*') {
+            starPattern = p++;
+            starText = t;
+        } else if (p < pattern.size() && (pattern[p] == u'?' || pattern[p] == (FoldText ? Fold(text[t]) : text[t]))) {
+            p++;
+            t++;
+        } else if (starPattern != std::u16string_view::npos) {
+            p = starPattern + 1;
+            t = ++starText;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == u'*') p++;
+    return p == pattern.size();
+}
+
+bool HasWildcard(std::u16string_view pattern) {
+    return pattern.find_first_of(u"*?") != std::u16string_view::npos;
+}
+
+// Ordre des enfants du trie : unités repliées, préfixe en premier
+int CompareFolded(std::u16string_view a, std::u16string_view b) {
+    const size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; i++) {
+        const char16_t ca = Fold(a[i]);
+        const char16_t cb = Fold(b[i]);
+        if (ca != cb) return ca < cb ? -1 : 1;
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+bool StartsWithFolded(std::u16string_view text, std::u16string_view prefix) {
+    return text.size() >= prefix.size() && CompareFolded(text.substr(0, prefix.size()), prefix) == 0;
+}
+
+// Volume d'un chemin normalisé ("C:", "\Device\HarddiskVolume3", "\\srv\share") = [0, volumeEnd),
+// reste = [restStart, fin) ; false si le chemin n'a pas de volume (relatif ou \ initial seul)
+bool SplitVolume(std::u16string_view path, size_t& volumeEnd, size_t& restStart) {
+    size_t end;
+    if (path.size() >= 2 && path[1] == u':') {
+        end = 2;
+    } else if (path.size() > 2 && path[0] == u'\\' && path[1] == u'\\') {
+        end = path.find(u'\\', 2);
+        if (end != std::u16string_view::npos) end = path.find(u'\\', end + 1);
+    } else if (StartsWithFolded(path, u"\\device\\")) {
+        end = path.find(u'\\', 8);
+    } else {
+        volumeEnd = 0;
+        restStart = !path.empty() && path[0] == u'\\' ? 1 : 0;
+        return false;
+    }
+    volumeEnd = std::min(end, path.size());
+    restStart = volumeEnd < path.size() && path[volumeEnd] == u'\\' ? volumeEnd + 1 : volumeEnd;
+    return true;
+}
+
+// Hachage FNV-1a d'un composant replié, graine = nœud parent
+uint64_t HashComponent(uint32_t parent, std::u16string_view name) {
+    uint64_t hash = 14695981039346656037ULL ^ parent;
+    for (char16_t c : name) hash = (hash ^ Fold(c)) * 1099511628211ULL;
+    return hash ^ (hash >> 29);
+}
+
+// Quatre premières unités repliées, ordre de CompareFolded : départage l'essentiel des tris sans relire les noms
+uint64_t FoldedPrefix(std::u16string_view name) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 4; i++) prefix = prefix << 16 | (i < name.size() ? Fold(name[i]) : 0);
+    return prefix;
+}
+
+}  // namespace
+
+template <class IdFn>
+void EntryIndex::Postings::Build(size_t idCount, size_t rowCount, IdFn&& id) {
+    std::vector<uint32_t> starts(idCount + 1, 0);
+    for (size_t row = 0; row < rowCount; row++) starts[id(row) + 1]++;
+    for (size_t i = 0; i < idCount; i++) starts[i + 1] += starts[i];
+    std::vector<uint32_t> listed(rowCount);
+    std::vector<uint32_t> cursor(starts.begin(), starts.end() - 1);
+    for (size_t row = 0; row < rowCount; row++) listed[cursor[id(row)]++] = static_cast<uint32_t>(row);
+    offsets.Assign(std::move(starts));
+    rows.Assign(std::move(listed));
+}
+
+void EntryIndex::Postings::AddTo(uint32_t id, RowBitmap& out) const {
+    for (uint32_t i = offsets[id]; i < offsets[id + 1]; i++) out.Set(rows[i]);
+}
+
+void EntryIndex::Postings::Save(CaseWriter& out, const std::string& name) const {
+    out.Section(name + ".offsets", offsets.data(), offsets.size());
+    out.Section(name + ".rows", rows.data(), rows.size());
+}
+
+bool EntryIndex::Postings::Attach(const CaseFile& in, const std::string& name, size_t idCount, size_t rowCount) {
+    if (!in.Attach(name + ".offsets", offsets, idCount + 1) || !in.Attach(name + ".rows", rows, rowCount)) {
+        return false;
+    }
+    // Offsets croissants de 0 à rowCount, lignes (ou rangs) sous rowCount : AddTo ne sort jamais du bitmap
+    if (offsets[0] != 0) return in.Invalid(name + ".offsets");
+    for (size_t id = 0; id < idCount; id++) {
+        if (offsets[id] > offsets[id + 1]) return in.Invalid(name + ".offsets");
+    }
+    if (offsets[idCount] != rowCount) return in.Invalid(name + ".offsets");
+    for (size_t i = 0; i < rowCount; i++) {
+        if (rows[i] >= rowCount) return in.Invalid(name + ".rows");
+    }
+    return true;
+}
+
+void EntryIndex::Build(const EntryStore& source) {
+    store = &source;
+    const size_t n = source.size();
+
+    // Tri sur des paires contiguës (pas d'accès indirect à la colonne pendant le tri)
+    struct TimedRow {
+        uint64_t time;
+        uint32_t row;
+    };
+    std::vector<TimedRow> timed(n);
+    for (size_t row = 0; row < n; row++) timed[row] = { source.FileTime(row), static_cast<uint32_t>(row) };
+    std::sort(timed.begin(), timed.end(), [](const TimedRow& a, const TimedRow& b) {
+        return a.time != b.time ? a.time < b.time : a.row < b.row;
+    });
+    std::vector<uint32_t> order(n);
+    std::vector<uint64_t> times(n);
+    for (size_t i = 0; i < n; i++) {
+        order[i] = timed[i].row;
+        times[i] = timed[i].time;
+    }
+    std::vector<TimedRow>().swap(timed);
+    timeOrder.Assign(std::move(order));
+    sortedTimes.Assign(std::move(times));
+
+    hostRows.Build(source.hosts.Count(), n, [&](size_t row) { return source.HostId(row); });
+    sidRows.Build(source.sids.Count(), n, [&](size_t row) { return source.SidId(row); });
+    userRows.Build(source.users.Count(), n, [&](size_t row) { return source.UserId(row); });
+    matchRows.Build(source.matches.Count(), n, [&](size_t row) { return source.MatchId(row); });
+    BuildPathTrie();
+}
+
+void EntryIndex::BuildPathTrie() {
+    const EntryStore& source = *store;
+    const size_t n = source.size();
+
+    // Chemins normalisés distincts ; au plus un nœud par composant
+    std::vector<uint32_t> pathRank(source.paths.Count(), UINT32_MAX);
+    std::vector<uint32_t> distinct;
+    size_t componentBound = 1;
+    for (size_t row = 0; row < n; row++) {
+        uint32_t& rank = pathRank[source.NormalizedPathId(row)];
+        if (rank != UINT32_MAX) continue;
+        rank = 0;
+        distinct.push_back(source.NormalizedPathId(row));
+        const std::u16string_view path = source.NormalizedPath(row);
+        componentBound += 2 + static_cast<size_t>(std::count(path.begin(), path.end(), u'\\'));
+    }
+
+    // Insertion dans l'ordre d'apparition : table (parent, nom replié) → nœud, dimensionnée une fois.
+    // Parcours à rebours : les chemins d'un même nœud (variantes de casse) restent dans l'ordre.
+    size_t capacity = 64;
+    while (capacity < componentBound * 2) capacity <<= 1;
+    std::vector<uint32_t> slots(capacity, NO_NODE);
+    std::vector<uint32_t> parents(1, NO_NODE);
+    std::vector<uint32_t> hashes(1, 0);  // Haut du hachage : candidats écartés sans lire leur nom
+    std::vector<uint32_t> terminalHead(1, NO_NODE);  // Nœud → premier chemin qui s'y termine
+    std::vector<uint32_t> terminalNext(distinct.size(), NO_NODE);
+    std::vector<PathNode> tree(1);
+    for (size_t d = distinct.size(); d-- > 0;) {
+        const uint32_t id = distinct[d];
+        const std::u16string_view path = source.paths.View(id).substr(0, 0xFFFF);
+        size_t volumeEnd;
+        size_t start;
+        SplitVolume(path, volumeEnd, start);
+
+        uint32_t node = 0;
+        size_t componentStart = 0;
+        size_t componentEnd = volumeEnd;
+        while (true) {
+            const std::u16string_view name = path.substr(componentStart, componentEnd - componentStart);
+            const uint64_t hash = HashComponent(node, name);
+            const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+            size_t slot = hash & (capacity - 1);
+            uint32_t child;
+            while ((child = slots[slot]) != NO_NODE) {
+                if (hashes[child] == tag && parents[child] == node &&
+                    CompareFolded(NodeName(tree[child]), name) == 0) {
+                    break;
+                }
+                slot = (slot + 1) & (capacity - 1);
+            }
+            if (child == NO_NODE) {
+                child = static_cast<uint32_t>(tree.size());
+                PathNode created;
+                created.path = id;
+                created.nameStart = static_cast<uint16_t>(componentStart);
+                created.nameLength = static_cast<uint16_t>(name.size());
+                created.nextSibling = tree[node].firstChild;
+                tree[node].firstChild = child;
+                tree.push_back(created);
+                parents.push_back(node);
+                hashes.push_back(tag);
+                terminalHead.push_back(NO_NODE);
+                slots[slot] = child;
+            }
+            node = child;
+
+            if (start >= path.size()) break;
+            componentStart = start;
+            componentEnd = path.find(u'\\', start);
+            if (componentEnd == std::u16string_view::npos) componentEnd = path.size();
+            start = componentEnd + 1;
+        }
+        terminalNext[d] = terminalHead[node];
+        terminalHead[node] = static_cast<uint32_t>(d);
+    }
+    std::vector<uint32_t>().swap(slots);
+    std::vector<uint32_t>().swap(parents);
+    std::vector<uint32_t>().swap(hashes);
+
+    std::vector<std::pair<uint64_t, uint32_t>> scratch;
+    for (uint32_t node = 0; node < tree.size(); node++) SortChildren(tree, node, scratch);
+
+    // Rangs en préordre : chemins qui se terminent sur le nœud, puis ses enfants dans l'ordre
+    std::vector<uint32_t> ranked;
+    ranked.reserve(distinct.size());
+    std::vector<std::pair<uint32_t, uint32_t>> stack;  // (nœud, prochain enfant)
+    const auto enter = [&](uint32_t node) {
+        tree[node].rankBegin = static_cast<uint32_t>(ranked.size());
+        for (uint32_t d = terminalHead[node]; d != NO_NODE; d = terminalNext[d]) {
+            pathRank[distinct[d]] = static_cast<uint32_t>(ranked.size());
+            ranked.push_back(distinct[d]);
+        }
+        stack.emplace_back(node, tree[node].firstChild);
+    };
+    enter(0);
+    while (!stack.empty()) {
+        const uint32_t child = stack.back().second;
+        if (child == NO_NODE) {
+            tree[stack.back().first].rankEnd = static_cast<uint32_t>(ranked.size());
+            stack.pop_back();
+            continue;
+        }
+        stack.back().second = tree[child].nextSibling;
+        enter(child);
+    }
+    nodes.Assign(std::move(tree));
+    rankPaths.Assign(std::move(ranked));
+    rankRows.Build(rankPaths.size(), n, [&](size_t row) { return pathRank[source.NormalizedPathId(row)]; });
+
+    // Noms de fichier distincts → rangs
+    fileNames.Clear();
+    std::vector<uint32_t> rankName(rankPaths.size());
+    std::u16string name;
+    for (size_t rank = 0; rank < rankPaths.size(); rank++) {
+        const std::u16string_view path = source.paths.View(rankPaths[rank]);
+        const size_t slash = path.rfind(u'\\');
+        name.clear();
+        for (char16_t c : slash == std::u16string_view::npos ? path : path.substr(slash + 1)) name += Fold(c);
+        rankName[rank] = fileNames.Intern(name);
+    }
+    nameRanks.Build(fileNames.Count(), rankPaths.size(), [&](size_t rank) { return rankName[rank]; });
+}
+
+void EntryIndex::SortChildren(std::vector<PathNode>& tree, uint32_t node,
+                              std::vector<std::pair<uint64_t, uint32_t>>& scratch) const {
+    if (tree[node].firstChild == NO_NODE || tree[tree[node].firstChild].nextSibling == NO_NODE) return;
+    scratch.clear();
+    for (uint32_t child = tree[node].firstChild; child != NO_NODE; child = tree[child].nextSibling) {
+        scratch.emplace_back(FoldedPrefix(NodeName(tree[child])), child);
+    }
+    std::sort(scratch.begin(), scratch.end(), [&](const auto& a, const auto& b) {
+        if (a.first != b.first) return a.first < b.first;
+        return CompareFolded(NodeName(tree[a.second]), NodeName(tree[b.second])) < 0;
+    });
+    tree[node].firstChild = scratch[0].second;
+    for (size_t i = 0; i < scratch.size(); i++) {
+        tree[scratch[i].second].nextSibling = i + 1 < scratch.size() ? scratch[i + 1].second : NO_NODE;
+    }
+}
+
+void EntryIndex::Save(CaseWriter& out) const {
+    static_assert(std::is_trivially_copyable<PathNode>::value && sizeof(PathNode) == 24, "nœud enregistré tel quel");
+    out.Section("index.timeOrder", timeOrder.data(), timeOrder.size());
+    out.Section("index.sortedTimes", sortedTimes.data(), sortedTimes.size());
+    hostRows.Save(out, "index.hostRows");
+    sidRows.Save(out, "index.sidRows");
+    userRows.Save(out, "index.userRows");
+    matchRows.Save(out, "index.matchRows");
+    out.Section("index.nodes", nodes.data(), nodes.size());
+    out.Section("index.rankPaths", rankPaths.data(), rankPaths.size());
+    rankRows.Save(out, "index.rankRows");
+    fileNames.Save(out, "index.fileNames");
+    nameRanks.Save(out, "index.nameRanks");
+}
+
+bool EntryIndex::Attach(const CaseFile& in, const EntryStore& source) {
+    store = &source;
+    const size_t n = source.size();
+    if (!in.Attach("index.timeOrder", timeOrder, n) || !in.Attach("index.sortedTimes", sortedTimes, n) ||
+        !hostRows.Attach(in, "index.hostRows", source.hosts.Count(), n) ||
+        !sidRows.Attach(in, "index.sidRows", source.sids.Count(), n) ||
+        !userRows.Attach(in, "index.userRows", source.users.Count(), n) ||
+        !matchRows.Attach(in, "index.matchRows", source.matches.Count(), n) || !in.Attach("index.nodes", nodes) ||
+        nodes.empty() || !in.Attach("index.rankPaths", rankPaths) ||
+        !rankRows.Attach(in, "index.rankRows", rankPaths.size(), n) || !fileNames.Attach(in, "index.fileNames") ||
+        !nameRanks.Attach(in, "index.nameRanks", fileNames.Count(), rankPaths.size()) || !Validate(in)) {
+        store = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool EntryIndex::Validate(const CaseFile& in) const {
+    const size_t n = timeOrder.size();
+    for (size_t i = 0; i < n; i++) {
+        if (timeOrder[i] >= n) return in.Invalid("index.timeOrder");
+    }
+    for (size_t rank = 0; rank < rankPaths.size(); rank++) {
+        if (rankPaths[rank] >= store->paths.Count()) return in.Invalid("index.rankPaths");
+    }
+
+    // Liens du trie dans le tableau, nom dans son chemin, rangs dans rankPaths ; un nœud n'a qu'un seul
+    // parent ou frère précédent et la racine aucun : les parcours depuis la racine se terminent
+    std::vector<uint8_t> linked(nodes.size(), 0);
+    linked[0] = 1;
+    auto link = [&](uint32_t target) {
+        if (target == NO_NODE) return true;
+        if (target >= nodes.size() || linked[target]) return false;
+        linked[target] = 1;
+        return true;
+    };
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const PathNode& node = nodes[i];
+        if (node.path >= store->paths.Count() ||
+            size_t(node.nameStart) + node.nameLength > store->paths.View(node.path).size() ||
+            node.rankBegin > node.rankEnd || node.rankEnd > rankPaths.size() || !link(node.firstChild) ||
+            !link(node.nextSibling)) {
+            return in.Invalid("index.nodes");
+        }
+    }
+    return true;
+}
+
+size_t EntryIndex::MemoryBytes() const {
+    return timeOrder.capacity() * sizeof(uint32_t) + sortedTimes.capacity() * sizeof(uint64_t) +
+           hostRows.MemoryBytes() + sidRows.MemoryBytes() + userRows.MemoryBytes() + matchRows.MemoryBytes() +
+           nodes.capacity() * sizeof(PathNode) + rankPaths.capacity() * sizeof(uint32_t) +
+           rankRows.MemoryBytes() + fileNames.MemoryBytes() + nameRanks.MemoryBytes();
+}
+
+void EntryIndex::SelectTime(uint64_t first, uint64_t end, RowBitmap& out) const {
+    first = std::max<uint64_t>(first, 1);
+    const size_t begin = std::lower_bound(sortedTimes.begin(), sortedTimes.end(), first) - sortedTimes.begin();
+    const size_t stop = std::lower_bound(sortedTimes.begin() + begin, sortedTimes.end(), end) - sortedTimes.begin();
+    if (stop - begin > timeOrder.size() / 16) {
+        // Plage large : la colonne parcourue dans l'ordre coûte moins que des bits épars
+        const uint64_t width = end - first;  // first <= t < end en une comparaison non signée
+        out.AddWhere([&](size_t row) { return store->FileTime(row) - first < width; });
+        return;
+    }
+    for (size_t i = begin; i < stop; i++) out.Set(timeOrder[i]);
+}
+
+void EntryIndex::SelectValues(QueryField field, std::u16string_view pattern, RowBitmap& out) const {
+    const StringPool* pool = nullptr;
+    const Postings* postings = &matchRows;
+    switch (field) {
+    case QueryField::Host:
+        pool = &store->hosts;
+        postings = &hostRows;
+        break;
+    case QueryField::Sid:
+        pool = &store->sids;
+        postings = &sidRows;
+        break;
+    case QueryField::User:
+        pool = &store->users;
+        postings = &userRows;
+        break;
+    case QueryField::Note: break;
+    }
+    const size_t idCount = postings->offsets.size() - 1;
+    std::vector<uint8_t> selected(idCount);
+    size_t rowCount = 0;
+    for (uint32_t id = 0; id < idCount; id++) {
+        if (!GlobMatch<true>(pattern, pool ? pool->View(id) : store->matches.Note(id))) continue;
+        selected[id] = 1;
+        rowCount += postings->offsets[id + 1] - postings->offsets[id];
+    }
+    if (rowCount <= timeOrder.size() / 16) {
+        for (uint32_t id = 0; id < idCount; id++) {
+            if (selected[id]) postings->AddTo(id, out);
+        }
+        return;
+    }
+    // Beaucoup de lignes : la colonne d'ids parcourue dans l'ordre coûte moins que des bits posés un à un
+    const auto scan = [&](auto idOf) { out.AddWhere([&](size_t row) { return selected[idOf(row)] != 0; }); };
+    switch (field) {
+    case QueryField::Host: scan([&](size_t row) { return store->HostId(row); }); break;
+    case QueryField::Sid: scan([&](size_t row) { return store->SidId(row); }); break;
+    case QueryField::User: scan([&](size_t row) { return store->UserId(row); }); break;
+    case QueryField::Note: scan([&](size_t row) { return store->MatchId(row); }); break;
+    }
+}
+
+void EntryIndex::SelectSource(EntrySource source, RowBitmap& out) const {
+    out.AddWhere([&](size_t row) { return store->Source(row) == source; });
+}
+
+void EntryIndex::MatchComponents(uint32_t node, const std::vector<std::u16string>& components, size_t depth,
+                                 std::vector<uint32_t>& matched) const {
+    if (depth == components.size()) {
+        matched.push_back(node);
+        return;
+    }
+    const std::u16string& component = components[depth];
+    const bool literal = !HasWildcard(component);
+    for (uint32_t child = nodes[node].firstChild; child != NO_NODE; child = nodes[child].nextSibling) {
+        const std::u16string_view name = NodeName(nodes[child]);
+        if (literal) {
+            // Enfants triés : arrêt au premier nom supérieur
+            const int c = CompareFolded(name, component);
+            if (c < 0) continue;
+            if (c == 0) MatchComponents(child, components, depth + 1, matched);
+            return;
+        }
+        if (GlobMatch<true>(component, name)) MatchComponents(child, components, depth + 1, matched);
+    }
+}
+
+void EntryIndex::AddRanks(uint32_t rankBegin, uint32_t rankEnd, RowBitmap& out) const {
+    for (uint32_t i = rankRows.offsets[rankBegin]; i < rankRows.offsets[rankEnd]; i++) out.Set(rankRows.rows[i]);
+}
+
+void EntryIndex::SelectPath(std::u16string_view pattern, RowBitmap& out) const {
+    // Composants du motif : volume (* si \ initial sans volume), répertoires, préfixe de nom
+    std::vector<std::u16string> components;
+    size_t volumeEnd;
+    size_t restStart;
+    if (SplitVolume(pattern, volumeEnd, restStart)) {
+        components.push_back(Fold(pattern.substr(0, volumeEnd)));
+    } else {
+        components.push_back(restStart > 0 ? u"*" : u"");
+    }
+    const std::u16string_view rest = pattern.substr(restStart);
+    const bool directory = rest.empty() || rest.back() == u'\\';
+    for (size_t start = 0; start < rest.size();) {
+        size_t end = rest.find(u'\\', start);
+        if (end == std::u16string_view::npos) end = rest.size();
+        if (end > start) components.push_back(Fold(rest.substr(start, end - start)));
+        start = end + 1;
+    }
+    if (!directory) components.back() += u'*';
+
+    std::vector<uint32_t> matched;
+    MatchComponents(0, components, 0, matched);
+    // Nœuds de même profondeur : sous-arbres disjoints
+    for (uint32_t node : matched) AddRanks(nodes[node].rankBegin, nodes[node].rankEnd, out);
+}
+
+void EntryIndex::SelectName(std::u16string_view pattern, RowBitmap& out) const {
+    for (uint32_t id = 0; id < fileNames.Count(); id++) {
+        if (!GlobMatch<false>(pattern, fileNames.View(id))) continue;
+        for (uint32_t i = nameRanks.offsets[id]; i < nameRanks.offsets[id + 1]; i++) {
+            AddRanks(nameRanks.rows[i], nameRanks.rows[i] + 1, out);
+        }
+    }
+}
+
+std::vector<uint32_t> EntryIndex::OrderByTime(const RowBitmap& selection, size_t limit) const {
+    std::vector<uint32_t> rows;
+    const size_t count = selection.Count();
+    rows.reserve(std::min(count, limit));
+    if (count > timeOrder.size() / 64) {
+        // Grande sélection : un passage sur l'index temporel plutôt qu'un tri
+        for (size_t i = 0; i < timeOrder.size() && rows.size() < limit; i++) {
+            if (selection.Test(timeOrder[i])) rows.push_back(timeOrder[i]);
+        }
+        return rows;
+    }
+    selection.ForEach([&](uint32_t row) { rows.push_back(row); });
+    const auto earlier = [&](uint32_t a, uint32_t b) {
+        const uint64_t ta = store->FileTime(a);
+        const uint64_t tb = store->FileTime(b);
+        return ta != tb ? ta < tb : a < b;
+    };
+    if (limit < rows.size()) {
+        std::partial_sort(rows.begin(), rows.begin() + limit, rows.end(), earlier);
+        rows.resize(limit);
+    } else {
+        std::sort(rows.begin(), rows.end(), earlier);
+    }
+    return rows;
+}
+
+namespace {
+
+bool ParseDigits(std::string_view text, size_t& pos, size_t count, uint32_t& value) {
+    value = 0;
+    for (size_t i = 0; i < count; i++, pos++) {
+        if (pos >= text.size() || text[pos] < '0' || text[pos] > '9') return false;
+        value = value * 10 + static_cast<uint32_t>(text[pos] - '0');
+    }
+    return true;
+}
+
+bool Expect(std::string_view text, size_t& pos, char c) {
+    if (pos >= text.size() || text[pos] != c) return false;
+    pos++;
+    return true;
+}
+
+}  // namespace
+
+bool ParseQueryTime(std::string_view text, uint64_t& fileTime, uint64_t& unit) {
+    size_t pos = 0;
+    uint32_t year;
+    uint32_t month;
+    uint32_t day;
+    if (!ParseDigits(text, pos, 4, year) || !Expect(text, pos, '-') || !ParseDigits(text, pos, 2, month) ||
+        !Expect(text, pos, '-') || !ParseDigits(text, pos, 2, day)) {
+        return false;
+    }
+    if (year < 1601 || month < 1 || month > 12 || day < 1) return false;
+    const int64_t days = CivilToDays(static_cast<int32_t>(year), month, day);
+    if (DaysToCivil(days).day != day) return false;  // 31 avril, 29 février hors bissextile
+
+    uint64_t ticks = 0;
+    unit = 86400 * FILETIME_TICKS_PER_SECOND;
+    if (pos < text.size() && (text[pos] == 'T' || text[pos] == 't')) {
+        pos++;
+        uint32_t hour;
+        uint32_t minute;
+        if (!ParseDigits(text, pos, 2, hour) || !Expect(text, pos, ':') || !ParseDigits(text, pos, 2, minute) ||
+            hour > 23 || minute > 59) {
+            return false;
+        }
+        ticks = (hour * 60ULL + minute) * FILETIME_TICKS_PER_MINUTE;
+        unit = FILETIME_TICKS_PER_MINUTE;
+        if (pos < text.size() && text[pos] == ':') {
+            pos++;
+            uint32_t second;
+            if (!ParseDigits(text, pos, 2, second) || second > 59) return false;
+            ticks += second * FILETIME_TICKS_PER_SECOND;
+            unit = FILETIME_TICKS_PER_SECOND;
+            if (pos < text.size() && text[pos] == '.') {
+                pos++;
+                uint64_t scale = FILETIME_TICKS_PER_SECOND;
+                size_t digits = 0;
+                for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && digits < 7; pos++, digits++) {
+                    scale /= 10;
+                    ticks += static_cast<uint64_t>(text[pos] - '0') * scale;
+                }
+                if (digits == 0) return false;
+                unit = scale;
+            }
+        }
+    }
+    if (pos < text.size() && (text[pos] == 'Z' || text[pos] == 'z')) pos++;
+    if (pos != text.size()) return false;
+
+    fileTime = static_cast<uint64_t>(days + FILETIME_EPOCH_DAYS) * 86400 * FILETIME_TICKS_PER_SECOND + ticks;
+    return true;
+}
+
+// Descente récursive : or < and (implicite) < not < terme / parenthèses
+class EntryQuery::Parser {
+public:
+    Parser(std::vector<Node>& nodes, std::string& error) : nodes(nodes), error(error) {}
+
+    bool Run(std::string_view text, uint32_t& root) {
+        if (!Tokenize(text)) return false;
+        if (tokens.size() == 1) return Fail(0, "requête vide");
+        if (!ParseOr(root)) return false;
+        if (tokens[next].kind != TokenKind::End) return Fail(tokens[next].position, "')' inattendue");
+        return true;
+    }
+
+private:
+    enum class TokenKind : uint8_t { Term, And, Or, Not, Open, Close, End };
+
+    struct Token {
+        TokenKind kind = TokenKind::End;
+        size_t position = 0;  // Octet de début dans la requête
+        std::string field;
+        std::string value;
+    };
+
+    bool Fail(size_t position, const char* message, const std::string& detail = std::string()) {
+        error = message;
+        if (!detail.empty()) error += " '" + detail + "'";
+        error += " (position " + std::to_string(position + 1) + ")";
+        return false;
+    }
+
+    static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    static bool EqualsKeyword(const std::string& word, const char* keyword) {
+        size_t i = 0;
+        for (; i < word.size() && keyword[i]; i++) {
+            if (std::tolower(static_cast<unsigned char>(word[i])) != keyword[i]) return false;
+        }
+        return i == word.size() && !keyword[i];
+    }
+
+    // Mots séparés par des blancs ou des parenthèses ; "..." protège blancs et parenthèses
+    bool Tokenize(std::string_view text) {
+        size_t pos = 0;
+        while (true) {
+            while (pos < text.size() && IsSpace(text[pos])) pos++;
+            Token token;
+            token.position = pos;
+            if (pos >= text.size()) {
+                tokens.push_back(token);
+                return true;
+            }
+            if (text[pos] == '(' || text[pos] == ')') {
+                token.kind = text[pos++] == '(' ? TokenKind::Open : TokenKind::Close;
+                tokens.push_back(token);
+                continue;
+            }
+
+            std::string word;
+            bool quoted = false;
+            bool hasField = false;
+            while (pos < text.size() && !IsSpace(text[pos]) && text[pos] != '(' && text[pos] != ')') {
+                if (text[pos] == '"') {
+                    const size_t close = text.find('"', pos + 1);
+                    if (close == std::string_view::npos) return Fail(pos, "guillemet non fermé");
+                    word.append(text.substr(pos + 1, close - pos - 1));
+                    quoted = true;
+                    pos = close + 1;
+                } else {
+                    if (text[pos] == ':' && !hasField && !quoted) {
+                        token.field = word;
+                        word.clear();
+                        hasField = true;
+                    } else {
+                        word += text[pos];
+                    }
+                    pos++;
+                }
+            }
+            if (!hasField) {
+                if (!quoted && EqualsKeyword(word, "and")) token.kind = TokenKind::And;
+                else if (!quoted && EqualsKeyword(word, "or")) token.kind = TokenKind::Or;
+                else if (!quoted && EqualsKeyword(word, "not")) token.kind = TokenKind::Not;
+                else return Fail(token.position, "terme sans champ (user:, path:, time:...)", word);
+            } else {
+                token.kind = TokenKind::Term;
+                token.value = std::move(word);
+            }
+            tokens.push_back(std::move(token));
+        }
+    }
+
+    uint32_t Add(Node node) {
+        nodes.push_back(std::move(node));
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    // Nœud and/or à un seul enfant : l'enfant lui-même
+    uint32_t Combine(NodeKind kind, std::vector<uint32_t>&& children) {
+        if (children.size() == 1) return children[0];
+        Node node;
+        node.kind = kind;
+        node.children = std::move(children);
+        return Add(std::move(node));
+    }
+
+    bool ParseOr(uint32_t& out) {
+        std::vector<uint32_t> children(1);
+        if (!ParseAnd(children[0])) return false;
+        while (tokens[next].kind == TokenKind::Or) {
+            next++;
+            children.emplace_back();
+            if (!ParseAnd(children.back())) return false;
+        }
+        out = Combine(NodeKind::Or, std::move(children));
+        return true;
+    }
+
+    bool ParseAnd(uint32_t& out) {
+        std::vector<uint32_t> children(1);
+        if (!ParseUnary(children[0])) return false;
+        while (true) {
+            const TokenKind kind = tokens[next].kind;
+            if (kind == TokenKind::Or || kind == TokenKind::Close || kind == TokenKind::End) break;
+            if (kind == TokenKind::And) next++;
+            children.emplace_back();
+            if (!ParseUnary(children.back())) return false;
+        }
+        out = Combine(NodeKind::And, std::move(children));
+        return true;
+    }
+
+    bool ParseUnary(uint32_t& out) {
+        const Token& token = tokens[next];
+        switch (token.kind) {
+        case TokenKind::Not: {
+            next++;
+            Node node;
+            node.kind = NodeKind::Not;
+            node.children.resize(1);
+            if (!ParseUnary(node.children[0])) return false;
+            out = Add(std::move(node));
+            return true;
+        }
+        case TokenKind::Open:
+            next++;
+            if (!ParseOr(out)) return false;
+            if (tokens[next].kind != TokenKind::Close) return Fail(tokens[next].position, "')' attendue");
+            next++;
+            return true;
+        case TokenKind::Term:
+            next++;
+            return ParseTerm(token, out);
+        default:
+            return Fail(token.position, "terme attendu");
+        }
+    }
+
+    bool ParseTime(const Token& token, std::string_view text, uint64_t& fileTime, uint64_t& unit) {
+        if (ParseQueryTime(text, fileTime, unit)) return true;
+        return Fail(token.position, "date invalide (AAAA-MM-JJ[THH:MM[:SS[.fffffff]]])", std::string(text));
+    }
+
+    bool ParseTerm(const Token& token, uint32_t& out) {
+        Node node;
+        const std::string& field = token.field;
+        const std::string_view value = token.value;
+        uint64_t unit = 0;
+        if (EqualsKeyword(field, "user") || EqualsKeyword(field, "sid") || EqualsKeyword(field, "host") ||
+            EqualsKeyword(field, "note")) {
+            node.kind = NodeKind::Values;
+            if (EqualsKeyword(field, "host")) node.field = QueryField::Host;
+            else if (EqualsKeyword(field, "sid")) node.field = QueryField::Sid;
+            else if (EqualsKeyword(field, "note")) node.field = QueryField::Note;
+            node.pattern = Fold(Utf8ToU16(value));
+        } else if (EqualsKeyword(field, "name")) {
+            node.kind = NodeKind::Name;
+            node.pattern = Fold(Utf8ToU16(value));
+        } else if (EqualsKeyword(field, "path")) {
+            node.kind = NodeKind::Path;
+            node.pattern = Utf8ToU16(value);
+        } else if (EqualsKeyword(field, "source")) {
+            node.kind = NodeKind::Source;
+            if (EqualsKeyword(token.value, "bam")) node.source = EntrySource::Bam;
+            else if (EqualsKeyword(token.value, "dam")) node.source = EntrySource::Dam;
+            else if (EqualsKeyword(token.value, "recovered")) node.source = EntrySource::Recovered;
+            else return Fail(token.position, "source inconnue (bam, dam ou recovered)", token.value);
+        } else if (EqualsKeyword(field, "after")) {
+            node.kind = NodeKind::Time;
+            if (!ParseTime(token, value, node.first, unit)) return false;
+            node.end = UINT64_MAX;
+        } else if (EqualsKeyword(field, "before")) {
+            node.kind = NodeKind::Time;
+            if (!ParseTime(token, value, node.end, unit)) return false;
+        } else if (EqualsKeyword(field, "time")) {
+            node.kind = NodeKind::Time;
+            const size_t dots = value.find("..");
+            const std::string_view from = dots == std::string_view::npos ? value : value.substr(0, dots);
+            const std::string_view to = dots == std::string_view::npos ? value : value.substr(dots + 2);
+            if (from.empty() && to.empty()) return Fail(token.position, "plage de temps vide");
+            node.end = UINT64_MAX;
+            if (!from.empty() && !ParseTime(token, from, node.first, unit)) return false;
+            if (!to.empty()) {
+                if (!ParseTime(token, to, node.end, unit)) return false;
+                node.end += unit;  // Borne haute comprise à l'unité saisie
+            }
+        } else {
+            return Fail(token.position, "champ inconnu", field);
+        }
+        out = Add(std::move(node));
+        return true;
+    }
+
+    std::vector<Node>& nodes;
+    std::string& error;
+    std::vector<Token> tokens;
+    size_t next = 0;
+};
+
+bool EntryQuery::Parse(std::string_view text) {
+    nodes.clear();
+    root = UINT32_MAX;
+    lastError.clear();
+    Parser parser(nodes, lastError);
+    if (parser.Run(text, root)) return true;
+    nodes.clear();
+    root = UINT32_MAX;
+    return false;
+}
+
+RowBitmap EntryQuery::Evaluate(const EntryIndex& index) const {
+    if (root == UINT32_MAX) return RowBitmap(index.Rows());
+    return EvaluateNode(index, root);
+}
+
+RowBitmap EntryQuery::EvaluateNode(const EntryIndex& index, uint32_t id) const {
+    const Node& node = nodes[id];
+    RowBitmap result(index.Rows());
+    switch (node.kind) {
+    case NodeKind::And:
+        result.Reset(index.Rows(), true);
+        for (uint32_t child : node.children) {
+            // x and not y : différence directe, sans inverser y
+            if (nodes[child].kind == NodeKind::Not) {
+                result.AndNot(EvaluateNode(index, nodes[child].children[0]));
+            } else {
+                result.And(EvaluateNode(index, child));
+            }
+        }
+        break;
+    case NodeKind::Or:
+        for (uint32_t child : node.children) result.Or(EvaluateNode(index, child));
+        break;
+    case NodeKind::Not:
+        result = EvaluateNode(index, node.children[0]);
+        result.Invert();
+        break;
+    case NodeKind::Time:
+        index.SelectTime(node.first, node.end, result);
+        break;
+    case NodeKind::Values:
+        index.SelectValues(node.field, node.pattern, result);
+        break;
+    case NodeKind::Source:
+        index.SelectSource(node.source, result);
+        break;
+    case NodeKind::Path:
+        index.SelectPath(node.pattern, result);
+        break;
+    case NodeKind::Name:
+        index.SelectName(node.pattern, result);
+        break;
+    }
+    return result;
+}
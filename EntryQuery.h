@@ -0,0 +1,228 @@
+/*
+ * EntryQuery - Requêtes indexées sur un EntryStore (utilisateur, plage de temps, préfixe de chemin)
+ *
+ * "Tout ce que X a lancé entre T1 et T2 sous \Users\*\AppData\" ne relit plus toutes les lignes :
+ *
+ * - EntryIndex, construit une fois par store :
+ *   - index temporel : lignes triées par FILETIME, plage [T1, T2) = deux recherches dichotomiques
+ *   - listes de postings (CSR : décalages + lignes croissantes) par hôte, SID, utilisateur et
+ *     combinaison de règles ; un motif sur les valeurs ne parcourt que les chaînes distinctes
+ *   - trie des chemins normalisés par composant (casse repliée, volume = premier niveau : "c:",
+ *     "\device\harddiskvolume3", "\\srv\share") ; les chemins distincts sont numérotés dans l'ordre
+ *     du trie, chaque nœud couvre un intervalle de rangs et chaque rang ses lignes (CSR), un préfixe
+ *     est donc un parcours de quelques nœuds puis une copie de lignes contiguës. Les noms des nœuds
+ *     restent dans le StringPool du store (id du chemin, début, longueur) : pas de copie des chaînes
+ *   - noms de fichier distincts (dernier composant, casse repliée) → rangs, pour name:
+ * - RowBitmap : un bit par ligne ; chaque terme produit un bitmap, and / or / not les combinent mot
+ *   par mot (64 lignes par opération)
+ * - EntryQuery : petit langage compilé une fois, évalué sur n'importe quel index
+ * - L'index s'enregistre avec son store dans un fichier de cas (CaseFile, sections "index.*") et se
+ *   rouvre projeté, sans reconstruction
+ *
+ * Langage (mots-clés insensibles à la casse, "and" implicite entre deux termes) :
+ *   user:motif  sid:motif  host:motif  note:motif   * et ? ; valeur entre guillemets si espaces
+ *   path:C:\Users\       sous-arbre (\ final) ; sans \ final, le dernier composant est un préfixe de nom
+ *   path:\Users\*\AppData\   \ initial = tout volume ; * = un composant quelconque
+ *   name:*.exe           dernier composant du chemin (motif)
+ *   source:bam|dam|recovered
+ *   after:T              à partir de T          before:T   avant T
+ *   time:T1..T2          de T1 à T2 compris, à l'unité saisie (time:2024-03-01..2024-03-07 : sept jours) ;
+ *                        borne omise = ouverte ; time:T = l'unité T (jour, minute, seconde...)
+ *     T = AAAA-MM-JJ[THH:MM[:SS[.fffffff]]][Z], toujours en UTC
+ *   not x   x and y   x or y   ( ... )       priorité : not, and, or
+ * Les lignes sans FILETIME valide ne satisfont aucun terme de temps.
+ *
+ * Ex. : user:jdoe time:2024-03-01..2024-03-07 path:\Users\*\AppData\ not note:""
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Ensemble de lignes d'un store
+class RowBitmap {
+public:
+    RowBitmap() = default;
+    explicit RowBitmap(size_t rows, bool all = false) { Reset(rows, all); }
+
+    void Reset(size_t rows, bool all = false);
+    size_t Size() const { return rows; }
+    void Set(uint32_t row) { words[row >> 6] |= uint64_t{ 1 } << (row & 63); }
+    bool Test(uint32_t row) const { return words[row >> 6] >> (row & 63) & 1; }
+
+    // Ajoute les lignes row < Size() pour lesquelles test(row) : parcours séquentiel, un mot à la fois
+    template <class F>
+    void AddWhere(F&& test) {
+        for (size_t w = 0; w < words.size(); w++) {
+            const size_t base = w * 64;
+            const size_t count = std::min<size_t>(64, rows - base);
+            uint64_t bits = 0;
+            for (size_t i = 0; i < count; i++) bits |= static_cast<uint64_t>(test(base + i) ? 1 : 0) << i;
+            words[w] |= bits;
+        }
+    }
+
+    void And(const RowBitmap& other);
+    void AndNot(const RowBitmap& other);
+    void Or(const RowBitmap& other);
+    void Invert();
+    size_t Count() const;
+
+    // fn(uint32_t row) par ligne présente, ordre croissant
+    template <class F>
+    void ForEach(F&& fn) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+                fn(static_cast<uint32_t>(w * 64 + CountTrailingZeros(bits)));
+            }
+        }
+    }
+
+private:
+    static unsigned CountTrailingZeros(uint64_t bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return index;
+#else
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+    }
+
+    std::vector<uint64_t> words;
+    size_t rows = 0;
+};
+
+enum class QueryField : uint8_t { Host, Sid, User, Note };
+
+class EntryIndex {
+public:
+    // Le store doit rester vivant et inchangé tant que l'index sert
+    void Build(const EntryStore& store);
+    const EntryStore* Store() const { return store; }
+    size_t Rows() const { return timeOrder.size(); }
+    size_t PathCount() const { return rankPaths.size(); }
+    size_t NodeCount() const { return nodes.size(); }
+    size_t MemoryBytes() const;
+
+    // Fichier de cas : tableaux de l'index tels qu'en mémoire ; Attach les lit en place, sur le store
+    // adossé au même fichier
+    void Save(CaseWriter& out) const;
+    bool Attach(const CaseFile& in, const EntryStore& store);
+
+    // Chaque Select ajoute (or) ses lignes à out, dimensionné sur Rows()
+    // FILETIME dans [first, end) ; FILETIME nul (données invalides) exclu
+    void SelectTime(uint64_t first, uint64_t end, RowBitmap& out) const;
+    // Valeurs distinctes du champ correspondant au motif (* et ?, casse repliée)
+    void SelectValues(QueryField field, std::u16string_view pattern, RowBitmap& out) const;
+    void SelectSource(EntrySource source, RowBitmap& out) const;
+    // Motif de chemin (voir le langage) sur le chemin normalisé
+    void SelectPath(std::u16string_view pattern, RowBitmap& out) const;
+    // Motif sur le dernier composant du chemin normalisé
+    void SelectName(std::u16string_view pattern, RowBitmap& out) const;
+
+    // Lignes de selection par FILETIME croissant (puis numéro de ligne), limit premières au plus
+    std::vector<uint32_t> OrderByTime(const RowBitmap& selection, size_t limit = SIZE_MAX) const;
+
+private:
+    // Listes de lignes par id : lignes de l'id i = rows[offsets[i], offsets[i + 1])
+    struct Postings {
+        Column<uint32_t> offsets;
+        Column<uint32_t> rows;
+
+        template <class IdFn>
+        void Build(size_t idCount, size_t rowCount, IdFn&& id);
+        void AddTo(uint32_t id, RowBitmap& out) const;
+        void Save(CaseWriter& out, const std::string& name) const;
+        bool Attach(const CaseFile& in, const std::string& name, size_t idCount, size_t rowCount);
+        size_t MemoryBytes() const { return (offsets.capacity() + rows.capacity()) * sizeof(uint32_t); }
+    };
+
+    // Nœud du trie : composant = unités [nameStart, nameStart + nameLength) du chemin path (les noms de
+    // valeur du registre sont limités à 16383 caractères), enfants triés par nom replié (premier enfant,
+    // frère suivant), rangs des chemins du sous-arbre
+    struct PathNode {
+        uint32_t path = 0;
+        uint16_t nameStart = 0;
+        uint16_t nameLength = 0;
+        uint32_t firstChild = UINT32_MAX;
+        uint32_t nextSibling = UINT32_MAX;
+        uint32_t rankBegin = 0;
+        uint32_t rankEnd = 0;
+    };
+
+    void BuildPathTrie();
+    // Fichier de cas : lignes, ids et liens du trie dans leurs bornes (Attach)
+    bool Validate(const CaseFile& in) const;
+    std::u16string_view NodeName(const PathNode& node) const {
+        return store->paths.View(node.path).substr(node.nameStart, node.nameLength);
+    }
+    void SortChildren(std::vector<PathNode>& tree, uint32_t node,
+                      std::vector<std::pair<uint64_t, uint32_t>>& scratch) const;
+    void MatchComponents(uint32_t node, const std::vector<std::u16string>& components, size_t depth,
+                         std::vector<uint32_t>& matched) const;
+    void AddRanks(uint32_t rankBegin, uint32_t rankEnd, RowBitmap& out) const;
+
+    const EntryStore* store = nullptr;
+    Column<uint32_t> timeOrder;  // Lignes par FILETIME croissant
+    Column<uint64_t> sortedTimes;
+    Postings hostRows;
+    Postings sidRows;
+    Postings userRows;
+    Postings matchRows;
+
+    Column<PathNode> nodes;  // nodes[0] = racine (enfants = volumes)
+    Column<uint32_t> rankPaths;  // Rang → id du chemin normalisé
+    Postings rankRows;
+    StringPool fileNames;  // Derniers composants repliés
+    Postings nameRanks;
+};
+
+class EntryQuery {
+public:
+    // Compile l'expression (UTF-8) ; erreur avec position dans LastError()
+    bool Parse(std::string_view text);
+    const std::string& LastError() const { return lastError; }
+
+    // Lignes satisfaisant la requête compilée
+    RowBitmap Evaluate(const EntryIndex& index) const;
+
+private:
+    enum class NodeKind : uint8_t { And, Or, Not, Time, Values, Source, Path, Name };
+
+    struct Node {
+        NodeKind kind = NodeKind::And;
+        QueryField field = QueryField::User;
+        EntrySource source = EntrySource::Bam;
+        uint64_t first = 0;  // Time : [first, end)
+        uint64_t end = 0;
+        std::u16string pattern;
+        std::vector<uint32_t> children;
+    };
+
+    class Parser;
+
+    RowBitmap EvaluateNode(const EntryIndex& index, uint32_t node) const;
+
+    std::vector<Node> nodes;
+    uint32_t root = UINT32_MAX;
+    std::string lastError;
+};
+
+// T = AAAA-MM-JJ[THH:MM[:SS[.fffffff]]][Z], UTC → FILETIME ; unit = durée du dernier champ saisi
+bool ParseQueryTime(std::string_view text, uint64_t& fileTime, uint64_t& unit);
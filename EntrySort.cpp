@@ -0,0 +1,380 @@
+/*
+ * EntrySort - Implémentation du tri par permutation (LSD radix, fusion parallèle)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "EntrySort.h"
+
+#include "Telemetry.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+constexpr unsigned RADIX_BITS = 11;
+constexpr size_t RADIX_BUCKETS = size_t{ 1 } << RADIX_BITS;
+constexpr uint64_t RADIX_MASK = RADIX_BUCKETS - 1;
+// En deçà, une tranche par thread ne paie pas la fusion
+constexpr size_t ROWS_PER_THREAD_MIN = size_t{ 1 } << 16;
+
+const char* const KEY_NAMES[] = { "host", "sid", "user", "path", "raw", "time", "first", "source" };
+
+struct SortPair {
+    uint64_t key;
+    uint32_t row;
+};
+
+inline char16_t FoldAscii(char16_t c) {
+    return c >= u'a' && c <= u'z' ? static_cast<char16_t>(c - (u'a' - u'A')) : c;
+}
+
+// Casse ASCII ignorée, puis ordinal : ordre total sur des chaînes distinctes
+bool TextLess(std::u16string_view a, std::u16string_view b) {
+    const size_t common = std::min(a.size(), b.size());
+    for (size_t i = 0; i < common; i++) {
+        const char16_t x = FoldAscii(a[i]);
+        const char16_t y = FoldAscii(b[i]);
+        if (x != y) return x < y;
+    }
+    if (a.size() != b.size()) return a.size() < b.size();
+    return a < b;
+}
+
+unsigned BitWidth(uint64_t value) {
+    unsigned bits = 0;
+    for (; value; value >>= 1) bits++;
+    return bits;
+}
+
+// Tri LSD stable de pairs[0, n) sur les width bits de poids faible des clés ; scratch : n éléments
+void RadixSort(SortPair* pairs, SortPair* scratch, size_t n, unsigned width) {
+    const unsigned digits = (width + RADIX_BITS - 1) / RADIX_BITS;
+    if (n < 2 || digits == 0) return;
+
+    // Histogrammes de tous les chiffres en une lecture
+    std::vector<uint32_t> counts(digits * RADIX_BUCKETS, 0);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = pairs[i].key;
+        for (unsigned d = 0; d < digits; d++, key >>= RADIX_BITS) {
+            counts[d * RADIX_BUCKETS + (key & RADIX_MASK)]++;
+        }
+    }
+
+    SortPair* src = pairs;
+    SortPair* dst = scratch;
+    for (unsigned d = 0; d < digits; d++) {
+        const unsigned shift = d * RADIX_BITS;
+        uint32_t* count = &counts[d * RADIX_BUCKETS];
+        if (count[(src[0].key >> shift) & RADIX_MASK] == n) continue;  // Chiffre constant : passe sautée
+        uint32_t sum = 0;
+        for (size_t b = 0; b < RADIX_BUCKETS; b++) {
+            const uint32_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const SortPair pair = src[i];
+            dst[count[(pair.key >> shift) & RADIX_MASK]++] = pair;
+        }
+        std::swap(src, dst);
+    }
+    if (src != pairs) std::memcpy(pairs, src, n * sizeof(SortPair));
+}
+
+// Nombre d'éléments de a parmi les k premiers de la fusion stable de a et b (a d'abord à égalité)
+template <class T, class Less>
+size_t CoRank(size_t k, const T* a, size_t na, const T* b, size_t nb, const Less& less) {
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = std::min(k, na);
+    while (lo < hi) {
+        const size_t i = lo + (hi - lo) / 2;
+        const size_t j = k - i;
+        if (j > 0 && i < na && !less(b[j - 1], a[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+// Fusions stables deux à deux des runs triés [bounds[r], bounds[r + 1]) de data, jusqu'à un seul run ;
+// chaque fusion est partagée entre les threads disponibles par points de coupe
+template <class T, class Less>
+void MergeRuns(std::vector<T>& data, std::vector<T>& scratch, std::vector<size_t> bounds, const Less& less,
+               WorkStealingPool& pool) {
+    struct Piece {
+        size_t merge;
+        size_t index;
+    };
+    std::vector<T>* src = &data;
+    std::vector<T>* dst = &scratch;
+    while (bounds.size() > 2) {
+        const size_t runs = bounds.size() - 1;
+        const size_t merges = runs / 2;
+        const size_t pieces = std::max<size_t>(1, pool.Threads() / merges);
+        std::vector<Piece> tasks;
+        std::vector<uint64_t> weights;
+        for (size_t m = 0; m < merges; m++) {
+            for (size_t p = 0; p < pieces; p++) {
+                tasks.push_back(Piece{ m, p });
+                weights.push_back((bounds[2 * m + 2] - bounds[2 * m]) / pieces);
+            }
+        }
+        if (runs % 2) {
+            tasks.push_back(Piece{ merges, 0 });
+            weights.push_back(bounds[runs] - bounds[runs - 1]);
+        }
+
+        pool.Run(weights, [&](size_t task, unsigned) {
+            const Piece piece = tasks[task];
+            const T* in = src->data();
+            T* out = dst->data();
+            if (piece.merge == merges) {  // Run impair : recopié tel quel
+                std::copy(in + bounds[runs - 1], in + bounds[runs], out + bounds[runs - 1]);
+                return;
+            }
+            const size_t lo = bounds[2 * piece.merge];
+            const size_t mid = bounds[2 * piece.merge + 1];
+            const size_t hi = bounds[2 * piece.merge + 2];
+            const T* a = in + lo;
+            const T* b = in + mid;
+            const size_t na = mid - lo;
+            const size_t nb = hi - mid;
+            const size_t k0 = (na + nb) * piece.index / pieces;
+            const size_t k1 = (na + nb) * (piece.index + 1) / pieces;
+            const size_t i0 = CoRank(k0, a, na, b, nb, less);
+            const size_t i1 = CoRank(k1, a, na, b, nb, less);
+            std::merge(a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), out + lo + k0, less);
+        });
+
+        std::vector<size_t> next;
+        for (size_t m = 0; m < merges; m++) next.push_back(bounds[2 * m]);
+        if (runs % 2) next.push_back(bounds[runs - 1]);
+        next.push_back(bounds[runs]);
+        bounds.swap(next);
+        std::swap(src, dst);
+    }
+    if (src != &data) data.swap(*src);
+}
+
+// Tranches [bounds[t], bounds[t + 1]) de n lignes, une par thread utile
+std::vector<size_t> SliceBounds(size_t n, unsigned threads) {
+    const size_t slices = std::max<size_t>(1, std::min<size_t>(threads, n / ROWS_PER_THREAD_MIN));
+    std::vector<size_t> bounds(slices + 1);
+    for (size_t t = 0; t <= slices; t++) bounds[t] = n * t / slices;
+    return bounds;
+}
+
+// Une clé : valeur entière brute par ligne, ramenée à [0, 2^width) dans le sens demandé
+struct FieldPlan {
+    SortKey key = SortKey::Time;
+    bool descending = false;
+    const std::vector<uint32_t>* ranks = nullptr;  // Clés de chaîne : rang de chaque id
+    uint64_t min = 0;
+    uint64_t max = 0;
+    unsigned width = 0;
+    unsigned shift = 0;
+};
+
+// Mot de 64 bits : clés consécutives, la première aux poids forts
+struct WordPlan {
+    std::vector<FieldPlan> fields;
+    unsigned width = 0;
+};
+
+inline uint64_t RawKey(const EntryStore& store, const FieldPlan& field, size_t row) {
+    switch (field.key) {
+    case SortKey::Host: return (*field.ranks)[store.HostId(row)];
+    case SortKey::Sid: return (*field.ranks)[store.SidId(row)];
+    case SortKey::User: return (*field.ranks)[store.UserId(row)];
+    case SortKey::Path: return (*field.ranks)[store.NormalizedPathId(row)];
+    case SortKey::RawPath: return (*field.ranks)[store.PathId(row)];
+    case SortKey::Time: return store.FileTime(row);
+    case SortKey::FirstSeen: return store.FirstSeen(row);
+    case SortKey::Source: return static_cast<uint64_t>(store.Source(row));
+    }
+    return 0;
+}
+
+inline uint64_t WordKey(const EntryStore& store, const WordPlan& word, size_t row) {
+    uint64_t key = 0;
+    for (const FieldPlan& field : word.fields) {
+        const uint64_t raw = RawKey(store, field, row);
+        key |= (field.descending ? field.max - raw : raw - field.min) << field.shift;
+    }
+    return key;
+}
+
+}  // namespace
+
+const char* SortKeyName(SortKey key) {
+    const size_t index = static_cast<size_t>(key);
+    return index < sizeof(KEY_NAMES) / sizeof(KEY_NAMES[0]) ? KEY_NAMES[index] : "?";
+}
+
+bool ParseSortFields(std::string_view spec, std::vector<SortField>& fields, std::string& error) {
+    fields.clear();
+    while (!spec.empty()) {
+        const size_t comma = spec.find(',');
+        std::string_view token = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+        while (!token.empty() && token.front() == ' ') token.remove_prefix(1);
+        while (!token.empty() && token.back() == ' ') token.remove_suffix(1);
+        if (token.empty()) continue;
+
+        SortField field;
+        if (token.front() == '-' || token.front() == '+') {
+            field.descending = token.front() == '-';
+            token.remove_prefix(1);
+        }
+        size_t index = 0;
+        while (index < sizeof(KEY_NAMES) / sizeof(KEY_NAMES[0]) && token != KEY_NAMES[index]) index++;
+        if (index == sizeof(KEY_NAMES) / sizeof(KEY_NAMES[0])) {
+            error = "Clé de tri inconnue : " + std::string(token);
+            return false;
+        }
+        field.key = static_cast<SortKey>(index);
+        fields.push_back(field);
+    }
+    if (fields.empty()) {
+        error = "Aucune clé de tri";
+        return false;
+    }
+    return true;
+}
+
+EntrySorter::EntrySorter(unsigned threads)
+    : threadCount(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+void EntrySorter::Reset() {
+    for (RankCache* cache : { &hostRanks, &sidRanks, &userRanks, &pathRanks }) {
+        cache->pool = nullptr;
+        cache->count = 0;
+        cache->ranks.clear();
+    }
+}
+
+// Table classée une fois (tranches triées puis fusionnées), rang de chaque id ; la table ne fait que croître
+// entre deux Reset, un nombre de chaînes inchangé suffit donc à réutiliser le cache
+const std::vector<uint32_t>& EntrySorter::Ranks(const StringPool& pool, RankCache& cache) {
+    const size_t count = pool.Count();
+    if (cache.pool == &pool && cache.count == count) return cache.ranks;
+
+    std::vector<uint32_t> ids(count);
+    std::iota(ids.begin(), ids.end(), 0u);
+    const auto less = [&pool](uint32_t a, uint32_t b) { return TextLess(pool.View(a), pool.View(b)); };
+    WorkStealingPool workers(threadCount);
+    const std::vector<size_t> bounds = SliceBounds(count, threadCount);
+    std::vector<uint64_t> weights(bounds.size() - 1, 1);
+    workers.Run(weights, [&](size_t slice, unsigned) {
+        std::sort(ids.begin() + bounds[slice], ids.begin() + bounds[slice + 1], less);
+    });
+    std::vector<uint32_t> scratch(count);
+    MergeRuns(ids, scratch, bounds, less, workers);
+
+    cache.ranks.assign(count, 0);
+    for (size_t rank = 0; rank < count; rank++) cache.ranks[ids[rank]] = static_cast<uint32_t>(rank);
+    cache.pool = &pool;
+    cache.count = count;
+    return cache.ranks;
+}
+
+void EntrySorter::Sort(const EntryStore& store, const std::vector<SortField>& fields, std::vector<uint32_t>& order) {
+    const size_t n = store.size();
+    ScopedSpan span(TelemetrySpan::RowSort, n);
+    order.resize(n);
+    WorkStealingPool workers(threadCount);
+    const std::vector<size_t> bounds = SliceBounds(n, threadCount);
+    std::vector<uint64_t> weights(bounds.size() - 1, 1);
+
+    // Plage de chaque clé : rangs [0, nombre de chaînes), valeurs numériques mesurées sur les lignes
+    std::vector<FieldPlan> plans;
+    for (const SortField& field : fields) {
+        FieldPlan plan;
+        plan.key = field.key;
+        plan.descending = field.descending;
+        const StringPool* pool = nullptr;
+        RankCache* cache = nullptr;
+        switch (field.key) {
+        case SortKey::Host: pool = &store.hosts; cache = &hostRanks; break;
+        case SortKey::Sid: pool = &store.sids; cache = &sidRanks; break;
+        case SortKey::User: pool = &store.users; cache = &userRanks; break;
+        case SortKey::Path:
+        case SortKey::RawPath: pool = &store.paths; cache = &pathRanks; break;
+        default: break;
+        }
+        if (pool) {
+            plan.ranks = &Ranks(*pool, *cache);
+            plan.max = pool->Count() ? pool->Count() - 1 : 0;
+        } else if (n) {
+            std::vector<uint64_t> mins(bounds.size() - 1, UINT64_MAX);
+            std::vector<uint64_t> maxs(bounds.size() - 1, 0);
+            workers.Run(weights, [&](size_t slice, unsigned) {
+                for (size_t row = bounds[slice]; row < bounds[slice + 1]; row++) {
+                    const uint64_t value = RawKey(store, plan, row);
+                    mins[slice] = std::min(mins[slice], value);
+                    maxs[slice] = std::max(maxs[slice], value);
+                }
+            });
+            plan.min = *std::min_element(mins.begin(), mins.end());
+            plan.max = *std::max_element(maxs.begin(), maxs.end());
+        }
+        plan.width = BitWidth(plan.max - plan.min);
+        if (plan.width) plans.push_back(plan);  // Clé constante : sans effet sur l'ordre
+    }
+
+    // Clés concaténées en mots de 64 bits, la première clé aux poids forts du premier mot
+    std::vector<WordPlan> words;
+    for (const FieldPlan& plan : plans) {
+        if (words.empty() || words.back().width + plan.width > 64) words.emplace_back();
+        words.back().fields.push_back(plan);
+        words.back().width += plan.width;
+    }
+    for (WordPlan& word : words) {
+        unsigned shift = word.width;
+        for (FieldPlan& field : word.fields) {
+            shift -= field.width;
+            field.shift = shift;
+        }
+    }
+
+    // Tranches triées en LSD, mot de poids faible d'abord ; les paires gardent le premier mot
+    std::vector<SortPair> pairs(n);
+    std::vector<SortPair> scratch(n);
+    workers.Run(weights, [&](size_t slice, unsigned) {
+        const size_t first = bounds[slice];
+        const size_t count = bounds[slice + 1] - first;
+        SortPair* slicePairs = pairs.data() + first;
+        for (size_t i = 0; i < count; i++) {
+            slicePairs[i].row = static_cast<uint32_t>(first + i);
+            slicePairs[i].key = words.empty() ? 0 : WordKey(store, words.back(), first + i);
+        }
+        for (size_t w = words.size(); w-- > 0;) {
+            if (w + 1 < words.size()) {
+                for (size_t i = 0; i < count; i++) slicePairs[i].key = WordKey(store, words[w], slicePairs[i].row);
+            }
+            RadixSort(slicePairs, scratch.data() + first, count, words[w].width);
+        }
+    });
+
+    const auto less = [&](const SortPair& a, const SortPair& b) {
+        if (a.key != b.key) return a.key < b.key;
+        for (size_t w = 1; w < words.size(); w++) {
+            const uint64_t x = WordKey(store, words[w], a.row);
+            const uint64_t y = WordKey(store, words[w], b.row);
+            if (x != y) return x < y;
+        }
+        return false;
+    };
+    MergeRuns(pairs, scratch, bounds, less, workers);
+
+    workers.Run(weights, [&](size_t slice, unsigned) {
+        for (size_t i = bounds[slice]; i < bounds[slice + 1]; i++) order[i] = pairs[i].row;
+    });
+}
@@ -0,0 +1,72 @@
+/*
+ * EntrySort - Tri multi-clés des lignes d'un EntryStore par permutation
+ *
+ * Le store n'est jamais déplacé : le tri produit une permutation de 32 bits (ligne affichée en position i =
+ * order[i]), lue telle quelle par la ListView virtuelle ou appliquée au besoin par EntryStore::Permute.
+ *
+ * - Clés : hôte, SID, utilisateur, chemin normalisé ou brut, FILETIME, première observation, source ;
+ *   chacune croissante ou décroissante, combinées dans l'ordre donné. Tri stable : à clés égales, l'ordre
+ *   des lignes est conservé.
+ * - Chaînes comparées par rang : chaque table (hôtes, SIDs, utilisateurs, chemins) est classée une fois
+ *   (casse ASCII ignorée, puis ordinal), en place, sans copie ; les rangs restent en cache tant que la
+ *   table ne change pas, un nouveau tri interactif ne touche plus au texte
+ * - Clés des lignes ramenées à des entiers (rang, FILETIME moins le minimum, complément si décroissant) de
+ *   la largeur utile, concaténées en mots de 64 bits : "hôte, utilisateur, date" tient souvent en un mot.
+ *   Tri LSD par chiffres de 11 bits sur des paires (clé, ligne), passes des chiffres constants sautées.
+ * - Parallèle : une tranche de lignes par thread triée en LSD, puis fusions stables deux à deux ; chaque
+ *   fusion est découpée entre les threads par recherche dichotomique des points de coupe (merge path)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class SortKey : uint8_t { Host, Sid, User, Path, RawPath, Time, FirstSeen, Source };
+
+struct SortField {
+    SortKey key = SortKey::Time;
+    bool descending = false;
+};
+
+// Noms stables : host, sid, user, path, raw, time, first, source
+const char* SortKeyName(SortKey key);
+// "host,-time,path" : clés séparées par des virgules, '-' = décroissant ; false (error) si nom inconnu
+bool ParseSortFields(std::string_view spec, std::vector<SortField>& fields, std::string& error);
+
+class EntrySorter {
+public:
+    // threads = 0 : tous les cœurs
+    explicit EntrySorter(unsigned threads = 0);
+
+    // Store vidé ou rechargé : rangs des chaînes à recalculer
+    void Reset();
+
+    // order reçoit une ligne par position (store.size() éléments) ; fields vide : ordre des lignes
+    void Sort(const EntryStore& store, const std::vector<SortField>& fields, std::vector<uint32_t>& order);
+
+    unsigned Threads() const { return threadCount; }
+
+private:
+    struct RankCache {
+        const StringPool* pool = nullptr;
+        size_t count = 0;
+        std::vector<uint32_t> ranks;  // id → rang dans l'ordre alphabétique
+    };
+
+    const std::vector<uint32_t>& Ranks(const StringPool& pool, RankCache& cache);
+
+    unsigned threadCount;
+    RankCache hostRanks;
+    RankCache sidRanks;
+    RankCache userRanks;
+    RankCache pathRanks;
+};
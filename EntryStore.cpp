@@ -0,0 +1,544 @@
+/*
+ * EntryStore - Implémentation de l'arène, des tables internées et du stockage en colonnes
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "EntryStore.h"
+
+#include "CaseFile.h"
+#include "Transcode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+
+namespace {
+
+constexpr size_t ARENA_MAX_BLOCK = 1u << 20;
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Accès uniforme aux caractères d'une u16string_view ou d'un RegfName
+struct ViewChars {
+    std::u16string_view text;
+    char16_t operator[](size_t i) const { return text[i]; }
+};
+
+struct NameChars {
+    const RegfName& name;
+    char16_t operator[](size_t i) const { return name.At(i); }
+};
+
+template <class Source>
+uint64_t HashChars(const Source& source, size_t length) {
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ static_cast<uint16_t>(source[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+}  // namespace
+
+const char16_t* SourceName(EntrySource source) {
+    switch (source) {
+        case EntrySource::Dam: return u"dam";
+        case EntrySource::Recovered: return u"recovered";
+        default: return u"bam";
+    }
+}
+
+void* Arena::Allocate(size_t bytes, size_t align) {
+    size_t padding = cursor ? (align - reinterpret_cast<uintptr_t>(cursor) % align) % align : 0;
+    if (!cursor || padding + bytes > remaining) {
+        size_t blockSize = std::max(nextBlockSize, bytes + align);
+        blocks.emplace_back(new char[blockSize]);
+        cursor = blocks.back().get();
+        remaining = blockSize;
+        reserved += blockSize;
+        nextBlockSize = std::min(nextBlockSize * 2, ARENA_MAX_BLOCK);
+        padding = (align - reinterpret_cast<uintptr_t>(cursor) % align) % align;
+    }
+    char* result = cursor + padding;
+    cursor = result + bytes;
+    remaining -= padding + bytes;
+    return result;
+}
+
+void Arena::Clear() {
+    blocks.clear();
+    cursor = nullptr;
+    remaining = 0;
+    nextBlockSize = 4096;
+    reserved = 0;
+}
+
+template <class Source>
+uint32_t StringPool::InternImpl(const Source& source, size_t length, uint64_t hash) {
+    if (mappedText) Materialize();
+    if ((strings.size() + 1) * 2 > slots.size()) {
+        Rehash(slots.empty() ? 64 : slots.size() * 2);
+    }
+
+    const size_t mask = slots.size() - 1;
+    size_t slot = static_cast<size_t>(hash) & mask;
+    while (slots[slot] != 0) {
+        uint32_t id = slots[slot] - 1;
+        if (hashes[id] == hash && lengths[id] == length) {
+            const char16_t* existing = strings[id];
+            size_t i = 0;
+            while (i < length && existing[i] == source[i]) i++;
+            if (i == length) return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    char16_t* copy = static_cast<char16_t*>(arena.Allocate((length + 1) * sizeof(char16_t), alignof(char16_t)));
+    for (size_t i = 0; i < length; i++) {
+        copy[i] = source[i];
+    }
+    copy[length] = 0;
+
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(copy);
+    lengths.push_back(static_cast<uint32_t>(length));
+    hashes.push_back(hash);
+    slots[slot] = id + 1;
+    return id;
+}
+
+uint32_t StringPool::Intern(std::u16string_view text) {
+    ViewChars chars{ text };
+    return InternImpl(chars, text.size(), HashChars(chars, text.size()));
+}
+
+uint32_t StringPool::Intern(const RegfName& name) {
+    NameChars chars{ name };
+    size_t length = name.Length();
+    return InternImpl(chars, length, HashChars(chars, length));
+}
+
+void StringPool::Rehash(size_t newCapacity) {
+    slots.assign(newCapacity, 0);
+    const size_t mask = newCapacity - 1;
+    for (uint32_t id = 0; id < strings.size(); id++) {
+        size_t slot = static_cast<size_t>(hashes[id]) & mask;
+        while (slots[slot] != 0) slot = (slot + 1) & mask;
+        slots[slot] = id + 1;
+    }
+}
+
+// Chaînes projetées recopiées dans l'arène d'un bloc, hachages et table reconstruits
+void StringPool::Materialize() {
+    const size_t count = lengths.size();
+    const size_t units = count ? static_cast<size_t>(mappedOffsets[count - 1]) + lengths[count - 1] + 1 : 0;
+    char16_t* copy =
+        static_cast<char16_t*>(arena.Allocate(std::max<size_t>(units, 1) * sizeof(char16_t), alignof(char16_t)));
+    std::memcpy(copy, mappedText, units * sizeof(char16_t));
+    strings.resize(count);
+    hashes.resize(count);
+    for (size_t id = 0; id < count; id++) {
+        strings[id] = copy + mappedOffsets[id];
+        hashes[id] = HashChars(ViewChars{ { strings[id], lengths[id] } }, lengths[id]);
+    }
+    mappedText = nullptr;
+    mappedOffsets = nullptr;
+    lengths.Mutable();
+    size_t capacity = 64;
+    while (capacity < (count + 1) * 2) capacity <<= 1;
+    Rehash(capacity);
+}
+
+void StringPool::Save(CaseWriter& out, const std::string& name) const {
+    std::vector<uint64_t> offsets(Count());
+    uint64_t units = 0;
+    out.BeginSection(name + ".text");
+    for (uint32_t id = 0; id < Count(); id++) {
+        offsets[id] = units;
+        out.Write(CStr(id), (lengths[id] + size_t{ 1 }) * sizeof(char16_t));
+        units += lengths[id] + 1;
+    }
+    out.EndSection();
+    out.Section(name + ".offsets", offsets.data(), offsets.size());
+    out.Section(name + ".lengths", lengths.data(), lengths.size());
+}
+
+bool StringPool::Attach(const CaseFile& in, const std::string& name) {
+    Clear();
+    const char16_t* text = nullptr;
+    size_t units = 0;
+    const uint64_t* offsets = nullptr;
+    size_t count = 0;
+    if (!in.Find(name + ".text", text, units) || !in.Find(name + ".offsets", offsets, count) ||
+        !in.Attach(name + ".lengths", lengths, count)) {
+        return false;
+    }
+    // Chaînes écrites dans l'ordre des ids, chacune terminée par zéro : toutes vérifiées, un fichier altéré
+    // est refusé ici plutôt que lu hors limites par View / CStr
+    uint64_t next = 0;
+    for (size_t id = 0; id < count; id++) {
+        const uint64_t offset = offsets[id];
+        if (offset < next || offset > units || lengths[id] >= units - offset || text[offset + lengths[id]] != 0) {
+            lengths.clear();
+            return in.Invalid(name + ".text");
+        }
+        next = offset + lengths[id] + 1;
+    }
+    mappedText = text;
+    mappedOffsets = offsets;
+    return true;
+}
+
+size_t StringPool::MemoryBytes() const {
+    return arena.BytesReserved() +
+           strings.capacity() * sizeof(const char16_t*) +
+           lengths.capacity() * sizeof(uint32_t) +
+           hashes.capacity() * sizeof(uint64_t) +
+           slots.capacity() * sizeof(uint32_t);
+}
+
+void StringPool::Clear() {
+    arena.Clear();
+    strings.clear();
+    mappedText = nullptr;
+    mappedOffsets = nullptr;
+    lengths.clear();
+    hashes.clear();
+    slots.clear();
+}
+
+uint32_t MatchTable::Intern(const uint64_t* bits, size_t wordCount, std::u16string_view note) {
+    while (wordCount > 0 && bits[wordCount - 1] == 0) wordCount--;
+    if (wordCount == 0) return ENTRY_NO_MATCH;
+
+    std::string key(reinterpret_cast<const char*>(bits), wordCount * sizeof(uint64_t));
+    auto found = index.find(key);
+    if (found != index.end()) return found->second;
+
+    const uint32_t id = static_cast<uint32_t>(noteIds.size());
+    noteIds.push_back(notes.Intern(note));
+    wordOffsets.push_back(static_cast<uint32_t>(words.size()));
+    wordCounts.push_back(static_cast<uint32_t>(wordCount));
+    words.insert(words.end(), bits, bits + wordCount);
+    index.emplace(std::move(key), id);
+    return id;
+}
+
+size_t MatchTable::MemoryBytes() const {
+    size_t keys = 0;
+    for (const auto& entry : index) keys += entry.first.capacity() + sizeof(entry);
+    return notes.MemoryBytes() + keys +
+           (noteIds.capacity() + wordOffsets.capacity() + wordCounts.capacity()) * sizeof(uint32_t) +
+           words.capacity() * sizeof(uint64_t);
+}
+
+void MatchTable::Save(CaseWriter& out) const {
+    notes.Save(out, "match.notes");
+    out.Section("match.noteIds", noteIds.data(), noteIds.size());
+    out.Section("match.wordOffsets", wordOffsets.data(), wordOffsets.size());
+    out.Section("match.wordCounts", wordCounts.data(), wordCounts.size());
+    out.Section("match.words", words.data(), words.size());
+}
+
+bool MatchTable::Attach(const CaseFile& in) {
+    Clear();
+    StringPool savedNotes;
+    const uint32_t* savedNoteIds = nullptr;
+    const uint32_t* savedOffsets = nullptr;
+    const uint32_t* savedCounts = nullptr;
+    const uint64_t* savedWords = nullptr;
+    size_t count = 0;
+    size_t wordTotal = 0;
+    if (!savedNotes.Attach(in, "match.notes") || !in.Find("match.noteIds", savedNoteIds, count) || count == 0 ||
+        !in.Find("match.wordOffsets", savedOffsets, count, count) ||
+        !in.Find("match.wordCounts", savedCounts, count, count) || !in.Find("match.words", savedWords, wordTotal)) {
+        return false;
+    }
+    for (uint32_t id = 1; id < count; id++) {
+        const bool valid = savedOffsets[id] <= wordTotal && savedCounts[id] <= wordTotal - savedOffsets[id] &&
+                           savedNoteIds[id] < savedNotes.Count() &&
+                           Intern(savedWords + savedOffsets[id], savedCounts[id],
+                                  savedNotes.View(savedNoteIds[id])) == id;
+        if (!valid) {
+            Clear();
+            return in.Invalid("match.words");
+        }
+    }
+    return true;
+}
+
+void MatchTable::Clear() {
+    notes.Clear();
+    noteIds.assign(1, notes.Intern(u""));
+    wordOffsets.assign(1, 0);
+    wordCounts.assign(1, 0);
+    words.clear();
+    index.clear();
+}
+
+void EntryStore::Reserve(size_t rows) {
+    hostId.reserve(rows);
+    sidId.reserve(rows);
+    userId.reserve(rows);
+    pathId.reserve(rows);
+    normalizedPathId.reserve(rows);
+    matchId.reserve(rows);
+    fileTime.reserve(rows);
+    if (trackFirstSeen) firstSeen.reserve(rows);
+    source.reserve(rows);
+    flags.reserve(rows);
+}
+
+void EntryStore::Clear() {
+    hosts.Clear();
+    sids.Clear();
+    users.Clear();
+    paths.Clear();
+    matches.Clear();
+    hostId.clear();
+    sidId.clear();
+    userId.clear();
+    pathId.clear();
+    normalizedPathId.clear();
+    matchId.clear();
+    fileTime.clear();
+    firstSeen.clear();
+    source.clear();
+    flags.clear();
+    trackFirstSeen = false;
+}
+
+size_t EntryStore::Add(uint32_t host, uint32_t sid, uint32_t user, uint32_t path, uint64_t time,
+                       EntrySource entrySource, uint32_t match, uint8_t entryFlags, uint32_t normalizedPath) {
+    hostId.push_back(host);
+    sidId.push_back(sid);
+    userId.push_back(user);
+    pathId.push_back(path);
+    normalizedPathId.push_back(normalizedPath == ENTRY_SAME_PATH ? path : normalizedPath);
+    matchId.push_back(match);
+    fileTime.push_back(time);
+    if (trackFirstSeen) firstSeen.push_back(time);
+    source.push_back(static_cast<uint8_t>(entrySource));
+    flags.push_back(entryFlags);
+    return fileTime.size() - 1;
+}
+
+void EntryStore::EnableFirstSeen() {
+    if (trackFirstSeen) return;
+    firstSeen.Assign(fileTime.begin(), fileTime.end());
+    trackFirstSeen = true;
+}
+
+void EntryStore::SetTimes(size_t row, uint64_t first, uint64_t last, uint8_t rowFlags) {
+    if (trackFirstSeen) firstSeen.Mutable()[row] = first;
+    fileTime.Mutable()[row] = last;
+    flags.Mutable()[row] = rowFlags;
+}
+
+namespace {
+
+template <class T>
+void PermuteColumn(Column<T>& column, const std::vector<uint32_t>& order) {
+    std::vector<T> permuted(column.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        permuted[i] = column[order[i]];
+    }
+    column.Assign(std::move(permuted));
+}
+
+}  // namespace
+
+void EntryStore::Permute(const std::vector<uint32_t>& order) {
+    PermuteColumn(hostId, order);
+    PermuteColumn(sidId, order);
+    PermuteColumn(userId, order);
+    PermuteColumn(pathId, order);
+    PermuteColumn(normalizedPathId, order);
+    PermuteColumn(matchId, order);
+    PermuteColumn(fileTime, order);
+    if (trackFirstSeen) PermuteColumn(firstSeen, order);
+    PermuteColumn(source, order);
+    PermuteColumn(flags, order);
+}
+
+namespace {
+
+// Id de source → id de destination, interné à la première rencontre
+uint32_t Remap(std::vector<uint32_t>& map, uint32_t id, const StringPool& from, StringPool& to) {
+    if (map[id] == UINT32_MAX) map[id] = to.Intern(from.View(id));
+    return map[id];
+}
+
+}  // namespace
+
+void EntryStore::AppendRows(const EntryStore& other, const uint32_t* rows, size_t count) {
+    if (other.HasFirstSeen()) EnableFirstSeen();
+    Reserve(size() + count);
+
+    std::vector<uint32_t> hostMap(other.hosts.Count(), UINT32_MAX);
+    std::vector<uint32_t> sidMap(other.sids.Count(), UINT32_MAX);
+    std::vector<uint32_t> userMap(other.users.Count(), UINT32_MAX);
+    std::vector<uint32_t> pathMap(other.paths.Count(), UINT32_MAX);
+    std::vector<uint32_t> matchMap(other.matches.Count(), UINT32_MAX);
+    matchMap[ENTRY_NO_MATCH] = ENTRY_NO_MATCH;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t row = rows ? rows[i] : static_cast<uint32_t>(i);
+        uint32_t& match = matchMap[other.matchId[row]];
+        if (match == UINT32_MAX) {
+            const uint32_t id = other.matchId[row];
+            match = matches.Intern(other.matches.Words(id), other.matches.WordCount(id), other.matches.Note(id));
+        }
+        const uint32_t host = Remap(hostMap, other.hostId[row], other.hosts, hosts);
+        const uint32_t sid = Remap(sidMap, other.sidId[row], other.sids, sids);
+        const uint32_t user = Remap(userMap, other.userId[row], other.users, users);
+        const uint32_t path = Remap(pathMap, other.pathId[row], other.paths, paths);
+        const uint32_t normalized = Remap(pathMap, other.normalizedPathId[row], other.paths, paths);
+        const size_t added =
+            Add(host, sid, user, path, other.fileTime[row], other.Source(row), match, other.flags[row], normalized);
+        if (trackFirstSeen) firstSeen.Mutable()[added] = other.FirstSeen(row);
+    }
+}
+
+void EntryStore::Save(CaseWriter& out) const {
+    hosts.Save(out, "hosts");
+    sids.Save(out, "sids");
+    users.Save(out, "users");
+    paths.Save(out, "paths");
+    matches.Save(out);
+    out.Section("store.hostId", hostId.data(), hostId.size());
+    out.Section("store.sidId", sidId.data(), sidId.size());
+    out.Section("store.userId", userId.data(), userId.size());
+    out.Section("store.pathId", pathId.data(), pathId.size());
+    out.Section("store.normalizedPathId", normalizedPathId.data(), normalizedPathId.size());
+    out.Section("store.matchId", matchId.data(), matchId.size());
+    out.Section("store.fileTime", fileTime.data(), fileTime.size());
+    if (trackFirstSeen) out.Section("store.firstSeen", firstSeen.data(), firstSeen.size());
+    out.Section("store.source", source.data(), source.size());
+    out.Section("store.flags", flags.data(), flags.size());
+}
+
+bool EntryStore::Attach(const CaseFile& in) {
+    Clear();
+    const size_t rows = static_cast<size_t>(in.Rows());
+    trackFirstSeen = in.Has("store.firstSeen");
+    const bool attached =
+        hosts.Attach(in, "hosts") && sids.Attach(in, "sids") && users.Attach(in, "users") &&
+        paths.Attach(in, "paths") && matches.Attach(in) && in.Attach("store.hostId", hostId, rows) &&
+        in.Attach("store.sidId", sidId, rows) && in.Attach("store.userId", userId, rows) &&
+        in.Attach("store.pathId", pathId, rows) && in.Attach("store.normalizedPathId", normalizedPathId, rows) &&
+        in.Attach("store.matchId", matchId, rows) && in.Attach("store.fileTime", fileTime, rows) &&
+        (!trackFirstSeen || in.Attach("store.firstSeen", firstSeen, rows)) &&
+        in.Attach("store.source", source, rows) && in.Attach("store.flags", flags, rows);
+    if (!attached) {
+        Clear();
+        return false;
+    }
+
+    // Ids hors de leur table : refus à l'ouverture, aucune ligne n'est lue avant ce contrôle
+    const struct {
+        const Column<uint32_t>& ids;
+        size_t limit;
+        const char* name;
+    } idColumns[] = {
+        { hostId, hosts.Count(), "store.hostId" },
+        { sidId, sids.Count(), "store.sidId" },
+        { userId, users.Count(), "store.userId" },
+        { pathId, paths.Count(), "store.pathId" },
+        { normalizedPathId, paths.Count(), "store.normalizedPathId" },
+        { matchId, matches.Count(), "store.matchId" },
+    };
+    for (const auto& column : idColumns) {
+        for (size_t row = 0; row < rows; row++) {
+            if (column.ids[row] >= column.limit) {
+                Clear();
+                return in.Invalid(column.name);
+            }
+        }
+    }
+    return true;
+}
+
+size_t EntryStore::MemoryBytes() const {
+    return hosts.MemoryBytes() + sids.MemoryBytes() + users.MemoryBytes() + paths.MemoryBytes() +
+           matches.MemoryBytes() +
+           (hostId.capacity() + sidId.capacity() + userId.capacity() + pathId.capacity() +
+            normalizedPathId.capacity() + matchId.capacity()) *
+               sizeof(uint32_t) +
+           (fileTime.capacity() + firstSeen.capacity()) * sizeof(uint64_t) +
+           source.capacity() + flags.capacity();
+}
+
+std::wstring ToWide(std::u16string_view text) {
+    std::wstring out;
+    out.reserve(text.size());
+#if WCHAR_MAX <= 0xFFFF
+    out.assign(text.begin(), text.end());
+#else
+    for (size_t i = 0; i < text.size(); i++) {
+        char32_t c = text[i];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size()) {
+            char32_t low = text[i + 1];
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            }
+        }
+        out.push_back(static_cast<wchar_t>(c));
+    }
+#endif
+    return out;
+}
+
+void AppendUtf8(std::string& out, std::u16string_view text) {
+    const size_t size = out.size();
+    out.resize(size + Utf8MaxBytes(text.size()));
+    out.resize(static_cast<size_t>(Utf16ToUtf8(text.data(), text.size(), &out[size]) - out.data()));
+}
+
+std::u16string Utf8ToU16(std::string_view text) {
+    std::u16string out;
+    AppendUtf16(out, text);
+    return out;
+}
+
+void AppendUtf16(std::u16string& out, std::string_view text) {
+    out.reserve(out.size() + text.size());
+    for (size_t i = 0; i < text.size();) {
+        uint8_t lead = static_cast<uint8_t>(text[i]);
+        uint32_t c;
+        size_t extra;
+        if (lead < 0x80) { c = lead; extra = 0; }
+        else if ((lead & 0xE0) == 0xC0) { c = lead & 0x1F; extra = 1; }
+        else if ((lead & 0xF0) == 0xE0) { c = lead & 0x0F; extra = 2; }
+        else if ((lead & 0xF8) == 0xF0) { c = lead & 0x07; extra = 3; }
+        else { out.push_back(0xFFFD); i++; continue; }
+
+        if (i + extra >= text.size()) {
+            out.push_back(0xFFFD);
+            break;
+        }
+        bool valid = true;
+        for (size_t k = 1; k <= extra; k++) {
+            uint8_t next = static_cast<uint8_t>(text[i + k]);
+            if ((next & 0xC0) != 0x80) { valid = false; break; }
+            c = (c << 6) | (next & 0x3F);
+        }
+        if (!valid || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+            out.push_back(0xFFFD);
+            i++;
+            continue;
+        }
+        if (c >= 0x10000) {
+            c -= 0x10000;
+            out.push_back(static_cast<char16_t>(0xD800 + (c >> 10)));
+            out.push_back(static_cast<char16_t>(0xDC00 + (c & 0x3FF)));
+        } else {
+            out.push_back(static_cast<char16_t>(c));
+        }
+        i += extra + 1;
+    }
+}
@@ -0,0 +1,324 @@
+/*
+ * EntryStore - Stockage compact des entrées BAM/DAM (struct-of-arrays)
+ *
+ * - Hôtes, SIDs, utilisateurs et chemins internés une seule fois (StringPool, ids 32 bits)
+ * - Chaînes UTF-16 terminées par zéro, allouées dans une arène (pas d'allocation par ligne)
+ * - Source en énumération, FILETIME brut : le timestamp est formaté à l'affichage
+ * - Règles de classification déclenchées : id d'une combinaison distincte (MatchTable),
+ *   qui porte le bitset des règles et le texte de la colonne Notes
+ * - Chemin brut (tel que stocké par BAM) et chemin normalisé avec lettre de lecteur (VolumeMap),
+ *   tous deux internés dans paths ; identiques si le volume n'est pas connu
+ * - Historique multi-versions (HiveHistory) : colonne optionnelle de première observation,
+ *   FileTime portant alors la dernière
+ *
+ * - Colonnes et tables de chaînes adossables à un fichier de cas projeté (CaseFile) : lues en place,
+ *   recopiées en mémoire à la première modification seulement
+ *
+ * Une ligne coûte 34 octets de colonnes, contre six std::wstring (192 octets + tas)
+ * pour l'ancienne structure BamDamEntry.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "RegfHive.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CaseFile;
+class CaseWriter;
+
+enum class EntrySource : uint8_t { Bam = 0, Dam = 1, Recovered = 2 };  // Recovered : vk supprimée (BamDamCarve)
+
+// Drapeaux par ligne
+constexpr uint8_t ENTRY_FLAG_INVALID_DATA = 0x01;  // Données non REG_BINARY ou < 8 octets
+
+// Id de combinaison de règles : aucune règle déclenchée, Notes vide
+constexpr uint32_t ENTRY_NO_MATCH = 0;
+// Chemin normalisé identique au chemin brut
+constexpr uint32_t ENTRY_SAME_PATH = 0xFFFFFFFF;
+
+const char16_t* SourceName(EntrySource source);  // u"bam" / u"dam" / u"recovered"
+
+// Colonne : vecteur possédé, ou tableau en lecture seule projeté depuis un fichier de cas (Attach),
+// recopié dans le vecteur à la première modification
+template <class T>
+class Column {
+public:
+    Column() = default;
+    Column(const Column&) = delete;
+    Column& operator=(const Column&) = delete;
+    Column(Column&& other) noexcept { *this = std::move(other); }
+    Column& operator=(Column&& other) noexcept {
+        owned = std::move(other.owned);
+        items = other.mapped ? other.items : owned.data();
+        count = other.count;
+        mapped = other.mapped;
+        other.owned.clear();
+        other.mapped = false;
+        other.Sync();
+        return *this;
+    }
+
+    const T& operator[](size_t i) const { return items[i]; }
+    const T* data() const { return items; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return owned.capacity(); }  // Éléments en mémoire (projetés non comptés)
+    bool Mapped() const { return mapped; }
+
+    T* Mutable() {
+        Own();
+        return owned.data();
+    }
+    void push_back(const T& value) {
+        Own();
+        owned.push_back(value);
+        Sync();
+    }
+    void reserve(size_t n) {
+        Own();
+        owned.reserve(n);
+        Sync();
+    }
+    void clear() {
+        mapped = false;
+        owned.clear();
+        Sync();
+    }
+    void Assign(std::vector<T>&& values) {
+        mapped = false;
+        owned = std::move(values);
+        Sync();
+    }
+    void Assign(const T* first, const T* last) {
+        mapped = false;
+        owned.assign(first, last);
+        Sync();
+    }
+    // Le tableau doit survivre à la colonne ou à sa prochaine modification
+    void Attach(const T* mappedItems, size_t mappedCount) {
+        std::vector<T>().swap(owned);
+        items = mappedItems;
+        count = mappedCount;
+        mapped = true;
+    }
+
+private:
+    void Own() {
+        if (!mapped) return;
+        owned.assign(items, items + count);
+        mapped = false;
+        Sync();
+    }
+    void Sync() {
+        items = owned.data();
+        count = owned.size();
+    }
+
+    std::vector<T> owned;
+    const T* items = nullptr;
+    size_t count = 0;
+    bool mapped = false;
+};
+
+// Allocateur par blocs (bump pointer), libéré d'un coup
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    void* Allocate(size_t bytes, size_t align);
+    void Clear();
+    size_t BytesReserved() const { return reserved; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    size_t remaining = 0;
+    size_t nextBlockSize = 4096;
+    size_t reserved = 0;
+};
+
+// Table de chaînes internées : une chaîne distincte = un id stable
+class StringPool {
+public:
+    uint32_t Intern(std::u16string_view text);
+    // Interne un nom directement depuis la ruche, sans chaîne intermédiaire
+    uint32_t Intern(const RegfName& name);
+
+    std::u16string_view View(uint32_t id) const { return { CStr(id), lengths[id] }; }
+    const char16_t* CStr(uint32_t id) const { return mappedText ? mappedText + mappedOffsets[id] : strings[id]; }
+    size_t Count() const { return lengths.size(); }
+    size_t MemoryBytes() const;
+    void Clear();
+
+    // Fichier de cas : "<name>.text" (chaînes terminées par zéro, concaténées), "<name>.offsets" (u64, en
+    // unités), "<name>.lengths" (u32). Attach lit en place ; le premier Intern recopie tout dans l'arène.
+    void Save(CaseWriter& out, const std::string& name) const;
+    bool Attach(const CaseFile& in, const std::string& name);
+
+private:
+    template <class Source>
+    uint32_t InternImpl(const Source& source, size_t length, uint64_t hash);
+    void Rehash(size_t newCapacity);
+    void Materialize();
+
+    Arena arena;
+    std::vector<const char16_t*> strings;  // Vide si les chaînes sont projetées
+    const char16_t* mappedText = nullptr;
+    const uint64_t* mappedOffsets = nullptr;
+    Column<uint32_t> lengths;
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> slots;  // id + 1, 0 = vide (adressage ouvert, sondage linéaire)
+};
+
+// Combinaisons distinctes de règles déclenchées : bitset (bit i = règle i) et texte Notes.
+// Peu de combinaisons par flotte, d'où un id 32 bits par ligne plutôt qu'un bitset.
+class MatchTable {
+public:
+    MatchTable() { Clear(); }
+
+    // words : wordCount mots de 64 bits ; bitset vide → ENTRY_NO_MATCH
+    uint32_t Intern(const uint64_t* words, size_t wordCount, std::u16string_view note);
+
+    std::u16string_view Note(uint32_t id) const { return notes.View(noteIds[id]); }
+    const char16_t* NoteCStr(uint32_t id) const { return notes.CStr(noteIds[id]); }
+    // Textes Notes internés (plusieurs combinaisons peuvent partager un texte)
+    const StringPool& Notes() const { return notes; }
+    uint32_t NoteId(uint32_t id) const { return noteIds[id]; }
+    const uint64_t* Words(uint32_t id) const { return words.data() + wordOffsets[id]; }
+    size_t WordCount(uint32_t id) const { return wordCounts[id]; }
+    bool Test(uint32_t id, uint32_t rule) const {
+        const uint32_t word = rule / 64;
+        return word < wordCounts[id] && (words[wordOffsets[id] + word] >> (rule % 64) & 1);
+    }
+    // fn(uint32_t rule) pour chaque règle déclenchée, ordre croissant
+    template <class F>
+    void ForEachRule(uint32_t id, F&& fn) const {
+        for (uint32_t w = 0; w < wordCounts[id]; w++) {
+            uint64_t bits = words[wordOffsets[id] + w];
+            for (uint32_t bit = 0; bits; bit++, bits >>= 1) {
+                if (bits & 1) fn(w * 64 + bit);
+            }
+        }
+    }
+
+    size_t Count() const { return noteIds.size(); }
+    size_t MemoryBytes() const;
+    void Clear();
+
+    // Peu de combinaisons : relues et réinternées dans le même ordre (mêmes ids) par Attach
+    void Save(CaseWriter& out) const;
+    bool Attach(const CaseFile& in);
+
+private:
+    StringPool notes;
+    std::vector<uint32_t> noteIds;
+    std::vector<uint32_t> wordOffsets;
+    std::vector<uint32_t> wordCounts;
+    std::vector<uint64_t> words;
+    std::unordered_map<std::string, uint32_t> index;  // Octets du bitset (zéros finaux retirés) → id
+};
+
+class EntryStore {
+public:
+    StringPool hosts;
+    StringPool sids;
+    StringPool users;
+    StringPool paths;
+    MatchTable matches;
+
+    size_t size() const { return fileTime.size(); }
+    bool empty() const { return fileTime.empty(); }
+    void Reserve(size_t rows);
+    void Clear();
+
+    size_t Add(uint32_t host, uint32_t sid, uint32_t user, uint32_t path, uint64_t time,
+               EntrySource source, uint32_t match = ENTRY_NO_MATCH, uint8_t flags = 0,
+               uint32_t normalizedPath = ENTRY_SAME_PATH);
+    // Complétés après coup (ParseBamDamHive : volumes et règles résolus une fois par chemin distinct)
+    void SetNormalizedPathId(size_t row, uint32_t path) { normalizedPathId.Mutable()[row] = path; }
+    void SetMatchId(size_t row, uint32_t match) { matchId.Mutable()[row] = match; }
+
+    // Colonne de première observation (absente par défaut : FirstSeen = FileTime)
+    void EnableFirstSeen();
+    bool HasFirstSeen() const { return trackFirstSeen; }
+    void SetTimes(size_t row, uint64_t first, uint64_t last, uint8_t rowFlags);
+
+    uint32_t HostId(size_t row) const { return hostId[row]; }
+    uint32_t SidId(size_t row) const { return sidId[row]; }
+    uint32_t UserId(size_t row) const { return userId[row]; }
+    uint32_t PathId(size_t row) const { return pathId[row]; }
+    uint32_t NormalizedPathId(size_t row) const { return normalizedPathId[row]; }
+    uint64_t FileTime(size_t row) const { return fileTime[row]; }
+    uint64_t FirstSeen(size_t row) const { return trackFirstSeen ? firstSeen[row] : fileTime[row]; }
+    EntrySource Source(size_t row) const { return static_cast<EntrySource>(source[row]); }
+    uint32_t MatchId(size_t row) const { return matchId[row]; }
+    uint8_t Flags(size_t row) const { return flags[row]; }
+
+    std::u16string_view Host(size_t row) const { return hosts.View(hostId[row]); }
+    std::u16string_view Sid(size_t row) const { return sids.View(sidId[row]); }
+    std::u16string_view User(size_t row) const { return users.View(userId[row]); }
+    std::u16string_view Path(size_t row) const { return paths.View(pathId[row]); }
+    std::u16string_view NormalizedPath(size_t row) const { return paths.View(normalizedPathId[row]); }
+    std::u16string_view Note(size_t row) const { return matches.Note(matchId[row]); }
+
+    // Réordonne toutes les colonnes : la ligne i devient l'ancienne ligne order[i]
+    void Permute(const std::vector<uint32_t>& order);
+    // Copie des lignes d'un autre store (ids réinternés ici) : toutes, ou rows[0..count) dans cet ordre.
+    // La première observation suit si source la porte.
+    void Append(const EntryStore& source) { AppendRows(source, nullptr, source.size()); }
+    void Append(const EntryStore& source, const uint32_t* rows, size_t count) { AppendRows(source, rows, count); }
+
+    size_t MemoryBytes() const;
+
+    // Fichier de cas (CaseFile) : tables de chaînes puis colonnes "store.*", telles qu'en mémoire.
+    // Attach adosse le store au fichier projeté sans copie ; le fichier doit rester ouvert jusqu'au
+    // prochain Clear, toute modification recopiant d'abord la colonne touchée.
+    void Save(CaseWriter& out) const;
+    bool Attach(const CaseFile& in);
+
+private:
+    // rows == nullptr : lignes 0..count de source
+    void AppendRows(const EntryStore& source, const uint32_t* rows, size_t count);
+
+    Column<uint32_t> hostId;
+    Column<uint32_t> sidId;
+    Column<uint32_t> userId;
+    Column<uint32_t> pathId;
+    Column<uint32_t> normalizedPathId;
+    Column<uint32_t> matchId;
+    Column<uint64_t> fileTime;
+    Column<uint64_t> firstSeen;
+    Column<uint8_t> source;
+    Column<uint8_t> flags;
+    bool trackFirstSeen = false;
+};
+
+// Consommateur de blocs de lignes (BamDamStream, Timeline) : le bloc lui est confié
+using EntryChunkFn = std::function<void(std::unique_ptr<EntryStore> chunk)>;
+
+// UTF-16 → wchar_t (copie triviale sous Windows, recomposition UTF-32 ailleurs)
+std::wstring ToWide(std::u16string_view text);
+// UTF-16 → UTF-8 (substitut isolé remplacé par U+FFFD)
+void AppendUtf8(std::string& out, std::u16string_view text);
+// UTF-8 → UTF-16 (séquence invalide remplacée par U+FFFD)
+std::u16string Utf8ToU16(std::string_view text);
+// Idem, ajouté à out (buffer réutilisé : pas d'allocation en régime établi)
+void AppendUtf16(std::u16string& out, std::string_view text);
@@ -0,0 +1,258 @@
+/*
+ * FileTimeFormat - Formatage FILETIME sans allocation (noyau entier days-to-civil)
+ *
+ * - Conversion jours → date civile en arithmétique entière pure (constexpr, sans table ni branche par mois)
+ *   et inverse (CivilToDays)
+ * - Écriture dans un buffer fourni par l'appelant (char ou wchar_t), aucune allocation
+ * - Précision seconde, milliseconde, microseconde ou 100 ns (résolution native du FILETIME)
+ * - UTC ou décalage fixe (ex. ActiveTimeBias de Control\TimeZoneInformation de la ruche)
+ * - Version colonne : formate un tableau de FILETIME d'un coup, préfixe de date réutilisé
+ *   tant que les timestamps consécutifs tombent le même jour
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class TimePrecision : uint8_t {
+    Seconds = 0,
+    Milliseconds = 3,
+    Microseconds = 6,
+    Ticks100ns = 7,
+};
+
+enum class TimeStyle : uint8_t {
+    Display,  // JJ/MM/AAAA HH:MM:SS.ffffff (affichage historique de l'outil)
+    Iso8601,  // AAAA-MM-JJTHH:MM:SS.ffffffZ ou +HH:MM (export, ingestion timeline)
+};
+
+struct TimeFormat {
+    TimePrecision precision = TimePrecision::Microseconds;
+    TimeStyle style = TimeStyle::Display;
+    int32_t offsetMinutes = 0;  // Heure affichée = UTC + offsetMinutes
+};
+
+// Taille de buffer suffisante pour tous les formats, zéro final compris
+constexpr size_t FILETIME_TEXT_MAX = 40;
+
+constexpr uint64_t FILETIME_TICKS_PER_SECOND = 10000000ULL;
+constexpr uint64_t FILETIME_TICKS_PER_MINUTE = 60ULL * FILETIME_TICKS_PER_SECOND;
+// Jours entre 1601-01-01 (origine FILETIME) et 1970-01-01
+constexpr int64_t FILETIME_EPOCH_DAYS = 134774;
+// Au-delà, FileTimeToSystemTime échoue : même borne ici
+constexpr uint64_t FILETIME_MAX_VALID = 0x7FFFFFFFFFFFFFFFULL;
+
+struct CivilDate {
+    int32_t year;
+    uint32_t month;
+    uint32_t day;
+};
+
+// Jours depuis 1970-01-01 → date civile (calendrier grégorien proleptique, ères de 400 ans)
+constexpr CivilDate DaysToCivil(int64_t days) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t doe = static_cast<uint32_t>(days - era * 146097);
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp = (5 * doy + 2) / 153;
+    const uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+    const uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    const int32_t year = static_cast<int32_t>(static_cast<int64_t>(yoe) + era * 400 + (month <= 2 ? 1 : 0));
+    return { year, month, day };
+}
+
+static_assert(DaysToCivil(0).year == 1970 && DaysToCivil(0).month == 1 && DaysToCivil(0).day == 1, "epoch");
+static_assert(DaysToCivil(-FILETIME_EPOCH_DAYS).year == 1601, "origine FILETIME");
+static_assert(DaysToCivil(19782).month == 2 && DaysToCivil(19782).day == 29, "2024-02-29");
+
+// Date civile → jours depuis 1970-01-01 (inverse de DaysToCivil ; dates saisies dans les requêtes)
+constexpr int64_t CivilToDays(int32_t year, uint32_t month, uint32_t day) {
+    const int64_t y = static_cast<int64_t>(year) - (month <= 2 ? 1 : 0);
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const uint32_t yoe = static_cast<uint32_t>(y - era * 400);
+    const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+static_assert(CivilToDays(1970, 1, 1) == 0 && CivilToDays(2024, 2, 29) == 19782, "civil → jours");
+static_assert(CivilToDays(1601, 1, 1) == -FILETIME_EPOCH_DAYS, "origine FILETIME");
+
+namespace filetime_detail {
+
+constexpr char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+constexpr uint32_t POW10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
+
+template <class Char>
+constexpr Char* Put2(Char* p, uint32_t value) {
+    p[0] = static_cast<Char>(DIGIT_PAIRS[2 * value]);
+    p[1] = static_cast<Char>(DIGIT_PAIRS[2 * value + 1]);
+    return p + 2;
+}
+
+template <class Char>
+constexpr Char* PutYear(Char* p, int32_t year) {
+    // FILETIME valide : 1601..30828, donc 4 ou 5 chiffres
+    uint32_t y = static_cast<uint32_t>(year);
+    if (y >= 10000) {
+        *p++ = static_cast<Char>('0' + y / 10000);
+        y %= 10000;
+    }
+    p = Put2(p, y / 100);
+    return Put2(p, y % 100);
+}
+
+template <class Char>
+constexpr Char* PutLiteral(Char* p, const char* text) {
+    while (*text) *p++ = static_cast<Char>(*text++);
+    return p;
+}
+
+// Partie fractionnaire : ticks (0..9999999) tronqués à la précision demandée
+template <class Char>
+constexpr Char* PutFraction(Char* p, uint32_t ticks, TimePrecision precision) {
+    const uint32_t digits = static_cast<uint32_t>(precision);
+    if (digits == 0) return p;
+    uint32_t value = ticks / POW10[7 - digits];
+    *p++ = static_cast<Char>('.');
+    for (uint32_t i = digits; i > 0; i--) {
+        p[i - 1] = static_cast<Char>('0' + value % 10);
+        value /= 10;
+    }
+    return p + digits;
+}
+
+template <class Char>
+constexpr Char* PutDate(Char* p, const CivilDate& date, TimeStyle style) {
+    if (style == TimeStyle::Iso8601) {
+        p = PutYear(p, date.year);
+        *p++ = static_cast<Char>('-');
+        p = Put2(p, date.month);
+        *p++ = static_cast<Char>('-');
+        p = Put2(p, date.day);
+        *p++ = static_cast<Char>('T');
+    } else {
+        p = Put2(p, date.day);
+        *p++ = static_cast<Char>('/');
+        p = Put2(p, date.month);
+        *p++ = static_cast<Char>('/');
+        p = PutYear(p, date.year);
+        *p++ = static_cast<Char>(' ');
+    }
+    return p;
+}
+
+template <class Char>
+constexpr Char* PutTimeOfDay(Char* p, uint32_t secondOfDay, uint32_t fraction, const TimeFormat& format) {
+    p = Put2(p, secondOfDay / 3600);
+    *p++ = static_cast<Char>(':');
+    p = Put2(p, (secondOfDay / 60) % 60);
+    *p++ = static_cast<Char>(':');
+    p = Put2(p, secondOfDay % 60);
+    p = PutFraction(p, fraction, format.precision);
+
+    if (format.style == TimeStyle::Iso8601) {
+        if (format.offsetMinutes == 0) {
+            *p++ = static_cast<Char>('Z');
+        } else {
+            uint32_t offset = static_cast<uint32_t>(format.offsetMinutes < 0 ? -format.offsetMinutes
+                                                                              : format.offsetMinutes);
+            *p++ = static_cast<Char>(format.offsetMinutes < 0 ? '-' : '+');
+            p = Put2(p, (offset / 60) % 100);
+            *p++ = static_cast<Char>(':');
+            p = Put2(p, offset % 60);
+        }
+    }
+    return p;
+}
+
+// Ticks locaux (UTC + décalage) ; false si hors plage, bornes vérifiées avant l'addition (pas de débordement
+// sur une valeur forgée proche de FILETIME_MAX_VALID)
+constexpr bool LocalTicks(uint64_t fileTime, int32_t offsetMinutes, uint64_t& ticks) {
+    if (fileTime == 0 || fileTime > FILETIME_MAX_VALID) return false;
+    const int64_t delta = static_cast<int64_t>(offsetMinutes) * static_cast<int64_t>(FILETIME_TICKS_PER_MINUTE);
+    const uint64_t magnitude = delta < 0 ? static_cast<uint64_t>(-delta) : static_cast<uint64_t>(delta);
+    if (delta < 0) {
+        if (fileTime <= magnitude) return false;
+        ticks = fileTime - magnitude;
+    } else {
+        if (fileTime > FILETIME_MAX_VALID - magnitude) return false;
+        ticks = fileTime + magnitude;
+    }
+    return true;
+}
+
+}  // namespace filetime_detail
+
+// Écrit le timestamp dans out (au moins FILETIME_TEXT_MAX caractères), zéro final compris.
+// Retourne la longueur écrite hors zéro final. 0 → "N/A", hors plage → "Invalide".
+template <class Char>
+constexpr size_t FormatFileTime(uint64_t fileTime, const TimeFormat& format, Char* out) {
+    using namespace filetime_detail;
+    Char* p = out;
+    uint64_t ticks = 0;
+
+    if (fileTime == 0) {
+        p = PutLiteral(p, "N/A");
+    } else if (!LocalTicks(fileTime, format.offsetMinutes, ticks)) {
+        p = PutLiteral(p, "Invalide");
+    } else {
+        const uint64_t seconds = ticks / FILETIME_TICKS_PER_SECOND;
+        const uint32_t fraction = static_cast<uint32_t>(ticks % FILETIME_TICKS_PER_SECOND);
+        const CivilDate date = DaysToCivil(static_cast<int64_t>(seconds / 86400) - FILETIME_EPOCH_DAYS);
+        p = PutDate(p, date, format.style);
+        p = PutTimeOfDay(p, static_cast<uint32_t>(seconds % 86400), fraction, format);
+    }
+
+    *p = 0;
+    return static_cast<size_t>(p - out);
+}
+
+// Formate count FILETIME ; le texte i commence à out + i * stride (stride >= FILETIME_TEXT_MAX).
+// lengths (optionnel) reçoit la longueur de chaque texte.
+template <class Char>
+void FormatFileTimeColumn(const uint64_t* fileTimes, size_t count, const TimeFormat& format,
+                          Char* out, size_t stride = FILETIME_TEXT_MAX, uint32_t* lengths = nullptr) {
+    using namespace filetime_detail;
+
+    // Préfixe de date du dernier jour rencontré
+    Char prefix[16] = {};
+    size_t prefixLength = 0;
+    uint64_t prefixDay = ~0ULL;
+
+    for (size_t i = 0; i < count; i++) {
+        Char* p = out + i * stride;
+        uint64_t ticks = 0;
+
+        if (!LocalTicks(fileTimes[i], format.offsetMinutes, ticks)) {
+            size_t length = FormatFileTime(fileTimes[i], format, p);
+            if (lengths) lengths[i] = static_cast<uint32_t>(length);
+            continue;
+        }
+
+        const uint64_t seconds = ticks / FILETIME_TICKS_PER_SECOND;
+        const uint64_t day = seconds / 86400;
+        if (day != prefixDay) {
+            prefixDay = day;
+            prefixLength = static_cast<size_t>(
+                PutDate(prefix, DaysToCivil(static_cast<int64_t>(day) - FILETIME_EPOCH_DAYS), format.style) - prefix);
+        }
+        for (size_t k = 0; k < prefixLength; k++) {
+            p[k] = prefix[k];
+        }
+
+        Char* end = PutTimeOfDay(p + prefixLength, static_cast<uint32_t>(seconds % 86400),
+                                 static_cast<uint32_t>(ticks % FILETIME_TICKS_PER_SECOND), format);
+        *end = 0;
+        if (lengths) lengths[i] = static_cast<uint32_t>(end - p);
+    }
+}
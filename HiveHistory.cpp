@@ -0,0 +1,166 @@
+/*
+ * HiveHistory - Implémentation de l'historique multi-versions dédupliqué
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "HiveHistory.h"
+
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+void AppendBytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void AppendName(std::vector<uint8_t>& out, const RegfName& name) {
+    out.push_back(name.compressed ? 1 : 0);
+    AppendBytes(out, &name.byteLength, 2);
+    AppendBytes(out, name.ptr, name.byteLength);
+}
+
+// Dossiers entre l'hôte et la ruche ; les préfixes couvrent les numéros (HarddiskVolumeShadowCopy12)
+const char* const SKIPPED_DIRS[] = { "Windows", "System32", "config", "RegBack", "repair", "TxR" };
+const char* const SKIPPED_PREFIXES[] = { "HarddiskVolumeShadowCopy" };
+
+bool StartsWithNoCase(const std::string& text, const char* prefix, bool whole) {
+    const size_t length = std::strlen(prefix);
+    if (text.size() < length || (whole && text.size() != length)) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (std::toupper(static_cast<unsigned char>(text[i])) != std::toupper(static_cast<unsigned char>(prefix[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SkippedDir(const std::string& name) {
+    for (const char* dir : SKIPPED_DIRS) {
+        if (StartsWithNoCase(name, dir, true)) return true;
+    }
+    for (const char* prefix : SKIPPED_PREFIXES) {
+        if (StartsWithNoCase(name, prefix, false)) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+std::string HiveHostName(const std::filesystem::path& hivePath) {
+    std::filesystem::path dir = hivePath.parent_path();
+    while (!dir.empty() && dir.has_filename()) {
+        std::string name = dir.filename().u8string();
+        if (!SkippedDir(name)) return name;
+        dir = dir.parent_path();
+    }
+    return hivePath.stem().u8string();
+}
+
+HiveHistory::HiveHistory(std::u16string_view host, const PathClassifier& classifier)
+    : store(std::make_unique<EntryStore>()), classifier(classifier) {
+    store->EnableFirstSeen();
+    hostId = store->hosts.Intern(host);
+}
+
+// Exactement ce que MergeKey consomme : même empreinte = mêmes lignes produites
+uint64_t HiveHistory::KeyFingerprint(const RegfHive& hive, EntrySource source, uint32_t sidKey,
+                                     const RegfName& sid) {
+    scratch.clear();
+    scratch.push_back(static_cast<uint8_t>(source));
+    AppendName(scratch, sid);
+    hive.ForEachValue(sidKey, [&](const RegfValue& value) {
+        if (IsIgnoredBamDamValue(value.name)) return true;
+        AppendName(scratch, value.name);
+        AppendBytes(scratch, &value.type, 4);
+        AppendBytes(scratch, &value.dataSize, 4);
+        if (value.data && value.dataSize >= 8) AppendBytes(scratch, value.data, 8);
+        return true;
+    });
+    return RegfMarvin32(scratch.data(), scratch.size());
+}
+
+void HiveHistory::MergeKey(const RegfHive& hive, EntrySource source, uint32_t sidKey, const RegfName& sid,
+                           const SidResolveFn& resolveUser) {
+    const uint32_t sidId = store->sids.Intern(sid);
+    if (sidId >= userOf.size()) userOf.resize(sidId + 1, UINT32_MAX);
+    if (userOf[sidId] == UINT32_MAX) {
+        if (resolveUser) {
+            ScopedSpan resolution(TelemetrySpan::SidResolution, 1);
+            userOf[sidId] = store->users.Intern(resolveUser(store->sids.View(sidId)));
+        } else {
+            userOf[sidId] = store->users.Intern(u"<Inconnu>");
+        }
+    }
+
+    auto& index = rows[static_cast<size_t>(source)];
+    ScopedSpan decode(TelemetrySpan::ValueDecode);
+    hive.ForEachValue(sidKey, [&](const RegfValue& value) {
+        if (IsIgnoredBamDamValue(value.name)) return true;
+
+        decode.AddItems(1);
+        uint64_t fileTime = 0;
+        const bool valid = DecodeBamDamFileTime(value.type, value.data, value.dataSize, fileTime);
+        if (!valid) Telemetry::Add(TelemetryCounter::InvalidValues);
+
+        const uint32_t pathId = store->paths.Intern(value.name);
+        const uint64_t key = static_cast<uint64_t>(sidId) << 32 | pathId;
+        auto found = index.find(key);
+        if (found == index.end()) {
+            const size_t row = store->Add(hostId, sidId, userOf[sidId], pathId, valid ? fileTime : 0, source,
+                                          ENTRY_NO_MATCH, valid ? 0 : ENTRY_FLAG_INVALID_DATA);
+            index.emplace(key, static_cast<uint32_t>(row));
+            return true;
+        }
+
+        // Une donnée invalide n'efface jamais une observation valide d'une autre version
+        const size_t row = found->second;
+        if (!valid) return true;
+        if (store->Flags(row) & ENTRY_FLAG_INVALID_DATA) {
+            store->SetTimes(row, fileTime, fileTime, 0);
+        } else {
+            store->SetTimes(row, std::min(store->FirstSeen(row), fileTime), std::max(store->FileTime(row), fileTime),
+                            store->Flags(row));
+        }
+        return true;
+    });
+}
+
+size_t HiveHistory::AddVersion(const RegfHive& hive, const SidResolveFn& resolveUser) {
+    size_t added = 0;
+    ScopedSpan enumeration(TelemetrySpan::KeyEnumeration);
+    WalkBamDamKeys(hive, [&](EntrySource source, uint32_t sidKey, const RegfName& sid) {
+        enumeration.AddItems(1);
+        if (!seenKeys.insert(KeyFingerprint(hive, source, sidKey, sid)).second) {
+            keysReused++;
+            return true;
+        }
+        MergeKey(hive, source, sidKey, sid, resolveUser);
+        keysParsed++;
+        added++;
+        return true;
+    });
+
+    versions++;
+    if (added == 0) {
+        identicalVersions++;
+    } else {
+        VolumeMap candidate;
+        if (candidate.Load(hive)) volumes = std::move(candidate);
+    }
+    return added;
+}
+
+std::unique_ptr<EntryStore> HiveHistory::Finish() {
+    if (store) ResolveRowPaths(*store, 0, volumes, classifier);
+    for (auto& index : rows) index.clear();
+    seenKeys.clear();
+    return std::move(store);
+}
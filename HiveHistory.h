@@ -0,0 +1,84 @@
+/*
+ * HiveHistory - Historique d'exécution fusionné sur plusieurs versions d'une même ruche SYSTEM
+ *
+ * RegBack, copies extraites des clichés VSS, collectes quotidiennes : les versions d'un hôte sont
+ * identiques à quelques clés près. Le parsing ne doit coûter que le contenu distinct.
+ *
+ * - Empreinte de contenu de chaque clé SID bam/dam : Marvin32 de ce que le parsing en lit (service,
+ *   SID, puis par valeur nom, type, taille et 8 premiers octets). Indépendante de l'emplacement des
+ *   cellules et de la LastWriteTime ; calculée sur les octets bruts, sans conversion ni internement.
+ *   Seules les cellules de bam/dam sont lues : le reste de la ruche n'est jamais touché.
+ * - Une clé SID dont l'empreinte a déjà été vue, dans n'importe quelle version, n'est pas parsée ;
+ *   une version sans aucune clé nouvelle est comptée comme identique
+ * - Fusion par (service, SID, chemin) : première et dernière observation = FILETIME minimum et
+ *   maximum relevés dans les versions (EntryStore::FirstSeen / FileTime)
+ * - Chemins normalisés et classés une seule fois à la fin, volumes de la dernière version ajoutée
+ *   qui contient MountedDevices
+ * - HiveHostName : dossier de l'hôte d'après le chemin d'une ruche collectée, au-dessus de
+ *   Windows\System32\config et des dossiers de sauvegarde (RegBack, repair, clichés VSS) : la copie
+ *   RegBack et la ruche vivante d'un même hôte sont regroupées
+ *
+ * Une instance par hôte, alimentée par un seul thread.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "BamDamHive.h"
+#include "EntryStore.h"
+#include "PathRules.h"
+#include "RegfHive.h"
+#include "VolumeMap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class HiveHistory {
+public:
+    explicit HiveHistory(std::u16string_view host, const PathClassifier& classifier = PathClassifier::Default());
+    HiveHistory(const HiveHistory&) = delete;
+    HiveHistory& operator=(const HiveHistory&) = delete;
+
+    // Fusionne une version ; retourne le nombre de clés SID au contenu encore jamais vu
+    size_t AddVersion(const RegfHive& hive, const SidResolveFn& resolveUser = nullptr);
+
+    // Normalise et classe les chemins ; le store (avec FirstSeen) passe à l'appelant
+    std::unique_ptr<EntryStore> Finish();
+
+    size_t Versions() const { return versions; }
+    size_t IdenticalVersions() const { return identicalVersions; }
+    size_t KeysParsed() const { return keysParsed; }
+    size_t KeysReused() const { return keysReused; }
+    size_t RowCount() const { return store ? store->size() : 0; }
+
+private:
+    uint64_t KeyFingerprint(const RegfHive& hive, EntrySource source, uint32_t sidKey, const RegfName& sid);
+    void MergeKey(const RegfHive& hive, EntrySource source, uint32_t sidKey, const RegfName& sid,
+                  const SidResolveFn& resolveUser);
+
+    std::unique_ptr<EntryStore> store;
+    const PathClassifier& classifier;
+    uint32_t hostId;
+    VolumeMap volumes;
+    std::unordered_set<uint64_t> seenKeys;
+    std::unordered_map<uint64_t, uint32_t> rows[2];  // Par service : (sidId << 32 | pathId) → ligne
+    std::vector<uint32_t> userOf;                     // sidId → userId, résolu une seule fois
+    std::vector<uint8_t> scratch;
+    size_t versions = 0;
+    size_t identicalVersions = 0;
+    size_t keysParsed = 0;
+    size_t keysReused = 0;
+};
+
+// Premier dossier parent qui n'est ni Windows, System32, config, ni un dossier de sauvegarde ; à défaut,
+// nom de la ruche (UTF-8)
+std::string HiveHostName(const std::filesystem::path& hivePath);
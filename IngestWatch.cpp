@@ -0,0 +1,357 @@
+/*
+ * IngestWatch - Implémentation de l'observation des dossiers de dépôt et du registre des ruches exportées
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "IngestWatch.h"
+
+#include "CaseFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+#ifdef __linux__
+constexpr uint32_t WATCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF | IN_ONLYDIR;
+constexpr size_t EVENT_BUFFER = 64 * 1024;
+#endif
+
+uint64_t Mix(uint64_t h, uint64_t value) {
+    h ^= value + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 29);
+}
+
+// Taille et date de modification d'un fichier ; false s'il est absent
+bool MixFile(uint64_t& h, const fs::path& path) {
+    std::error_code ec;
+    const uint64_t size = fs::file_size(path, ec);
+    if (ec) return false;
+    const auto written = fs::last_write_time(path, ec);
+    if (ec) return false;
+    h = Mix(h, size);
+    h = Mix(h, static_cast<uint64_t>(written.time_since_epoch().count()));
+    return true;
+}
+
+std::string Upper(std::string text) {
+    for (auto& c : text) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return text;
+}
+
+// Écriture en ajout puis synchronisation sur disque
+bool AppendDurable(const fs::path& path, const std::string& data) {
+#ifdef _WIN32
+    FILE* file = _wfopen(path.c_str(), L"ab");
+#else
+    FILE* file = std::fopen(path.c_str(), "ab");
+#endif
+    if (!file) return false;
+    bool ok = data.empty() || std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = std::fflush(file) == 0 && ok;
+#ifdef _WIN32
+    ok = _commit(_fileno(file)) == 0 && ok;
+#else
+    ok = fsync(fileno(file)) == 0 && ok;
+#endif
+    return std::fclose(file) == 0 && ok;
+}
+
+void AppendRecord(std::string& out, const IngestRecord& record, const std::string& segment) {
+    char numbers[48];
+    std::snprintf(numbers, sizeof(numbers), "%016llx\t%016llx\t", static_cast<unsigned long long>(record.hash),
+                  static_cast<unsigned long long>(record.signature));
+    out += numbers;
+    out += segment;
+    out += '\t';
+    out += record.host;
+    out += '\t';
+    out += record.path.u8string();
+    out += '\n';
+}
+
+}  // namespace
+
+DirectoryWatcher::DirectoryWatcher() {
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) lastError = std::string("inotify indisponible : ") + std::strerror(errno);
+    buffer.resize(EVENT_BUFFER);
+#endif
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+#ifdef __linux__
+    if (fd >= 0) close(fd);
+#endif
+}
+
+bool DirectoryWatcher::Native() const {
+#ifdef __linux__
+    return fd >= 0;
+#else
+    return false;
+#endif
+}
+
+size_t DirectoryWatcher::Watches() const {
+#ifdef __linux__
+    return watches.size();
+#else
+    return 0;
+#endif
+}
+
+bool DirectoryWatcher::Add(const fs::path& root) {
+    std::error_code ec;
+    if (!fs::is_directory(root, ec)) {
+        lastError = "Dossier introuvable : " + root.u8string();
+        return false;
+    }
+#ifdef __linux__
+    if (fd >= 0) {
+        bool overflow = false;
+        AddTree(root, overflow);
+        lostWatches = lostWatches || overflow;
+    }
+#endif
+    return true;
+}
+
+#ifdef __linux__
+// Surveillance de dir et de ses sous-dossiers (liens symboliques non suivis) ; un dossier déjà surveillé
+// (renommé) garde son descripteur, son chemin est mis à jour
+void DirectoryWatcher::AddTree(const fs::path& dir, bool& overflow) {
+    const auto add = [&](const fs::path& target) {
+        const int wd = inotify_add_watch(fd, target.c_str(), WATCH_EVENTS);
+        if (wd >= 0) {
+            watches[wd] = target;
+        } else if (errno == ENOSPC) {
+            overflow = true;
+        }
+    };
+    add(dir);
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) add(it->path());
+    }
+}
+#endif
+
+void DirectoryWatcher::Wait(int timeoutMs, std::vector<fs::path>& changed, bool& overflow) {
+#ifdef __linux__
+    if (fd >= 0) {
+        if (lostWatches) {
+            overflow = true;
+            lostWatches = false;
+        }
+        pollfd descriptor = { fd, POLLIN, 0 };
+        if (poll(&descriptor, 1, timeoutMs) <= 0) return;
+        while (true) {
+            const ssize_t n = read(fd, buffer.data(), buffer.size());
+            if (n <= 0) break;
+            for (const char* p = buffer.data(); p < buffer.data() + n;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    overflow = true;
+                    continue;
+                }
+                const auto it = watches.find(event->wd);
+                if (it == watches.end()) continue;
+                if (event->mask & IN_IGNORED) {
+                    watches.erase(it);
+                    continue;
+                }
+                fs::path target = it->second;
+                if (event->len) target /= std::string(event->name, strnlen(event->name, event->len));
+                changed.push_back(target);
+                if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    AddTree(target, overflow);
+                }
+            }
+        }
+        return;
+    }
+#endif
+    (void)changed;
+    (void)overflow;
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+}
+
+uint64_t HiveContentHash(const RegfHive& hive) {
+    SectionChecksum checksum;
+    const uint64_t total = hive.HbinsSize();
+    uint8_t header[12];
+    const uint32_t root = hive.RootKey();
+    std::memcpy(header, &root, 4);
+    std::memcpy(header + 4, &total, 8);
+    checksum.Update(header, sizeof(header));
+
+    // Parcours par segments contigus : pages du fichier et pages rejouées depuis les journaux
+    uint64_t offset = 0;
+    while (offset < total) {
+        uint64_t available = 0;
+        const uint8_t* data = hive.HbinData(static_cast<uint32_t>(offset), available);
+        if (!data || available == 0) break;
+        available = std::min(available, total - offset);
+        checksum.Update(data, static_cast<size_t>(available));
+        offset += available;
+    }
+    return checksum.Finish();
+}
+
+uint64_t HiveFileSignature(const fs::path& path, bool image) {
+    uint64_t h = 0x6A09E667F3BCC908ULL;
+    if (!MixFile(h, path)) return 0;
+    if (!image) {
+        // Journaux voisins (casse indifférente, comme RegfHive) : un journal réécrit change le contenu
+        const std::string stem = Upper(path.filename().u8string());
+        std::vector<fs::path> logs;
+        std::error_code ec;
+        for (fs::directory_iterator it(path.parent_path(), ec), end; !ec && it != end; it.increment(ec)) {
+            const std::string file = Upper(it->path().filename().u8string());
+            if (file == stem + ".LOG1" || file == stem + ".LOG2") logs.push_back(it->path());
+        }
+        std::sort(logs.begin(), logs.end());
+        for (const fs::path& log : logs) MixFile(h, log);
+    }
+    return h ? h : 1;
+}
+
+bool IngestLedger::Open(const fs::path& file) {
+    std::lock_guard<std::mutex> guard(lock);
+    path = file;
+    hashes.clear();
+    signatures.clear();
+    exported.clear();
+    duplicates.clear();
+    committed = 0;
+
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return true;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        lastError = "Registre illisible : " + path.u8string();
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        // empreinte, signature, segment, hôte, chemin
+        size_t tabs[4];
+        size_t found = 0;
+        for (size_t pos = line.find('\t'); pos != std::string::npos && found < 4; pos = line.find('\t', pos + 1)) {
+            tabs[found++] = pos;
+        }
+        if (found < 4 || tabs[0] != 16 || tabs[1] != 33) continue;
+        const uint64_t hash = std::strtoull(line.substr(0, 16).c_str(), nullptr, 16);
+        const uint64_t signature = std::strtoull(line.substr(17, 16).c_str(), nullptr, 16);
+        const bool duplicate = line.compare(tabs[1] + 1, tabs[2] - tabs[1] - 1, "=") == 0;
+        if (hashes.insert(hash).second && !duplicate) committed++;
+        signatures[line.substr(tabs[3] + 1)] = signature;
+    }
+    return true;
+}
+
+bool IngestLedger::Unchanged(const fs::path& file, uint64_t signature) const {
+    std::lock_guard<std::mutex> guard(lock);
+    const auto it = signatures.find(file.u8string());
+    return it != signatures.end() && it->second == signature;
+}
+
+void IngestLedger::Remember(const fs::path& file, uint64_t signature) {
+    std::lock_guard<std::mutex> guard(lock);
+    signatures[file.u8string()] = signature;
+}
+
+bool IngestLedger::Claim(uint64_t hash) {
+    std::lock_guard<std::mutex> guard(lock);
+    return hashes.insert(hash).second;
+}
+
+void IngestLedger::Release(uint64_t hash) {
+    std::lock_guard<std::mutex> guard(lock);
+    hashes.erase(hash);
+}
+
+void IngestLedger::AddExported(const IngestRecord& record) {
+    std::lock_guard<std::mutex> guard(lock);
+    exported.push_back(record);
+}
+
+void IngestLedger::AddDuplicate(const IngestRecord& record) {
+    std::lock_guard<std::mutex> guard(lock);
+    duplicates.push_back(record);
+}
+
+bool IngestLedger::Commit(const std::string& segment) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (exported.empty() && duplicates.empty()) return true;
+    std::string text;
+    for (const IngestRecord& record : exported) AppendRecord(text, record, segment);
+    for (const IngestRecord& record : duplicates) AppendRecord(text, record, "=");
+    if (!AppendDurable(path, text)) {
+        lastError = "Écriture impossible : " + path.u8string();
+        return false;
+    }
+    committed += exported.size();
+    exported.clear();
+    duplicates.clear();
+    return true;
+}
+
+void IngestLedger::Abandon() {
+    std::lock_guard<std::mutex> guard(lock);
+    std::unordered_set<uint64_t> lost;
+    for (const IngestRecord& record : exported) {
+        lost.insert(record.hash);
+        hashes.erase(record.hash);
+        signatures.erase(record.path.u8string());
+    }
+    exported.clear();
+
+    // Doublons d'un contenu dont la seule copie exportée était dans ce segment : retirés, sinon leur ligne
+    // "=" ferait tenir ce contenu pour exporté au prochain Open ; relus comme les ruches du segment
+    const auto kept = std::remove_if(duplicates.begin(), duplicates.end(), [&](const IngestRecord& record) {
+        if (!lost.count(record.hash)) return false;
+        signatures.erase(record.path.u8string());
+        return true;
+    });
+    duplicates.erase(kept, duplicates.end());
+}
+
+size_t IngestLedger::Count() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return committed;
+}
+
+size_t IngestLedger::PendingExported() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return exported.size();
+}
@@ -0,0 +1,174 @@
+/*
+ * IngestWatch - Briques du mode surveillance de BamDamBatch (--watch) : dossiers de dépôt alimentés en continu
+ * par les collecteurs
+ *
+ * - DirectoryWatcher : inotify récursif sous Linux (fichier fermé après écriture, déplacé ou créé) ; les
+ *   sous-dossiers créés sont surveillés à leur tour. File d'événements du noyau débordée : signalé à
+ *   l'appelant, qui refait un inventaire complet. Ailleurs, aucun événement : l'appelant s'en remet aux
+ *   inventaires périodiques. Sur un partage réseau (CIFS, NFS), inotify ne voit que les écritures faites
+ *   depuis cette machine : l'inventaire périodique rattrape celles des collecteurs.
+ * - BoundedQueue : file bornée multi-producteurs / multi-consommateurs ; Push bloque tant qu'elle est
+ *   pleine, la contre-pression remonte ainsi de l'export jusqu'à l'observateur des dossiers
+ * - HiveContentHash : empreinte 64 bits des hbin effectifs (journaux appliqués) et de la cellule racine ;
+ *   une copie consolidée et une copie non consolidée d'un même état ont la même empreinte
+ * - HiveFileSignature : taille et date de modification de la ruche et de ses journaux (ou de l'image),
+ *   pour ne pas relire un fichier inchangé lors des inventaires
+ * - IngestLedger : empreintes déjà exportées, journal texte en ajout synchronisé sur disque
+ *   ("empreinte<TAB>signature<TAB>segment<TAB>hôte<TAB>chemin", segment "=" pour un contenu déjà vu). Les
+ *   enregistrements d'un segment de sortie ne sont écrits qu'une fois ce segment fermé : un arrêt brutal
+ *   fait au pire réexporter, jamais perdre.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "RegfHive.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity ? capacity : 1) {}
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Attend une place au plus timeout ; false si le délai expire ou si la file est fermée (item intact)
+    template <class Rep, class Period>
+    bool Push(T& item, std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (!changed.wait_for(guard, timeout, [this] { return closed || items.size() < capacity; }) || closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        changed.notify_all();
+        return true;
+    }
+
+    // Attend un élément ; false une fois la file fermée et vide
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    // Les consommateurs vident ce qui reste puis s'arrêtent ; les producteurs sont refusés
+    void Close() {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        changed.notify_all();
+    }
+
+    size_t Size() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return items.size();
+    }
+    size_t Capacity() const { return capacity; }
+
+private:
+    mutable std::mutex lock;
+    std::condition_variable changed;
+    std::deque<T> items;
+    const size_t capacity;
+    bool closed = false;
+};
+
+class DirectoryWatcher {
+public:
+    DirectoryWatcher();
+    ~DirectoryWatcher();
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Surveille root et tous ses sous-dossiers ; false (LastError) si root n'est pas un dossier lisible
+    bool Add(const std::filesystem::path& root);
+    // Attend au plus timeoutMs ; changed reçoit les chemins touchés (ajoutés à la fin), overflow passe à
+    // true si des événements ont été perdus (file du noyau pleine, limite de surveillances atteinte)
+    void Wait(int timeoutMs, std::vector<std::filesystem::path>& changed, bool& overflow);
+
+    // false : pas d'événements (plateforme, inotify indisponible), inventaires périodiques seulement
+    bool Native() const;
+    size_t Watches() const;
+    const std::string& LastError() const { return lastError; }
+
+private:
+#ifdef __linux__
+    void AddTree(const std::filesystem::path& dir, bool& overflow);
+
+    int fd = -1;
+    std::unordered_map<int, std::filesystem::path> watches;
+    std::vector<char> buffer;
+    bool lostWatches = false;  // Limite fs.inotify.max_user_watches atteinte, signalée au prochain Wait
+#endif
+    std::string lastError;
+};
+
+uint64_t HiveContentHash(const RegfHive& hive);
+// 0 si le fichier est absent ; image = fichier seul, sinon journaux .LOG1 / .LOG2 voisins compris
+uint64_t HiveFileSignature(const std::filesystem::path& path, bool image);
+
+struct IngestRecord {
+    uint64_t hash = 0;
+    uint64_t signature = 0;
+    std::string host;  // UTF-8
+    std::filesystem::path path;
+};
+
+class IngestLedger {
+public:
+    IngestLedger() = default;
+    IngestLedger(const IngestLedger&) = delete;
+    IngestLedger& operator=(const IngestLedger&) = delete;
+
+    // Charge le journal s'il existe (lignes illisibles ignorées) ; false (LastError) si illisible
+    bool Open(const std::filesystem::path& path);
+
+    // Fichier déjà vu avec cette signature (exporté, doublon ou échec) : inutile de le relire
+    bool Unchanged(const std::filesystem::path& path, uint64_t signature) const;
+    void Remember(const std::filesystem::path& path, uint64_t signature);
+
+    // Réserve une empreinte pour l'export ; false si elle est déjà exportée ou en cours
+    bool Claim(uint64_t hash);
+    // Réservation levée (échec avant la remise à l'export)
+    void Release(uint64_t hash);
+
+    // Enregistrements en attente du prochain Commit : ruche remise au segment courant, ou doublon
+    void AddExported(const IngestRecord& record);
+    void AddDuplicate(const IngestRecord& record);
+    // Segment fermé et renommé : ses enregistrements (et les doublons en attente) écrits et synchronisés
+    bool Commit(const std::string& segment);
+    // Segment perdu : ses empreintes redeviennent inconnues, ses fichiers et les doublons en attente de ces
+    // empreintes seront relus
+    void Abandon();
+
+    size_t Count() const;
+    size_t PendingExported() const;
+    const std::filesystem::path& Path() const { return path; }
+    const std::string& LastError() const { return lastError; }
+
+private:
+    mutable std::mutex lock;
+    std::filesystem::path path;
+    std::unordered_set<uint64_t> hashes;  // Exportées ou réservées
+    std::unordered_map<std::string, uint64_t> signatures;  // Chemin UTF-8 → dernière signature vue
+    std::vector<IngestRecord> exported;
+    std::vector<IngestRecord> duplicates;
+    size_t committed = 0;
+    std::string lastError;
+};
@@ -0,0 +1,133 @@
+/*
+ * MappedFile - Implémentation Win32 (CreateFileMapping) et POSIX (mmap)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        base = other.base;
+        length = other.length;
+        lastError = std::move(other.lastError);
+#ifdef _WIN32
+        hFile = other.hFile;
+        hMapping = other.hMapping;
+        other.hFile = nullptr;
+        other.hMapping = nullptr;
+#else
+        fd = other.fd;
+        other.fd = -1;
+#endif
+        other.base = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+    Close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        lastError = "CreateFileW a échoué (" + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        lastError = "Fichier vide ou taille illisible";
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        lastError = "CreateFileMappingW a échoué (" + std::to_string(GetLastError()) + ")";
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        lastError = "MapViewOfFile a échoué (" + std::to_string(GetLastError()) + ")";
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    hFile = file;
+    hMapping = mapping;
+    base = static_cast<const uint8_t*>(view);
+    length = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (base) UnmapViewOfFile(base);
+    if (hMapping) CloseHandle(hMapping);
+    if (hFile) CloseHandle(hFile);
+    base = nullptr;
+    length = 0;
+    hMapping = nullptr;
+    hFile = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+    Close();
+
+    int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        lastError = "open a échoué : " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    struct stat st = {};
+    if (fstat(file, &st) != 0 || st.st_size <= 0) {
+        lastError = "Fichier vide ou taille illisible";
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+        lastError = "mmap a échoué : " + std::string(std::strerror(errno));
+        ::close(file);
+        return false;
+    }
+
+    fd = file;
+    base = static_cast<const uint8_t*>(view);
+    length = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (base) munmap(const_cast<uint8_t*>(base), length);
+    if (fd >= 0) ::close(fd);
+    base = nullptr;
+    length = 0;
+    fd = -1;
+}
+
+#endif
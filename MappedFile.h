@@ -0,0 +1,47 @@
+/*
+ * MappedFile - Projection mémoire en lecture seule d'un fichier (portable Win32 / POSIX)
+ *
+ * Utilisé par le moteur regf hors-ligne : la ruche n'est jamais copiée,
+ * toutes les structures (hbin, cellules, noms, données) sont lues en place.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Projette le fichier entier en lecture seule. Un fichier vide est refusé.
+    bool Open(const std::filesystem::path& path);
+    void Close();
+
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+    bool valid() const { return base != nullptr; }
+    const std::string& LastError() const { return lastError; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    std::string lastError;
+#ifdef _WIN32
+    void* hFile = nullptr;
+    void* hMapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
@@ -0,0 +1,668 @@
+/*
+ * NtfsImage - Implémentation de la lecture NTFS dans une image disque
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "NtfsImage.h"
+
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t NTFS_SPARSE = UINT64_MAX;
+constexpr uint32_t FIXUP_STRIDE = 512;
+constexpr size_t MAX_ATTRIBUTE_LIST = 1 << 20;
+constexpr int MAX_INDEX_DEPTH = 32;
+
+constexpr uint32_t ATTR_ATTRIBUTE_LIST = 0x20;
+constexpr uint32_t ATTR_DATA = 0x80;
+constexpr uint32_t ATTR_INDEX_ROOT = 0x90;
+constexpr uint32_t ATTR_INDEX_ALLOCATION = 0xA0;
+constexpr uint32_t ATTR_END = 0xFFFFFFFF;
+
+constexpr uint16_t ATTR_FLAG_COMPRESSED = 0x00FF;
+constexpr uint16_t ATTR_FLAG_ENCRYPTED = 0x4000;
+
+constexpr uint32_t INDEX_ENTRY_SUBNODE = 0x01;
+constexpr uint32_t INDEX_ENTRY_LAST = 0x02;
+
+constexpr uint64_t RECORD_NUMBER_MASK = 0x0000FFFFFFFFFFFF;
+
+constexpr char16_t CONFIG_DIR[] = u"Windows\\System32\\config\\";
+
+bool IsNtfsBoot(const uint8_t* image, size_t size, uint64_t offset) {
+    return offset < size && size - offset >= 512 && std::memcmp(image + offset + 3, "NTFS    ", 8) == 0;
+}
+
+// Taille codée sur un octet signé du boot sector : > 0 en clusters, < 0 en puissance de 2 d'octets
+uint64_t EncodedSize(int8_t value, uint32_t clusterSize) {
+    if (value > 0) return static_cast<uint64_t>(value) * clusterSize;
+    if (value < -31 || value == 0) return 0;
+    return uint64_t{ 1 } << -value;
+}
+
+// Approximation de la table $UpCase : suffisante pour les chemins système (ASCII)
+char16_t Upcase(char16_t c) { return c >= u'a' && c <= u'z' ? static_cast<char16_t>(c - 32) : c; }
+
+// Nom UTF-16LE brut de l'index comparé à name : < 0, 0, > 0 (ordre de collation de $I30)
+int CompareName(std::u16string_view name, const uint8_t* raw, size_t length) {
+    const size_t common = std::min(name.size(), length);
+    for (size_t i = 0; i < common; i++) {
+        const char16_t a = Upcase(name[i]);
+        const char16_t b = Upcase(static_cast<char16_t>(RegfRead16(raw + i * 2)));
+        if (a != b) return a < b ? -1 : 1;
+    }
+    if (name.size() == length) return 0;
+    return name.size() < length ? -1 : 1;
+}
+
+bool NameEquals(const uint8_t* raw, size_t length, std::u16string_view name) {
+    if (length != name.size()) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (static_cast<char16_t>(RegfRead16(raw + i * 2)) != name[i]) return false;
+    }
+    return true;
+}
+
+// En-tête d'attribut validé dans un enregistrement FILE corrigé
+struct AttributeView {
+    const uint8_t* header;
+    uint32_t type;
+    uint32_t length;
+    bool nonResident;
+    const uint8_t* name;
+    size_t nameLength;
+    uint16_t flags;
+};
+
+template <typename Fn>
+bool ForEachAttribute(const std::vector<uint8_t>& record, Fn&& fn) {
+    const uint8_t* data = record.data();
+    const size_t used = std::min<size_t>(RegfRead32(data + 0x18), record.size());
+    size_t offset = RegfRead16(data + 0x14);
+    while (offset + 16 <= used) {
+        AttributeView attribute{};
+        attribute.header = data + offset;
+        attribute.type = RegfRead32(attribute.header);
+        if (attribute.type == ATTR_END) return true;
+        attribute.length = RegfRead32(attribute.header + 4);
+        if (attribute.length < 16 || attribute.length > used - offset) return false;
+        attribute.nonResident = attribute.header[8] != 0;
+        attribute.nameLength = attribute.header[9];
+        const size_t nameOffset = RegfRead16(attribute.header + 10);
+        if (nameOffset + attribute.nameLength * 2 > attribute.length) return false;
+        if (attribute.nonResident && attribute.length < 0x40) return false;
+        if (!attribute.nonResident && attribute.length < 0x18) return false;
+        attribute.name = attribute.header + nameOffset;
+        attribute.flags = RegfRead16(attribute.header + 12);
+        if (!fn(attribute)) return true;
+        offset += attribute.length;
+    }
+    return true;
+}
+
+// Valeur d'un attribut résident ; nullptr si elle déborde de l'attribut
+const uint8_t* ResidentValue(const AttributeView& attribute, uint32_t& size) {
+    size = RegfRead32(attribute.header + 0x10);
+    const uint16_t offset = RegfRead16(attribute.header + 0x14);
+    if (offset > attribute.length || size > attribute.length - offset) return nullptr;
+    return attribute.header + offset;
+}
+
+// Liste d'extents (data runs) : octet d'en-tête = tailles (longueur, offset), offset LCN signé
+// relatif au précédent, offset absent = extent creux
+template <typename Extent>
+bool DecodeRuns(const AttributeView& attribute, std::vector<Extent>& out) {
+    const size_t runsOffset = RegfRead16(attribute.header + 0x20);
+    if (runsOffset > attribute.length) return false;
+    const uint8_t* runs = attribute.header + runsOffset;
+    const size_t size = attribute.length - runsOffset;
+
+    uint64_t vcn = RegfRead64(attribute.header + 0x10);
+    int64_t lcn = 0;
+    size_t pos = 0;
+    while (pos < size && runs[pos] != 0) {
+        const unsigned lengthSize = runs[pos] & 0x0F;
+        const unsigned offsetSize = runs[pos] >> 4;
+        if (lengthSize == 0 || lengthSize > 8 || offsetSize > 8 || pos + 1 + lengthSize + offsetSize > size) {
+            return false;
+        }
+        pos++;
+        uint64_t length = 0;
+        for (unsigned i = 0; i < lengthSize; i++) length |= static_cast<uint64_t>(runs[pos + i]) << (8 * i);
+        pos += lengthSize;
+        if (length == 0 || length > UINT64_MAX - vcn) return false;
+
+        Extent extent{ vcn, NTFS_SPARSE, length };
+        if (offsetSize > 0) {
+            uint64_t delta = 0;
+            for (unsigned i = 0; i < offsetSize; i++) delta |= static_cast<uint64_t>(runs[pos + i]) << (8 * i);
+            if (offsetSize < 8 && (runs[pos + offsetSize - 1] & 0x80)) delta |= UINT64_MAX << (8 * offsetSize);
+            lcn += static_cast<int64_t>(delta);
+            if (lcn < 0) return false;
+            extent.lcn = static_cast<uint64_t>(lcn);
+        }
+        pos += offsetSize;
+        out.push_back(extent);
+        vcn += length;
+    }
+    return true;
+}
+
+}  // namespace
+
+std::vector<uint64_t> NtfsVolume::FindVolumes(const uint8_t* image, size_t size) {
+    std::vector<uint64_t> volumes;
+    auto candidate = [&](uint64_t lba, uint32_t sector) {
+        if (lba == 0 || lba > UINT64_MAX / sector) return;
+        const uint64_t offset = lba * sector;
+        if (IsNtfsBoot(image, size, offset) && std::find(volumes.begin(), volumes.end(), offset) == volumes.end()) {
+            volumes.push_back(offset);
+        }
+    };
+
+    // Image de volume : le boot sector NTFS se termine aussi par 55 AA, sa "table" est du code
+    if (IsNtfsBoot(image, size, 0)) return { 0 };
+    if (size < 512 || image[510] != 0x55 || image[511] != 0xAA) return volumes;
+
+    bool gpt = false;
+    for (int i = 0; i < 4; i++) {
+        const uint8_t* entry = image + 0x1BE + i * 16;
+        if (entry[4] == 0xEE) gpt = true;
+        else if (entry[4] != 0) {
+            // Disques 4Kn : LBA en secteurs de 4096 octets
+            candidate(RegfRead32(entry + 8), 512);
+            candidate(RegfRead32(entry + 8), 4096);
+        }
+    }
+    if (!gpt) return volumes;
+
+    for (uint32_t sector : { 512u, 4096u }) {
+        if (size < uint64_t{ sector } * 2 || std::memcmp(image + sector, "EFI PART", 8) != 0) continue;
+        const uint8_t* header = image + sector;
+        const uint64_t entriesLba = RegfRead64(header + 0x48);
+        const uint32_t count = std::min<uint32_t>(RegfRead32(header + 0x50), 1024);
+        const uint32_t entrySize = RegfRead32(header + 0x54);
+        if (entrySize < 128 || entriesLba > size / sector) continue;
+        const uint64_t first = entriesLba * sector;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint64_t position = first + uint64_t{ i } * entrySize;
+            if (position + entrySize > size) break;
+            candidate(RegfRead64(image + position + 32), sector);
+        }
+    }
+    return volumes;
+}
+
+const uint8_t* NtfsVolume::Bytes(uint64_t volumePosition, uint64_t size) {
+    if (volumePosition > volumeSize || size > volumeSize - volumePosition) {
+        lastError = "Lecture hors du volume (image tronquée ?)";
+        return nullptr;
+    }
+    bytesRead += size;
+    return image + volumeOffset + volumePosition;
+}
+
+bool NtfsVolume::Open(const uint8_t* data, size_t size, uint64_t offset) {
+    image = data;
+    imageSize = size;
+    volumeOffset = offset;
+    bytesRead = 0;
+    mft = NonResident{};
+    if (!IsNtfsBoot(data, size, offset)) {
+        lastError = "Boot sector NTFS absent";
+        return false;
+    }
+
+    const uint8_t* boot = data + offset;
+    sectorSize = RegfRead16(boot + 0x0B);
+    const uint8_t perCluster = boot[0x0D];
+    const uint32_t sectorsPerCluster = perCluster <= 0x80 ? perCluster : 1u << (256 - perCluster);
+    if (sectorSize < 256 || sectorSize > 4096 || (sectorSize & (sectorSize - 1)) || sectorsPerCluster == 0 ||
+        sectorsPerCluster > (2u << 20) / sectorSize) {
+        lastError = "Géométrie NTFS invalide";
+        return false;
+    }
+    clusterSize = sectorSize * sectorsPerCluster;
+    const uint64_t records = EncodedSize(static_cast<int8_t>(boot[0x40]), clusterSize);
+    const uint64_t blocks = EncodedSize(static_cast<int8_t>(boot[0x44]), clusterSize);
+    if (records < FIXUP_STRIDE || records > 65536 || blocks < FIXUP_STRIDE || blocks > 65536) {
+        lastError = "Taille d'enregistrement MFT invalide";
+        return false;
+    }
+    recordSize = static_cast<uint32_t>(records);
+    indexBlockSize = static_cast<uint32_t>(blocks);
+
+    // Volume borné par le boot sector et par l'image
+    const uint64_t sectors = RegfRead64(boot + 0x28);
+    volumeSize = size - offset;
+    if (sectors != 0 && sectors < volumeSize / sectorSize) volumeSize = (sectors + 1) * sectorSize;
+
+    // Amorçage : l'enregistrement 0 ($MFT) est au début de la MFT, ses propres extents la décrivent
+    const uint64_t mftLcn = RegfRead64(boot + 0x30);
+    if (mftLcn > volumeSize / clusterSize) {
+        lastError = "LCN de la MFT hors du volume";
+        return false;
+    }
+    mft.extents.push_back({ 0, mftLcn, (recordSize + clusterSize - 1) / clusterSize });
+    mft.realSize = mft.initializedSize = recordSize;
+
+    std::vector<uint8_t> record;
+    if (!ReadRecord(0, record)) return false;
+    NonResident first;
+    bool found = false;
+    bool valid = ForEachAttribute(record, [&](const AttributeView& attribute) {
+        if (attribute.type != ATTR_DATA || attribute.nameLength != 0 || !attribute.nonResident) return true;
+        if (RegfRead64(attribute.header + 0x10) != 0) return true;
+        found = DecodeRuns(attribute, first.extents);
+        first.realSize = RegfRead64(attribute.header + 0x30);
+        first.initializedSize = RegfRead64(attribute.header + 0x38);
+        return false;
+    });
+    if (!valid || !found) {
+        lastError = "$DATA de la MFT illisible";
+        return false;
+    }
+    mft = std::move(first);
+
+    // MFT très fragmentée : la suite de ses extents est décrite par $ATTRIBUTE_LIST
+    std::vector<uint8_t> resident;
+    NonResident complete;
+    bool isResident = false;
+    if (!FindAttribute(0, ATTR_DATA, u"", resident, complete, isResident) || isResident) {
+        if (lastError.empty()) lastError = "$DATA de la MFT illisible";
+        return false;
+    }
+    mft = std::move(complete);
+    lastError.clear();
+    return true;
+}
+
+bool NtfsVolume::ApplyFixup(uint8_t* block, size_t size, const char* signature) {
+    if (std::memcmp(block, signature, 4) != 0) {
+        lastError = std::string("Signature ") + signature + " absente";
+        return false;
+    }
+    const size_t usaOffset = RegfRead16(block + 4);
+    const size_t usaCount = RegfRead16(block + 6);
+    if (usaCount < 2 || usaOffset + usaCount * 2 > size || (usaCount - 1) * FIXUP_STRIDE > size) {
+        lastError = "Tableau de mise à jour invalide";
+        return false;
+    }
+    const uint8_t* usa = block + usaOffset;
+    for (size_t i = 1; i < usaCount; i++) {
+        uint8_t* tail = block + i * FIXUP_STRIDE - 2;
+        // Secteur écrit partiellement : le numéro de séquence ne correspond pas
+        if (std::memcmp(tail, usa, 2) != 0) {
+            lastError = "Tableau de mise à jour incohérent (écriture interrompue)";
+            return false;
+        }
+        std::memcpy(tail, usa + i * 2, 2);
+    }
+    return true;
+}
+
+bool NtfsVolume::ReadRecord(uint64_t record, std::vector<uint8_t>& out) {
+    if (record > UINT64_MAX / recordSize) {
+        lastError = "Numéro d'enregistrement MFT invalide";
+        return false;
+    }
+    out.resize(recordSize);
+    if (!ReadNonResident(mft, record * recordSize, recordSize, out.data())) return false;
+    if (!ApplyFixup(out.data(), out.size(), "FILE")) return false;
+    if (!(RegfRead16(out.data() + 0x16) & 0x01)) {
+        lastError = "Enregistrement MFT libre";
+        return false;
+    }
+    if (RegfRead16(out.data() + 0x14) >= recordSize) {
+        lastError = "Enregistrement MFT invalide";
+        return false;
+    }
+    return true;
+}
+
+bool NtfsVolume::ReadNonResident(const NonResident& attribute, uint64_t position, uint64_t size, uint8_t* out) {
+    if (position > attribute.realSize || size > attribute.realSize - position) {
+        lastError = "Lecture au-delà de la fin du flux";
+        return false;
+    }
+    const uint64_t start = position;
+    const uint64_t end = position + size;
+    while (position < end) {
+        uint8_t* target = out + (position - start);
+        const uint64_t vcn = position / clusterSize;
+        auto it = std::upper_bound(attribute.extents.begin(), attribute.extents.end(), vcn,
+                                   [](uint64_t value, const Extent& extent) { return value < extent.vcn; });
+        if (it == attribute.extents.begin() || vcn - (it - 1)->vcn >= (it - 1)->length) {
+            lastError = "Extent manquant dans la liste des data runs";
+            return false;
+        }
+        const Extent& extent = *(it - 1);
+        const uint64_t extentEnd = (extent.vcn + extent.length) * clusterSize;
+        uint64_t chunk = std::min(end, extentEnd) - position;
+
+        if (position >= attribute.initializedSize || extent.lcn == NTFS_SPARSE) {
+            // Non initialisé ou creux : lu comme des zéros
+            if (position < attribute.initializedSize) chunk = std::min(chunk, attribute.initializedSize - position);
+            std::memset(target, 0, chunk);
+        } else {
+            chunk = std::min(chunk, attribute.initializedSize - position);
+            if (extent.lcn > UINT64_MAX / clusterSize) {
+                lastError = "LCN invalide";
+                return false;
+            }
+            const uint8_t* source = Bytes(extent.lcn * clusterSize + (position - extent.vcn * clusterSize), chunk);
+            if (!source) return false;
+            std::memcpy(target, source, chunk);
+        }
+        position += chunk;
+    }
+    return true;
+}
+
+bool NtfsVolume::FindAttribute(uint64_t record, uint32_t type, std::u16string_view name,
+                               std::vector<uint8_t>& resident, NonResident& nonResident, bool& isResident) {
+    std::vector<uint8_t> base;
+    if (!ReadRecord(record, base)) return false;
+
+    // Enregistrements qui portent l'attribut : le base record, ou ceux désignés par $ATTRIBUTE_LIST
+    std::vector<uint64_t> holders;
+    std::vector<uint8_t> list;
+    bool listFound = false;
+    bool valid = ForEachAttribute(base, [&](const AttributeView& attribute) {
+        if (attribute.type != ATTR_ATTRIBUTE_LIST) return true;
+        listFound = true;
+        if (!attribute.nonResident) {
+            uint32_t size = 0;
+            const uint8_t* value = ResidentValue(attribute, size);
+            if (value) list.assign(value, value + size);
+            return false;
+        }
+        NonResident runs;
+        runs.realSize = RegfRead64(attribute.header + 0x30);
+        runs.initializedSize = RegfRead64(attribute.header + 0x38);
+        if (runs.realSize <= MAX_ATTRIBUTE_LIST && DecodeRuns(attribute, runs.extents)) {
+            list.resize(runs.realSize);
+            if (!ReadNonResident(runs, 0, runs.realSize, list.data())) list.clear();
+        }
+        return false;
+    });
+    if (!valid) {
+        lastError = "Attributs de l'enregistrement MFT invalides";
+        return false;
+    }
+    if (listFound) {
+        for (size_t pos = 0; pos + 0x1A <= list.size();) {
+            const uint8_t* entry = list.data() + pos;
+            const uint16_t length = RegfRead16(entry + 4);
+            const uint8_t nameLength = entry[6];
+            const uint8_t nameOffset = entry[7];
+            if (length < 0x1A || pos + length > list.size() || nameOffset + nameLength * 2u > length) break;
+            if (RegfRead32(entry) == type && NameEquals(entry + nameOffset, nameLength, name)) {
+                const uint64_t holder = RegfRead64(entry + 0x10) & RECORD_NUMBER_MASK;
+                if (std::find(holders.begin(), holders.end(), holder) == holders.end()) holders.push_back(holder);
+            }
+            pos += length;
+        }
+    } else {
+        holders.push_back(record);
+    }
+
+    isResident = false;
+    nonResident = NonResident{};
+    bool found = false;
+    std::vector<uint8_t> extension;
+    for (uint64_t holder : holders) {
+        const std::vector<uint8_t>* data = &base;
+        if (holder != record) {
+            if (!ReadRecord(holder, extension)) return false;
+            data = &extension;
+        }
+        bool rejected = false;
+        valid = ForEachAttribute(*data, [&](const AttributeView& attribute) {
+            if (attribute.type != type || !NameEquals(attribute.name, attribute.nameLength, name)) return true;
+            if (attribute.flags & (ATTR_FLAG_COMPRESSED | ATTR_FLAG_ENCRYPTED)) {
+                lastError = "Flux compressé ou chiffré non pris en charge";
+                rejected = true;
+                return false;
+            }
+            if (!attribute.nonResident) {
+                uint32_t size = 0;
+                const uint8_t* value = ResidentValue(attribute, size);
+                if (!value) {
+                    rejected = true;
+                    return false;
+                }
+                resident.assign(value, value + size);
+                isResident = found = true;
+                return false;
+            }
+            if (!DecodeRuns(attribute, nonResident.extents)) {
+                lastError = "Data runs invalides";
+                rejected = true;
+                return false;
+            }
+            // Tailles portées par le segment de VCN 0
+            if (RegfRead64(attribute.header + 0x10) == 0) {
+                nonResident.realSize = RegfRead64(attribute.header + 0x30);
+                nonResident.initializedSize = RegfRead64(attribute.header + 0x38);
+            }
+            found = true;
+            return true;
+        });
+        if (!valid || rejected) {
+            if (!rejected || lastError.empty()) lastError = "Attributs de l'enregistrement MFT invalides";
+            return false;
+        }
+        if (isResident) return true;
+    }
+    if (!found) {
+        lastError = "Attribut introuvable";
+        return false;
+    }
+    std::sort(nonResident.extents.begin(), nonResident.extents.end(),
+              [](const Extent& a, const Extent& b) { return a.vcn < b.vcn; });
+    nonResident.initializedSize = std::min(nonResident.initializedSize, nonResident.realSize);
+    return true;
+}
+
+bool NtfsVolume::ReadFile(uint64_t record, NtfsStream& out) {
+    out.data = nullptr;
+    out.size = 0;
+    out.buffer.clear();
+
+    NonResident stream;
+    bool isResident = false;
+    if (!FindAttribute(record, ATTR_DATA, u"", out.buffer, stream, isResident)) return false;
+    if (isResident) {
+        out.data = out.buffer.data();
+        out.size = out.buffer.size();
+        return true;
+    }
+    if (stream.realSize > std::numeric_limits<size_t>::max()) {
+        lastError = "Flux trop volumineux";
+        return false;
+    }
+    out.size = stream.realSize;
+    if (out.size == 0 || stream.extents.empty()) {
+        out.buffer.assign(static_cast<size_t>(out.size), 0);
+        out.data = out.buffer.data();
+        return true;
+    }
+
+    // Un seul extent initialisé : pointeur direct dans l'image
+    const Extent& first = stream.extents.front();
+    if (first.vcn == 0 && first.lcn != NTFS_SPARSE && stream.initializedSize == stream.realSize &&
+        first.length >= (stream.realSize + clusterSize - 1) / clusterSize && first.lcn <= UINT64_MAX / clusterSize) {
+        out.data = Bytes(first.lcn * clusterSize, stream.realSize);
+        return out.data != nullptr;
+    }
+    out.buffer.resize(static_cast<size_t>(stream.realSize));
+    if (!ReadNonResident(stream, 0, stream.realSize, out.buffer.data())) return false;
+    out.data = out.buffer.data();
+    return true;
+}
+
+bool NtfsVolume::FindInDirectory(uint64_t directory, std::u16string_view name, uint64_t& record) {
+    std::vector<uint8_t> root;
+    NonResident allocation;
+    bool isResident = false;
+    if (!FindAttribute(directory, ATTR_INDEX_ROOT, u"$I30", root, allocation, isResident) || !isResident ||
+        root.size() < 0x20) {
+        lastError = "Index $I30 du répertoire illisible";
+        return false;
+    }
+    const uint32_t blockSize = RegfRead32(root.data() + 8);
+    bool allocationLoaded = false;
+
+    // node = en-tête de nœud (offsets relatifs à lui), available = octets lisibles à partir de node
+    std::vector<uint8_t> block;
+    const uint8_t* node = root.data() + 0x10;
+    size_t available = root.size() - 0x10;
+    for (int depth = 0; depth < MAX_INDEX_DEPTH; depth++) {
+        const size_t entriesEnd = std::min<size_t>(RegfRead32(node + 4), available);
+        size_t pos = RegfRead32(node);
+        uint64_t subnode = UINT64_MAX;
+        bool descend = false;
+        while (pos + 16 <= entriesEnd) {
+            const uint8_t* entry = node + pos;
+            const uint16_t length = RegfRead16(entry + 8);
+            const uint16_t keyLength = RegfRead16(entry + 10);
+            const uint32_t flags = RegfRead32(entry + 12);
+            if (length < 16 || pos + length > entriesEnd) break;
+            if ((flags & INDEX_ENTRY_SUBNODE) && length >= 24) subnode = RegfRead64(entry + length - 8);
+
+            int order = -1;  // Entrée finale : plus grande que tout nom
+            if (!(flags & INDEX_ENTRY_LAST)) {
+                const uint8_t* key = entry + 16;
+                if (keyLength < 0x42 || 16u + keyLength > length) break;
+                const size_t nameLength = key[0x40];
+                if (0x42 + nameLength * 2 > keyLength) break;
+                order = CompareName(name, key + 0x42, nameLength);
+            }
+            if (order == 0) {
+                record = RegfRead64(entry) & RECORD_NUMBER_MASK;
+                return true;
+            }
+            if (order < 0) {
+                descend = (flags & INDEX_ENTRY_SUBNODE) != 0;
+                break;
+            }
+            pos += length;
+        }
+        if (!descend) break;
+
+        if (!allocationLoaded) {
+            std::vector<uint8_t> ignored;
+            if (!FindAttribute(directory, ATTR_INDEX_ALLOCATION, u"$I30", ignored, allocation, isResident) ||
+                isResident || blockSize < FIXUP_STRIDE || blockSize > 65536) {
+                lastError = "Blocs INDX du répertoire illisibles";
+                return false;
+            }
+            allocationLoaded = true;
+        }
+        // VCN en clusters, ou en secteurs de 512 octets quand le bloc est plus petit qu'un cluster
+        const uint64_t unit = blockSize >= clusterSize ? clusterSize : 512;
+        if (subnode > UINT64_MAX / unit) break;
+        block.resize(blockSize);
+        if (!ReadNonResident(allocation, subnode * unit, blockSize, block.data()) ||
+            !ApplyFixup(block.data(), block.size(), "INDX")) {
+            return false;
+        }
+        node = block.data() + 0x18;
+        available = block.size() - 0x18;
+    }
+    lastError = "Introuvable dans le répertoire";
+    return false;
+}
+
+bool NtfsVolume::FindFile(std::u16string_view path, uint64_t& record) {
+    record = NTFS_ROOT_RECORD;
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t end = path.find(u'\\', start);
+        if (end == std::u16string_view::npos) end = path.size();
+        if (end > start && !FindInDirectory(record, path.substr(start, end - start), record)) return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+bool NtfsImage::Open(const fs::path& path) {
+    if (!file.Open(path)) {
+        lastError = file.LastError();
+        return false;
+    }
+    const std::vector<uint64_t> offsets = NtfsVolume::FindVolumes(file.data(), file.size());
+    if (offsets.empty()) {
+        lastError = "Aucun volume NTFS dans l'image";
+        return false;
+    }
+    const std::u16string system = std::u16string(CONFIG_DIR) + u"SYSTEM";
+    for (uint64_t offset : offsets) {
+        uint64_t record = 0;
+        if (volume.Open(file.data(), file.size(), offset) && volume.FindFile(system, record)) {
+            lastError.clear();
+            return true;
+        }
+    }
+    // Cause de l'échec sur le dernier volume essayé (image tronquée, MFT corrompue...)
+    lastError = "Aucun volume ne contient Windows\\System32\\config\\SYSTEM (" + volume.LastError() + ")";
+    return false;
+}
+
+bool NtfsImage::OpenHive(std::u16string_view name, RegfHive& hive, bool replayLogs) {
+    ScopedSpan span(TelemetrySpan::HiveOpen);
+    const std::u16string path = std::u16string(CONFIG_DIR).append(name);
+    uint64_t record = 0;
+    NtfsStream stream;
+    if (!volume.FindFile(path, record) || !volume.ReadFile(record, stream)) {
+        lastError = volume.LastError();
+        Telemetry::Add(TelemetryCounter::HiveOpenErrors);
+        return false;
+    }
+    span.SetItems(stream.size);
+    const bool attached = stream.buffer.empty() ? hive.Attach(stream.data, static_cast<size_t>(stream.size))
+                                                : hive.Adopt(std::move(stream.buffer));
+    if (!attached) {
+        lastError = hive.LastError();
+        Telemetry::Add(TelemetryCounter::HiveOpenErrors);
+        return false;
+    }
+    if (!replayLogs || !hive.IsDirty()) return true;
+
+    // Journaux absents ou illisibles : la ruche reste utilisable, comme RegfHive::Open
+    NtfsStream logs[2];
+    std::vector<RegfLogView> views;
+    const char16_t* suffixes[] = { u".LOG1", u".LOG2" };
+    for (int i = 0; i < 2; i++) {
+        if (volume.FindFile(path + suffixes[i], record) && volume.ReadFile(record, logs[i])) {
+            views.push_back({ logs[i].data, static_cast<size_t>(logs[i].size) });
+        }
+    }
+    if (!views.empty()) hive.ReplayLogs(views);
+    return true;
+}
+
+bool NtfsImage::LooksLikeImage(const fs::path& path) {
+    // Jusqu'à l'en-tête GPT des disques 4Kn (LBA 1 = 4096)
+    uint8_t head[4096 + 8] = {};
+    std::ifstream in(path, std::ios::binary);
+    in.read(reinterpret_cast<char*>(head), sizeof(head));
+    const size_t size = static_cast<size_t>(in.gcount());
+    if (size < 512 || std::memcmp(head, "regf", 4) == 0) return false;
+    // Volume NTFS seul, MBR (GPT compris, MBR protecteur) ou en-tête GPT sans MBR valide
+    if (IsNtfsBoot(head, size, 0) || (head[510] == 0x55 && head[511] == 0xAA)) return true;
+    return std::memcmp(head + 512, "EFI PART", 8) == 0 ||
+           (size >= 4096 + 8 && std::memcmp(head + 4096, "EFI PART", 8) == 0);
+}
@@ -0,0 +1,122 @@
+/*
+ * NtfsImage - Lecture NTFS en lecture seule dans une image disque brute (dd, raw, img)
+ *
+ * Évite d'extraire Windows\System32\config\SYSTEM (et ses journaux) sur disque avant le parsing :
+ *
+ * - Image projetée en mémoire (MappedFile) : seules les pages réellement lues sont chargées,
+ *   une image de 500 Go se trie en lisant quelques Mo
+ * - Volumes NTFS détectés à l'offset 0 (image de volume), dans la table MBR ou GPT (secteurs de 512
+ *   ou 4096 octets) ; le premier volume qui contient Windows\System32\config\SYSTEM est retenu
+ * - Chemin résolu par l'index $I30 des répertoires (descente de l'arbre B, $INDEX_ROOT puis blocs
+ *   INDX de $INDEX_ALLOCATION) à partir de l'enregistrement racine 5, noms comparés sans casse
+ * - Enregistrements FILE et blocs INDX corrigés (tableau de mise à jour) dans une copie locale ;
+ *   $ATTRIBUTE_LIST suivi pour les fichiers et la MFT fragmentés
+ * - Flux $DATA : un seul extent = pointeur direct dans l'image (aucune copie) ; sinon les extents
+ *   sont rassemblés dans un buffer, extents creux et fin non initialisée à zéro.
+ *   Flux compressés ou chiffrés refusés.
+ *
+ * Toutes les lectures sont bornées par la taille de l'image : une image tronquée ou corrompue
+ * produit une erreur, jamais une lecture hors du mapping.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "MappedFile.h"
+#include "RegfHive.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint64_t NTFS_ROOT_RECORD = 5;
+
+// Contenu d'un flux $DATA : data pointe dans l'image (extent unique) ou dans buffer
+struct NtfsStream {
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+    std::vector<uint8_t> buffer;  // Vide si data pointe dans l'image
+};
+
+// Un volume NTFS dans une image projetée (non possédée)
+class NtfsVolume {
+public:
+    // Offsets (octets) des volumes NTFS de l'image : 0, partitions MBR primaires, entrées GPT
+    static std::vector<uint64_t> FindVolumes(const uint8_t* image, size_t size);
+
+    bool Open(const uint8_t* image, size_t size, uint64_t offset);
+
+    // Chemin relatif à la racine, séparé par '\\' (ex. u"Windows\\System32\\config\\SYSTEM")
+    bool FindFile(std::u16string_view path, uint64_t& record);
+    // Flux $DATA sans nom du fichier
+    bool ReadFile(uint64_t record, NtfsStream& out);
+
+    uint64_t Offset() const { return volumeOffset; }
+    uint32_t ClusterSize() const { return clusterSize; }
+    // Octets de l'image lus depuis Open (enregistrements, index, données copiées ou référencées)
+    uint64_t BytesRead() const { return bytesRead; }
+    const std::string& LastError() const { return lastError; }
+
+private:
+    struct Extent {
+        uint64_t vcn;
+        uint64_t lcn;     // NTFS_SPARSE : extent creux
+        uint64_t length;  // Clusters
+    };
+
+    // Attribut non résident reconstitué (tous ses extents, éventuellement sur plusieurs enregistrements)
+    struct NonResident {
+        std::vector<Extent> extents;
+        uint64_t realSize = 0;
+        uint64_t initializedSize = 0;
+    };
+
+    const uint8_t* Bytes(uint64_t volumePosition, uint64_t size);
+    bool ReadRecord(uint64_t record, std::vector<uint8_t>& out);
+    bool ApplyFixup(uint8_t* block, size_t size, const char* signature);
+    // Valeur résidente ou extents de l'attribut (type, nom) d'un enregistrement de base
+    bool FindAttribute(uint64_t record, uint32_t type, std::u16string_view name, std::vector<uint8_t>& resident,
+                       NonResident& nonResident, bool& isResident);
+    bool ReadNonResident(const NonResident& attribute, uint64_t position, uint64_t size, uint8_t* out);
+    bool FindInDirectory(uint64_t directory, std::u16string_view name, uint64_t& record);
+
+    const uint8_t* image = nullptr;
+    size_t imageSize = 0;
+    uint64_t volumeOffset = 0;
+    uint64_t volumeSize = 0;
+    uint32_t sectorSize = 512;
+    uint32_t clusterSize = 0;
+    uint32_t recordSize = 0;
+    uint32_t indexBlockSize = 0;
+    NonResident mft;
+    uint64_t bytesRead = 0;
+    std::string lastError;
+};
+
+// Image disque projetée + volume Windows retenu
+class NtfsImage {
+public:
+    bool Open(const std::filesystem::path& path);
+
+    // Ouvre Windows\System32\config\<name> ; si la ruche n'est pas consolidée, rejoue
+    // <name>.LOG1 / <name>.LOG2 lus dans l'image. La ruche ne doit pas survivre à l'image.
+    bool OpenHive(std::u16string_view name, RegfHive& hive, bool replayLogs = true);
+
+    // Boot sector NTFS, signature MBR (55 AA) ou en-tête GPT ("EFI PART") : image disque ; tout autre fichier,
+    // "regf" ou non, est traité comme une ruche (une ruche tronquée ou corrompue échoue comme ruche)
+    static bool LooksLikeImage(const std::filesystem::path& path);
+
+    const NtfsVolume& Volume() const { return volume; }
+    uint64_t ImageSize() const { return file.size(); }
+    const std::string& LastError() const { return lastError; }
+
+private:
+    MappedFile file;
+    NtfsVolume volume;
+    std::string lastError;
+};
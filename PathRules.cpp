@@ -0,0 +1,452 @@
+/*
+ * PathRules - Implémentation de l'automate Aho-Corasick et du chargement des règles
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "PathRules.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+constexpr size_t UTF16_UNITS = 65536;
+constexpr size_t REGEX_GATE_MIN = 3;
+constexpr uint32_t TRANSITION_OUTPUT = 0x80000000;  // Bit de transition : l'état cible a des sorties
+
+bool ParseKind(std::string_view name, RuleKind& kind) {
+    if (name == "contains") kind = RuleKind::Contains;
+    else if (name == "prefix") kind = RuleKind::Prefix;
+    else if (name == "suffix") kind = RuleKind::Suffix;
+    else if (name == "name") kind = RuleKind::Name;
+    else if (name == "regex") kind = RuleKind::Regex;
+    else return false;
+    return true;
+}
+
+bool IsRegexMeta(char16_t c) {
+    return c == u'.' || c == u'^' || c == u'$' || c == u'*' || c == u'+' || c == u'?' || c == u'(' ||
+           c == u')' || c == u'[' || c == u']' || c == u'{' || c == u'}' || c == u'|' || c == u'\\';
+}
+
+int HexDigit(char16_t c) {
+    if (c >= u'0' && c <= u'9') return c - u'0';
+    if (c >= u'a' && c <= u'f') return c - u'a' + 10;
+    if (c >= u'A' && c <= u'F') return c - u'A' + 10;
+    return -1;
+}
+
+// Plus long littéral présent dans toute correspondance de la regex ; vide si aucun n'est sûr
+// (alternative au premier niveau). Groupes et classes interrompent le littéral sans y entrer.
+std::u16string RequiredLiteral(std::u16string_view pattern) {
+    int depth = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] == u'\\') { i++; continue; }
+        if (pattern[i] == u'(') depth++;
+        else if (pattern[i] == u')') depth--;
+        else if (pattern[i] == u'|' && depth == 0) return {};
+    }
+
+    std::u16string best;
+    std::u16string run;
+    auto endRun = [&]() {
+        if (run.size() > best.size()) best = run;
+        run.clear();
+    };
+
+    for (size_t i = 0; i < pattern.size();) {
+        char16_t c = pattern[i];
+        char16_t literal = 0;
+        size_t next = i + 1;
+
+        if (c == u'\\' && i + 1 < pattern.size()) {
+            char16_t escaped = pattern[i + 1];
+            next = i + 2;
+            bool alnum = (escaped >= u'0' && escaped <= u'9') || (escaped >= u'a' && escaped <= u'z') ||
+                         (escaped >= u'A' && escaped <= u'Z');
+            if (escaped == u'x' || escaped == u'u') {
+                // \xHH, \uHHHH : caractère littéral décodé, chiffres compris
+                const size_t digits = escaped == u'x' ? 2 : 4;
+                uint32_t value = 0;
+                size_t read = 0;
+                for (; read < digits && next + read < pattern.size(); read++) {
+                    const int digit = HexDigit(pattern[next + read]);
+                    if (digit < 0) break;
+                    value = value * 16 + static_cast<uint32_t>(digit);
+                }
+                if (read == digits) {
+                    run.push_back(static_cast<char16_t>(value));
+                    i = next + digits;
+                    continue;
+                }
+                alnum = true;  // Échappement incomplet : littéral incertain
+            }
+            if (alnum) {  // \d, \w, \b, \cX, \0, \1... : classe, assertion, contrôle ou référence arrière
+                endRun();
+                if (escaped == u'c' && next < pattern.size()) next++;
+                while (escaped >= u'0' && escaped <= u'9' && next < pattern.size() && pattern[next] >= u'0' &&
+                       pattern[next] <= u'9') {
+                    next++;
+                }
+                i = next;
+                continue;
+            }
+            literal = escaped;
+        } else if (c == u'[') {
+            endRun();
+            while (next < pattern.size() && pattern[next] != u']') {
+                if (pattern[next] == u'\\') next++;
+                next++;
+            }
+            i = next + 1;
+            continue;
+        } else if (c == u'(') {
+            endRun();
+            int level = 1;
+            while (next < pattern.size() && level > 0) {
+                if (pattern[next] == u'\\') next++;
+                else if (pattern[next] == u'(') level++;
+                else if (pattern[next] == u')') level--;
+                next++;
+            }
+            i = next;
+            continue;
+        } else if (IsRegexMeta(c)) {
+            // Quantificateur rendant le caractère précédent optionnel : on le retire du littéral
+            if ((c == u'*' || c == u'?' || c == u'{') && !run.empty()) run.pop_back();
+            endRun();
+            if (c == u'{') {
+                while (next < pattern.size() && pattern[next - 1] != u'}') next++;
+            }
+            i = next;
+            continue;
+        } else {
+            literal = c;
+        }
+
+        run.push_back(literal);
+        i = next;
+    }
+    endRun();
+    return best;
+}
+
+void AppendLabel(std::u16string& note, std::u16string_view label) {
+    // Libellés distincts seulement (plusieurs règles partagent souvent le même)
+    size_t pos = 0;
+    while (pos < note.size()) {
+        size_t end = note.find(u"; ", pos);
+        if (end == std::u16string::npos) end = note.size();
+        if (std::u16string_view(note).substr(pos, end - pos) == label) return;
+        pos = end + 2;
+    }
+    if (!note.empty()) note += u"; ";
+    note.append(label);
+}
+
+}  // namespace
+
+char16_t FoldCase(char16_t c) {
+    if (c < 0x80) return (c >= u'A' && c <= u'Z') ? static_cast<char16_t>(c + 32) : c;
+    if (c >= 0xC0 && c <= 0xDE && c != 0xD7) return static_cast<char16_t>(c + 32);
+    if (c >= 0x100 && c <= 0x17F) {
+        // Latin étendu A : paires majuscule/minuscule, parité inversée entre 0x139 et 0x148
+        const bool oddUpper = (c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E);
+        if (c == 0x130 || c == 0x131 || c == 0x138 || c == 0x149 || c == 0x17F) return c;
+        if (oddUpper) return (c & 1) ? static_cast<char16_t>(c + 1) : c;
+        return (c & 1) ? c : static_cast<char16_t>(c + 1);
+    }
+    if (c >= 0x391 && c <= 0x3A9 && c != 0x3A2) return static_cast<char16_t>(c + 32);
+    if (c >= 0x410 && c <= 0x42F) return static_cast<char16_t>(c + 32);
+    if (c >= 0x400 && c <= 0x40F) return static_cast<char16_t>(c + 80);
+    return c;
+}
+
+PathClassifier::PathClassifier() = default;
+PathClassifier::~PathClassifier() = default;
+PathClassifier::PathClassifier(PathClassifier&&) noexcept = default;
+PathClassifier& PathClassifier::operator=(PathClassifier&&) noexcept = default;
+
+const PathClassifier& PathClassifier::Default() {
+    static const PathClassifier classifier = [] {
+        PathClassifier rules;
+        rules.AddDefaultRules();
+        rules.Compile();
+        return rules;
+    }();
+    return classifier;
+}
+
+void PathClassifier::AddDefaultRules() {
+    AddRule(RuleKind::Contains, "temp", u"\\Temp\\", u"Emplacement suspect");
+    AddRule(RuleKind::Contains, "downloads", u"\\Downloads\\", u"Emplacement suspect");
+}
+
+bool PathClassifier::AddRule(RuleKind kind, std::string_view id, std::u16string_view pattern,
+                             std::u16string_view label) {
+    if (pattern.empty()) {
+        lastError = "Motif vide : " + std::string(id);
+        return false;
+    }
+
+    PathRule rule;
+    rule.kind = kind;
+    rule.id = std::string(id);
+    rule.pattern = std::u16string(pattern);
+    rule.label = label.empty() ? Utf8ToU16(id) : std::u16string(label);
+
+    if (kind == RuleKind::Regex) {
+        try {
+            std::wstring wide = ToWide(pattern);
+            regexes.push_back(Regex{ static_cast<uint32_t>(rules.size()), false,
+                                     std::wregex(wide, std::regex::ECMAScript | std::regex::icase |
+                                                       std::regex::optimize) });
+        } catch (const std::regex_error& error) {
+            lastError = "Regex invalide (" + rule.id + ") : " + error.what();
+            return false;
+        }
+    }
+
+    rules.push_back(std::move(rule));
+    compiled = false;
+    return true;
+}
+
+bool PathClassifier::LoadText(std::string_view text) {
+    size_t lineNumber = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+        lineNumber++;
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (lineNumber == 1 && line.size() >= 3 && line.substr(0, 3) == "\xEF\xBB\xBF") line.remove_prefix(3);
+        if (line.empty() || line[0] == '#') continue;
+
+        std::string_view fields[4];
+        size_t count = 0;
+        while (count < 4) {
+            size_t tab = count < 3 ? line.find('\t') : std::string_view::npos;
+            fields[count++] = line.substr(0, tab);
+            if (tab == std::string_view::npos) break;
+            line.remove_prefix(tab + 1);
+        }
+
+        RuleKind kind;
+        if (count < 3 || !ParseKind(fields[0], kind)) {
+            lastError = "Ligne " + std::to_string(lineNumber) + " : attendu type<TAB>id<TAB>motif[<TAB>libellé]";
+            return false;
+        }
+        if (!AddRule(kind, fields[1], Utf8ToU16(fields[2]), count > 3 ? Utf8ToU16(fields[3]) : std::u16string())) {
+            lastError = "Ligne " + std::to_string(lineNumber) + " : " + lastError;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PathClassifier::LoadFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        lastError = "Fichier de règles illisible : " + path.u8string();
+        return false;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return LoadText(text.str());
+}
+
+bool PathClassifier::Compile() {
+    literals.clear();
+    gateOf.assign(rules.size(), UINT32_MAX);
+    std::vector<std::u16string> folded;
+
+    for (size_t r = 0; r < rules.size(); r++) {
+        const PathRule& rule = rules[r];
+        std::u16string text;
+        if (rule.kind == RuleKind::Regex) {
+            auto regex = std::find_if(regexes.begin(), regexes.end(), [&](const Regex& x) { return x.rule == r; });
+            text = RequiredLiteral(rule.pattern);
+            regex->gated = text.size() >= REGEX_GATE_MIN;
+            if (!regex->gated) continue;
+            gateOf[r] = static_cast<uint32_t>(regex - regexes.begin());
+        } else {
+            text = rule.pattern;
+        }
+        for (auto& c : text) c = FoldCase(c);
+        literals.push_back(Literal{ static_cast<uint32_t>(r), static_cast<uint32_t>(text.size()), rule.kind });
+        folded.push_back(std::move(text));
+    }
+
+    // Alphabet compact : une classe par caractère (replié) présent dans les motifs, 0 pour le reste
+    std::vector<uint16_t> foldedClass(UTF16_UNITS, 0);
+    classCount = 1;
+    for (const auto& text : folded) {
+        for (char16_t c : text) {
+            if (foldedClass[c] == 0) {
+                if (classCount == UINT16_MAX) {
+                    lastError = "Trop de caractères distincts dans les motifs";
+                    return false;
+                }
+                foldedClass[c] = static_cast<uint16_t>(classCount++);
+            }
+        }
+    }
+    classOf.reset(new uint16_t[UTF16_UNITS]);
+    for (size_t c = 0; c < UTF16_UNITS; c++) {
+        classOf[c] = foldedClass[FoldCase(static_cast<char16_t>(c))];
+    }
+
+    // Trie (0 = pas d'arête, la racine n'étant la cible d'aucune arête)
+    transitions.assign(classCount, 0);
+    stateCount = 1;
+    std::vector<std::vector<uint32_t>> stateOutputs(1);
+    for (size_t l = 0; l < folded.size(); l++) {
+        uint32_t state = 0;
+        for (char16_t c : folded[l]) {
+            uint32_t& edge = transitions[state * classCount + foldedClass[c]];
+            if (edge == 0) {
+                edge = static_cast<uint32_t>(stateCount++);
+                transitions.resize(stateCount * classCount, 0);
+                stateOutputs.emplace_back();
+            }
+            state = transitions[state * classCount + foldedClass[c]];
+        }
+        stateOutputs[state].push_back(static_cast<uint32_t>(l));
+    }
+
+    // Liens d'échec en largeur, transitions manquantes complétées : automate déterministe
+    std::vector<uint32_t> fail(stateCount, 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(stateCount);
+    queue.push_back(0);
+    for (size_t head = 0; head < queue.size(); head++) {
+        const uint32_t state = queue[head];
+        for (uint32_t c = 1; c < classCount; c++) {
+            uint32_t& edge = transitions[state * classCount + c];
+            const uint32_t fallback = state == 0 ? 0 : transitions[fail[state] * classCount + c];
+            if (edge != 0) {
+                fail[edge] = fallback;
+                const auto& inherited = stateOutputs[fallback];
+                stateOutputs[edge].insert(stateOutputs[edge].end(), inherited.begin(), inherited.end());
+                queue.push_back(edge);
+            } else {
+                edge = fallback;
+            }
+        }
+    }
+
+    outputStart.assign(stateCount + 1, 0);
+    outputs.clear();
+    for (size_t s = 0; s < stateCount; s++) {
+        outputStart[s] = static_cast<uint32_t>(outputs.size());
+        outputs.insert(outputs.end(), stateOutputs[s].begin(), stateOutputs[s].end());
+    }
+    outputStart[stateCount] = static_cast<uint32_t>(outputs.size());
+
+    // Cibles pré-multipliées (début de ligne) et marquées si l'état a des sorties :
+    // la boucle de Match ne fait qu'une lecture de table par caractère
+    if (stateCount * classCount >= TRANSITION_OUTPUT) {
+        lastError = "Automate trop grand";
+        return false;
+    }
+    for (auto& target : transitions) {
+        const uint32_t state = target;
+        target = state * classCount | (stateOutputs[state].empty() ? 0 : TRANSITION_OUTPUT);
+    }
+
+    compiled = true;
+    return true;
+}
+
+bool PathClassifier::Accepts(const Literal& literal, size_t end, size_t pathLength, std::u16string_view path) const {
+    const size_t start = end + 1 - literal.length;
+    switch (literal.kind) {
+        case RuleKind::Prefix: return start == 0;
+        case RuleKind::Suffix: return end + 1 == pathLength;
+        case RuleKind::Name:
+            return end + 1 == pathLength && (start == 0 || path[start - 1] == u'\\' || path[start - 1] == u'/');
+        default: return true;
+    }
+}
+
+bool PathClassifier::Match(std::u16string_view path, uint64_t* words) const {
+    const size_t wordCount = WordCount();
+    std::fill(words, words + wordCount, 0);
+    if (!compiled) return false;
+
+    std::wstring wide;  // Converti seulement si une regex doit tourner
+    auto runRegex = [&](const Regex& regex) {
+        if (words[regex.rule / 64] >> (regex.rule % 64) & 1) return;
+        if (wide.empty()) wide = ToWide(path);
+        if (std::regex_search(wide, regex.compiled)) {
+            words[regex.rule / 64] |= 1ULL << (regex.rule % 64);
+        }
+    };
+
+    const uint16_t* classes = classOf.get();
+    const uint32_t* next = transitions.data();
+    uint32_t row = 0;
+    bool any = false;
+
+    for (size_t i = 0; i < path.size(); i++) {
+        row = next[(row & ~TRANSITION_OUTPUT) + classes[path[i]]];
+        if (!(row & TRANSITION_OUTPUT)) continue;
+
+        const uint32_t state = (row & ~TRANSITION_OUTPUT) / classCount;
+        const uint32_t first = outputStart[state];
+        const uint32_t last = outputStart[state + 1];
+        for (uint32_t o = first; o < last; o++) {
+            const Literal& literal = literals[outputs[o]];
+            if (literal.kind == RuleKind::Regex) {
+                runRegex(regexes[gateOf[literal.rule]]);
+            } else if (Accepts(literal, i, path.size(), path)) {
+                words[literal.rule / 64] |= 1ULL << (literal.rule % 64);
+                any = true;
+            }
+        }
+    }
+
+    for (const Regex& regex : regexes) {
+        if (!regex.gated) runRegex(regex);
+    }
+    if (!regexes.empty()) {
+        for (size_t w = 0; w < wordCount && !any; w++) any = words[w] != 0;
+    }
+    return any;
+}
+
+uint32_t PathClassifier::Classify(std::u16string_view path, MatchTable& matches) const {
+    return Classify(path, std::u16string_view(), matches);
+}
+
+uint32_t PathClassifier::Classify(std::u16string_view path, std::u16string_view alternate,
+                                  MatchTable& matches) const {
+    uint64_t local[16];
+    std::vector<uint64_t> heap;
+    uint64_t* words = local;
+    uint64_t* other = local + 8;
+    if (WordCount() > 8) {
+        heap.resize(WordCount() * 2);
+        words = heap.data();
+        other = words + WordCount();
+    }
+    bool matched = Match(path, words);
+    if (!alternate.empty() && alternate != path && Match(alternate, other)) {
+        for (size_t w = 0; w < WordCount(); w++) words[w] |= other[w];
+        matched = true;
+    }
+    if (!matched) return ENTRY_NO_MATCH;
+
+    std::u16string note;
+    for (size_t r = 0; r < rules.size(); r++) {
+        if (words[r / 64] >> (r % 64) & 1) AppendLabel(note, rules[r].label);
+    }
+    return matches.Intern(words, WordCount(), note);
+}
@@ -0,0 +1,110 @@
+/*
+ * PathRules - Classification des chemins par règles compilées (Aho-Corasick, UTF-16, insensible à la casse)
+ *
+ * - Toutes les règles littérales d'un jeu sont compilées en un seul automate déterministe :
+ *   un passage par chemin, une lecture de table par caractère, quel que soit le nombre de règles
+ * - Casse repliée à la compilation (ASCII, Latin-1, grec, cyrillique) : table caractère → classe
+ * - Types : contains (n'importe où), prefix, suffix, name (dernier composant exact), regex
+ * - Les regex sont filtrées par leur plus long littéral obligatoire, cherché par le même automate :
+ *   std::wregex ne tourne que sur les chemins qui contiennent ce littéral
+ * - Résultat : bitset des règles déclenchées (bit i = i-ème règle du fichier)
+ *
+ * Fichier de règles (UTF-8, une règle par ligne, # = commentaire, champs séparés par des tabulations) :
+ *   type<TAB>id<TAB>motif[<TAB>libellé]
+ *   contains	user-temp	\AppData\Local\Temp\	Emplacement suspect
+ *   name	lolbin-certutil	certutil.exe	LOLBin
+ *   regex	random-exe	\\[a-f0-9]{16,}\.exe$	Nom aléatoire
+ * Le libellé (l'id par défaut) alimente la colonne Notes ; libellés distincts joints par "; ".
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class RuleKind : uint8_t { Contains, Prefix, Suffix, Name, Regex };
+
+struct PathRule {
+    RuleKind kind = RuleKind::Contains;
+    std::string id;        // UTF-8
+    std::u16string pattern;
+    std::u16string label;  // Texte Notes
+};
+
+// Repli de casse d'un caractère UTF-16 (minuscule simple)
+char16_t FoldCase(char16_t c);
+
+class PathClassifier {
+public:
+    PathClassifier();
+    ~PathClassifier();
+    PathClassifier(PathClassifier&&) noexcept;
+    PathClassifier& operator=(PathClassifier&&) noexcept;
+
+    // Jeu historique : \Temp\ et \Downloads\ → "Emplacement suspect" (compilé)
+    static const PathClassifier& Default();
+    void AddDefaultRules();
+
+    bool AddRule(RuleKind kind, std::string_view id, std::u16string_view pattern, std::u16string_view label);
+    // Ajoute les règles d'un texte / fichier ; erreur avec numéro de ligne dans LastError()
+    bool LoadText(std::string_view text);
+    bool LoadFile(const std::filesystem::path& path);
+    // Construit l'automate ; obligatoire après ajout de règles, avant Match/Classify
+    bool Compile();
+    const std::string& LastError() const { return lastError; }
+
+    size_t RuleCount() const { return rules.size(); }
+    const PathRule& Rule(size_t index) const { return rules[index]; }
+    size_t WordCount() const { return (rules.size() + 63) / 64; }
+    size_t StateCount() const { return stateCount; }
+
+    // Écrit WordCount() mots dans words ; true si au moins une règle est déclenchée. Thread-safe.
+    bool Match(std::u16string_view path, uint64_t* words) const;
+    // Match puis interne la combinaison (et son texte Notes) dans matches
+    uint32_t Classify(std::u16string_view path, MatchTable& matches) const;
+    // Idem sur deux formes du même chemin (brut et avec lettre de lecteur) : union des règles
+    uint32_t Classify(std::u16string_view path, std::u16string_view alternate, MatchTable& matches) const;
+
+private:
+    // Motif littéral de l'automate : règle littérale, ou filtre d'une regex
+    struct Literal {
+        uint32_t rule;
+        uint32_t length;
+        RuleKind kind;
+    };
+
+    struct Regex {
+        uint32_t rule;
+        bool gated;  // Exécutée seulement si son littéral a été vu
+        std::wregex compiled;
+    };
+
+    bool Accepts(const Literal& literal, size_t end, size_t pathLength, std::u16string_view path) const;
+
+    std::vector<PathRule> rules;
+    std::vector<Literal> literals;
+    std::vector<Regex> regexes;
+    std::vector<uint32_t> gateOf;  // Règle → index dans regexes (filtres)
+
+    // Automate : transitions denses états x classes (cible = début de ligne, bit 31 = sorties),
+    // sorties aplaties
+    std::unique_ptr<uint16_t[]> classOf;  // 65536 entrées, casse repliée
+    uint32_t classCount = 1;
+    size_t stateCount = 0;
+    std::vector<uint32_t> transitions;
+    std::vector<uint32_t> outputStart;  // stateCount + 1 entrées
+    std::vector<uint32_t> outputs;      // Index dans literals
+    bool compiled = false;
+    std::string lastError;
+};
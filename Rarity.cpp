@@ -0,0 +1,458 @@
+/*
+ * Rarity - Implémentation des HyperLogLog, des count-min, des candidats et du rapport
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "Rarity.h"
+
+#include "PathRules.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Finaliseur splitmix64 : FNV-1a seul répartit mal ses bits de poids fort (index des registres)
+uint64_t Mix(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+uint64_t HashFolded(std::u16string_view text) {
+    uint64_t hash = FNV_OFFSET;
+    for (char16_t c : text) hash = (hash ^ FoldCase(c)) * FNV_PRIME;
+    return Mix(hash);
+}
+
+unsigned CountLeadingZeros(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    return _BitScanReverse64(&index, bits) ? 63 - index : 64;
+#else
+    return bits ? static_cast<unsigned>(__builtin_clzll(bits)) : 64;
+#endif
+}
+
+uint32_t SaturatingAdd(uint32_t counter, uint64_t count) {
+    return static_cast<uint32_t>(std::min<uint64_t>(uint64_t{ counter } + count, UINT32_MAX));
+}
+
+void AppendField(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += "\",";
+}
+
+void AppendField(std::string& out, std::u16string_view text) {
+    std::string utf8;
+    AppendUtf8(utf8, text);
+    AppendField(out, std::string_view(utf8));
+}
+
+void AppendTime(std::string& out, uint64_t fileTime, const TimeFormat& format) {
+    char text[FILETIME_TEXT_MAX];
+    FormatFileTime(fileTime, format, text);
+    AppendField(out, std::string_view(text));
+}
+
+const char* CountKindName(RarityCount kind) {
+    switch (kind) {
+        case RarityCount::Exact: return "exact";
+        case RarityCount::Estimated: return "estimé";
+        case RarityCount::UpperBound: return "majorant";
+    }
+    return "";
+}
+
+}  // namespace
+
+HyperLogLog::HyperLogLog(unsigned precision) : precision(std::clamp(precision, 4u, 18u)) {}
+
+void HyperLogLog::Add(uint64_t hash) {
+    if (!registers.empty()) {
+        AddDense(hash);
+        return;
+    }
+    const auto at = std::lower_bound(sparse.begin(), sparse.end(), hash);
+    if (at != sparse.end() && *at == hash) return;
+    sparse.insert(at, hash);
+    // Plus d'octets en empreintes qu'en registres : bascule
+    if (sparse.size() * sizeof(uint64_t) > (size_t{ 1 } << precision)) Densify();
+}
+
+void HyperLogLog::AddDense(uint64_t hash) {
+    const size_t index = static_cast<size_t>(hash >> (64 - precision));
+    // Bit sentinelle : rang au plus 65 - precision
+    const uint64_t rest = hash << precision | uint64_t{ 1 } << (precision - 1);
+    const uint8_t rank = static_cast<uint8_t>(CountLeadingZeros(rest) + 1);
+    if (registers[index] < rank) registers[index] = rank;
+}
+
+void HyperLogLog::Densify() {
+    registers.assign(size_t{ 1 } << precision, 0);
+    for (uint64_t hash : sparse) AddDense(hash);
+    sparse.clear();
+    sparse.shrink_to_fit();
+}
+
+bool HyperLogLog::Merge(const HyperLogLog& other) {
+    if (other.precision != precision) return false;
+    if (other.registers.empty()) {
+        for (uint64_t hash : other.sparse) Add(hash);
+        return true;
+    }
+    if (registers.empty()) Densify();
+    for (size_t i = 0; i < registers.size(); i++) registers[i] = std::max(registers[i], other.registers[i]);
+    return true;
+}
+
+double HyperLogLog::Estimate() const {
+    if (registers.empty()) return static_cast<double>(sparse.size());
+    const double m = static_cast<double>(registers.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+        sum += std::ldexp(1.0, -static_cast<int>(r));
+        if (r == 0) zeros++;
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double estimate = alpha * m * m / sum;
+    // Petites cardinalités : comptage linéaire des registres vides
+    if (estimate <= 2.5 * m && zeros > 0) return m * std::log(m / static_cast<double>(zeros));
+    return estimate;
+}
+
+CountMinSketch::CountMinSketch(size_t width, unsigned depth) : width(1), depth(std::clamp(depth, 1u, 16u)) {
+    while (this->width < width) this->width <<= 1;
+    counters.assign(this->width * this->depth, 0);
+}
+
+uint64_t CountMinSketch::Add(uint64_t hash, uint64_t count) {
+    // Colonnes par double hachage (Kirsch-Mitzenmacher) : une seule empreinte pour toutes les lignes
+    const uint64_t h1 = hash;
+    const uint64_t h2 = (hash >> 32 | hash << 32) | 1;
+    const uint64_t estimate = Estimate(hash);
+    const uint64_t target = std::min<uint64_t>(estimate + count, UINT32_MAX);
+    for (unsigned d = 0; d < depth; d++) {
+        uint32_t& counter = counters[d * width + ((h1 + d * h2) & (width - 1))];
+        if (counter < target) counter = static_cast<uint32_t>(target);
+    }
+    total += count;
+    return target;
+}
+
+uint64_t CountMinSketch::Estimate(uint64_t hash) const {
+    const uint64_t h1 = hash;
+    const uint64_t h2 = (hash >> 32 | hash << 32) | 1;
+    uint32_t estimate = UINT32_MAX;
+    for (unsigned d = 0; d < depth; d++) {
+        estimate = std::min(estimate, counters[d * width + ((h1 + d * h2) & (width - 1))]);
+    }
+    return estimate;
+}
+
+bool CountMinSketch::Merge(const CountMinSketch& other) {
+    if (other.width != width || other.depth != depth) return false;
+    for (size_t i = 0; i < counters.size(); i++) counters[i] = SaturatingAdd(counters[i], other.counters[i]);
+    total += other.total;
+    return true;
+}
+
+uint64_t CountMinSketch::ErrorBound() const {
+    return static_cast<uint64_t>(std::ceil(std::exp(1.0) / static_cast<double>(width) * static_cast<double>(total)));
+}
+
+BloomFilter::BloomFilter(size_t bits, unsigned hashes) : bits(1), hashes(std::clamp(hashes, 1u, 16u)) {
+    while (this->bits < std::max<size_t>(bits, 64)) this->bits <<= 1;
+    words.assign(this->bits / 64, 0);
+}
+
+bool BloomFilter::Insert(uint64_t hash) {
+    const uint64_t h2 = (hash >> 32 | hash << 32) | 1;
+    bool present = true;
+    for (unsigned i = 0; i < hashes; i++) {
+        const uint64_t bit = (hash + i * h2) & (bits - 1);
+        uint64_t& word = words[bit >> 6];
+        const uint64_t mask = uint64_t{ 1 } << (bit & 63);
+        present = present && (word & mask);
+        word |= mask;
+    }
+    return present;
+}
+
+bool BloomFilter::MayContain(uint64_t hash) const {
+    const uint64_t h2 = (hash >> 32 | hash << 32) | 1;
+    for (unsigned i = 0; i < hashes; i++) {
+        const uint64_t bit = (hash + i * h2) & (bits - 1);
+        if (!(words[bit >> 6] >> (bit & 63) & 1)) return false;
+    }
+    return true;
+}
+
+bool BloomFilter::Merge(const BloomFilter& other) {
+    if (other.bits != bits || other.hashes != hashes) return false;
+    for (size_t i = 0; i < words.size(); i++) words[i] |= other.words[i];
+    return true;
+}
+
+void RaritySketch::Candidate::Merge(const Candidate& other) {
+    hosts.Merge(other.hosts);
+    firstTime = std::min(firstTime, other.firstTime);
+    lastTime = std::max(lastTime, other.lastTime);
+    complete = complete && other.complete;
+}
+
+RaritySketch::RaritySketch(const RarityOptions& options)
+    : options(options),
+      fleetHosts(options.fleetPrecision),
+      fleetPaths(options.fleetPrecision),
+      sightings(options.width, options.depth),
+      runs(options.width, options.depth),
+      seen(options.seenBits) {}
+
+void RaritySketch::Add(const EntryStore& store) {
+    if (store.empty()) return;
+
+    hostHashes.assign(store.hosts.Count(), 0);
+    for (uint32_t id = 0; id < hostHashes.size(); id++) hostHashes[id] = HashFolded(store.hosts.View(id));
+    pathHashes.assign(store.paths.Count(), 0);
+
+    // Lignes groupées par (chemin, hôte) repliés : une apparition par groupe, ses lignes comptées d'un coup.
+    // Valeurs sans FILETIME (SequenceNumber, données invalides) écartées : ce ne sont pas des exécutions
+    groups.clear();
+    groups.reserve(store.size());
+    for (uint32_t row = 0; row < store.size(); row++) {
+        if (store.Flags(row) & ENTRY_FLAG_INVALID_DATA) continue;
+        const uint32_t pathId = store.NormalizedPathId(row);
+        if (!pathHashes[pathId]) pathHashes[pathId] = HashFolded(store.paths.View(pathId)) | 1;
+        groups.push_back(Sighting{ pathHashes[pathId], hostHashes[store.HostId(row)], row });
+    }
+    std::sort(groups.begin(), groups.end(), [](const Sighting& a, const Sighting& b) {
+        return a.path != b.path ? a.path < b.path : a.host != b.host ? a.host < b.host : a.row < b.row;
+    });
+
+    for (size_t first = 0; first < groups.size();) {
+        const uint64_t hash = groups[first].path;
+        const uint64_t host = groups[first].host;
+        uint64_t firstTime = UINT64_MAX;
+        uint64_t lastTime = 0;
+        size_t end = first;
+        for (; end < groups.size() && groups[end].path == hash && groups[end].host == host; end++) {
+            const uint64_t fileTime = store.FileTime(groups[end].row);
+            if (fileTime == 0) continue;
+            firstTime = std::min(firstTime, fileTime);
+            lastTime = std::max(lastTime, fileTime);
+        }
+
+        fleetHosts.Add(host);
+        fleetPaths.Add(hash);
+        const bool firstSighting = !seen.Insert(hash);
+        const uint64_t sighted = sightings.Add(hash);
+        const uint64_t ran = runs.Add(hash, end - first);
+        rows += end - first;
+
+        const std::u16string_view path = store.paths.View(store.NormalizedPathId(groups[first].row));
+        // Admission comparée à la frontière du dernier élagage, empreinte comprise : à égalité (des milliers de
+        // chemins sur un seul hôte), un candidat qui serait aussitôt écarté n'est pas créé
+        const std::pair<uint64_t, uint64_t> rareScore(firstSighting ? 1 : sighted, hash);
+        Track(rare, rareScore <= rareLimit, hash, path, host, firstSighting, firstTime, lastTime);
+        if (rare.size() > 4 * options.rare) PruneRare();
+        Track(common, std::make_pair(ran, hash) >= commonFloor, hash, path, host, firstSighting, firstTime, lastTime);
+        if (common.size() > 4 * options.common) PruneCommon();
+        first = end;
+    }
+}
+
+void RaritySketch::Track(Pool& pool, bool admit, uint64_t hash, std::u16string_view path, uint64_t host,
+                         bool firstSighting, uint64_t firstTime, uint64_t lastTime) {
+    auto it = pool.find(hash);
+    if (it == pool.end()) {
+        if (!admit) return;
+        it = pool.emplace(hash, Candidate(options.pathPrecision)).first;
+        it->second.path.assign(path);
+        it->second.complete = firstSighting;
+    }
+    Candidate& candidate = it->second;
+    candidate.hosts.Add(host);
+    candidate.firstTime = std::min(candidate.firstTime, firstTime);
+    candidate.lastTime = std::max(candidate.lastTime, lastTime);
+}
+
+// Hôtes du candidat s'il est complet, sinon apparitions (majorant)
+uint64_t RaritySketch::RareScore(const Candidate& candidate, uint64_t hash) const {
+    if (!candidate.complete) return sightings.Estimate(hash);
+    return std::min(static_cast<uint64_t>(std::llround(candidate.hosts.Estimate())), sightings.Estimate(hash));
+}
+
+void RaritySketch::PruneRare() {
+    // k plus petits scores (empreinte en départage : résultat indépendant de l'ordre du hachage)
+    std::vector<std::pair<uint64_t, uint64_t>> ranked;
+    ranked.reserve(rare.size());
+    for (const auto& [hash, candidate] : rare) ranked.emplace_back(RareScore(candidate, hash), hash);
+    const size_t keep = std::min(2 * options.rare, ranked.size());
+    std::nth_element(ranked.begin(), ranked.begin() + keep, ranked.end());
+    rareLimit = { 0, 0 };
+    for (size_t i = 0; i < keep; i++) rareLimit = std::max(rareLimit, ranked[i]);
+    for (size_t i = keep; i < ranked.size(); i++) rare.erase(ranked[i].second);
+}
+
+void RaritySketch::PruneCommon() {
+    std::vector<std::pair<uint64_t, uint64_t>> ranked;
+    ranked.reserve(common.size());
+    for (const auto& [hash, candidate] : common) ranked.emplace_back(runs.Estimate(hash), hash);
+    const size_t keep = std::min(2 * options.common, ranked.size());
+    std::nth_element(ranked.begin(), ranked.begin() + keep, ranked.end(), std::greater<>());
+    commonFloor = { UINT64_MAX, UINT64_MAX };
+    for (size_t i = 0; i < keep; i++) commonFloor = std::min(commonFloor, ranked[i]);
+    for (size_t i = keep; i < ranked.size(); i++) common.erase(ranked[i].second);
+}
+
+void RaritySketch::MergePool(Pool& pool, const Pool& otherPool, const RaritySketch& other) {
+    // Un chemin vu de l'autre côté sans y être suivi : ses hôtes de ce côté-là sont inconnus
+    for (auto& [hash, candidate] : pool) {
+        if (!otherPool.count(hash) && other.seen.MayContain(hash)) candidate.complete = false;
+    }
+    for (const auto& [hash, candidate] : otherPool) {
+        auto it = pool.find(hash);
+        if (it != pool.end()) {
+            it->second.Merge(candidate);
+            continue;
+        }
+        Candidate& added = pool.emplace(hash, candidate).first->second;
+        if (seen.MayContain(hash)) added.complete = false;
+    }
+}
+
+bool RaritySketch::Merge(const RaritySketch& other) {
+    if (other.options.width != options.width || other.options.depth != options.depth ||
+        other.options.seenBits != options.seenBits ||
+        other.options.fleetPrecision != options.fleetPrecision ||
+        other.options.pathPrecision != options.pathPrecision) {
+        return false;
+    }
+    // Candidats avant les compteurs : la complétude se juge sur ce que chaque côté avait vu
+    MergePool(rare, other.rare, other);
+    MergePool(common, other.common, other);
+    sightings.Merge(other.sightings);
+    runs.Merge(other.runs);
+    seen.Merge(other.seen);
+    fleetHosts.Merge(other.fleetHosts);
+    fleetPaths.Merge(other.fleetPaths);
+    rows += other.rows;
+    rareLimit = std::max(rareLimit, other.rareLimit);
+    commonFloor = std::min(commonFloor, other.commonFloor);
+    if (rare.size() > 4 * options.rare) PruneRare();
+    if (common.size() > 4 * options.common) PruneCommon();
+    return true;
+}
+
+RarityRow RaritySketch::MakeRow(const Candidate& candidate, uint64_t hash) const {
+    RarityRow row;
+    row.path = candidate.path;
+    row.sightings = sightings.Estimate(hash);
+    row.runs = runs.Estimate(hash);
+    if (candidate.firstTime != UINT64_MAX) {
+        row.firstTime = candidate.firstTime;
+        row.lastTime = candidate.lastTime;
+    }
+    if (!candidate.complete) {
+        row.hosts = row.sightings;
+        row.hostsKind = RarityCount::UpperBound;
+    } else if (candidate.hosts.Exact()) {
+        row.hosts = static_cast<uint64_t>(candidate.hosts.Estimate());
+        row.hostsKind = RarityCount::Exact;
+    } else {
+        // Une apparition par hôte au moins : les apparitions bornent aussi l'estimation
+        row.hosts = std::min(static_cast<uint64_t>(std::llround(candidate.hosts.Estimate())), row.sightings);
+        row.hostsKind = RarityCount::Estimated;
+    }
+    return row;
+}
+
+RarityReport RaritySketch::Report() const {
+    RarityReport report;
+    report.rows = rows;
+    report.hosts = fleetHosts.Estimate();
+    report.paths = fleetPaths.Estimate();
+    report.fleetError = 1.04 / std::sqrt(std::ldexp(1.0, static_cast<int>(options.fleetPrecision)));
+    report.sightingsError = sightings.ErrorBound();
+    report.runsError = runs.ErrorBound();
+
+    for (const auto& [hash, candidate] : rare) report.rare.push_back(MakeRow(candidate, hash));
+    std::sort(report.rare.begin(), report.rare.end(), [](const RarityRow& a, const RarityRow& b) {
+        if (a.hosts != b.hosts) return a.hosts < b.hosts;
+        if (a.runs != b.runs) return a.runs < b.runs;
+        return a.path < b.path;
+    });
+    if (report.rare.size() > options.rare) report.rare.resize(options.rare);
+
+    for (const auto& [hash, candidate] : common) report.common.push_back(MakeRow(candidate, hash));
+    std::sort(report.common.begin(), report.common.end(), [](const RarityRow& a, const RarityRow& b) {
+        if (a.runs != b.runs) return a.runs > b.runs;
+        return a.path < b.path;
+    });
+    if (report.common.size() > options.common) report.common.resize(options.common);
+    return report;
+}
+
+size_t RaritySketch::MemoryBytes() const {
+    size_t bytes = fleetHosts.MemoryBytes() + fleetPaths.MemoryBytes() + sightings.MemoryBytes() +
+                   runs.MemoryBytes() + seen.MemoryBytes();
+    for (const Pool* pool : { &rare, &common }) {
+        for (const auto& [hash, candidate] : *pool) {
+            bytes += sizeof(Candidate) + candidate.path.capacity() * sizeof(char16_t) + candidate.hosts.MemoryBytes();
+        }
+    }
+    return bytes + groups.capacity() * sizeof(groups[0]) +
+           (pathHashes.capacity() + hostHashes.capacity()) * sizeof(uint64_t);
+}
+
+bool RarityReport::Write(const fs::path& path, const TimeFormat& format) const {
+    std::string out = "\xEF\xBB\xBF" "Categorie,Rang,Hotes,Comptage,Apparitions,Executions,PremiereExecution,"
+                      "DerniereExecution,Chemin\n";
+    const auto appendRows = [&](const char* category, const std::vector<RarityRow>& rows) {
+        for (size_t i = 0; i < rows.size(); i++) {
+            const RarityRow& row = rows[i];
+            AppendField(out, std::string_view(category));
+            AppendField(out, std::string_view(std::to_string(i + 1)));
+            AppendField(out, std::string_view(std::to_string(row.hosts)));
+            AppendField(out, std::string_view(CountKindName(row.hostsKind)));
+            AppendField(out, std::string_view(std::to_string(row.sightings)));
+            AppendField(out, std::string_view(std::to_string(row.runs)));
+            AppendTime(out, row.firstTime, format);
+            AppendTime(out, row.lastTime, format);
+            AppendField(out, row.path);
+            out.back() = '\n';
+        }
+    };
+    appendRows("rare", rare);
+    appendRows("frequent", common);
+
+#ifdef _WIN32
+    FILE* file = _wfopen(path.c_str(), L"wb");
+#else
+    FILE* file = std::fopen(path.c_str(), "wb");
+#endif
+    if (!file) return false;
+    const bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,205 @@
+/*
+ * Rarity - Rareté des exécutables sur une flotte (moindre fréquence d'apparition) en mémoire bornée
+ *
+ * Un exécutable vu sur trois hôtes sur 50 000 se cherche sans table exacte (chemin, hôte) : chaque
+ * worker alimente son RaritySketch, fusionné avec les autres à la fin, puis le rapport est produit.
+ *
+ * - HyperLogLog : hôtes et chemins distincts de la flotte, hôtes distincts de chaque chemin suivi ;
+ *   représentation creuse (empreintes exactes) tant qu'elle est plus petite que les registres,
+ *   donc exacte pour les chemins rares
+ * - CountMinSketch (mise à jour conservatrice) : exécutions par chemin et apparitions par (ruche, chemin),
+ *   estimations toujours majorantes, erreur ≤ e / largeur × total avec une probabilité 1 - e^-profondeur
+ * - BloomFilter : chemins déjà vus ; un candidat admis à sa première apparition a tous ses hôtes (les
+ *   count-min, saturés par des millions de chemins uniques, ne distinguent pas "jamais vu")
+ * - Candidats bornés : les chemins les moins répandus (bottom-k sur les hôtes, ou les apparitions s'ils
+ *   sont incomplets) et les plus exécutés (top-k sur les exécutions) ; au-delà de 4k candidats, seuls les
+ *   2k meilleurs sont gardés et le seuil d'admission suit, le rapport en retient k. Un chemin écarté puis
+ *   revu est réadmis, ses compteurs étant dans les count-min ; le nombre d'hôtes n'est alors plus qu'un
+ *   majorant (apparitions), et un chemin écarté pour de bon peut manquer au classement (approximation)
+ * - Chemins normalisés, casse repliée ; hôtes par nom replié
+ * - Fusion : même configuration exigée (dimensions des count-min, précisions des HyperLogLog)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+#include "FileTimeFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Cardinalité approchée : 2^precision registres de 6 bits (un octet chacun), erreur type 1,04 / √2^precision
+class HyperLogLog {
+public:
+    explicit HyperLogLog(unsigned precision = 14);
+
+    void Add(uint64_t hash);
+    // false si les précisions diffèrent
+    bool Merge(const HyperLogLog& other);
+    double Estimate() const;
+    // Représentation creuse : Estimate() est le nombre exact d'empreintes distinctes
+    bool Exact() const { return registers.empty(); }
+    unsigned Precision() const { return precision; }
+    size_t MemoryBytes() const { return registers.capacity() + sparse.capacity() * sizeof(uint64_t); }
+
+private:
+    void Densify();
+    void AddDense(uint64_t hash);
+
+    unsigned precision;
+    std::vector<uint64_t> sparse;  // Empreintes triées, tant que registers est vide
+    std::vector<uint8_t> registers;
+};
+
+// Compteurs approchés par empreinte : depth lignes de width compteurs (puissance de deux)
+class CountMinSketch {
+public:
+    explicit CountMinSketch(size_t width = size_t{ 1 } << 16, unsigned depth = 4);
+
+    // Mise à jour conservatrice : seuls les compteurs sous la nouvelle estimation montent ; retourne celle-ci
+    uint64_t Add(uint64_t hash, uint64_t count = 1);
+    uint64_t Estimate(uint64_t hash) const;
+    // Somme compteur par compteur (reste un majorant) ; false si les dimensions diffèrent
+    bool Merge(const CountMinSketch& other);
+
+    size_t Width() const { return width; }
+    unsigned Depth() const { return depth; }
+    uint64_t Total() const { return total; }
+    // Erreur additive bornée (probabilité 1 - e^-depth) : e / width × Total()
+    uint64_t ErrorBound() const;
+    size_t MemoryBytes() const { return counters.capacity() * sizeof(uint32_t); }
+
+private:
+    size_t width;
+    unsigned depth;
+    uint64_t total = 0;
+    std::vector<uint32_t> counters;  // Ligne d, colonne c : counters[d * width + c] ; saturés à UINT32_MAX
+};
+
+// Appartenance sans faux négatif : bits bits, hashes positions par empreinte (double hachage)
+class BloomFilter {
+public:
+    explicit BloomFilter(size_t bits = size_t{ 1 } << 24, unsigned hashes = 4);
+
+    // true si l'empreinte était peut-être déjà présente
+    bool Insert(uint64_t hash);
+    bool MayContain(uint64_t hash) const;
+    // Union ; false si les dimensions diffèrent
+    bool Merge(const BloomFilter& other);
+    size_t MemoryBytes() const { return words.capacity() * sizeof(uint64_t); }
+
+private:
+    size_t bits;
+    unsigned hashes;
+    std::vector<uint64_t> words;
+};
+
+struct RarityOptions {
+    size_t rare = 100;  // Chemins les moins répandus rapportés
+    size_t common = 20;  // Chemins les plus exécutés rapportés
+    size_t width = size_t{ 1 } << 17;  // Compteurs par ligne des count-min (2 Mo par sketch)
+    unsigned depth = 4;
+    size_t seenBits = size_t{ 1 } << 24;  // Chemins vus (2 Mo : ≈ 4 % de faux positifs à 2,4 millions de chemins)
+    unsigned fleetPrecision = 14;  // HyperLogLog de la flotte (≈ 0,8 %)
+    unsigned pathPrecision = 10;  // HyperLogLog des hôtes d'un chemin suivi (exact jusqu'à 128 hôtes)
+};
+
+enum class RarityCount : uint8_t {
+    Exact,  // Hôtes distincts comptés un à un
+    Estimated,  // HyperLogLog
+    UpperBound  // Chemin écarté puis réadmis : apparitions (ruches), majorant du nombre d'hôtes
+};
+
+struct RarityRow {
+    std::u16string path;  // Chemin normalisé, casse de la première apparition
+    uint64_t hosts = 0;
+    RarityCount hostsKind = RarityCount::Exact;
+    uint64_t sightings = 0;  // Apparitions (ruche, chemin), majorant
+    uint64_t runs = 0;  // Lignes, majorant
+    uint64_t firstTime = 0;  // FILETIME extrêmes des lignes vues par le candidat, 0 si aucun
+    uint64_t lastTime = 0;
+};
+
+struct RarityReport {
+    std::vector<RarityRow> rare;  // Hôtes croissants, puis exécutions croissantes
+    std::vector<RarityRow> common;  // Exécutions décroissantes
+    uint64_t rows = 0;
+    double hosts = 0;
+    double paths = 0;
+    double fleetError = 0;  // Erreur type relative des deux estimations précédentes
+    uint64_t sightingsError = 0;  // Erreur additive bornée des count-min
+    uint64_t runsError = 0;
+
+    // CSV UTF-8 (BOM, champs entre guillemets) : une ligne par chemin, rares puis fréquents
+    bool Write(const std::filesystem::path& path, const TimeFormat& format) const;
+};
+
+class RaritySketch {
+public:
+    explicit RaritySketch(const RarityOptions& options = RarityOptions());
+
+    // Lignes d'une ruche (ou d'un store de plusieurs hôtes) ; un chemin compte une apparition par hôte du store,
+    // lignes ENTRY_FLAG_INVALID_DATA ignorées
+    void Add(const EntryStore& store);
+    // Ajoute other (d'un autre worker) ; false si les configurations diffèrent
+    bool Merge(const RaritySketch& other);
+    RarityReport Report() const;
+
+    uint64_t Rows() const { return rows; }
+    size_t MemoryBytes() const;
+
+private:
+    struct Candidate {
+        std::u16string path;
+        HyperLogLog hosts;
+        uint64_t firstTime = UINT64_MAX;
+        uint64_t lastTime = 0;
+        bool complete = true;  // Suivi depuis la première apparition : hosts est complet
+
+        explicit Candidate(unsigned precision) : hosts(precision) {}
+        void Merge(const Candidate& other);
+    };
+    using Pool = std::unordered_map<uint64_t, Candidate>;
+
+    void Track(Pool& pool, bool admit, uint64_t hash, std::u16string_view path, uint64_t host, bool firstSighting,
+               uint64_t firstTime, uint64_t lastTime);
+    void MergePool(Pool& pool, const Pool& otherPool, const RaritySketch& other);
+    void PruneRare();
+    void PruneCommon();
+    uint64_t RareScore(const Candidate& candidate, uint64_t hash) const;
+    RarityRow MakeRow(const Candidate& candidate, uint64_t hash) const;
+
+    RarityOptions options;
+    HyperLogLog fleetHosts;
+    HyperLogLog fleetPaths;
+    CountMinSketch sightings;  // Apparitions (ruche, chemin)
+    CountMinSketch runs;  // Lignes par chemin
+    BloomFilter seen;  // Chemins déjà apparus
+    uint64_t rows = 0;
+
+    Pool rare;
+    Pool common;
+    // Frontières du dernier élagage, (score, empreinte) : admission sous rareLimit, au-dessus de commonFloor
+    std::pair<uint64_t, uint64_t> rareLimit{ UINT64_MAX, UINT64_MAX };
+    std::pair<uint64_t, uint64_t> commonFloor{ 0, 0 };
+
+    struct Sighting {
+        uint64_t path;  // Empreintes des noms repliés
+        uint64_t host;
+        uint32_t row;
+    };
+
+    // Réutilisés d'un store à l'autre
+    std::vector<Sighting> groups;
+    std::vector<uint64_t> pathHashes;
+    std::vector<uint64_t> hostHashes;
+};
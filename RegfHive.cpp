@@ -0,0 +1,686 @@
+/*
+ * RegfHive - Implémentation du moteur regf hors-ligne
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "RegfHive.h"
+
+#include "Telemetry.h"
+#include "Transcode.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cwchar>
+#include <map>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Taille maximale d'un segment de données avant passage au format big data (regf >= 1.4)
+constexpr uint32_t REGF_BIG_DATA_THRESHOLD = 16344;
+
+constexpr uint32_t REGF_PAGE_SIZE = 4096;
+
+// Journaux format Windows 8.1+ : base block partiel de 512 octets, puis entrées "HvLE"
+constexpr size_t LOG_BASE_BLOCK_SIZE = 512;
+constexpr uint32_t LOG_TYPE_NEW = 6;
+constexpr size_t LOG_ENTRY_HEADER = 40;
+constexpr uint64_t MARVIN_SEED = 0x82EF4D887A4E55C5ULL;
+// Recherche de l'en-tête du hbin d'une page modifiée : au-delà, seule la page est copiée
+constexpr uint32_t HBIN_SCAN_LIMIT = 16u * 1024 * 1024;
+
+constexpr uint16_t KEY_COMP_NAME = 0x0020;
+constexpr uint16_t VALUE_COMP_NAME = 0x0001;
+
+inline char16_t AsciiUpper(char16_t c) {
+    return (c >= u'a' && c <= u'z') ? static_cast<char16_t>(c - 32) : c;
+}
+
+// Hash des listes "lh" : h = h * 37 + upper(c)
+uint32_t LhHash(std::string_view name) {
+    uint32_t hash = 0;
+    for (char c : name) {
+        hash = hash * 37 + AsciiUpper(static_cast<unsigned char>(c));
+    }
+    return hash;
+}
+
+// Indice des listes "lf" : 4 premiers caractères du nom (Latin-1), complétés par des zéros
+bool LfHintMatches(uint32_t hint, std::string_view name) {
+    for (size_t i = 0; i < 4; i++) {
+        uint8_t stored = static_cast<uint8_t>(hint >> (8 * i));
+        char16_t expected = i < name.size() ? AsciiUpper(static_cast<unsigned char>(name[i])) : 0;
+        if (stored >= 0x80) return true;  // Caractère non ASCII : l'indice n'est pas exploitable
+        if (AsciiUpper(stored) != expected) return false;
+        if (expected == 0) return true;
+    }
+    return true;
+}
+
+inline uint32_t Rotl(uint32_t v, int n) { return (v << n) | (v >> (32 - n)); }
+
+inline void MarvinBlock(uint32_t& lo, uint32_t& hi) {
+    hi ^= lo; lo = Rotl(lo, 20);
+    lo += hi; hi = Rotl(hi, 9);
+    hi ^= lo; lo = Rotl(lo, 27);
+    lo += hi; hi = Rotl(hi, 19);
+}
+
+struct LogPage {
+    uint32_t offset;  // Relatif aux hbin, multiple de 4096
+    const uint8_t* data;
+};
+
+struct LogEntry {
+    uint32_t sequence;
+    uint32_t hbinsSize;
+    uint32_t rootCell;  // Base block du journal
+    std::vector<LogPage> pages;
+};
+
+// Entrées valides et consécutives d'un journal ; la première entrée invalide (fin d'écriture
+// interrompue, ancien contenu) termine la lecture
+bool ReadLogEntries(const RegfLogView& log, std::vector<LogEntry>& entries, std::string& error) {
+    const uint8_t* data = log.data;
+    size_t size = log.size;
+    if (!data) {
+        error = "Journal vide";
+        return false;
+    }
+    if (size < LOG_BASE_BLOCK_SIZE || std::memcmp(data, "regf", 4) != 0 ||
+        RegfBaseBlockChecksum(data) != RegfRead32(data + 508)) {
+        error = "Base block du journal invalide";
+        return false;
+    }
+    if (RegfRead32(data + 28) != LOG_TYPE_NEW) {
+        error = "Journal ancien format (DIRT) non pris en charge";
+        return false;
+    }
+
+    for (size_t pos = LOG_BASE_BLOCK_SIZE; size - pos >= LOG_ENTRY_HEADER;) {
+        const uint8_t* entry = data + pos;
+        uint32_t entrySize = RegfRead32(entry + 4);
+        if (std::memcmp(entry, "HvLE", 4) != 0 || entrySize < LOG_ENTRY_HEADER || entrySize % 512 != 0 ||
+            entrySize > size - pos) {
+            break;
+        }
+        uint32_t pageCount = RegfRead32(entry + 20);
+        if (RegfMarvin32(entry, 32) != RegfRead64(entry + 32) ||
+            RegfMarvin32(entry + LOG_ENTRY_HEADER, entrySize - LOG_ENTRY_HEADER) != RegfRead64(entry + 24) ||
+            static_cast<uint64_t>(pageCount) * 8 > entrySize - LOG_ENTRY_HEADER) {
+            break;
+        }
+
+        LogEntry parsed;
+        parsed.sequence = RegfRead32(entry + 12);
+        parsed.hbinsSize = RegfRead32(entry + 16);
+        parsed.rootCell = RegfRead32(data + 36);
+        if (!entries.empty() && parsed.sequence != entries.back().sequence + 1) break;
+
+        // Références (offset, taille) suivies des pages, dans le même ordre
+        uint64_t dataPos = LOG_ENTRY_HEADER + static_cast<uint64_t>(pageCount) * 8;
+        bool valid = true;
+        for (uint32_t i = 0; i < pageCount && valid; i++) {
+            uint32_t offset = RegfRead32(entry + LOG_ENTRY_HEADER + i * 8);
+            uint32_t pageSize = RegfRead32(entry + LOG_ENTRY_HEADER + i * 8 + 4);
+            valid = offset % REGF_PAGE_SIZE == 0 && pageSize % REGF_PAGE_SIZE == 0 && dataPos + pageSize <= entrySize &&
+                    static_cast<uint64_t>(offset) + pageSize <= parsed.hbinsSize;
+            for (uint32_t done = 0; valid && done < pageSize; done += REGF_PAGE_SIZE) {
+                parsed.pages.push_back({ offset + done, entry + dataPos + done });
+            }
+            dataPos += pageSize;
+        }
+        if (!valid) break;
+        entries.push_back(std::move(parsed));
+        pos += entrySize;
+    }
+    return true;
+}
+
+// Journaux <nom>.LOG1 / <nom>.LOG2 à côté de la ruche (casse indifférente)
+std::vector<fs::path> FindLogFiles(const fs::path& hivePath) {
+    std::string stem = hivePath.filename().u8string();
+    for (auto& c : stem) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+    std::vector<fs::path> logs;
+    std::error_code ec;
+    for (fs::directory_iterator it(hivePath.parent_path(), ec), end; !ec && it != end; it.increment(ec)) {
+        std::string file = it->path().filename().u8string();
+        for (auto& c : file) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if ((file == stem + ".LOG1" || file == stem + ".LOG2") && it->is_regular_file(ec)) {
+            logs.push_back(it->path());
+        }
+    }
+    std::sort(logs.begin(), logs.end());
+    return logs;
+}
+
+}  // namespace
+
+uint32_t RegfBaseBlockChecksum(const uint8_t* block) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < 508; i += 4) sum ^= RegfRead32(block + i);
+    if (sum == 0xFFFFFFFF) return 0xFFFFFFFE;
+    if (sum == 0) return 1;
+    return sum;
+}
+
+uint64_t RegfMarvin32(const uint8_t* data, size_t size) {
+    uint32_t lo = static_cast<uint32_t>(MARVIN_SEED);
+    uint32_t hi = static_cast<uint32_t>(MARVIN_SEED >> 32);
+    for (; size >= 4; data += 4, size -= 4) {
+        lo += RegfRead32(data);
+        MarvinBlock(lo, hi);
+    }
+    uint32_t last = 0x80;
+    for (size_t i = size; i-- > 0;) {
+        last = (last << 8) | data[i];
+    }
+    lo += last;
+    MarvinBlock(lo, hi);
+    MarvinBlock(lo, hi);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+bool RegfName::Equals(std::string_view ascii) const {
+    if (Length() != ascii.size()) return false;
+    for (size_t i = 0; i < ascii.size(); i++) {
+        if (At(i) != static_cast<unsigned char>(ascii[i])) return false;
+    }
+    return true;
+}
+
+bool RegfName::EqualsNoCase(std::string_view ascii) const {
+    if (Length() != ascii.size()) return false;
+    for (size_t i = 0; i < ascii.size(); i++) {
+        if (AsciiUpper(At(i)) != AsciiUpper(static_cast<unsigned char>(ascii[i]))) return false;
+    }
+    return true;
+}
+
+void RegfName::AppendTo(std::u16string& out) const {
+    const size_t size = out.size();
+    const size_t count = Length();
+    out.resize(size + count);
+    if (compressed) {
+        Latin1ToUtf16(ptr, count, &out[size]);
+    } else {
+        for (size_t i = 0; i < count; i++) out[size + i] = At(i);
+    }
+}
+
+void RegfName::AppendTo(std::wstring& out) const {
+    size_t count = Length();
+    out.reserve(out.size() + count);
+#if WCHAR_MAX <= 0xFFFF
+    for (size_t i = 0; i < count; i++) {
+        out.push_back(static_cast<wchar_t>(At(i)));
+    }
+#else
+    // wchar_t 32 bits : recomposition des paires de substitution
+    for (size_t i = 0; i < count; i++) {
+        char32_t c = At(i);
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < count) {
+            char32_t low = At(i + 1);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            }
+        }
+        out.push_back(static_cast<wchar_t>(c));
+    }
+#endif
+}
+
+bool RegfHive::Open(const fs::path& path, bool replayLogs) {
+    ScopedSpan span(TelemetrySpan::HiveOpen);
+    if (!file.Open(path)) {
+        lastError = file.LastError();
+        Telemetry::Add(TelemetryCounter::HiveOpenErrors);
+        return false;
+    }
+    span.SetItems(file.size());
+    if (!Attach(file.data(), file.size())) {
+        Telemetry::Add(TelemetryCounter::HiveOpenErrors);
+        return false;
+    }
+    if (replayLogs && dirty) {
+        std::vector<fs::path> logs = FindLogFiles(path);
+        if (!logs.empty()) ReplayLogs(logs);
+    }
+    return true;
+}
+
+bool RegfHive::Adopt(std::vector<uint8_t> image) {
+    file.Close();
+    owned = std::move(image);
+    return Attach(owned.data(), owned.size());
+}
+
+bool RegfHive::Attach(const uint8_t* data, size_t size) {
+    if (data != owned.data()) owned.clear();
+    base = data;
+    length = size;
+    hbinsEnd = size > REGF_BASE_BLOCK_SIZE ? size - REGF_BASE_BLOCK_SIZE : 0;
+    overlay.clear();
+    logEntries = 0;
+    logPages = 0;
+    rootCell = REGF_NO_CELL;
+    return ParseHeader();
+}
+
+bool RegfHive::ReplayLogs(const std::vector<fs::path>& logs) {
+    std::vector<MappedFile> files(logs.size());
+    std::vector<RegfLogView> views;
+    for (size_t i = 0; i < logs.size(); i++) {
+        if (files[i].Open(logs[i])) views.push_back({ files[i].data(), files[i].size() });
+    }
+    return ReplayLogs(views);
+}
+
+bool RegfHive::ReplayLogs(const std::vector<RegfLogView>& logs) {
+    if (!base) return false;
+    ScopedSpan span(TelemetrySpan::LogReplay);
+
+    // Les deux journaux sont utilisés en alternance : leurs entrées sont fusionnées par séquence
+    std::vector<LogEntry> entries;
+    for (const RegfLogView& log : logs) {
+        std::vector<LogEntry> found;
+        if (ReadLogEntries(log, found, lastError)) {
+            for (auto& entry : found) entries.push_back(std::move(entry));
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const LogEntry& a, const LogEntry& b) { return a.sequence < b.sequence; });
+
+    // Entrées postérieures à la dernière écriture complète du primaire, sans trou de séquence
+    const uint32_t secondary = RegfRead32(base + 8);
+    std::map<uint32_t, const uint8_t*> pages;  // Offset → contenu le plus récent
+    uint32_t newSize = 0;
+    uint32_t newRoot = rootCell;
+    size_t applied = 0;
+    bool started = false;
+    uint32_t expected = 0;
+    for (const auto& entry : entries) {
+        if (entry.sequence < secondary) continue;
+        if (started && entry.sequence != expected) {
+            if (entry.sequence < expected) continue;  // Même entrée dans les deux journaux
+            break;
+        }
+        started = true;
+        expected = entry.sequence + 1;
+        newSize = entry.hbinsSize;
+        newRoot = entry.rootCell;
+        for (const auto& page : entry.pages) pages[page.offset] = page.data;
+        applied++;
+    }
+    if (applied == 0) {
+        if (lastError.empty()) lastError = "Aucune entrée de journal applicable";
+        return false;
+    }
+
+    // Vue finale d'une page : journal, sinon primaire, sinon zéros (hbin ajoutés)
+    const uint64_t primaryEnd = length - REGF_BASE_BLOCK_SIZE;
+    auto pageAt = [&](uint32_t offset) -> const uint8_t* {
+        auto it = pages.find(offset);
+        if (it != pages.end()) return it->second;
+        if (offset + static_cast<uint64_t>(REGF_PAGE_SIZE) <= primaryEnd) return base + REGF_BASE_BLOCK_SIZE + offset;
+        return nullptr;
+    };
+
+    // Une cellule ne traverse jamais un hbin : chaque page modifiée entraîne la copie de tout son hbin,
+    // retrouvé en remontant jusqu'à son en-tête
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (const auto& [offset, data] : pages) {
+        if (!ranges.empty() && offset < ranges.back().second) continue;
+        uint32_t begin = offset;
+        uint32_t end = offset + REGF_PAGE_SIZE;
+        for (uint32_t scan = offset;; scan -= REGF_PAGE_SIZE) {
+            const uint8_t* page = pageAt(scan);
+            if (page && std::memcmp(page, "hbin", 4) == 0 && RegfRead32(page + 4) == scan) {
+                uint32_t hbinSize = RegfRead32(page + 8);
+                if (hbinSize % REGF_PAGE_SIZE == 0 && static_cast<uint64_t>(scan) + hbinSize > offset) {
+                    begin = scan;
+                    end = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(scan) + hbinSize, newSize));
+                }
+                break;
+            }
+            if (scan == 0 || offset - scan >= HBIN_SCAN_LIMIT) break;
+        }
+        ranges.emplace_back(begin, end);
+    }
+    if (newSize > primaryEnd) {
+        ranges.emplace_back(static_cast<uint32_t>(primaryEnd & ~uint64_t(REGF_PAGE_SIZE - 1)), newSize);
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    overlay.clear();
+    for (const auto& [begin, end] : ranges) {
+        if (!overlay.empty() && begin <= overlay.back().end) {
+            overlay.back().end = std::max(overlay.back().end, end);
+            continue;
+        }
+        overlay.push_back({ begin, end, nullptr });
+    }
+    for (auto& segment : overlay) {
+        size_t bytes = segment.end - segment.offset;
+        segment.data.reset(new uint8_t[bytes]);
+        for (uint32_t offset = segment.offset; offset < segment.end; offset += REGF_PAGE_SIZE) {
+            const uint8_t* page = pageAt(offset);
+            uint8_t* target = segment.data.get() + (offset - segment.offset);
+            if (page) {
+                std::memcpy(target, page, REGF_PAGE_SIZE);
+                continue;
+            }
+            // Page neuve, ou dernière page incomplète d'un primaire tronqué
+            size_t kept = offset < primaryEnd ? static_cast<size_t>(primaryEnd - offset) : 0;
+            if (kept) std::memcpy(target, base + REGF_BASE_BLOCK_SIZE + offset, kept);
+            std::memset(target + kept, 0, REGF_PAGE_SIZE - kept);
+        }
+    }
+
+    hbinsEnd = newSize;
+    logEntries = applied;
+    logPages = pages.size();
+    lastError.clear();
+
+    uint32_t size = 0;
+    if (KeyCell(newRoot, size)) {
+        rootCell = newRoot;
+    } else if (!KeyCell(rootCell, size)) {
+        lastError = "Clé racine invalide après application des journaux";
+        overlay.clear();
+        hbinsEnd = length - REGF_BASE_BLOCK_SIZE;
+        logEntries = 0;
+        logPages = 0;
+        return false;
+    }
+    span.SetItems(logPages);
+    return true;
+}
+
+size_t RegfHive::OverlayBytes() const {
+    size_t bytes = 0;
+    for (const auto& segment : overlay) bytes += segment.end - segment.offset;
+    return bytes;
+}
+
+bool RegfHive::ParseHeader() {
+    if (!base || length < REGF_BASE_BLOCK_SIZE + 32) {
+        lastError = "Ruche trop petite";
+        return false;
+    }
+    if (std::memcmp(base, "regf", 4) != 0) {
+        lastError = "Signature regf absente";
+        return false;
+    }
+    if (RegfRead32(base + 20) != 1) {
+        lastError = "Version majeure regf non supportée";
+        return false;
+    }
+    if (std::memcmp(base + REGF_BASE_BLOCK_SIZE, "hbin", 4) != 0) {
+        lastError = "Premier hbin introuvable";
+        return false;
+    }
+
+    dirty = RegfRead32(base + 4) != RegfRead32(base + 8);
+    minorVersion = RegfRead32(base + 24);
+
+    uint32_t size = 0;
+    rootCell = RegfRead32(base + 36);
+    if (!KeyCell(rootCell, size)) {
+        lastError = "Clé racine invalide";
+        rootCell = REGF_NO_CELL;
+        return false;
+    }
+    return true;
+}
+
+const uint8_t* RegfHive::Locate(uint32_t offset, uint64_t& available) const {
+    if (offset >= hbinsEnd) return nullptr;
+    uint64_t limit = hbinsEnd;
+
+    if (!overlay.empty()) {
+        // Premier segment qui finit après l'offset : il le contient, ou borne la zone primaire
+        auto it = std::upper_bound(overlay.begin(), overlay.end(), offset,
+                                   [](uint32_t value, const OverlaySegment& segment) { return value < segment.end; });
+        if (it != overlay.end()) {
+            if (it->offset <= offset) {
+                available = it->end - offset;
+                return it->data.get() + (offset - it->offset);
+            }
+            limit = it->offset;
+        }
+    }
+
+    uint64_t pos = REGF_BASE_BLOCK_SIZE + static_cast<uint64_t>(offset);
+    if (pos >= length) return nullptr;
+    available = std::min<uint64_t>(length - pos, limit - offset);
+    return base + pos;
+}
+
+const uint8_t* RegfHive::CellData(uint32_t offset, uint32_t& size) const {
+    if (offset == REGF_NO_CELL) return nullptr;
+
+    uint64_t available = 0;
+    const uint8_t* cell = Locate(offset, available);
+    if (!cell || available < 4) return nullptr;
+
+    int32_t raw = static_cast<int32_t>(RegfRead32(cell));
+    uint64_t cellSize = raw < 0 ? static_cast<uint64_t>(-static_cast<int64_t>(raw)) : static_cast<uint64_t>(raw);
+    if (cellSize < 4 || cellSize > available) return nullptr;
+
+    size = static_cast<uint32_t>(cellSize - 4);
+    return cell + 4;
+}
+
+const uint8_t* RegfHive::KeyCell(uint32_t key, uint32_t& size) const {
+    const uint8_t* nk = CellData(key, size);
+    if (!nk || size < 76 || nk[0] != 'n' || nk[1] != 'k') return nullptr;
+    if (76u + RegfRead16(nk + 72) > size) return nullptr;
+    return nk;
+}
+
+uint64_t RegfHive::KeyLastWrite(uint32_t key) const {
+    uint32_t size = 0;
+    const uint8_t* nk = KeyCell(key, size);
+    return nk ? RegfRead64(nk + 4) : 0;
+}
+
+bool RegfHive::KeyName(uint32_t key, RegfName& out) const {
+    uint32_t size = 0;
+    const uint8_t* nk = KeyCell(key, size);
+    if (!nk) return false;
+
+    out.ptr = nk + 76;
+    out.byteLength = RegfRead16(nk + 72);
+    out.compressed = (RegfRead16(nk + 2) & KEY_COMP_NAME) != 0;
+    return true;
+}
+
+uint32_t RegfHive::FindSubkey(uint32_t key, std::string_view name) const {
+    uint32_t size = 0;
+    const uint8_t* nk = KeyCell(key, size);
+    if (!nk || RegfRead32(nk + 20) == 0) return REGF_NO_CELL;
+
+    const uint32_t hash = LhHash(name);
+    uint32_t found = REGF_NO_CELL;
+
+    WalkSubkeyList(RegfRead32(nk + 28), 0, [&](uint32_t child, uint16_t sig, uint32_t hint) {
+        // Préfiltrage par l'indice de la liste avant de toucher la cellule nk
+        if (sig == 0x686C && hint != hash) return true;
+        if (sig == 0x666C && !LfHintMatches(hint, name)) return true;
+
+        RegfName childName;
+        if (KeyName(child, childName) && childName.EqualsNoCase(name)) {
+            found = child;
+            return false;
+        }
+        return true;
+    });
+
+    return found;
+}
+
+uint32_t RegfHive::OpenKey(uint32_t key, std::string_view path) const {
+    while (key != REGF_NO_CELL && !path.empty()) {
+        size_t sep = path.find('\\');
+        std::string_view component = path.substr(0, sep);
+        if (!component.empty()) {
+            key = FindSubkey(key, component);
+        }
+        path = sep == std::string_view::npos ? std::string_view() : path.substr(sep + 1);
+    }
+    return key;
+}
+
+bool RegfHive::ValueList(uint32_t key, const uint8_t*& list, uint32_t& count) const {
+    list = nullptr;
+    count = 0;
+    uint32_t size = 0;
+    const uint8_t* nk = KeyCell(key, size);
+    if (!nk) return false;
+    const uint32_t values = RegfRead32(nk + 36);
+    if (values == 0) return true;
+
+    uint32_t listSize = 0;
+    const uint8_t* cells = CellData(RegfRead32(nk + 40), listSize);
+    if (!cells || static_cast<uint64_t>(values) * 4 > listSize) return false;
+    list = cells;
+    count = values;
+    return true;
+}
+
+bool RegfHive::ParseValue(uint32_t cell, RegfValue& out) const {
+    uint32_t size = 0;
+    const uint8_t* vk = CellData(cell, size);
+    if (!vk || !ParseValueRecord(vk, size, out)) return false;
+    out.cell = cell;
+    return true;
+}
+
+bool RegfHive::ParseValueRecord(const uint8_t* vk, uint64_t size, RegfValue& out) const {
+    if (size < 20 || vk[0] != 'v' || vk[1] != 'k') return false;
+
+    uint16_t nameLength = RegfRead16(vk + 2);
+    if (20u + nameLength > size) return false;
+
+    out.cell = REGF_NO_CELL;
+    out.name.ptr = vk + 20;
+    out.name.byteLength = nameLength;
+    out.name.compressed = (RegfRead16(vk + 16) & VALUE_COMP_NAME) != 0;
+    out.type = RegfRead32(vk + 12);
+
+    uint32_t rawSize = RegfRead32(vk + 4);
+    out.data = nullptr;
+
+    if (rawSize & 0x80000000u) {
+        // Données résidentes : stockées directement dans le champ offset de la vk
+        out.dataSize = rawSize & 0x7FFFFFFFu;
+        if (out.dataSize > 4) out.dataSize = 4;
+        out.data = vk + 8;
+        return true;
+    }
+
+    out.dataSize = rawSize;
+    if (rawSize == 0) return true;
+    if (rawSize > REGF_BIG_DATA_THRESHOLD && minorVersion >= 4) {
+        return true;  // Big data : ReadValueData() réassemble les segments
+    }
+
+    uint32_t dataCellSize = 0;
+    const uint8_t* data = CellData(RegfRead32(vk + 8), dataCellSize);
+    if (data && rawSize <= dataCellSize) {
+        out.data = data;
+    }
+    return true;
+}
+
+bool RegfHive::FindValue(uint32_t key, std::string_view name, RegfValue& out) const {
+    bool found = false;
+    ForEachValue(key, [&](const RegfValue& value) {
+        if (value.name.EqualsNoCase(name)) {
+            out = value;
+            found = true;
+            return false;
+        }
+        return true;
+    });
+    return found;
+}
+
+bool RegfHive::ReadDword(uint32_t key, std::string_view name, uint32_t& out) const {
+    RegfValue value;
+    if (!FindValue(key, name, value) || !value.data || value.dataSize < 4) return false;
+    out = RegfRead32(value.data);
+    return true;
+}
+
+bool RegfHive::ReadString(uint32_t key, std::string_view name, std::u16string& out) const {
+    RegfValue value;
+    if (!FindValue(key, name, value)) return false;
+    if (value.type != REGF_TYPE_SZ && value.type != REGF_TYPE_EXPAND_SZ) return false;
+
+    std::vector<uint8_t> data;
+    if (!ReadValueData(value, data)) return false;
+    out.resize(data.size() / 2);
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i] = static_cast<char16_t>(RegfRead16(data.data() + 2 * i));
+    }
+    while (!out.empty() && out.back() == 0) out.pop_back();
+    return true;
+}
+
+bool RegfHive::ReadValueData(const RegfValue& value, std::vector<uint8_t>& out) const {
+    out.clear();
+    if (value.data) {
+        out.assign(value.data, value.data + value.dataSize);
+        return true;
+    }
+    if (value.dataSize == 0) return true;
+
+    uint32_t vkSize = 0;
+    const uint8_t* vk = CellData(value.cell, vkSize);
+    if (!vk) return false;
+
+    uint32_t dbSize = 0;
+    const uint8_t* db = CellData(RegfRead32(vk + 8), dbSize);
+    if (!db || dbSize < 8 || db[0] != 'd' || db[1] != 'b') return false;
+
+    uint32_t segments = RegfRead16(db + 2);
+    uint32_t listSize = 0;
+    const uint8_t* list = CellData(RegfRead32(db + 4), listSize);
+    if (!list || static_cast<uint64_t>(segments) * 4 > listSize) return false;
+
+    out.reserve(value.dataSize);
+    for (uint32_t i = 0; i < segments && out.size() < value.dataSize; i++) {
+        uint32_t segmentSize = 0;
+        const uint8_t* segment = CellData(RegfRead32(list + i * 4), segmentSize);
+        if (!segment) return false;
+        uint32_t take = std::min<uint32_t>(segmentSize, REGF_BIG_DATA_THRESHOLD);
+        take = std::min<uint32_t>(take, value.dataSize - static_cast<uint32_t>(out.size()));
+        out.insert(out.end(), segment, segment + take);
+    }
+    return out.size() == value.dataSize;
+}
+
+uint32_t RegfHive::CurrentControlSet() const {
+    uint32_t current = 1;
+    uint32_t select = FindSubkey(rootCell, "Select");
+    if (select != REGF_NO_CELL) {
+        ReadDword(select, "Current", current);
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "ControlSet%03u", current);
+    uint32_t controlSet = FindSubkey(rootCell, name);
+    if (controlSet == REGF_NO_CELL && current != 1) {
+        controlSet = FindSubkey(rootCell, "ControlSet001");
+    }
+    return controlSet;
+}
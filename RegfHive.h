@@ -0,0 +1,241 @@
+/*
+ * RegfHive - Moteur de lecture hors-ligne des ruches registry (format regf)
+ *
+ * - Projection mémoire de la ruche (MappedFile), aucune copie des noms ni des données
+ * - Base block regf, hbin, cellules nk / vk / lf / lh / li / ri / db
+ * - Résolution Select\Current → ControlSet00N
+ * - Toutes les lectures sont bornées : une ruche corrompue ne fait jamais sortir du mapping
+ * - Ruche non consolidée : entrées HvLE des journaux .LOG1/.LOG2 appliquées en mémoire, sans
+ *   copie de la ruche ni écriture sur disque. Seuls les hbin qui contiennent une page modifiée
+ *   (et les hbin ajoutés après la fin du fichier primaire) sont copiés dans une surcouche ;
+ *   le reste est lu dans la projection. Le coût suit la taille des journaux, pas celle de la ruche.
+ *
+ * Les offsets de cellules sont relatifs au début des hbin (offset fichier - 4096),
+ * comme dans le format regf lui-même.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t REGF_NO_CELL = 0xFFFFFFFF;
+constexpr size_t REGF_BASE_BLOCK_SIZE = 4096;
+
+// Types de valeurs registry (identiques à winnt.h, redéfinis pour la portabilité)
+constexpr uint32_t REGF_TYPE_SZ = 1;
+constexpr uint32_t REGF_TYPE_EXPAND_SZ = 2;
+constexpr uint32_t REGF_TYPE_BINARY = 3;
+constexpr uint32_t REGF_TYPE_DWORD = 4;
+
+// Lectures little-endian non alignées
+inline uint16_t RegfRead16(const uint8_t* p) { uint16_t v; std::memcpy(&v, p, 2); return v; }
+inline uint32_t RegfRead32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+inline uint64_t RegfRead64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+
+// Somme de contrôle d'un base block : XOR des 127 premiers mots (0 et 0xFFFFFFFF réservés)
+uint32_t RegfBaseBlockChecksum(const uint8_t* block);
+// Marvin32 64 bits, graine des entrées de journal HvLE
+uint64_t RegfMarvin32(const uint8_t* data, size_t size);
+
+// Journal .LOG1/.LOG2 déjà en mémoire (extrait d'une image disque...)
+struct RegfLogView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Vue sur un nom de clé ou de valeur stocké dans la ruche
+struct RegfName {
+    const uint8_t* ptr = nullptr;
+    uint16_t byteLength = 0;
+    bool compressed = false;  // Nom "compressé" : Latin-1, un octet par caractère
+
+    size_t Length() const { return compressed ? byteLength : byteLength / 2u; }
+    char16_t At(size_t i) const {
+        return compressed ? static_cast<char16_t>(ptr[i])
+                          : static_cast<char16_t>(ptr[2 * i] | (ptr[2 * i + 1] << 8));
+    }
+
+    // Comparaison exacte (noms de valeurs)
+    bool Equals(std::string_view ascii) const;
+    // Comparaison insensible à la casse ASCII (noms de clés)
+    bool EqualsNoCase(std::string_view ascii) const;
+
+    // UTF-16 → wchar_t (UTF-16 sous Windows, UTF-32 ailleurs)
+    void AppendTo(std::wstring& out) const;
+    void AppendTo(std::u16string& out) const;
+};
+
+// Vue sur une valeur (cellule vk)
+struct RegfValue {
+    RegfName name;
+    uint32_t type = 0;
+    uint32_t dataSize = 0;
+    const uint8_t* data = nullptr;  // nullptr si données fragmentées (big data) ou hors limites
+    uint32_t cell = REGF_NO_CELL;
+};
+
+class RegfHive {
+public:
+    RegfHive() = default;
+    RegfHive(const RegfHive&) = delete;
+    RegfHive& operator=(const RegfHive&) = delete;
+
+    // Ouvre et projette une ruche depuis un fichier ; si elle n'est pas consolidée, rejoue
+    // les journaux voisins (<nom>.LOG1, <nom>.LOG2). Un journal illisible n'empêche pas l'ouverture.
+    bool Open(const std::filesystem::path& path, bool replayLogs = true);
+    // Utilise une image de ruche déjà présente en mémoire (non possédée)
+    bool Attach(const uint8_t* data, size_t size);
+    // Reprend une image de ruche copiée (possédée par la ruche)
+    bool Adopt(std::vector<uint8_t> image);
+
+    const std::string& LastError() const { return lastError; }
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+
+    // Séquences primaire/secondaire différentes : ruche non consolidée (logs en attente)
+    bool IsDirty() const { return dirty; }
+
+    // Applique les entrées HvLE valides des journaux (format Windows 8.1+), dans l'ordre des séquences,
+    // à partir de la séquence secondaire du fichier primaire. Remplace une surcouche précédente.
+    bool ReplayLogs(const std::vector<std::filesystem::path>& logs);
+    // Idem sur des journaux en mémoire ; ils peuvent être libérés au retour
+    bool ReplayLogs(const std::vector<RegfLogView>& logs);
+    size_t LogEntriesApplied() const { return logEntries; }
+    size_t LogPagesApplied() const { return logPages; }
+    size_t OverlayBytes() const;
+    uint32_t RootKey() const { return rootCell; }
+
+    // Accès brut à une cellule allouée ou libre ; size = taille utile (sans l'en-tête de 4 octets)
+    const uint8_t* CellData(uint32_t offset, uint32_t& size) const;
+    // Parcours séquentiel des hbin (carving) : taille des données hbin, journaux appliqués compris, et zone
+    // lisible contiguë à un offset (available octets, jusqu'à la fin de la surcouche ou du fichier au plus)
+    uint64_t HbinsSize() const { return hbinsEnd; }
+    const uint8_t* HbinData(uint32_t offset, uint64_t& available) const { return Locate(offset, available); }
+    // Enregistrement vk lu en place (cellule libre) : size = octets lisibles depuis vk, out.cell non renseigné
+    bool ParseValueRecord(const uint8_t* vk, uint64_t size, RegfValue& out) const;
+
+    bool KeyName(uint32_t key, RegfName& out) const;
+    // Dernière écriture de la clé (FILETIME), 0 si cellule invalide
+    uint64_t KeyLastWrite(uint32_t key) const;
+    uint32_t FindSubkey(uint32_t key, std::string_view name) const;
+    // Chemin relatif séparé par '\\', ex. "Services\\bam\\State"
+    uint32_t OpenKey(uint32_t key, std::string_view path) const;
+    bool FindValue(uint32_t key, std::string_view name, RegfValue& out) const;
+    bool ReadDword(uint32_t key, std::string_view name, uint32_t& out) const;
+    // REG_SZ / REG_EXPAND_SZ UTF-16LE, zéros finaux retirés (variables d'environnement non développées)
+    bool ReadString(uint32_t key, std::string_view name, std::u16string& out) const;
+    // Copie les données d'une valeur, y compris les valeurs big data fragmentées
+    bool ReadValueData(const RegfValue& value, std::vector<uint8_t>& out) const;
+
+    // Clé ControlSet00N désignée par Select\Current (ControlSet001 par défaut)
+    uint32_t CurrentControlSet() const;
+
+    // fn(uint32_t subkeyCell) -> bool (false = arrêt)
+    template <class F>
+    bool ForEachSubkey(uint32_t key, F&& fn) const {
+        uint32_t size = 0;
+        const uint8_t* nk = KeyCell(key, size);
+        if (!nk) return false;
+        if (RegfRead32(nk + 20) == 0) return true;
+        return WalkSubkeyList(RegfRead32(nk + 28), 0,
+                              [&](uint32_t child, uint16_t, uint32_t) { return fn(child); });
+    }
+
+    // Liste des cellules vk d'une clé, pour un parcours pas à pas (ValueAt) ; nullptr et count = 0
+    // si la clé n'a pas de valeur, nullptr et false si la liste est invalide
+    bool ValueList(uint32_t key, const uint8_t*& list, uint32_t& count) const;
+    // index < count ; false si la cellule vk est invalide (valeur à sauter)
+    bool ValueAt(const uint8_t* list, uint32_t index, RegfValue& out) const {
+        return ParseValue(RegfRead32(list + static_cast<size_t>(index) * 4), out);
+    }
+
+    // fn(const RegfValue&) -> bool (false = arrêt)
+    template <class F>
+    bool ForEachValue(uint32_t key, F&& fn) const {
+        const uint8_t* list = nullptr;
+        uint32_t count = 0;
+        if (!ValueList(key, list, count)) return false;
+
+        for (uint32_t i = 0; i < count; i++) {
+            RegfValue value;
+            if (!ValueAt(list, i, value)) continue;
+            if (!fn(static_cast<const RegfValue&>(value))) return false;
+        }
+        return true;
+    }
+
+private:
+    // hbin modifié(s) par les journaux, copiés et corrigés ; [offset, end) relatifs aux hbin
+    struct OverlaySegment {
+        uint32_t offset;
+        uint32_t end;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    bool ParseHeader();
+    // Début de la zone lisible contiguë à l'offset (jusqu'à la fin de son hbin au plus)
+    const uint8_t* Locate(uint32_t offset, uint64_t& available) const;
+    const uint8_t* KeyCell(uint32_t key, uint32_t& size) const;
+    bool ParseValue(uint32_t cell, RegfValue& out) const;
+
+    // fn(uint32_t child, uint16_t listSignature, uint32_t hint) -> bool
+    template <class F>
+    bool WalkSubkeyList(uint32_t listCell, int depth, F&& fn) const {
+        uint32_t size = 0;
+        const uint8_t* list = CellData(listCell, size);
+        if (!list || size < 4) return false;
+
+        uint16_t sig = RegfRead16(list);
+        uint32_t count = RegfRead16(list + 2);
+
+        if (sig == 0x6972) {  // "ri" : liste de listes
+            if (depth > 0 || 4 + static_cast<uint64_t>(count) * 4 > size) return false;
+            for (uint32_t i = 0; i < count; i++) {
+                if (!WalkSubkeyList(RegfRead32(list + 4 + i * 4), depth + 1, fn)) return false;
+            }
+            return true;
+        }
+
+        uint32_t stride;
+        if (sig == 0x696C) {          // "li" : offsets seuls
+            stride = 4;
+        } else if (sig == 0x666C ||   // "lf" : offset + 4 premiers caractères
+                   sig == 0x686C) {   // "lh" : offset + hash du nom
+            stride = 8;
+        } else {
+            return false;
+        }
+        if (4 + static_cast<uint64_t>(count) * stride > size) return false;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t* element = list + 4 + i * stride;
+            uint32_t hint = stride == 8 ? RegfRead32(element + 4) : 0;
+            if (!fn(RegfRead32(element), sig, hint)) return false;
+        }
+        return true;
+    }
+
+    MappedFile file;
+    std::vector<uint8_t> owned;  // Image adoptée (Adopt)
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    uint32_t rootCell = REGF_NO_CELL;
+    uint32_t minorVersion = 0;
+    bool dirty = false;
+    uint64_t hbinsEnd = 0;  // Taille des données hbin (journaux appliqués compris)
+    std::vector<OverlaySegment> overlay;  // Trié par offset, sans recouvrement
+    size_t logEntries = 0;
+    size_t logPages = 0;
+    std::string lastError;
+};
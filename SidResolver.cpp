@@ -0,0 +1,379 @@
+/*
+ * SidResolver - Implémentation de la résolution hors-ligne et du cache de SIDs
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "SidResolver.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+constexpr size_t SID_CACHE_INITIAL_SLOTS = 1024;
+
+uint64_t HashSid(std::u16string_view sid) {
+    uint64_t hash = FNV_OFFSET;
+    for (char16_t c : sid) {
+        hash = (hash ^ static_cast<uint16_t>(c)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+bool StartsWith(std::u16string_view text, std::u16string_view prefix) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool AllDigits(std::u16string_view text) {
+    if (text.empty()) return false;
+    for (char16_t c : text) {
+        if (c < u'0' || c > u'9') return false;
+    }
+    return true;
+}
+
+// Dernier composant d'un chemin de profil ("C:\Users\bob" → "bob")
+std::u16string_view ProfileName(std::u16string_view imagePath) {
+    while (!imagePath.empty() && (imagePath.back() == u'\\' || imagePath.back() == u'/')) {
+        imagePath.remove_suffix(1);
+    }
+    size_t slash = imagePath.find_last_of(u"\\/");
+    return slash == std::u16string_view::npos ? imagePath : imagePath.substr(slash + 1);
+}
+
+void AppendDecimal(std::u16string& out, uint32_t value) {
+    char16_t digits[10];
+    size_t n = 0;
+    do {
+        digits[n++] = static_cast<char16_t>(u'0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) out.push_back(digits[--n]);
+}
+
+// SID de la machine : 24 derniers octets de la valeur V de SAM\Domains\Account
+// (révision 1, 4 sous-autorités, autorité NT 5, 21, puis les trois identifiants machine)
+bool ReadMachineSid(const RegfHive& sam, uint32_t account, std::u16string& sid) {
+    RegfValue value;
+    std::vector<uint8_t> data;
+    if (!sam.FindValue(account, "V", value) || !sam.ReadValueData(value, data) || data.size() < 24) {
+        return false;
+    }
+    const uint8_t* p = data.data() + data.size() - 24;
+    if (p[0] != 1 || p[1] != 4 || p[7] != 5 || RegfRead32(p + 8) != 21) return false;
+
+    sid = u"S-1-5-21";
+    for (int i = 0; i < 3; i++) {
+        sid.push_back(u'-');
+        AppendDecimal(sid, RegfRead32(p + 12 + 4 * i));
+    }
+    return true;
+}
+
+bool FindSibling(const fs::path& dir, const char* name, fs::path& found) {
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string file = it->path().filename().u8string();
+        size_t i = 0;
+        while (i < file.size() && name[i] &&
+               std::toupper(static_cast<unsigned char>(file[i])) == static_cast<unsigned char>(name[i])) {
+            i++;
+        }
+        if (i == file.size() && name[i] == 0 && it->is_regular_file(ec)) {
+            found = it->path();
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+bool WellKnownSidName(std::u16string_view sid, std::u16string& name) {
+    struct WellKnown {
+        const char16_t* sid;
+        const char16_t* name;
+    };
+    static const WellKnown FIXED[] = {
+        { u"S-1-5-18", u"NT AUTHORITY\\SYSTEM" },
+        { u"S-1-5-19", u"NT AUTHORITY\\LOCAL SERVICE" },
+        { u"S-1-5-20", u"NT AUTHORITY\\NETWORK SERVICE" },
+    };
+    for (const auto& known : FIXED) {
+        if (sid == known.sid) {
+            name = known.name;
+            return true;
+        }
+    }
+
+    // Sessions de service : S-1-5-90-0-<session> (DWM-n), S-1-5-96-0-<session> (UMFD-n)
+    if (StartsWith(sid, u"S-1-5-90-0-") && AllDigits(sid.substr(11))) {
+        name = u"Window Manager\\DWM-";
+        name.append(sid.substr(11));
+        return true;
+    }
+    if (StartsWith(sid, u"S-1-5-96-0-") && AllDigits(sid.substr(11))) {
+        name = u"Font Driver Host\\UMFD-";
+        name.append(sid.substr(11));
+        return true;
+    }
+    return false;
+}
+
+size_t ReadProfileList(const RegfHive& software, const SidAccountFn& fn) {
+    uint32_t profiles = software.OpenKey(software.RootKey(), "Microsoft\\Windows NT\\CurrentVersion\\ProfileList");
+    if (profiles == REGF_NO_CELL) return 0;
+
+    size_t count = 0;
+    std::u16string sid;
+    std::u16string imagePath;
+    software.ForEachSubkey(profiles, [&](uint32_t profile) {
+        RegfName name;
+        if (!software.KeyName(profile, name)) return true;
+        if (!software.ReadString(profile, "ProfileImagePath", imagePath)) return true;
+
+        std::u16string_view user = ProfileName(imagePath);
+        if (user.empty()) return true;
+        sid.clear();
+        name.AppendTo(sid);
+        fn(sid, user);
+        count++;
+        return true;
+    });
+    return count;
+}
+
+size_t ReadSamAccounts(const RegfHive& sam, std::u16string_view host, const SidAccountFn& fn) {
+    uint32_t account = sam.OpenKey(sam.RootKey(), "SAM\\Domains\\Account");
+    if (account == REGF_NO_CELL) return 0;
+    std::u16string machineSid;
+    if (!ReadMachineSid(sam, account, machineSid)) return 0;
+
+    uint32_t names = sam.OpenKey(account, "Users\\Names");
+    if (names == REGF_NO_CELL) return 0;
+
+    size_t count = 0;
+    std::u16string sid;
+    std::u16string user;
+    sam.ForEachSubkey(names, [&](uint32_t nameKey) {
+        RegfName name;
+        if (!sam.KeyName(nameKey, name)) return true;
+
+        // Le RID est stocké dans le type de la valeur par défaut
+        bool found = false;
+        uint32_t rid = 0;
+        sam.ForEachValue(nameKey, [&](const RegfValue& value) {
+            if (value.name.Length() != 0) return true;
+            rid = value.type;
+            found = true;
+            return false;
+        });
+        if (!found) return true;
+
+        sid = machineSid;
+        sid.push_back(u'-');
+        AppendDecimal(sid, rid);
+        user.assign(host);
+        if (!user.empty()) user.push_back(u'\\');
+        name.AppendTo(user);
+        fn(sid, user);
+        count++;
+        return true;
+    });
+    return count;
+}
+
+SidCache::Table::Table(size_t capacity) : mask(capacity - 1), slots(new std::atomic<const Entry*>[capacity]) {
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+SidCache::SidCache() {
+    tables.push_back(std::make_unique<Table>(SID_CACHE_INITIAL_SLOTS));
+    table.store(tables.back().get(), std::memory_order_release);
+}
+
+SidCache::~SidCache() = default;
+
+bool SidCache::Find(std::u16string_view sid, std::u16string_view& name) const {
+    const uint64_t hash = HashSid(sid);
+    const Table* current = table.load(std::memory_order_acquire);
+    size_t slot = static_cast<size_t>(hash) & current->mask;
+    while (const Entry* entry = current->slots[slot].load(std::memory_order_acquire)) {
+        if (entry->hash == hash && std::u16string_view(entry->sid, entry->sidLength) == sid) {
+            name = std::u16string_view(entry->name, entry->nameLength);
+            return true;
+        }
+        slot = (slot + 1) & current->mask;
+    }
+    return false;
+}
+
+const char16_t* SidCache::Copy(std::u16string_view text) {
+    char16_t* copy = static_cast<char16_t*>(arena.Allocate((text.size() + 1) * sizeof(char16_t), alignof(char16_t)));
+    std::copy(text.begin(), text.end(), copy);
+    copy[text.size()] = 0;
+    return copy;
+}
+
+// Insère ou remplace l'entrée de même SID (appelant sous writeLock)
+void SidCache::Place(Table& target, const Entry* entry) {
+    size_t slot = static_cast<size_t>(entry->hash) & target.mask;
+    while (const Entry* existing = target.slots[slot].load(std::memory_order_relaxed)) {
+        if (existing->hash == entry->hash &&
+            std::u16string_view(existing->sid, existing->sidLength) == std::u16string_view(entry->sid, entry->sidLength)) {
+            break;
+        }
+        slot = (slot + 1) & target.mask;
+    }
+    target.slots[slot].store(entry, std::memory_order_release);
+}
+
+void SidCache::Insert(std::u16string_view sid, std::u16string_view name, SidOrigin origin) {
+    if (sid.empty() || name.empty()) return;
+    std::lock_guard<std::mutex> guard(writeLock);
+
+    const uint64_t hash = HashSid(sid);
+    Table* current = table.load(std::memory_order_relaxed);
+    size_t slot = static_cast<size_t>(hash) & current->mask;
+    bool replacing = false;
+    while (const Entry* existing = current->slots[slot].load(std::memory_order_relaxed)) {
+        if (existing->hash == hash && std::u16string_view(existing->sid, existing->sidLength) == sid) {
+            if (existing->origin >= origin || std::u16string_view(existing->name, existing->nameLength) == name) {
+                return;
+            }
+            replacing = true;
+            break;
+        }
+        slot = (slot + 1) & current->mask;
+    }
+
+    Entry* entry = static_cast<Entry*>(arena.Allocate(sizeof(Entry), alignof(Entry)));
+    entry->hash = hash;
+    entry->sid = Copy(sid);
+    entry->sidLength = static_cast<uint32_t>(sid.size());
+    entry->name = Copy(name);
+    entry->nameLength = static_cast<uint32_t>(name.size());
+    entry->origin = origin;
+
+    if (replacing) {
+        current->slots[slot].store(entry, std::memory_order_release);
+        return;
+    }
+
+    const size_t used = count.load(std::memory_order_relaxed) + 1;
+    if (used * 2 > current->mask + 1) {
+        // Nouvelle table remplie hors ligne puis publiée : les lecteurs finissent sur l'ancienne
+        auto grown = std::make_unique<Table>((current->mask + 1) * 2);
+        for (size_t i = 0; i <= current->mask; i++) {
+            if (const Entry* existing = current->slots[i].load(std::memory_order_relaxed)) {
+                Place(*grown, existing);
+            }
+        }
+        Place(*grown, entry);
+        tables.push_back(std::move(grown));
+        table.store(tables.back().get(), std::memory_order_release);
+    } else {
+        current->slots[slot].store(entry, std::memory_order_release);
+    }
+    count.store(used, std::memory_order_release);
+}
+
+std::u16string SidCache::Resolve(std::u16string_view sid) const {
+    std::u16string name;
+    if (WellKnownSidName(sid, name)) return name;
+    std::u16string_view cached;
+    if (Find(sid, cached)) return std::u16string(cached);
+    return u"<Inconnu>";
+}
+
+size_t SidCache::ImportHostHives(const fs::path& configDir, std::u16string_view host) {
+    fs::path path;
+    RegfHive software;
+    RegfHive sam;
+    const bool hasSoftware = FindSibling(configDir, "SOFTWARE", path) && software.Open(path);
+    const bool hasSam = FindSibling(configDir, "SAM", path) && sam.Open(path);
+    return ImportHives(hasSoftware ? &software : nullptr, hasSam ? &sam : nullptr, host);
+}
+
+size_t SidCache::ImportHives(const RegfHive* software, const RegfHive* sam, std::u16string_view host) {
+    size_t imported = 0;
+    if (software) {
+        ReadProfileList(*software, [&](std::u16string_view sid, std::u16string_view name) {
+            Insert(sid, name, SidOrigin::ProfileList);
+            imported++;
+        });
+    }
+    if (sam) {
+        ReadSamAccounts(*sam, host, [&](std::u16string_view sid, std::u16string_view name) {
+            Insert(sid, name, SidOrigin::Sam);
+            imported++;
+        });
+    }
+    return imported;
+}
+
+bool SidCache::Load(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        lastError = "Ouverture impossible";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        Insert(Utf8ToU16(std::string_view(line).substr(0, tab)), Utf8ToU16(std::string_view(line).substr(tab + 1)),
+               SidOrigin::Cache);
+    }
+    return true;
+}
+
+bool SidCache::Save(const fs::path& path) const {
+    std::vector<const Entry*> sorted;
+    {
+        std::lock_guard<std::mutex> guard(writeLock);
+        const Table* current = table.load(std::memory_order_relaxed);
+        for (size_t i = 0; i <= current->mask; i++) {
+            if (const Entry* entry = current->slots[i].load(std::memory_order_relaxed)) {
+                sorted.push_back(entry);
+            }
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Entry* a, const Entry* b) {
+        return std::u16string_view(a->sid, a->sidLength) < std::u16string_view(b->sid, b->sidLength);
+    });
+
+    std::string text = "# BamDamForensics SID cache v1 (SID<TAB>compte)\n";
+    for (const Entry* entry : sorted) {
+        AppendUtf8(text, std::u16string_view(entry->sid, entry->sidLength));
+        text.push_back('\t');
+        AppendUtf8(text, std::u16string_view(entry->name, entry->nameLength));
+        text.push_back('\n');
+    }
+
+    fs::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open() || !out.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    return !ec;
+}
@@ -0,0 +1,101 @@
+/*
+ * SidResolver - Résolution SID → compte hors-ligne, avec cache partagé persistant
+ *
+ * - SIDs bien connus (SYSTEM, LOCAL SERVICE, DWM-n, UMFD-n...) résolus par table, sans appel API
+ * - SOFTWARE\Microsoft\Windows NT\CurrentVersion\ProfileList : SID → dossier de profil
+ * - SAM\Domains\Account (optionnel) : SID de la machine + RID des comptes locaux → HÔTE\nom
+ * - SidCache : table à adressage ouvert lue sans verrou (lecteurs = workers de parsing),
+ *   écritures rares sérialisées par un mutex ; les entrées sont immuables et jamais libérées
+ *   avant la destruction du cache, un agrandissement publie une nouvelle table
+ * - Persistance texte UTF-8 "SID<TAB>nom" : les SIDs de domaine vus sur d'autres hôtes
+ *   ou lors d'exécutions précédentes se résolvent sans ruche ni LookupAccountSidW
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryStore.h"
+#include "RegfHive.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fiabilité croissante : une origine plus fiable remplace une entrée existante
+enum class SidOrigin : uint8_t { Cache = 0, Live = 1, ProfileList = 2, Sam = 3 };
+
+// Nom d'un SID bien connu ; false si le SID n'en fait pas partie
+bool WellKnownSidName(std::u16string_view sid, std::u16string& name);
+
+using SidAccountFn = std::function<void(std::u16string_view sid, std::u16string_view name)>;
+
+// ProfileList d'une ruche SOFTWARE : nom = dernier composant de ProfileImagePath.
+// Retourne le nombre de profils lus.
+size_t ReadProfileList(const RegfHive& software, const SidAccountFn& fn);
+
+// Comptes locaux d'une ruche SAM : nom = "hôte\compte". Retourne le nombre de comptes lus.
+size_t ReadSamAccounts(const RegfHive& sam, std::u16string_view host, const SidAccountFn& fn);
+
+class SidCache {
+public:
+    SidCache();
+    ~SidCache();
+    SidCache(const SidCache&) = delete;
+    SidCache& operator=(const SidCache&) = delete;
+
+    // Lecture sans verrou ; la vue reste valide pendant toute la vie du cache
+    bool Find(std::u16string_view sid, std::u16string_view& name) const;
+    // Écriture (mutex) ; ignorée si une entrée au moins aussi fiable existe déjà
+    void Insert(std::u16string_view sid, std::u16string_view name, SidOrigin origin);
+
+    // Bien connu, puis cache, sinon "<Inconnu>"
+    std::u16string Resolve(std::u16string_view sid) const;
+
+    // Charge SOFTWARE et SAM voisins de la ruche SYSTEM (même dossier config) ;
+    // retourne le nombre de comptes ajoutés ou mis à jour
+    size_t ImportHostHives(const std::filesystem::path& configDir, std::u16string_view host);
+    // Idem sur des ruches déjà ouvertes (image disque...) ; nullptr = ruche absente
+    size_t ImportHives(const RegfHive* software, const RegfHive* sam, std::u16string_view host);
+
+    bool Load(const std::filesystem::path& path);
+    // Écriture atomique (fichier temporaire puis renommage), SIDs triés
+    bool Save(const std::filesystem::path& path) const;
+    const std::string& LastError() const { return lastError; }
+
+    size_t Count() const { return count.load(std::memory_order_acquire); }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        const char16_t* sid;
+        const char16_t* name;
+        uint32_t sidLength;
+        uint32_t nameLength;
+        SidOrigin origin;
+    };
+
+    struct Table {
+        explicit Table(size_t capacity);
+        size_t mask;
+        std::unique_ptr<std::atomic<const Entry*>[]> slots;
+    };
+
+    const char16_t* Copy(std::u16string_view text);
+    static void Place(Table& table, const Entry* entry);
+
+    std::atomic<Table*> table;
+    std::vector<std::unique_ptr<Table>> tables;  // Anciennes tables conservées pour les lecteurs en cours
+    Arena arena;                                 // Entrées et chaînes, immuables
+    mutable std::mutex writeLock;
+    std::atomic<size_t> count{ 0 };
+    std::string lastError;
+};
@@ -0,0 +1,440 @@
+/*
+ * SnapshotIndex - Implémentation de la base mappée, du journal et de la compaction
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "SnapshotIndex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = { 'B', 'D', 'S', 'N', 'A', 'P', 1, 0 };
+constexpr size_t HEADER_SIZE = 64;
+constexpr size_t SLOT_SIZE = 24;
+constexpr uint32_t JOURNAL_MAGIC = 0x474C4442;  // "BDLG"
+constexpr size_t JOURNAL_HEADER = 16;           // magic, longueur, valeur
+constexpr size_t JOURNAL_MIN_COMPACT = 65536;   // Enregistrements avant compaction conseillée
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+constexpr uint32_t FNV32_OFFSET = 2166136261U;
+constexpr uint32_t FNV32_PRIME = 16777619U;
+
+constexpr char16_t KEY_SEPARATOR = u'\x01';
+
+uint64_t HashKey(std::u16string_view key) {
+    uint64_t hash = FNV_OFFSET;
+    for (char16_t c : key) {
+        hash = (hash ^ static_cast<uint16_t>(c)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t HashBytes(const uint8_t* data, size_t size) {
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+uint32_t Checksum32(const uint8_t* data, size_t size) {
+    uint32_t hash = FNV32_OFFSET;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * FNV32_PRIME;
+    }
+    return hash;
+}
+
+uint32_t Read32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t Read64(const uint8_t* p) {
+    return static_cast<uint64_t>(Read32(p)) | (static_cast<uint64_t>(Read32(p + 4)) << 32);
+}
+
+void Put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+void Put64(std::string& out, uint64_t value) {
+    Put32(out, static_cast<uint32_t>(value));
+    Put32(out, static_cast<uint32_t>(value >> 32));
+}
+
+void PutKey(std::string& out, std::u16string_view key) {
+    for (char16_t c : key) {
+        out.push_back(static_cast<char>(c & 0xFF));
+        out.push_back(static_cast<char>(c >> 8));
+    }
+}
+
+void AppendJournalRecord(std::string& out, std::u16string_view key, uint64_t value) {
+    size_t start = out.size();
+    Put32(out, JOURNAL_MAGIC);
+    Put32(out, static_cast<uint32_t>(key.size()));
+    Put64(out, value);
+    PutKey(out, key);
+    Put32(out, Checksum32(reinterpret_cast<const uint8_t*>(out.data()) + start, out.size() - start));
+}
+
+// Écriture puis synchronisation sur disque (le journal doit survivre à une coupure après Commit)
+bool WriteDurable(const fs::path& path, const std::string& data, bool append) {
+#ifdef _WIN32
+    FILE* file = _wfopen(path.c_str(), append ? L"ab" : L"wb");
+#else
+    FILE* file = std::fopen(path.c_str(), append ? "ab" : "wb");
+#endif
+    if (!file) return false;
+    bool ok = data.empty() || std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = std::fflush(file) == 0 && ok;
+#ifdef _WIN32
+    ok = _commit(_fileno(file)) == 0 && ok;
+#else
+    ok = fsync(fileno(file)) == 0 && ok;
+#endif
+    return std::fclose(file) == 0 && ok;
+}
+
+}  // namespace
+
+std::u16string SnapshotIndex::RowKey(std::u16string_view host, EntrySource source, std::u16string_view sid,
+                                     std::u16string_view path) {
+    std::u16string key;
+    key.reserve(host.size() + sid.size() + path.size() + 8);
+    key.push_back(u'V');
+    key += host;
+    key.push_back(KEY_SEPARATOR);
+    key += SourceName(source);
+    key.push_back(KEY_SEPARATOR);
+    key += sid;
+    key.push_back(KEY_SEPARATOR);
+    key += path;
+    return key;
+}
+
+std::u16string SnapshotIndex::SidKey(std::u16string_view host, EntrySource source, std::u16string_view sid) {
+    std::u16string key;
+    key.reserve(host.size() + sid.size() + 7);
+    key.push_back(u'K');
+    key += host;
+    key.push_back(KEY_SEPARATOR);
+    key += SourceName(source);
+    key.push_back(KEY_SEPARATOR);
+    key += sid;
+    return key;
+}
+
+bool SnapshotIndex::Open(const fs::path& path) {
+    Close();
+    basePath = path;
+    journalPath = path;
+    journalPath += ".log";
+    return OpenBase() && ReplayJournal();
+}
+
+void SnapshotIndex::Close() {
+    base.Close();
+    slots = nullptr;
+    keys = nullptr;
+    slotMask = 0;
+    baseCount = 0;
+    std::unique_lock<std::shared_mutex> guard(overlayLock);
+    overlay.clear();
+    pending.clear();
+    journalRecords = 0;
+}
+
+bool SnapshotIndex::OpenBase() {
+    std::error_code ec;
+    if (!fs::exists(basePath, ec)) return true;  // Première collecte : base vide
+
+    if (!base.Open(basePath)) {
+        lastError = "Base : " + base.LastError();
+        return false;
+    }
+    const uint8_t* data = base.data();
+    size_t size = base.size();
+    if (size < HEADER_SIZE || std::memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        lastError = "Base : signature invalide";
+        base.Close();
+        return false;
+    }
+    if (HashBytes(data, 48) != Read64(data + 48)) {
+        lastError = "Base : en-tête corrompu";
+        base.Close();
+        return false;
+    }
+
+    uint64_t entries = Read64(data + 8);
+    uint64_t slotCount = Read64(data + 16);
+    uint64_t slotsOffset = Read64(data + 24);
+    uint64_t keysOffset = Read64(data + 32);
+    uint64_t keysBytes = Read64(data + 40);
+    bool ok = slotCount != 0 && (slotCount & (slotCount - 1)) == 0 && entries < slotCount &&
+              slotsOffset >= HEADER_SIZE && slotCount <= (size - slotsOffset) / SLOT_SIZE &&
+              keysOffset >= slotsOffset + slotCount * SLOT_SIZE && keysOffset <= size && keysBytes <= size - keysOffset &&
+              keysBytes <= UINT32_MAX;
+    if (!ok) {
+        lastError = "Base : dimensions incohérentes";
+        base.Close();
+        return false;
+    }
+
+    slots = data + slotsOffset;
+    keys = data + keysOffset;
+    slotMask = slotCount - 1;
+    baseCount = static_cast<size_t>(entries);
+
+    // Les offsets de clés sont vérifiés une fois ici : les recherches n'ont plus de test de bornes,
+    // et un emplacement vide au moins garantit la fin des sondages
+    uint64_t used = 0;
+    for (uint64_t i = 0; i < slotCount; i++) {
+        const uint8_t* slot = slots + i * SLOT_SIZE;
+        uint64_t keyOffset = Read32(slot + 16);
+        uint64_t keyLength = Read32(slot + 20);
+        if (keyLength != 0 && (keyOffset + keyLength * 2 > keysBytes)) {
+            lastError = "Base : clé hors limites";
+            Close();
+            return false;
+        }
+        used += keyLength != 0;
+    }
+    if (used != entries) {
+        lastError = "Base : nombre d'entrées incohérent";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotIndex::ReplayJournal() {
+    std::error_code ec;
+    if (!fs::exists(journalPath, ec)) return true;
+
+    std::string data;
+    {
+        std::ifstream in(journalPath, std::ios::binary);
+        if (!in.is_open()) {
+            lastError = "Journal : ouverture impossible";
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data());
+    size_t offset = 0;
+    std::unique_lock<std::shared_mutex> guard(overlayLock);
+    while (data.size() - offset >= JOURNAL_HEADER + 4) {
+        const uint8_t* record = p + offset;
+        if (Read32(record) != JOURNAL_MAGIC) break;
+        size_t keyUnits = Read32(record + 4);
+        if (keyUnits > (data.size() - offset - JOURNAL_HEADER - 4) / 2) break;
+        size_t recordSize = JOURNAL_HEADER + keyUnits * 2;
+        if (Checksum32(record, recordSize) != Read32(record + recordSize)) break;
+
+        std::u16string key(keyUnits, u'\0');
+        for (size_t i = 0; i < keyUnits; i++) {
+            key[i] = static_cast<char16_t>(record[JOURNAL_HEADER + 2 * i] | (record[JOURNAL_HEADER + 2 * i + 1] << 8));
+        }
+        uint64_t value = Read64(record + 8);
+        auto [it, inserted] = overlay.try_emplace(std::move(key), value);
+        if (!inserted && it->second < value) it->second = value;
+        journalRecords++;
+        offset += recordSize + 4;
+    }
+
+    // Fin tronquée ou corrompue (arrêt pendant un Commit) : coupée pour que les ajouts suivants restent lisibles
+    if (offset != data.size()) {
+        fs::resize_file(journalPath, offset, ec);
+        if (ec) {
+            lastError = "Journal : troncature impossible";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SnapshotIndex::FindInBase(std::u16string_view key, uint64_t hash, uint64_t& value) const {
+    if (!slots) return false;
+    for (uint64_t i = hash & slotMask;; i = (i + 1) & slotMask) {
+        const uint8_t* slot = slots + i * SLOT_SIZE;
+        uint32_t keyLength = Read32(slot + 20);
+        if (keyLength == 0) return false;
+        if (Read64(slot) != hash || keyLength != key.size()) continue;
+        const uint8_t* stored = keys + Read32(slot + 16);
+        bool same = true;
+        for (size_t c = 0; c < key.size() && same; c++) {
+            same = static_cast<char16_t>(stored[2 * c] | (stored[2 * c + 1] << 8)) == key[c];
+        }
+        if (same) {
+            value = Read64(slot + 8);
+            return true;
+        }
+    }
+}
+
+bool SnapshotIndex::Find(std::u16string_view key, uint64_t& value) const {
+    uint64_t hash = HashKey(key);
+    {
+        std::shared_lock<std::shared_mutex> guard(overlayLock);
+        auto it = overlay.find(std::u16string(key));
+        if (it != overlay.end()) {
+            value = it->second;
+            return true;
+        }
+    }
+    return FindInBase(key, hash, value);
+}
+
+bool SnapshotIndex::Advance(std::u16string_view key, uint64_t value) {
+    uint64_t known = 0;
+    if (Find(key, known) && known >= value) return false;
+
+    std::unique_lock<std::shared_mutex> guard(overlayLock);
+    auto [it, inserted] = overlay.try_emplace(std::u16string(key), value);
+    if (!inserted) {
+        if (it->second >= value) return false;  // Avancée concurrente
+        it->second = value;
+    }
+    pending.push_back(it->first);
+    return true;
+}
+
+bool SnapshotIndex::Commit() {
+    std::string data;
+    {
+        std::shared_lock<std::shared_mutex> guard(overlayLock);
+        if (pending.empty()) return true;
+        for (const auto& key : pending) {
+            AppendJournalRecord(data, key, overlay.find(key)->second);
+        }
+    }
+    if (!WriteDurable(journalPath, data, true)) {
+        lastError = "Journal : écriture impossible";
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> guard(overlayLock);
+    journalRecords += pending.size();
+    pending.clear();
+    return true;
+}
+
+bool SnapshotIndex::NeedsCompaction() const {
+    return journalRecords >= std::max(JOURNAL_MIN_COMPACT, baseCount / 2);
+}
+
+bool SnapshotIndex::Compact() {
+    if (!Commit()) return false;
+
+    // Fusion base + surcouche : la surcouche contient toujours la valeur la plus récente
+    std::vector<std::pair<std::u16string, uint64_t>> entries;
+    {
+        std::shared_lock<std::shared_mutex> guard(overlayLock);
+        entries.reserve(baseCount + overlay.size());
+        for (uint64_t i = 0; slots && i <= slotMask; i++) {
+            const uint8_t* slot = slots + i * SLOT_SIZE;
+            uint32_t keyLength = Read32(slot + 20);
+            if (keyLength == 0) continue;
+            const uint8_t* stored = keys + Read32(slot + 16);
+            std::u16string key(keyLength, u'\0');
+            for (size_t c = 0; c < keyLength; c++) {
+                key[c] = static_cast<char16_t>(stored[2 * c] | (stored[2 * c + 1] << 8));
+            }
+            if (overlay.count(key)) continue;
+            entries.emplace_back(std::move(key), Read64(slot + 8));
+        }
+        for (const auto& [key, value] : overlay) {
+            entries.emplace_back(key, value);
+        }
+    }
+
+    uint64_t slotCount = 16;
+    while (slotCount < entries.size() * 2) slotCount <<= 1;
+    std::vector<uint8_t> table(slotCount * SLOT_SIZE, 0);
+    std::string keyBlob;
+    for (const auto& [key, value] : entries) {
+        if (keyBlob.size() + key.size() * 2 > UINT32_MAX) {
+            lastError = "Compaction : clés trop volumineuses";
+            return false;
+        }
+        uint64_t hash = HashKey(key);
+        uint64_t i = hash & (slotCount - 1);
+        while (Read32(&table[i * SLOT_SIZE + 20]) != 0) i = (i + 1) & (slotCount - 1);
+        std::string slot;
+        Put64(slot, hash);
+        Put64(slot, value);
+        Put32(slot, static_cast<uint32_t>(keyBlob.size()));
+        Put32(slot, static_cast<uint32_t>(key.size()));
+        std::memcpy(&table[i * SLOT_SIZE], slot.data(), SLOT_SIZE);
+        PutKey(keyBlob, key);
+    }
+
+    std::string file(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    Put64(file, entries.size());
+    Put64(file, slotCount);
+    Put64(file, HEADER_SIZE);
+    Put64(file, HEADER_SIZE + slotCount * SLOT_SIZE);
+    Put64(file, keyBlob.size());
+    Put64(file, HashBytes(reinterpret_cast<const uint8_t*>(file.data()), 48));
+    Put64(file, 0);
+    file.append(reinterpret_cast<const char*>(table.data()), table.size());
+    file += keyBlob;
+
+    // Nouvelle base complète et synchronisée avant le renommage : un arrêt laisse l'ancienne intacte
+    fs::path temp = basePath;
+    temp += ".tmp";
+    if (!WriteDurable(temp, file, false)) {
+        lastError = "Compaction : écriture impossible";
+        return false;
+    }
+    base.Close();  // Windows : pas de renommage sur un fichier projeté
+    slots = nullptr;
+    keys = nullptr;
+    std::error_code ec;
+    fs::rename(temp, basePath, ec);
+    if (ec) {
+        lastError = "Compaction : renommage impossible";
+        Open(basePath);
+        return false;
+    }
+    // Le journal est maintenant inclus dans la base ; s'il survit à un arrêt ici, le rejouer est sans effet
+    if (!WriteDurable(journalPath, std::string(), false)) {
+        lastError = "Compaction : remise à zéro du journal impossible";
+        return false;
+    }
+    return Open(basePath);
+}
+
+bool SnapshotFilter::VisitSidKey(EntrySource keySource, std::u16string_view sid, uint64_t lastWrite) {
+    source = keySource;
+    // Date absente : la clé ne peut pas être comparée, ses valeurs sont filtrées une à une
+    if (lastWrite == 0) return true;
+    if (index.Advance(SnapshotIndex::SidKey(host, keySource, sid), lastWrite)) return true;
+    skippedKeys++;
+    return false;
+}
+
+bool SnapshotFilter::KeepRow(std::u16string_view sid, std::u16string_view path, uint64_t fileTime) {
+    if (index.Advance(SnapshotIndex::RowKey(host, source, sid, path), fileTime)) return true;
+    skippedRows++;
+    return false;
+}
@@ -0,0 +1,113 @@
+/*
+ * SnapshotIndex - Index persistant des collectes précédentes, pour une collecte incrémentale
+ *
+ * - Clé (hôte, service, SID, chemin) → dernier FILETIME émis ; clé (hôte, service, SID) → dernière
+ *   écriture de la clé SID : une clé SID inchangée est sautée sans lire ses valeurs
+ * - Base : table de hachage à adressage ouvert mappée en mémoire, lue sans copie ni parsing
+ * - Journal : enregistrements ajoutés en fin de fichier avec somme de contrôle, écrits par Commit()
+ *   une fois la sortie de la collecte écrite ; un enregistrement tronqué (arrêt brutal) est
+ *   ignoré et coupé à l'ouverture. Les valeurs ne font qu'augmenter (max), rejouer un journal
+ *   déjà fusionné est donc sans effet.
+ * - Compact() : base + journal réécrits dans un fichier temporaire, puis renommage atomique
+ *
+ * Format de la base (little-endian) :
+ *   En-tête (64 octets) : "BDSNAP\x01\0" | u64 entrées | u64 emplacements (puissance de 2)
+ *                         | u64 offset emplacements | u64 offset clés | u64 octets de clés
+ *                         | u64 somme FNV-1a des 48 octets précédents | u64 réservé
+ *   Emplacement (24 octets) : u64 hachage | u64 valeur | u32 offset clé | u32 longueur (0 = vide)
+ *   Clés : UTF-16LE concaténées
+ * Journal ("<base>.log") : u32 "BDLG" | u32 longueur clé | u64 valeur | clé UTF-16LE | u32 FNV-1a
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "BamDamHive.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class SnapshotIndex {
+public:
+    SnapshotIndex() = default;
+    SnapshotIndex(const SnapshotIndex&) = delete;
+    SnapshotIndex& operator=(const SnapshotIndex&) = delete;
+
+    // Ouvre (ou crée) la base et rejoue le journal
+    bool Open(const std::filesystem::path& path);
+    void Close();
+    const std::string& LastError() const { return lastError; }
+
+    static std::u16string RowKey(std::u16string_view host, EntrySource source, std::u16string_view sid,
+                                 std::u16string_view path);
+    static std::u16string SidKey(std::u16string_view host, EntrySource source, std::u16string_view sid);
+
+    bool Find(std::u16string_view key, uint64_t& value) const;
+    // Enregistre value si la clé est absente ou plus ancienne ; true dans ce cas. Thread-safe.
+    bool Advance(std::u16string_view key, uint64_t value);
+
+    // Ajoute au journal (et synchronise sur disque) les avancées depuis le dernier Commit
+    bool Commit();
+    // Journal volumineux par rapport à la base : Compact() conseillé
+    bool NeedsCompaction() const;
+    bool Compact();
+
+    size_t BaseCount() const { return baseCount; }
+    size_t JournalRecords() const { return journalRecords; }
+    size_t PendingRecords() const { return pending.size(); }
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint64_t value;
+        uint32_t keyOffset;
+        uint32_t keyLength;
+    };
+
+    bool OpenBase();
+    bool ReplayJournal();
+    bool FindInBase(std::u16string_view key, uint64_t hash, uint64_t& value) const;
+
+    std::filesystem::path basePath;
+    std::filesystem::path journalPath;
+    MappedFile base;
+    const uint8_t* slots = nullptr;
+    const uint8_t* keys = nullptr;
+    uint64_t slotMask = 0;
+    size_t baseCount = 0;
+
+    // Valeurs plus récentes que la base (journal rejoué + collecte en cours)
+    mutable std::shared_mutex overlayLock;
+    std::unordered_map<std::u16string, uint64_t> overlay;
+    std::vector<std::u16string> pending;  // Clés avancées depuis le dernier Commit
+    size_t journalRecords = 0;
+    std::string lastError;
+};
+
+// Filtre incrémental d'une ruche : émet les exécutables nouveaux et les FILETIME qui avancent
+class SnapshotFilter : public BamDamFilter {
+public:
+    SnapshotFilter(SnapshotIndex& index, std::u16string_view host) : index(index), host(host) {}
+
+    bool VisitSidKey(EntrySource source, std::u16string_view sid, uint64_t lastWrite) override;
+    bool KeepRow(std::u16string_view sid, std::u16string_view path, uint64_t fileTime) override;
+
+    size_t SkippedKeys() const { return skippedKeys; }
+    size_t SkippedRows() const { return skippedRows; }
+
+private:
+    SnapshotIndex& index;
+    std::u16string host;
+    EntrySource source = EntrySource::Bam;  // Clé SID en cours
+    size_t skippedKeys = 0;
+    size_t skippedRows = 0;
+};
@@ -0,0 +1,633 @@
+/*
+ * Telemetry - Implémentation du journal asynchrone et des compteurs
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "Telemetry.h"
+
+#include "FileTimeFormat.h"
+
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+constexpr size_t TELEMETRY_SHARDS = 16;
+constexpr uint64_t UNIX_EPOCH_FILETIME = 116444736000000000ULL;
+
+// Un shard par groupe de threads : les workers n'écrivent pas dans la même ligne de cache
+struct alignas(64) TelemetryShard {
+    std::atomic<uint64_t> calls[TELEMETRY_SPAN_COUNT];
+    std::atomic<uint64_t> items[TELEMETRY_SPAN_COUNT];
+    std::atomic<uint64_t> totalNs[TELEMETRY_SPAN_COUNT];
+    std::atomic<uint64_t> maxNs[TELEMETRY_SPAN_COUNT];
+    std::atomic<uint64_t> buckets[TELEMETRY_SPAN_COUNT][TELEMETRY_BUCKETS];
+    std::atomic<uint64_t> counters[TELEMETRY_COUNTER_COUNT];
+};
+
+TelemetryShard shards[TELEMETRY_SHARDS];
+const auto processStart = std::chrono::steady_clock::now();
+
+TelemetryShard& LocalShard() {
+    static std::atomic<uint32_t> nextThread{ 0 };
+    thread_local const uint32_t slot = nextThread.fetch_add(1, std::memory_order_relaxed) % TELEMETRY_SHARDS;
+    return shards[slot];
+}
+
+size_t BucketOf(uint64_t nanoseconds) {
+    size_t k = 0;
+    for (uint64_t x = nanoseconds >> 10; x; x >>= 1) k++;
+    return k < TELEMETRY_BUCKETS ? k : TELEMETRY_BUCKETS - 1;
+}
+
+const char* const SPAN_NAMES[] = {
+    "hive_open", "log_replay", "key_enumeration", "value_decode", "sid_resolution", "export_serialize",
+    "export_write", "timeline_spill", "timeline_merge", "hive_carve", "ingest_read", "ingest_parse", "ingest_enrich",
+    "ingest_export", "ingest_latency", "row_sort",
+};
+static_assert(sizeof(SPAN_NAMES) / sizeof(SPAN_NAMES[0]) == TELEMETRY_SPAN_COUNT, "noms d'étapes");
+
+const char* const COUNTER_NAMES[] = {
+    "hive_open_errors", "invalid_values", "log_records", "log_dropped", "ingest_hives", "ingest_duplicates",
+    "ingest_failures", "ingest_rescans",
+};
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == TELEMETRY_COUNTER_COUNT, "noms de compteurs");
+
+const char* const GAUGE_NAMES[] = { "ingest_queue_depth", "ingest_in_flight", "export_queue_depth" };
+static_assert(sizeof(GAUGE_NAMES) / sizeof(GAUGE_NAMES[0]) == TELEMETRY_GAUGE_COUNT, "noms de jauges");
+
+// Jauges : une seule valeur courante, écrite rarement (pas de shard)
+std::atomic<int64_t> gauges[TELEMETRY_GAUGE_COUNT];
+
+const double QUANTILES[] = { 0.5, 0.9, 0.99 };
+const char* const QUANTILE_NAMES[] = { "p50", "p90", "p99" };
+
+void AppendUnsigned(std::string& out, uint64_t value) {
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value));
+    out.append(buf, static_cast<size_t>(n));
+}
+
+void AppendDouble(std::string& out, double value) {
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.6g", value);
+    out.append(buf, static_cast<size_t>(n));
+}
+
+FILE* OpenAppend(const std::filesystem::path& path, bool append) {
+#ifdef _WIN32
+    return _wfopen(path.c_str(), append ? L"ab" : L"wb");
+#else
+    return std::fopen(path.c_str(), append ? "ab" : "wb");
+#endif
+}
+
+// Heure locale = UTC + offset (minutes), différence des champs localtime / gmtime
+int32_t LocalOffsetMinutes(std::time_t when) {
+    std::tm local = {};
+    std::tm utc = {};
+#ifdef _WIN32
+    localtime_s(&local, &when);
+    gmtime_s(&utc, &when);
+#else
+    localtime_r(&when, &local);
+    gmtime_r(&when, &utc);
+#endif
+    int32_t days = local.tm_yday - utc.tm_yday;
+    if (local.tm_year != utc.tm_year) days = local.tm_year > utc.tm_year ? 1 : -1;
+    return days * 1440 + (local.tm_hour - utc.tm_hour) * 60 + (local.tm_min - utc.tm_min);
+}
+
+// UTF-16 → UTF-8 borné, sans couper une séquence ; retourne le nombre d'octets écrits
+size_t EncodeUtf8(std::u16string_view text, char* out, size_t capacity, bool& truncated) {
+    size_t n = 0;
+    truncated = false;
+    for (size_t i = 0; i < text.size(); i++) {
+        uint32_t c = text[i];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (text[++i] - 0xDC00);
+        } else if (c >= 0xD800 && c <= 0xDFFF) {
+            c = 0xFFFD;
+        }
+        const size_t need = c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+        if (n + need > capacity) {
+            truncated = true;
+            break;
+        }
+        if (need == 1) {
+            out[n++] = static_cast<char>(c);
+        } else if (need == 2) {
+            out[n++] = static_cast<char>(0xC0 | (c >> 6));
+            out[n++] = static_cast<char>(0x80 | (c & 0x3F));
+        } else if (need == 3) {
+            out[n++] = static_cast<char>(0xE0 | (c >> 12));
+            out[n++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out[n++] = static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            out[n++] = static_cast<char>(0xF0 | (c >> 18));
+            out[n++] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out[n++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out[n++] = static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return n;
+}
+
+}  // namespace
+
+std::atomic<bool> Telemetry::enabledFlag{ true };
+
+const char* TelemetrySpanName(TelemetrySpan span) {
+    return span < TelemetrySpan::Count ? SPAN_NAMES[static_cast<size_t>(span)] : "?";
+}
+
+const char* TelemetryCounterName(TelemetryCounter counter) {
+    return counter < TelemetryCounter::Count ? COUNTER_NAMES[static_cast<size_t>(counter)] : "?";
+}
+
+const char* TelemetryGaugeName(TelemetryGauge gauge) {
+    return gauge < TelemetryGauge::Count ? GAUGE_NAMES[static_cast<size_t>(gauge)] : "?";
+}
+
+double TelemetryQuantileNs(const TelemetrySpanStats& stats, double q) {
+    if (stats.calls == 0) return 0;
+    const double rank = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(stats.calls);
+    uint64_t below = 0;
+    for (size_t b = 0; b < TELEMETRY_BUCKETS; b++) {
+        if (stats.buckets[b] == 0 || static_cast<double>(below + stats.buckets[b]) < rank) {
+            below += stats.buckets[b];
+            continue;
+        }
+        // Seau b : [2^(b + 9), 2^(b + 10)) ns, [0, 1024) pour le premier ; le dernier s'arrête à maxNs
+        const double low = b ? static_cast<double>(1ULL << (b + 9)) : 0.0;
+        double high = static_cast<double>(1ULL << (b + 10));
+        if (b + 1 == TELEMETRY_BUCKETS || high > static_cast<double>(stats.maxNs)) {
+            high = std::max(low, static_cast<double>(stats.maxNs));
+        }
+        return low + (high - low) * (rank - static_cast<double>(below)) / static_cast<double>(stats.buckets[b]);
+    }
+    return static_cast<double>(stats.maxNs);
+}
+
+void Telemetry::SetGauge(TelemetryGauge gauge, int64_t value) {
+    gauges[static_cast<size_t>(gauge)].store(value, std::memory_order_relaxed);
+}
+
+void Telemetry::Add(TelemetryCounter counter, uint64_t n) {
+    if (!Enabled()) return;
+    LocalShard().counters[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+}
+
+void Telemetry::Record(TelemetrySpan span, uint64_t nanoseconds, uint64_t items) {
+    const size_t s = static_cast<size_t>(span);
+    TelemetryShard& shard = LocalShard();
+    shard.calls[s].fetch_add(1, std::memory_order_relaxed);
+    shard.items[s].fetch_add(items, std::memory_order_relaxed);
+    shard.totalNs[s].fetch_add(nanoseconds, std::memory_order_relaxed);
+    shard.buckets[s][BucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = shard.maxNs[s].load(std::memory_order_relaxed);
+    while (nanoseconds > max &&
+           !shard.maxNs[s].compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+TelemetrySnapshot Telemetry::Capture() {
+    TelemetrySnapshot snapshot;
+    for (const TelemetryShard& shard : shards) {
+        for (size_t s = 0; s < TELEMETRY_SPAN_COUNT; s++) {
+            TelemetrySpanStats& stats = snapshot.spans[s];
+            stats.calls += shard.calls[s].load(std::memory_order_relaxed);
+            stats.items += shard.items[s].load(std::memory_order_relaxed);
+            stats.totalNs += shard.totalNs[s].load(std::memory_order_relaxed);
+            stats.maxNs = std::max(stats.maxNs, shard.maxNs[s].load(std::memory_order_relaxed));
+            for (size_t b = 0; b < TELEMETRY_BUCKETS; b++) {
+                stats.buckets[b] += shard.buckets[s][b].load(std::memory_order_relaxed);
+            }
+        }
+        for (size_t c = 0; c < TELEMETRY_COUNTER_COUNT; c++) {
+            snapshot.counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+        }
+    }
+    for (size_t g = 0; g < TELEMETRY_GAUGE_COUNT; g++) {
+        snapshot.gauges[g] = gauges[g].load(std::memory_order_relaxed);
+    }
+    snapshot.uptimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - processStart).count();
+    return snapshot;
+}
+
+void Telemetry::Reset() {
+    for (TelemetryShard& shard : shards) {
+        for (size_t s = 0; s < TELEMETRY_SPAN_COUNT; s++) {
+            shard.calls[s].store(0, std::memory_order_relaxed);
+            shard.items[s].store(0, std::memory_order_relaxed);
+            shard.totalNs[s].store(0, std::memory_order_relaxed);
+            shard.maxNs[s].store(0, std::memory_order_relaxed);
+            for (auto& bucket : shard.buckets[s]) bucket.store(0, std::memory_order_relaxed);
+        }
+        for (auto& counter : shard.counters) counter.store(0, std::memory_order_relaxed);
+    }
+    for (auto& gauge : gauges) gauge.store(0, std::memory_order_relaxed);
+}
+
+// {"uptime_s":..,"spans":[{"name":..,"calls":..,"items":..,"total_ms":..,"mean_us":..,"max_ms":..,
+//   "p50_ms":..,"p90_ms":..,"p99_ms":..,"buckets":[n0..n23]}],"counters":{..},"gauges":{..}} ;
+//   buckets[k] = durées < 2^(k+10) ns (non cumulés)
+std::string Telemetry::ToJson(const TelemetrySnapshot& snapshot) {
+    std::string out = "{\"uptime_s\":";
+    AppendDouble(out, snapshot.uptimeSeconds);
+    out += ",\"spans\":[";
+    for (size_t s = 0; s < TELEMETRY_SPAN_COUNT; s++) {
+        const TelemetrySpanStats& stats = snapshot.spans[s];
+        if (s) out += ',';
+        out += "{\"name\":\"";
+        out += SPAN_NAMES[s];
+        out += "\",\"calls\":";
+        AppendUnsigned(out, stats.calls);
+        out += ",\"items\":";
+        AppendUnsigned(out, stats.items);
+        out += ",\"total_ms\":";
+        AppendDouble(out, stats.totalNs / 1e6);
+        out += ",\"mean_us\":";
+        AppendDouble(out, stats.calls ? stats.totalNs / 1e3 / stats.calls : 0.0);
+        out += ",\"max_ms\":";
+        AppendDouble(out, stats.maxNs / 1e6);
+        for (size_t q = 0; q < 3; q++) {
+            out += ",\"";
+            out += QUANTILE_NAMES[q];
+            out += "_ms\":";
+            AppendDouble(out, TelemetryQuantileNs(stats, QUANTILES[q]) / 1e6);
+        }
+        out += ",\"buckets\":[";
+        for (size_t b = 0; b < TELEMETRY_BUCKETS; b++) {
+            if (b) out += ',';
+            AppendUnsigned(out, stats.buckets[b]);
+        }
+        out += "]}";
+    }
+    out += "],\"counters\":{";
+    for (size_t c = 0; c < TELEMETRY_COUNTER_COUNT; c++) {
+        if (c) out += ',';
+        out += '"';
+        out += COUNTER_NAMES[c];
+        out += "\":";
+        AppendUnsigned(out, snapshot.counters[c]);
+    }
+    out += "},\"gauges\":{";
+    for (size_t g = 0; g < TELEMETRY_GAUGE_COUNT; g++) {
+        if (g) out += ',';
+        out += '"';
+        out += GAUGE_NAMES[g];
+        out += "\":";
+        AppendDouble(out, static_cast<double>(snapshot.gauges[g]));
+    }
+    out += "}}\n";
+    return out;
+}
+
+std::string Telemetry::ToPrometheus(const TelemetrySnapshot& snapshot) {
+    std::string out;
+    out += "# HELP bamdam_span_seconds Durée des étapes instrumentées (inclusives)\n";
+    out += "# TYPE bamdam_span_seconds histogram\n";
+    for (size_t s = 0; s < TELEMETRY_SPAN_COUNT; s++) {
+        const TelemetrySpanStats& stats = snapshot.spans[s];
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b + 1 < TELEMETRY_BUCKETS; b++) {
+            cumulative += stats.buckets[b];
+            out += "bamdam_span_seconds_bucket{span=\"";
+            out += SPAN_NAMES[s];
+            out += "\",le=\"";
+            AppendDouble(out, static_cast<double>(1ULL << (b + 10)) / 1e9);
+            out += "\"} ";
+            AppendUnsigned(out, cumulative);
+            out += '\n';
+        }
+        out += "bamdam_span_seconds_bucket{span=\"";
+        out += SPAN_NAMES[s];
+        out += "\",le=\"+Inf\"} ";
+        AppendUnsigned(out, stats.calls);
+        out += "\nbamdam_span_seconds_sum{span=\"";
+        out += SPAN_NAMES[s];
+        out += "\"} ";
+        AppendDouble(out, stats.totalNs / 1e9);
+        out += "\nbamdam_span_seconds_count{span=\"";
+        out += SPAN_NAMES[s];
+        out += "\"} ";
+        AppendUnsigned(out, stats.calls);
+        out += '\n';
+    }
+
+    out += "# HELP bamdam_span_items_total Éléments traités par étape (octets, clés, valeurs, lignes)\n";
+    out += "# TYPE bamdam_span_items_total counter\n";
+    for (size_t s = 0; s < TELEMETRY_SPAN_COUNT; s++) {
+        out += "bamdam_span_items_total{span=\"";
+        out += SPAN_NAMES[s];
+        out += "\"} ";
+        AppendUnsigned(out, snapshot.spans[s].items);
+        out += '\n';
+    }
+
+    out += "# HELP bamdam_span_max_seconds Plus longue exécution de chaque étape\n";
+    out += "# TYPE bamdam_span_max_seconds gauge\n";
+    for (size_t s = 0; s < TELEMETRY_SPAN_COUNT; s++) {
+        out += "bamdam_span_max_seconds{span=\"";
+        out += SPAN_NAMES[s];
+        out += "\"} ";
+        AppendDouble(out, snapshot.spans[s].maxNs / 1e9);
+        out += '\n';
+    }
+
+    out += "# HELP bamdam_span_quantile_seconds Quantiles des durées, interpolés dans les seaux\n";
+    out += "# TYPE bamdam_span_quantile_seconds gauge\n";
+    for (size_t s = 0; s < TELEMETRY_SPAN_COUNT; s++) {
+        for (size_t q = 0; q < 3; q++) {
+            out += "bamdam_span_quantile_seconds{span=\"";
+            out += SPAN_NAMES[s];
+            out += "\",quantile=\"";
+            AppendDouble(out, QUANTILES[q]);
+            out += "\"} ";
+            AppendDouble(out, TelemetryQuantileNs(snapshot.spans[s], QUANTILES[q]) / 1e9);
+            out += '\n';
+        }
+    }
+
+    for (size_t c = 0; c < TELEMETRY_COUNTER_COUNT; c++) {
+        out += "# TYPE bamdam_";
+        out += COUNTER_NAMES[c];
+        out += "_total counter\nbamdam_";
+        out += COUNTER_NAMES[c];
+        out += "_total ";
+        AppendUnsigned(out, snapshot.counters[c]);
+        out += '\n';
+    }
+    for (size_t g = 0; g < TELEMETRY_GAUGE_COUNT; g++) {
+        out += "# TYPE bamdam_";
+        out += GAUGE_NAMES[g];
+        out += " gauge\nbamdam_";
+        out += GAUGE_NAMES[g];
+        out += ' ';
+        AppendDouble(out, static_cast<double>(snapshot.gauges[g]));
+        out += '\n';
+    }
+    out += "# TYPE bamdam_uptime_seconds gauge\nbamdam_uptime_seconds ";
+    AppendDouble(out, snapshot.uptimeSeconds);
+    out += '\n';
+    return out;
+}
+
+bool Telemetry::WriteFile(const std::filesystem::path& path, std::string& error) {
+    const std::string ext = path.extension().u8string();
+    const TelemetrySnapshot snapshot = Capture();
+    const std::string text = ext == ".prom" || ext == ".txt" ? ToPrometheus(snapshot) : ToJson(snapshot);
+
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    FILE* file = OpenAppend(temp, false);
+    if (!file) {
+        error = "Impossible de créer " + temp.u8string();
+        return false;
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = std::fclose(file) == 0 && ok;
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temp, path, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(temp, ec);
+        error = "Écriture impossible : " + path.u8string();
+        return false;
+    }
+    return true;
+}
+
+AsyncLogger::AsyncLogger(size_t capacity) {
+    size_t slots = 2;
+    while (slots < capacity) slots <<= 1;
+    ring.reset(new Record[slots]);
+    mask = slots - 1;
+    for (size_t i = 0; i < slots; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool AsyncLogger::Open(const std::filesystem::path& path, FILE* console) {
+    if (open) Close();
+    file = OpenAppend(path, true);
+    if (!file) {
+        lastError = "Impossible d'ouvrir le journal " + path.u8string();
+        return false;
+    }
+    stream = console;
+    return Start();
+}
+
+bool AsyncLogger::Open(FILE* console) {
+    if (open) Close();
+    stream = console;
+    return Start();
+}
+
+bool AsyncLogger::Start() {
+    stopping.store(false);
+    drainer = std::thread(&AsyncLogger::DrainMain, this);
+    open = true;
+    return true;
+}
+
+// File bornée de Vyukov : sequence == position → libre, position + 1 → publié
+AsyncLogger::Record* AsyncLogger::Claim() {
+    uint64_t position = head.load(std::memory_order_relaxed);
+    while (true) {
+        Record& record = ring[position & mask];
+        const uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+        const int64_t diff = static_cast<int64_t>(sequence - position);
+        if (diff == 0) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return &record;
+        } else if (diff < 0) {
+            return nullptr;  // Plein
+        } else {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Anneau plein : information perdue (comptée), avertissement ou erreur attendu jusqu'à ce que le thread
+// de vidage libère une place ; une ruche en échec ne disparaît jamais du journal
+AsyncLogger::Record* AsyncLogger::Reserve(LogLevel level) {
+    Record* record = Claim();
+    while (!record && level != LogLevel::Info && !stopping.load(std::memory_order_relaxed)) {
+        {
+            std::unique_lock<std::mutex> guard(wakeLock);
+            wake.notify_one();
+            drainedChanged.wait_for(guard, std::chrono::milliseconds(10));
+        }
+        record = Claim();
+    }
+    if (!record) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        Telemetry::Add(TelemetryCounter::LogDropped);
+    }
+    return record;
+}
+
+void AsyncLogger::Publish(Record* record) {
+    record->sequence.store(record->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    // Réveil seulement si le thread de vidage s'est endormi (il revérifie l'anneau après l'annonce)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+        std::lock_guard<std::mutex> guard(wakeLock);
+        wake.notify_one();
+    }
+}
+
+namespace {
+
+uint64_t NowFileTime() {
+    const auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+    return UNIX_EPOCH_FILETIME +
+           static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count()) * 10;
+}
+
+}  // namespace
+
+bool AsyncLogger::Log(LogLevel level, std::string_view utf8) {
+    if (!open || stopping.load(std::memory_order_relaxed)) return false;
+    Record* record = Reserve(level);
+    if (!record) return false;
+    size_t length = std::min(utf8.size(), RECORD_TEXT);
+    record->truncated = length < utf8.size();
+    if (record->truncated) {
+        while (length > 0 && (static_cast<uint8_t>(utf8[length]) & 0xC0) == 0x80) length--;
+    }
+    std::memcpy(record->text, utf8.data(), length);
+    record->length = static_cast<uint16_t>(length);
+    record->level = level;
+    record->fileTime = NowFileTime();
+    Publish(record);
+    Telemetry::Add(TelemetryCounter::LogRecords);
+    return true;
+}
+
+bool AsyncLogger::Log(LogLevel level, std::u16string_view text) {
+    if (!open || stopping.load(std::memory_order_relaxed)) return false;
+    Record* record = Reserve(level);
+    if (!record) return false;
+    record->length = static_cast<uint16_t>(EncodeUtf8(text, record->text, RECORD_TEXT, record->truncated));
+    record->level = level;
+    record->fileTime = NowFileTime();
+    Publish(record);
+    Telemetry::Add(TelemetryCounter::LogRecords);
+    return true;
+}
+
+void AsyncLogger::Format(const Record& record, std::string& fileOut, std::string& streamOut, int32_t& offsetMinutes,
+                         int64_t& offsetMinute) {
+    const std::string_view text(record.text, record.length);
+    const char* suffix = record.truncated ? " [...]\n" : "\n";
+    if (stream) {
+        streamOut += text;
+        streamOut += suffix;
+    }
+    if (!file) return;
+
+    // Décalage local recalculé au plus une fois par minute (changement d'heure)
+    const int64_t minute = static_cast<int64_t>((record.fileTime - UNIX_EPOCH_FILETIME) / FILETIME_TICKS_PER_MINUTE);
+    if (minute != offsetMinute) {
+        offsetMinute = minute;
+        offsetMinutes = LocalOffsetMinutes(static_cast<std::time_t>(minute * 60));
+    }
+    TimeFormat format;
+    format.precision = TimePrecision::Milliseconds;
+    format.offsetMinutes = offsetMinutes;
+    char stamp[FILETIME_TEXT_MAX];
+    const size_t stampLength = FormatFileTime(record.fileTime, format, stamp);
+
+    fileOut += '[';
+    fileOut.append(stamp, stampLength);
+    fileOut += "] ";
+    if (record.level == LogLevel::Warning) fileOut += "ATTENTION : ";
+    else if (record.level == LogLevel::Error) fileOut += "ERREUR : ";
+    fileOut += text;
+    fileOut += suffix;
+}
+
+void AsyncLogger::DrainMain() {
+    std::string fileOut;
+    std::string streamOut;
+    int32_t offsetMinutes = 0;
+    int64_t offsetMinute = -1;
+
+    while (true) {
+        const bool stop = stopping.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (true) {
+            Record& record = ring[tail & mask];
+            if (record.sequence.load(std::memory_order_acquire) != tail + 1) break;
+            Format(record, fileOut, streamOut, offsetMinutes, offsetMinute);
+            record.sequence.store(tail + mask + 1, std::memory_order_release);
+            tail++;
+            count++;
+            if (fileOut.size() + streamOut.size() >= (64u << 10)) break;
+        }
+
+        // Une écriture par lot, pas par ligne
+        if (!fileOut.empty()) {
+            std::fwrite(fileOut.data(), 1, fileOut.size(), file);
+            std::fflush(file);
+            fileOut.clear();
+        }
+        if (!streamOut.empty()) {
+            std::fwrite(streamOut.data(), 1, streamOut.size(), stream);
+            std::fflush(stream);
+            streamOut.clear();
+        }
+        if (count) {
+            std::lock_guard<std::mutex> guard(wakeLock);
+            drained.store(tail, std::memory_order_release);
+            drainedChanged.notify_all();
+            continue;
+        }
+
+        // Anneau vide : arrêt demandé et aucune réservation en cours de publication
+        if (stop && head.load(std::memory_order_acquire) == tail) break;
+
+        std::unique_lock<std::mutex> guard(wakeLock);
+        sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring[tail & mask].sequence.load(std::memory_order_acquire) == tail + 1 ||
+            stopping.load(std::memory_order_acquire)) {
+            sleeping.store(false);
+            if (stop) {
+                guard.unlock();
+                std::this_thread::yield();  // Un producteur termine sa publication
+            }
+            continue;
+        }
+        wake.wait_for(guard, std::chrono::seconds(1));
+        sleeping.store(false);
+    }
+}
+
+void AsyncLogger::Flush() {
+    if (!open) return;
+    const uint64_t target = head.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> guard(wakeLock);
+    wake.notify_one();
+    drainedChanged.wait(guard, [&] { return drained.load(std::memory_order_acquire) >= target; });
+}
+
+void AsyncLogger::Close() {
+    if (!open) return;
+    {
+        std::lock_guard<std::mutex> guard(wakeLock);
+        stopping.store(true, std::memory_order_release);
+        wake.notify_one();
+    }
+    drainer.join();
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    stream = nullptr;
+    open = false;
+}
@@ -0,0 +1,226 @@
+/*
+ * Telemetry - Journal asynchrone et instrumentation des étapes chaudes
+ *
+ * - AsyncLogger : anneau borné sans verrou (multi-producteurs, un consommateur) d'enregistrements
+ *   binaires de taille fixe (FILETIME, niveau, texte UTF-8) ; le thread appelant ne fait
+ *   qu'une copie, l'horodatage texte et les écritures disque se font sur un thread de vidage.
+ *   Anneau plein : une information est comptée comme perdue (Dropped), sans attente ; un avertissement
+ *   ou une erreur attend une place, il n'est jamais perdu.
+ * - Compteurs et étapes chronométrées (ScopedSpan) : ouverture de ruche, rejeu des journaux,
+ *   énumération des clés SID, décodage des valeurs, résolution SID, sérialisation et écriture
+ *   de l'export, déversement et fusion de la chronologie. Accumulés par shard de thread (atomiques
+ *   relâchés, pas de partage de ligne de cache), agrégés seulement à la capture.
+ * - Capture exportable en JSON ou en texte Prometheus (histogramme de durées par étape, quantiles
+ *   p50 / p90 / p99 interpolés dans les seaux, jauges du mode surveillance)
+ *
+ * Les durées sont inclusives : l'ouverture de ruche contient le rejeu des journaux, l'énumération
+ * des clés contient la résolution SID et le décodage des valeurs.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Étapes chronométrées (ordre = ordre d'export)
+enum class TelemetrySpan : uint8_t {
+    HiveOpen,        // RegfHive::Open (projection, en-tête, rejeu) ; éléments = octets projetés
+    LogReplay,       // RegfHive::ReplayLogs ; éléments = pages appliquées
+    KeyEnumeration,  // Parcours bam/dam\State\UserSettings ; éléments = clés SID
+    ValueDecode,     // Valeurs d'une clé SID ; éléments = valeurs décodées
+    SidResolution,   // SID → compte ; éléments = SIDs résolus
+    ExportSerialize, // Sérialisation CSV / JSONL / BDCOL ; éléments = lignes
+    ExportWrite,     // Écriture disque des buffers d'export ; éléments = octets
+    TimelineSpill,   // Fusion des runs en attente vers un fichier (Timeline) ; éléments = lignes
+    TimelineMerge,   // Passe de fusion k-voies des runs ; éléments = lignes
+    HiveCarve,       // Recherche de vk supprimées dans l'espace libre (BamDamCarve) ; éléments = octets lus
+    IngestRead,      // Surveillance : ouverture, empreinte, comptes SID ; éléments = octets de hbin
+    IngestParse,     // Surveillance : lignes BAM/DAM de la ruche ; éléments = lignes
+    IngestEnrich,    // Surveillance : volumes, classification, carving ; éléments = lignes
+    IngestExport,    // Surveillance : remise à l'export (attente si sa file est pleine) ; éléments = lignes
+    IngestLatency,   // Surveillance : de la mise en file à la remise à l'export ; éléments = lignes
+    RowSort,         // EntrySorter : tri multi-clés par permutation ; éléments = lignes
+    Count
+};
+
+enum class TelemetryCounter : uint8_t {
+    HiveOpenErrors,
+    InvalidValues,   // Valeurs sans FILETIME décodable
+    LogRecords,      // Enregistrements de journal acceptés par AsyncLogger
+    LogDropped,      // Informations perdues (anneau plein)
+    IngestHives,     // Surveillance : ruches exportées
+    IngestDuplicates, // Surveillance : contenu déjà exporté (empreinte connue)
+    IngestFailures,  // Surveillance : ruches illisibles
+    IngestRescans,   // Surveillance : inventaires complets des dossiers
+    Count
+};
+
+// Valeurs instantanées (dernière valeur écrite, pas de somme)
+enum class TelemetryGauge : uint8_t {
+    IngestQueue,     // Ruches en attente d'un worker
+    IngestInFlight,  // Ruches en cours de traitement
+    ExportQueue,     // Stores en attente de sérialisation
+    Count
+};
+
+constexpr size_t TELEMETRY_SPAN_COUNT = static_cast<size_t>(TelemetrySpan::Count);
+constexpr size_t TELEMETRY_COUNTER_COUNT = static_cast<size_t>(TelemetryCounter::Count);
+constexpr size_t TELEMETRY_GAUGE_COUNT = static_cast<size_t>(TelemetryGauge::Count);
+// Histogramme : seau k = durée < 2^(k + 10) ns (~1 µs à ~4 s), dernier seau = au-delà
+constexpr size_t TELEMETRY_BUCKETS = 24;
+
+// Noms stables (JSON, étiquettes Prometheus)
+const char* TelemetrySpanName(TelemetrySpan span);
+const char* TelemetryCounterName(TelemetryCounter counter);
+const char* TelemetryGaugeName(TelemetryGauge gauge);
+
+struct TelemetrySpanStats {
+    uint64_t calls = 0;
+    uint64_t items = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t buckets[TELEMETRY_BUCKETS] = {};
+};
+
+// Quantile q (0..1) des durées en ns, interpolé dans le seau qui le contient (borné par maxNs)
+double TelemetryQuantileNs(const TelemetrySpanStats& stats, double q);
+
+struct TelemetrySnapshot {
+    TelemetrySpanStats spans[TELEMETRY_SPAN_COUNT];
+    uint64_t counters[TELEMETRY_COUNTER_COUNT] = {};
+    int64_t gauges[TELEMETRY_GAUGE_COUNT] = {};
+    double uptimeSeconds = 0;
+};
+
+class Telemetry {
+public:
+    // Actif par défaut ; inactif, une étape ne lit pas l'horloge
+    static void SetEnabled(bool enabled) { enabledFlag.store(enabled, std::memory_order_relaxed); }
+    static bool Enabled() { return enabledFlag.load(std::memory_order_relaxed); }
+
+    static void Add(TelemetryCounter counter, uint64_t n = 1);
+    static void Record(TelemetrySpan span, uint64_t nanoseconds, uint64_t items);
+    static void SetGauge(TelemetryGauge gauge, int64_t value);
+
+    // Somme de tous les shards (cohérente par compteur, pas entre compteurs)
+    static TelemetrySnapshot Capture();
+    static void Reset();
+
+    static std::string ToJson(const TelemetrySnapshot& snapshot);
+    static std::string ToPrometheus(const TelemetrySnapshot& snapshot);
+    // Texte Prometheus si l'extension est .prom ou .txt, JSON sinon ; fichier temporaire puis renommage
+    // (un collecteur qui relit le fichier ne voit jamais une capture à moitié écrite)
+    static bool WriteFile(const std::filesystem::path& path, std::string& error);
+
+private:
+    static std::atomic<bool> enabledFlag;
+};
+
+// Chronomètre RAII d'une étape
+class ScopedSpan {
+public:
+    explicit ScopedSpan(TelemetrySpan id, uint64_t initialItems = 0)
+        : span(id), items(initialItems), active(Telemetry::Enabled()) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+    ~ScopedSpan() {
+        if (active) {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            Telemetry::Record(span, static_cast<uint64_t>(
+                                  std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), items);
+        }
+    }
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    void AddItems(uint64_t n) { items += n; }
+    void SetItems(uint64_t n) { items = n; }
+
+private:
+    TelemetrySpan span;
+    uint64_t items;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+enum class LogLevel : uint8_t { Info, Warning, Error };
+
+class AsyncLogger {
+public:
+    static constexpr size_t RECORD_TEXT = 480;  // Octets UTF-8 par enregistrement, au-delà tronqué
+
+    // capacity arrondie à la puissance de 2 supérieure
+    explicit AsyncLogger(size_t capacity = 2048);
+    ~AsyncLogger() { Close(); }
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Fichier horodaté "[JJ/MM/AAAA HH:MM:SS.mmm] message" (heure locale, UTF-8, ajout) ;
+    // stream reçoit le texte seul (ex. stderr). Démarre le thread de vidage.
+    bool Open(const std::filesystem::path& path, FILE* stream = nullptr);
+    bool Open(FILE* stream);
+
+    // Sans verrou ni allocation ; anneau plein : Info perdue (false), Warning / Error attendent une place.
+    // false si le journal est fermé.
+    bool Log(LogLevel level, std::string_view utf8);
+    bool Log(LogLevel level, std::u16string_view text);
+
+    // Attend que tout ce qui a été journalisé avant l'appel soit écrit
+    void Flush();
+    // Vide l'anneau, arrête le thread et ferme le fichier
+    void Close();
+
+    bool IsOpen() const { return open; }
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+    const std::string& LastError() const { return lastError; }
+
+private:
+    struct Record {
+        std::atomic<uint64_t> sequence;
+        uint64_t fileTime;
+        uint16_t length;
+        LogLevel level;
+        bool truncated;
+        char text[RECORD_TEXT];
+    };
+
+    Record* Claim();
+    Record* Reserve(LogLevel level);
+    void Publish(Record* record);
+    bool Start();
+    void DrainMain();
+    void Format(const Record& record, std::string& fileOut, std::string& streamOut, int32_t& offsetMinutes,
+                int64_t& offsetMinute);
+
+    std::unique_ptr<Record[]> ring;
+    size_t mask;
+    alignas(64) std::atomic<uint64_t> head{ 0 };  // Prochain enregistrement à réserver
+    alignas(64) uint64_t tail = 0;                // Prochain à vider (thread de vidage seulement)
+    alignas(64) std::atomic<uint64_t> drained{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+
+    FILE* file = nullptr;
+    FILE* stream = nullptr;
+    std::thread drainer;
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    std::condition_variable drainedChanged;
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> sleeping{ false };  // Thread de vidage en attente : le prochain producteur le réveille
+    bool open = false;
+    std::string lastError;
+};
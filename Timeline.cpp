@@ -0,0 +1,887 @@
+/*
+ * Timeline - Implémentation du tri externe : encodage des runs, arbre des perdants, préchargement
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "Timeline.h"
+
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char RUN_MAGIC[6] = { 'B', 'D', 'R', 'U', 'N', '1' };
+constexpr size_t RUN_HEADER_SIZE = 8;
+constexpr uint8_t RUN_FLAG_FIRST_SEEN = 0x01;
+constexpr size_t BLOCK_TARGET = 64u << 10;
+constexpr size_t MAX_FAN_IN = 256;  // Descripteurs ouverts et profondeur de l'arbre raisonnables
+
+// Une ligne en cours de fusion : vues sur le store source ou sur les tampons d'un décodeur,
+// valides jusqu'à l'avancée de leur source
+struct TimelineRow {
+    uint64_t fileTime = 0;
+    uint64_t firstSeen = 0;
+    EntrySource source = EntrySource::Bam;
+    uint8_t flags = 0;
+    std::u16string_view host;
+    std::u16string_view sid;
+    std::u16string_view user;
+    std::u16string_view path;
+    std::u16string_view normalizedPath;
+    std::u16string_view note;
+    const uint64_t* words = nullptr;  // Bitset des règles déclenchées
+    size_t wordCount = 0;
+};
+
+using RowFn = std::function<void(const TimelineRow& row)>;
+
+void PutVarint(ByteBuffer& out, uint64_t value) {
+    char* p = out.Tail(10);
+    while (value >= 0x80) {
+        *p++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<char>(value);
+    out.SetEnd(p);
+}
+
+// Chemins, SIDs et noms de comptes presque toujours ASCII : copie directe, transcodage sinon
+void PutString(ByteBuffer& out, std::u16string_view text, std::string& scratch) {
+    char16_t any = 0;
+    for (char16_t c : text) any |= c;
+    if (any < 0x80) {
+        PutVarint(out, text.size());
+        char* p = out.Tail(text.size());
+        for (char16_t c : text) *p++ = static_cast<char>(c);
+        out.Advance(text.size());
+        return;
+    }
+    scratch.clear();
+    AppendUtf8(scratch, text);
+    PutVarint(out, scratch.size());
+    out.Append(scratch);
+}
+
+bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (p == end) return false;
+        const uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool GetString(const uint8_t*& p, const uint8_t* end, std::u16string& out) {
+    uint64_t length;
+    if (!GetVarint(p, end, length) || length > static_cast<uint64_t>(end - p)) return false;
+    uint8_t any = 0;
+    for (const uint8_t* c = p; c != p + length; c++) any |= *c;
+    if (any < 0x80) {
+        out.resize(static_cast<size_t>(length));
+        for (size_t i = 0; i < length; i++) out[i] = p[i];
+    } else {
+        out.clear();
+        AppendUtf16(out, std::string_view(reinterpret_cast<const char*>(p), static_cast<size_t>(length)));
+    }
+    p += length;
+    return true;
+}
+
+// Dictionnaire d'une colonne de chaînes dans un run. Les sources (StringPool d'un store,
+// dictionnaires d'un décodeur) ne déplacent pas leurs chaînes : une même chaîne revient avec le même
+// pointeur, d'où un premier niveau indexé par adresse avant le hachage du texte.
+class RefEncoder {
+public:
+    void Put(ByteBuffer& out, std::u16string_view text, std::string& scratch) {
+        auto known = byAddress.find(text.data());
+        if (known != byAddress.end() && known->second.size == text.size()) {
+            PutVarint(out, uint64_t{ known->second.id } + 1);
+            return;
+        }
+        key.assign(text);
+        uint32_t id;
+        auto it = ids.find(key);
+        if (it != ids.end()) {
+            id = it->second;
+            PutVarint(out, uint64_t{ id } + 1);
+        } else {
+            id = static_cast<uint32_t>(ids.size());
+            ids.emplace(key, id);
+            PutVarint(out, 0);
+            PutString(out, text, scratch);
+        }
+        byAddress[text.data()] = { text.size(), id };
+    }
+
+private:
+    struct Known {
+        size_t size;
+        uint32_t id;
+    };
+    std::unordered_map<const char16_t*, Known> byAddress;
+    std::unordered_map<std::u16string, uint32_t> ids;
+    std::u16string key;
+};
+
+// Combinaisons de règles (Notes + bitset) d'un run
+class MatchEncoder {
+public:
+    void Put(ByteBuffer& out, const TimelineRow& row, std::string& scratch) {
+        if (lastId != UINT32_MAX && row.words == lastWords && row.note.data() == lastNote.data() &&
+            row.note.size() == lastNote.size()) {
+            PutVarint(out, uint64_t{ lastId } + 1);
+            return;
+        }
+        key.assign(reinterpret_cast<const char*>(row.note.data()), row.note.size() * sizeof(char16_t));
+        key.push_back('\0');
+        key.append(reinterpret_cast<const char*>(row.words), row.wordCount * sizeof(uint64_t));
+        auto it = ids.find(key);
+        if (it != ids.end()) {
+            lastId = it->second;
+            PutVarint(out, uint64_t{ lastId } + 1);
+        } else {
+            lastId = static_cast<uint32_t>(ids.size());
+            ids.emplace(key, lastId);
+            PutVarint(out, 0);
+            PutString(out, row.note, scratch);
+            PutVarint(out, row.wordCount);
+            for (size_t w = 0; w < row.wordCount; w++) PutVarint(out, row.words[w]);
+        }
+        lastWords = row.words;
+        lastNote = row.note;
+    }
+
+private:
+    std::unordered_map<std::string, uint32_t> ids;
+    std::string key;
+    const uint64_t* lastWords = nullptr;
+    std::u16string_view lastNote;
+    uint32_t lastId = UINT32_MAX;
+};
+
+// Lignes triées → run (en mémoire ou vers un fichier), par blocs
+class RunEncoder {
+public:
+    RunEncoder(bool firstSeen, ByteBuffer& memory) : firstSeen(firstSeen), memory(&memory) { Begin(); }
+    RunEncoder(bool firstSeen, BufferedFileWriter& writer) : firstSeen(firstSeen), writer(&writer) { Begin(); }
+
+    void Put(const TimelineRow& row) {
+        PutVarint(block, row.fileTime - previous);
+        previous = row.fileTime;
+        if (firstSeen) {
+            const int64_t span = static_cast<int64_t>(row.fileTime - row.firstSeen);
+            PutVarint(block, (static_cast<uint64_t>(span) << 1) ^ static_cast<uint64_t>(span >> 63));
+        }
+        block.Push(static_cast<char>(row.source));
+        block.Push(static_cast<char>(row.flags));
+        hosts.Put(block, row.host, scratch);
+        sids.Put(block, row.sid, scratch);
+        users.Put(block, row.user, scratch);
+        matches.Put(block, row, scratch);
+        PutString(block, row.path, scratch);
+
+        // Chemin normalisé = préfixe propre + fin commune avec le chemin brut
+        size_t common = 0;
+        const size_t limit = std::min(row.path.size(), row.normalizedPath.size());
+        while (common < limit &&
+               row.path[row.path.size() - 1 - common] == row.normalizedPath[row.normalizedPath.size() - 1 - common]) {
+            common++;
+        }
+        PutVarint(block, common);
+        PutString(block, row.normalizedPath.substr(0, row.normalizedPath.size() - common), scratch);
+
+        rows++;
+        if (block.size() >= BLOCK_TARGET) FlushBlock();
+    }
+
+    // Dernier bloc et marqueur de fin ; le fichier reste à fermer (BufferedFileWriter::Close)
+    void Finish() {
+        FlushBlock();
+        const uint32_t end = 0;
+        Output().Append(&end, 4);
+        if (writer) {
+            writer->Submit(std::move(fileBuffer));
+        }
+    }
+
+    uint64_t Rows() const { return rows; }
+
+private:
+    void Begin() {
+        char header[RUN_HEADER_SIZE] = {};
+        std::memcpy(header, RUN_MAGIC, sizeof(RUN_MAGIC));
+        header[6] = static_cast<char>(firstSeen ? RUN_FLAG_FIRST_SEEN : 0);
+        Output().Append(header, sizeof(header));
+    }
+
+    ByteBuffer& Output() {
+        if (memory) return *memory;
+        if (!fileBuffer) fileBuffer = writer->Acquire();
+        return *fileBuffer;
+    }
+
+    void FlushBlock() {
+        if (block.empty()) return;
+        const uint32_t size = static_cast<uint32_t>(block.size());
+        ByteBuffer& out = Output();
+        out.Append(&size, 4);
+        out.Append(block.data(), block.size());
+        block.clear();
+        if (writer && fileBuffer->size() >= BufferedFileWriter::BUFFER_SIZE) {
+            writer->Submit(std::move(fileBuffer));
+        }
+    }
+
+    const bool firstSeen;
+    ByteBuffer* memory = nullptr;
+    BufferedFileWriter* writer = nullptr;
+    std::unique_ptr<ByteBuffer> fileBuffer;
+    ByteBuffer block{ BLOCK_TARGET + 4096 };
+    RefEncoder hosts;
+    RefEncoder sids;
+    RefEncoder users;
+    MatchEncoder matches;
+    std::string scratch;
+    uint64_t previous = 0;
+    uint64_t rows = 0;
+};
+
+// Source de blocs d'un run
+class RunReader {
+public:
+    virtual ~RunReader() = default;
+    // Bloc suivant ; false en fin de run ou sur erreur (Failed)
+    virtual bool NextBlock(const uint8_t*& begin, const uint8_t*& end) = 0;
+    virtual bool Failed() const { return false; }
+};
+
+class MemoryRunReader : public RunReader {
+public:
+    explicit MemoryRunReader(const ByteBuffer& run) : run(run) {}
+
+    bool NextBlock(const uint8_t*& begin, const uint8_t*& end) override {
+        uint32_t size = 0;
+        if (offset + 4 > run.size()) return false;
+        std::memcpy(&size, run.data() + offset, 4);
+        if (size == 0 || size > run.size() - offset - 4) return false;
+        begin = reinterpret_cast<const uint8_t*>(run.data()) + offset + 4;
+        end = begin + size;
+        offset += 4 + size;
+        return true;
+    }
+
+private:
+    const ByteBuffer& run;
+    size_t offset = RUN_HEADER_SIZE;
+};
+
+class FileRunReader;
+
+// Thread unique de lecture anticipée : une requête = le bloc suivant d'un run, lu dans son tampon libre
+class BlockPrefetcher {
+public:
+    BlockPrefetcher() : thread(&BlockPrefetcher::Main, this) {}
+    ~BlockPrefetcher() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        thread.join();
+    }
+    BlockPrefetcher(const BlockPrefetcher&) = delete;
+    BlockPrefetcher& operator=(const BlockPrefetcher&) = delete;
+
+    void Request(FileRunReader* reader) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back(reader);
+        }
+        changed.notify_all();
+    }
+
+    std::mutex lock;
+    std::condition_variable changed;
+
+private:
+    void Main();
+
+    std::deque<FileRunReader*> queue;
+    bool stopping = false;
+    std::thread thread;  // Dernier membre : démarré une fois les autres construits
+};
+
+class FileRunReader : public RunReader {
+public:
+    ~FileRunReader() override {
+        if (file) std::fclose(file);
+    }
+
+    bool Open(const fs::path& path, bool firstSeen, BlockPrefetcher& owner, std::string& error) {
+#ifdef _WIN32
+        file = _wfopen(path.c_str(), L"rb");
+#else
+        file = std::fopen(path.c_str(), "rb");
+#endif
+        char header[RUN_HEADER_SIZE];
+        if (!file || std::fread(header, 1, sizeof(header), file) != sizeof(header) ||
+            std::memcmp(header, RUN_MAGIC, sizeof(RUN_MAGIC)) != 0 ||
+            (header[6] & RUN_FLAG_FIRST_SEEN) != (firstSeen ? RUN_FLAG_FIRST_SEEN : 0)) {
+            error = "Run illisible : " + path.u8string();
+            return false;
+        }
+        std::setvbuf(file, nullptr, _IONBF, 0);  // Blocs lus d'un seul fread : pas de double copie
+        prefetcher = &owner;
+        prefetcher->Request(this);
+        return true;
+    }
+
+    bool NextBlock(const uint8_t*& begin, const uint8_t*& end) override {
+        size_t current;
+        {
+            std::unique_lock<std::mutex> guard(prefetcher->lock);
+            prefetcher->changed.wait(guard, [this] { return ready; });
+            if (failed || ended) return false;
+            ready = false;
+            current = fill;
+            fill = 1 - current;
+        }
+        begin = buffers[current].data();
+        end = begin + sizes[current];
+        prefetcher->Request(this);  // Le bloc suivant arrive pendant la fusion de celui-ci
+        return true;
+    }
+
+    bool Failed() const override { return failed; }
+
+    // Thread de préchargement, hors verrou : seul le tampon fill est touché
+    void Fill() {
+        uint32_t size = 0;
+        if (std::fread(&size, 1, 4, file) != 4) {
+            failed = true;
+        } else if (size == 0) {
+            ended = true;
+        } else {
+            std::vector<uint8_t>& buffer = buffers[fill];
+            if (buffer.size() < size) buffer.resize(size);
+            sizes[fill] = size;
+            if (std::fread(buffer.data(), 1, size, file) != size) failed = true;
+        }
+    }
+
+    void MarkReady() { ready = true; }  // Sous le verrou du préchargeur
+
+private:
+    BlockPrefetcher* prefetcher = nullptr;
+    FILE* file = nullptr;
+    std::vector<uint8_t> buffers[2];
+    size_t sizes[2] = { 0, 0 };
+    size_t fill = 0;  // Tampon en cours de remplissage ou rempli d'avance
+    bool ready = false;
+    bool ended = false;
+    bool failed = false;
+};
+
+void BlockPrefetcher::Main() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        changed.wait(guard, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) break;
+        FileRunReader* reader = queue.front();
+        queue.pop_front();
+        guard.unlock();
+        reader->Fill();
+        guard.lock();
+        reader->MarkReady();
+        changed.notify_all();
+    }
+}
+
+// Décodage d'un run ligne à ligne
+class RunCursor {
+public:
+    RunCursor(RunReader& reader, bool firstSeen) : reader(reader), firstSeen(firstSeen) {}
+
+    // false en fin de run ou sur erreur (Failed)
+    bool Next() {
+        while (p == end) {
+            if (!reader.NextBlock(p, end)) return false;
+        }
+        if (!Decode()) {
+            corrupt = true;
+            return false;
+        }
+        return true;
+    }
+
+    const TimelineRow& Row() const { return row; }
+    bool Failed() const { return corrupt || reader.Failed(); }
+
+private:
+    struct Match {
+        std::u16string note;
+        std::vector<uint64_t> words;
+    };
+
+    bool Decode() {
+        uint64_t delta;
+        if (!GetVarint(p, end, delta)) return false;
+        previous += delta;
+        row.fileTime = previous;
+        row.firstSeen = previous;
+        if (firstSeen) {
+            uint64_t zigzag;
+            if (!GetVarint(p, end, zigzag)) return false;
+            const int64_t span = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            row.firstSeen = previous - static_cast<uint64_t>(span);
+        }
+        if (end - p < 2) return false;
+        row.source = static_cast<EntrySource>(*p++ & 3);
+        row.flags = *p++;
+        if (!GetRef(hosts, row.host) || !GetRef(sids, row.sid) || !GetRef(users, row.user) || !GetMatch()) {
+            return false;
+        }
+
+        if (!GetString(p, end, path)) return false;
+        row.path = path;
+        uint64_t common;
+        if (!GetVarint(p, end, common) || common > path.size() || !GetString(p, end, prefix)) return false;
+        if (prefix.empty() && common == path.size()) {
+            row.normalizedPath = row.path;
+        } else {
+            normalized.assign(prefix);
+            normalized.append(path, path.size() - common, common);
+            row.normalizedPath = normalized;
+        }
+        return true;
+    }
+
+    bool GetRef(std::deque<std::u16string>& dictionary, std::u16string_view& out) {
+        uint64_t ref;
+        if (!GetVarint(p, end, ref) || ref > dictionary.size()) return false;
+        if (ref == 0) {
+            dictionary.emplace_back();
+            if (!GetString(p, end, dictionary.back())) return false;
+            out = dictionary.back();
+        } else {
+            out = dictionary[ref - 1];
+        }
+        return true;
+    }
+
+    bool GetMatch() {
+        uint64_t ref;
+        if (!GetVarint(p, end, ref) || ref > matches.size()) return false;
+        const Match* match;
+        if (ref == 0) {
+            matches.emplace_back();
+            Match& added = matches.back();
+            uint64_t wordCount;
+            if (!GetString(p, end, added.note) || !GetVarint(p, end, wordCount) ||
+                wordCount > static_cast<uint64_t>(end - p)) {
+                return false;
+            }
+            added.words.resize(static_cast<size_t>(wordCount));
+            for (uint64_t& word : added.words) {
+                if (!GetVarint(p, end, word)) return false;
+            }
+            match = &added;
+        } else {
+            match = &matches[ref - 1];
+        }
+        row.note = match->note;
+        row.words = match->words.data();
+        row.wordCount = match->words.size();
+        return true;
+    }
+
+    RunReader& reader;
+    const bool firstSeen;
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+    uint64_t previous = 0;
+    // deque : les vues des lignes précédentes restent valides quand le dictionnaire grandit
+    std::deque<std::u16string> hosts;
+    std::deque<std::u16string> sids;
+    std::deque<std::u16string> users;
+    std::deque<Match> matches;
+    std::u16string path;
+    std::u16string prefix;
+    std::u16string normalized;
+    TimelineRow row;
+    bool corrupt = false;
+};
+
+// Arbre des perdants sur k sources : tree[0] = gagnant, tree[1..k-1] = perdant de chaque match.
+// Une ligne émise coûte log2 k comparaisons, contre ~2 log2 k pour un tas.
+class LoserTree {
+public:
+    template <class Less>
+    void Build(size_t count, Less less) {
+        k = count;
+        tree.assign(std::max<size_t>(k, 1), 0);
+        if (k < 2) return;
+        std::vector<size_t> winners(2 * k);
+        for (size_t i = 0; i < k; i++) winners[k + i] = i;
+        for (size_t n = k - 1; n >= 1; n--) {
+            const size_t a = winners[2 * n];
+            const size_t b = winners[2 * n + 1];
+            const bool aWins = less(a, b);
+            winners[n] = aWins ? a : b;
+            tree[n] = aWins ? b : a;
+        }
+        tree[0] = winners[1];
+    }
+
+    size_t Winner() const { return tree[0]; }
+
+    // La source gagnante a avancé : ses matchs sont rejoués de sa feuille à la racine
+    template <class Less>
+    void Replay(Less less) {
+        size_t winner = tree[0];
+        for (size_t n = (winner + k) / 2; n >= 1; n /= 2) {
+            if (less(tree[n], winner)) std::swap(tree[n], winner);
+        }
+        tree[0] = winner;
+    }
+
+private:
+    size_t k = 0;
+    std::vector<size_t> tree;
+};
+
+// Fusion de runs sur disque puis en mémoire ; à égalité de FILETIME et d'hôte, l'ordre des runs
+bool MergeRuns(const std::vector<fs::path>& files, const std::vector<const ByteBuffer*>& memory, bool firstSeen,
+               const RowFn& emit, std::string& error) {
+    std::vector<std::unique_ptr<RunReader>> readers;  // Détruits après l'arrêt du préchargeur
+    BlockPrefetcher prefetcher;
+    for (const fs::path& path : files) {
+        auto reader = std::make_unique<FileRunReader>();
+        if (!reader->Open(path, firstSeen, prefetcher, error)) return false;
+        readers.push_back(std::move(reader));
+    }
+    for (const ByteBuffer* run : memory) {
+        readers.push_back(std::make_unique<MemoryRunReader>(*run));
+    }
+
+    std::vector<RunCursor> cursors;
+    cursors.reserve(readers.size());
+    for (auto& reader : readers) cursors.emplace_back(*reader, firstSeen);
+    std::vector<uint8_t> live(cursors.size());
+    for (size_t i = 0; i < cursors.size(); i++) live[i] = cursors[i].Next();
+
+    const auto less = [&](size_t a, size_t b) {
+        if (live[a] != live[b]) return live[a] != 0;
+        if (!live[a]) return a < b;
+        const TimelineRow& x = cursors[a].Row();
+        const TimelineRow& y = cursors[b].Row();
+        if (x.fileTime != y.fileTime) return x.fileTime < y.fileTime;
+        const int host = x.host.compare(y.host);
+        return host != 0 ? host < 0 : a < b;
+    };
+    LoserTree tree;
+    tree.Build(cursors.size(), less);
+    while (!cursors.empty()) {
+        const size_t winner = tree.Winner();
+        if (!live[winner]) break;
+        emit(cursors[winner].Row());
+        live[winner] = cursors[winner].Next();
+        tree.Replay(less);
+    }
+
+    for (size_t i = 0; i < cursors.size(); i++) {
+        if (cursors[i].Failed()) {
+            error = i < files.size() ? "Run corrompu ou tronqué : " + files[i].u8string() : "Run en mémoire corrompu";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Id interné d'une chaîne de dictionnaire de run, indexé par adresse (voir RefEncoder)
+class CachedIntern {
+public:
+    uint32_t Get(StringPool& pool, std::u16string_view text) {
+        auto known = ids.find(text.data());
+        if (known != ids.end() && pool.View(known->second).size() == text.size()) return known->second;
+        const uint32_t id = pool.Intern(text);
+        ids[text.data()] = id;
+        return id;
+    }
+    void Reset() { ids.clear(); }
+
+private:
+    std::unordered_map<const char16_t*, uint32_t> ids;
+};
+
+// Lignes fusionnées → EntryStore de chunkRows lignes au plus
+class ChunkBuilder {
+public:
+    ChunkBuilder(size_t chunkRows, bool firstSeen, const EntryChunkFn& sink)
+        : chunkRows(std::max<size_t>(chunkRows, 1)), firstSeen(firstSeen), sink(sink) {}
+
+    void Put(const TimelineRow& row) {
+        if (!chunk) {
+            chunk = std::make_unique<EntryStore>();
+            chunk->Reserve(chunkRows);
+            if (firstSeen) chunk->EnableFirstSeen();
+            hosts.Reset();
+            sids.Reset();
+            users.Reset();
+            matchValid = false;
+        }
+        if (!matchValid || row.words != lastWords || row.note.data() != lastNote.data() ||
+            row.note.size() != lastNote.size()) {
+            match = chunk->matches.Intern(row.words, row.wordCount, row.note);
+            lastWords = row.words;
+            lastNote = row.note;
+            matchValid = true;
+        }
+        const uint32_t pathId = chunk->paths.Intern(row.path);
+        const uint32_t normalizedId =
+            row.normalizedPath.data() == row.path.data() ? pathId : chunk->paths.Intern(row.normalizedPath);
+        const size_t r = chunk->Add(hosts.Get(chunk->hosts, row.host), sids.Get(chunk->sids, row.sid),
+                                    users.Get(chunk->users, row.user), pathId, row.fileTime, row.source, match,
+                                    row.flags, normalizedId);
+        if (firstSeen) chunk->SetTimes(r, row.firstSeen, row.fileTime, row.flags);
+        if (chunk->size() >= chunkRows) Flush();
+    }
+
+    void Flush() {
+        if (chunk && !chunk->empty()) sink(std::move(chunk));
+        chunk.reset();
+    }
+
+private:
+    const size_t chunkRows;
+    const bool firstSeen;
+    const EntryChunkFn& sink;
+    std::unique_ptr<EntryStore> chunk;
+    CachedIntern hosts;
+    CachedIntern sids;
+    CachedIntern users;
+    const uint64_t* lastWords = nullptr;
+    std::u16string_view lastNote;
+    uint32_t match = ENTRY_NO_MATCH;
+    bool matchValid = false;
+};
+
+}  // namespace
+
+TimelineBuilder::TimelineBuilder(const TimelineOptions& options) : options(options) {}
+
+TimelineBuilder::~TimelineBuilder() {
+    if (!open) return;
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+}
+
+bool TimelineBuilder::Open() {
+    std::error_code ec;
+    fs::path base = options.spillDirectory.empty() ? fs::temp_directory_path(ec) : options.spillDirectory;
+    if (ec) {
+        lastError = "Répertoire temporaire introuvable";
+        return false;
+    }
+    std::mt19937_64 random(std::random_device{}() ^
+                           static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    char name[48];
+    std::snprintf(name, sizeof(name), "bamdam-timeline-%016llx", static_cast<unsigned long long>(random()));
+    directory = base / name;
+    if (!fs::create_directories(directory, ec)) {
+        lastError = "Impossible de créer " + directory.u8string();
+        return false;
+    }
+    open = true;
+    return true;
+}
+
+size_t TimelineBuilder::FanIn() const {
+    // Moitié du budget pour les tampons de lecture : deux blocs par run sur disque
+    const size_t perRun = 2 * (BLOCK_TARGET + 4096);
+    return std::clamp<size_t>(options.memoryBytes / 2 / perRun, 2, MAX_FAN_IN);
+}
+
+bool TimelineBuilder::Add(EntryStore& store) {
+    if (store.empty()) return true;
+
+    // Tri stable par FILETIME : les lignes d'une ruche de même date gardent leur ordre
+    std::vector<uint32_t> order(store.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return store.FileTime(a) < store.FileTime(b); });
+    store.Permute(order);
+
+    // Bitset de chaque combinaison de règles du store
+    std::vector<std::vector<uint64_t>> words(store.matches.Count());
+    for (uint32_t id = 0; id < words.size(); id++) {
+        store.matches.ForEachRule(id, [&](uint32_t rule) {
+            if (words[id].size() <= rule / 64) words[id].resize(rule / 64 + 1, 0);
+            words[id][rule / 64] |= uint64_t{ 1 } << (rule % 64);
+        });
+    }
+
+    auto run = std::make_unique<ByteBuffer>(store.size() * 32 + RUN_HEADER_SIZE);
+    RunEncoder encoder(options.history, *run);
+    TimelineRow row;
+    for (size_t i = 0; i < store.size(); i++) {
+        const uint32_t match = store.MatchId(i);
+        row.fileTime = store.FileTime(i);
+        row.firstSeen = store.FirstSeen(i);
+        row.source = store.Source(i);
+        row.flags = store.Flags(i);
+        row.host = store.Host(i);
+        row.sid = store.Sid(i);
+        row.user = store.User(i);
+        row.path = store.Path(i);
+        row.normalizedPath = store.NormalizedPath(i);
+        row.note = store.matches.Note(match);
+        row.words = words[match].data();
+        row.wordCount = words[match].size();
+        encoder.Put(row);
+    }
+    encoder.Finish();
+
+    const size_t half = options.memoryBytes / 2;
+    std::unique_lock<std::mutex> guard(lock);
+    spaceFree.wait(guard, [&] { return failed || !spilling || pendingBytes < half; });
+    if (failed) return false;
+    rows += store.size();
+    pendingBytes += run->size();
+    pending.push_back(std::move(run));
+    if (pendingBytes < half || spilling) return true;
+
+    std::vector<std::unique_ptr<ByteBuffer>> full;
+    full.swap(pending);
+    pendingBytes = 0;
+    spilling = true;
+    guard.unlock();
+    const bool ok = Spill(full);
+    full.clear();
+    guard.lock();
+    spilling = false;
+    if (!ok) failed = true;
+    spaceFree.notify_all();
+    return ok;
+}
+
+bool TimelineBuilder::Spill(const std::vector<std::unique_ptr<ByteBuffer>>& runs) {
+    ScopedSpan span(TelemetrySpan::TimelineSpill);
+    if (!open) {
+        lastError = "Chronologie non ouverte";
+        return false;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "run%06zu.bdrun", nextRunId++);
+    const fs::path path = directory / name;
+
+    BufferedFileWriter writer;
+    if (!writer.Open(path)) {
+        lastError = "Impossible d'écrire " + path.u8string();
+        return false;
+    }
+    std::vector<const ByteBuffer*> memory;
+    for (const auto& run : runs) memory.push_back(run.get());
+    RunEncoder encoder(options.history, writer);
+    bool ok = MergeRuns({}, memory, options.history, [&](const TimelineRow& row) { encoder.Put(row); }, lastError);
+    encoder.Finish();
+    if (!writer.Close() && ok) {
+        lastError = "Écriture incomplète : " + path.u8string();
+        ok = false;
+    }
+    if (!ok) return false;
+    span.AddItems(encoder.Rows());
+    files.push_back(path);
+    runsSpilled++;
+    bytesSpilled += writer.BytesWritten();
+    return true;
+}
+
+bool TimelineBuilder::Merge(size_t chunkRows, const EntryChunkFn& sink) {
+    std::vector<std::unique_ptr<ByteBuffer>> memoryRuns;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (failed) return false;
+        memoryRuns.swap(pending);
+        pendingBytes = 0;
+    }
+
+    // Passes intermédiaires, niveau par niveau : chaque groupe de FanIn runs consécutifs remplacé sur place
+    // par sa fusion (l'ordre des runs départage les égalités) ; log_FanIn(runs) passes sur les données
+    const size_t fanIn = FanIn();
+    while (files.size() > fanIn) {
+        ScopedSpan span(TelemetrySpan::TimelineMerge);
+        std::vector<fs::path> level;
+        for (size_t first = 0; first < files.size(); first += fanIn) {
+            const size_t end = std::min(files.size(), first + fanIn);
+            if (end - first == 1) {
+                level.push_back(files[first]);
+                continue;
+            }
+            const std::vector<fs::path> group(files.begin() + first, files.begin() + end);
+            char name[32];
+            std::snprintf(name, sizeof(name), "run%06zu.bdrun", nextRunId++);
+            const fs::path path = directory / name;
+
+            BufferedFileWriter writer;
+            if (!writer.Open(path)) {
+                lastError = "Impossible d'écrire " + path.u8string();
+                return false;
+            }
+            RunEncoder encoder(options.history, writer);
+            bool ok = MergeRuns(group, {}, options.history, [&](const TimelineRow& row) { encoder.Put(row); },
+                                lastError);
+            encoder.Finish();
+            if (!writer.Close() && ok) {
+                lastError = "Écriture incomplète : " + path.u8string();
+                ok = false;
+            }
+            if (!ok) return false;
+            span.AddItems(encoder.Rows());
+            bytesSpilled += writer.BytesWritten();
+
+            std::error_code ec;
+            for (const fs::path& merged : group) fs::remove(merged, ec);
+            level.push_back(path);
+        }
+        files.swap(level);
+        mergePasses++;
+    }
+
+    ScopedSpan span(TelemetrySpan::TimelineMerge);
+    std::vector<const ByteBuffer*> memory;
+    for (const auto& run : memoryRuns) memory.push_back(run.get());
+    ChunkBuilder chunks(chunkRows, options.history, sink);
+    uint64_t merged = 0;
+    const bool ok = MergeRuns(files, memory, options.history, [&](const TimelineRow& row) {
+        chunks.Put(row);
+        merged++;
+    }, lastError);
+    if (!ok) return false;
+    chunks.Flush();
+    span.AddItems(merged);
+
+    std::error_code ec;
+    for (const fs::path& path : files) fs::remove(path, ec);
+    files.clear();
+    return true;
+}
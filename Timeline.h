@@ -0,0 +1,107 @@
+/*
+ * Timeline - Chronologie globale de la flotte hors mémoire (tri externe par FILETIME)
+ *
+ * Des centaines de millions de lignes ne tiennent pas dans un EntryStore : "qu'est-ce qui a tourné
+ * où, dans l'ordre" passe par un tri externe.
+ *
+ * - Add (thread-safe, appelé par les workers) : les lignes d'une ruche sont triées sur place par
+ *   FILETIME (tri stable) et encodées en un run binaire compact ; le tri se fait donc en parallèle
+ * - Runs en attente en mémoire jusqu'à la moitié du budget, puis fusionnés (arbre des perdants)
+ *   en un seul run déversé sur disque ; un seul déversement à la fois, les workers qui remplissent
+ *   à nouveau la moitié du budget pendant ce temps attendent (contre-pression)
+ * - Merge : fusion k-voies de tous les runs par arbre des perdants (log2 k comparaisons par ligne),
+ *   par passes intermédiaires (niveaux de groupes consécutifs, log_k(runs) passes) si les runs dépassent
+ *   l'éventail permis par le budget ; sortie en EntryStore de chunkRows lignes pour ExportPipeline::Submit
+ * - E/S séquentielles : écriture par BufferedFileWriter, lecture par blocs avec un thread de
+ *   préchargement (le bloc suivant de chaque run est lu pendant que le précédent est fusionné)
+ *
+ * Ordre : FILETIME croissant, puis hôte, puis ordre d'ajout (stable pour les lignes d'une ruche).
+ *
+ * Format d'un run (little-endian, fichier temporaire ou mémoire) :
+ *   En-tête : "BDRUN1" | u8 drapeaux (0x01 = première observation) | "\0"
+ *   Bloc    : u32 octets (0 = fin du run) | lignes, jamais coupées entre deux blocs (~64 Ko)
+ *   Ligne   : varint delta FILETIME (croissant dans le run)
+ *             [drapeau 0x01 : varint zigzag FILETIME - première observation]
+ *             u8 source | u8 drapeaux de ligne
+ *             hôte, SID, utilisateur : varint réf (0 = nouvelle chaîne : varint longueur + UTF-8,
+ *               sinon id + 1 dans le dictionnaire du run, ids attribués dans l'ordre d'apparition)
+ *             règles : varint réf (0 = nouvelle combinaison : Notes en chaîne, varint n mots, n varints)
+ *             chemin brut : varint longueur + UTF-8
+ *             chemin normalisé : varint unités UTF-16 reprises de la fin du chemin brut, puis préfixe
+ *               en chaîne (\Device\HarddiskVolume3\x → C:\x = "C:" + 2 unités ; identique = 0 octet de préfixe)
+ *
+ * Mémoire : options.memoryBytes pour les runs en attente et les tampons de lecture de la fusion,
+ * plus les tampons fixes de BufferedFileWriter pendant un déversement ; les dictionnaires des runs
+ * (hôtes, SIDs, utilisateurs, combinaisons de règles) restent petits, les chemins n'y sont pas.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "EntryExport.h"
+#include "EntryStore.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TimelineOptions {
+    size_t memoryBytes = size_t{ 256 } << 20;
+    std::filesystem::path spillDirectory;  // Vide : répertoire temporaire du système
+    bool history = false;                  // Stores de HiveHistory : première observation conservée
+};
+
+class TimelineBuilder {
+public:
+    explicit TimelineBuilder(const TimelineOptions& options = TimelineOptions());
+    // Supprime les runs déversés et leur répertoire
+    ~TimelineBuilder();
+    TimelineBuilder(const TimelineBuilder&) = delete;
+    TimelineBuilder& operator=(const TimelineBuilder&) = delete;
+
+    // Crée le répertoire de déversement propre à cette chronologie
+    bool Open();
+
+    // Thread-safe. Le store est trié sur place (Permute) puis encodé ; false si un déversement a échoué
+    bool Add(EntryStore& store);
+
+    // Après le dernier Add : toutes les lignes, dans l'ordre, par blocs de chunkRows lignes au plus
+    bool Merge(size_t chunkRows, const EntryChunkFn& sink);
+
+    uint64_t Rows() const { return rows; }
+    size_t RunsSpilled() const { return runsSpilled; }
+    uint64_t BytesSpilled() const { return bytesSpilled; }
+    size_t MergePasses() const { return mergePasses; }  // Passes intermédiaires sur disque
+    const std::string& LastError() const { return lastError; }
+
+private:
+    bool Spill(const std::vector<std::unique_ptr<ByteBuffer>>& runs);
+    size_t FanIn() const;
+
+    TimelineOptions options;
+    std::filesystem::path directory;
+    bool open = false;
+
+    std::mutex lock;  // pending, pendingBytes, rows, spilling, failed
+    std::condition_variable spaceFree;
+    std::vector<std::unique_ptr<ByteBuffer>> pending;
+    size_t pendingBytes = 0;
+    uint64_t rows = 0;
+    bool spilling = false;
+    bool failed = false;
+
+    // Modifiés par le seul déversement en cours, puis par Merge
+    std::vector<std::filesystem::path> files;
+    size_t nextRunId = 0;
+    size_t runsSpilled = 0;
+    uint64_t bytesSpilled = 0;
+    size_t mergePasses = 0;
+    std::string lastError;
+};
@@ -0,0 +1,385 @@
+/*
+ * Transcode - Implémentation des noyaux scalaire, SSE2 et AVX2
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "Transcode.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSCODE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 compilé pour cette seule unité (attribut target sous GCC / Clang), utilisé si le processeur le permet
+#if defined(TRANSCODE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TRANSCODE_AVX2 1
+#define TRANSCODE_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(TRANSCODE_X86) && defined(_MSC_VER)
+#define TRANSCODE_AVX2 1
+#define TRANSCODE_AVX2_TARGET
+#endif
+
+namespace {
+
+// Sources : unités lues une à une (scalaire) ou par registre depuis Address (SIMD, x86 little-endian)
+struct Utf16Source {
+    static constexpr size_t WIDTH = 2;
+    const char16_t* text;
+    uint32_t operator[](size_t i) const { return text[i]; }
+    const void* Address(size_t i) const { return text + i; }
+};
+
+struct Utf16LeSource {
+    static constexpr size_t WIDTH = 2;
+    const uint8_t* bytes;
+    uint32_t operator[](size_t i) const { return bytes[2 * i] | static_cast<uint32_t>(bytes[2 * i + 1]) << 8; }
+    const void* Address(size_t i) const { return bytes + 2 * i; }
+};
+
+struct Latin1Source {
+    static constexpr size_t WIDTH = 1;
+    const uint8_t* bytes;
+    uint32_t operator[](size_t i) const { return bytes[i]; }
+    const void* Address(size_t i) const { return bytes + i; }
+};
+
+// Unité recopiée telle quelle : ASCII sans échappement
+template <Utf8Escape escape>
+inline bool IsPlain(uint32_t c) {
+    if (escape == Utf8Escape::Csv) return c < 0x80 && c != '"';
+    if (escape == Utf8Escape::Json) return c < 0x80 && c >= 0x20 && c != '"' && c != '\\';
+    return c < 0x80;
+}
+
+// Un caractère à partir de l'unité i (avancée d'une ou deux unités) : échappement, substituts, multi-octets
+template <Utf8Escape escape, class Source>
+char* EmitOne(const Source& source, size_t& i, size_t units, char* p) {
+    uint32_t c = source[i++];
+    if (c < 0x80) {
+        if (escape == Utf8Escape::Csv) {
+            if (c == '"') *p++ = '"';
+            *p++ = static_cast<char>(c);
+        } else if (escape != Utf8Escape::Json || (c >= 0x20 && c != '"' && c != '\\')) {
+            *p++ = static_cast<char>(c);
+        } else {
+            *p++ = '\\';
+            switch (c) {
+                case '"': *p++ = '"'; break;
+                case '\\': *p++ = '\\'; break;
+                case '\n': *p++ = 'n'; break;
+                case '\r': *p++ = 'r'; break;
+                case '\t': *p++ = 't'; break;
+                default: {
+                    static const char HEX[] = "0123456789abcdef";
+                    *p++ = 'u';
+                    *p++ = '0';
+                    *p++ = '0';
+                    *p++ = HEX[c >> 4];
+                    *p++ = HEX[c & 0xF];
+                }
+            }
+        }
+        return p;
+    }
+
+    if (c >= 0xD800 && c <= 0xDFFF) {
+        const uint32_t low = i < units ? source[i] : 0;
+        if (c <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+            i++;
+        } else {
+            c = 0xFFFD;
+        }
+    }
+    if (c < 0x800) {
+        *p++ = static_cast<char>(0xC0 | (c >> 6));
+        *p++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        *p++ = static_cast<char>(0xE0 | (c >> 12));
+        *p++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *p++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        *p++ = static_cast<char>(0xF0 | (c >> 18));
+        *p++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        *p++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *p++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return p;
+}
+
+template <Utf8Escape escape, class Source>
+size_t RunScalar(const Source& source, size_t i, size_t units, char*& p) {
+    for (; i < units; i++) {
+        const uint32_t c = source[i];
+        if (!IsPlain<escape>(c)) break;
+        *p++ = static_cast<char>(c);
+    }
+    return i;
+}
+
+#ifdef TRANSCODE_X86
+
+inline unsigned CountTrailingZeros(uint32_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(bits));
+#endif
+}
+
+// Guillemet (CSV, JSON) ou barre oblique inverse (JSON) stocké en p par la voie rapide : échappé sur place
+// pour que celle-ci continue (un chemin compte un \ tous les dix caractères environ)
+template <Utf8Escape escape>
+inline bool EscapeInPlace(char*& p) {
+    const char c = *p;
+    if (escape == Utf8Escape::None || (c != '"' && (escape != Utf8Escape::Json || c != '\\'))) return false;
+    p[1] = c;
+    p[0] = escape == Utf8Escape::Csv ? '"' : '\\';
+    p += 2;
+    return true;
+}
+
+// Octets demandant un échappement (0xFF), octets ≥ 0x80 compris en JSON (déjà exclus par ailleurs)
+template <Utf8Escape escape>
+inline __m128i SpecialSse2(__m128i bytes) {
+    if (escape == Utf8Escape::None) return _mm_setzero_si128();
+    __m128i special = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'));
+    if (escape == Utf8Escape::Json) {
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\')));
+        special = _mm_or_si128(special, _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x20)));
+    }
+    return special;
+}
+
+// Recopie 16 unités par itération tant qu'elles sont toutes "plain" (guillemets et \ échappés au passage) ;
+// chaque itération écrit 16 octets, garantis par la réservation Utf8MaxBytes tant qu'il reste 16 unités
+template <Utf8Escape escape, class Source>
+size_t RunSse2(const Source& source, size_t i, size_t units, char*& out) {
+    char* p = out;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 16 <= units;) {
+        __m128i bytes;
+        uint32_t plain;
+        if constexpr (Source::WIDTH == 2) {
+            const __m128i a = _mm_loadu_si128(static_cast<const __m128i*>(source.Address(i)));
+            const __m128i b = _mm_loadu_si128(static_cast<const __m128i*>(source.Address(i + 8)));
+            // Unités < 0x80 : packus les garde intactes, le masque ASCII est calculé sur 16 bits
+            const __m128i ascii = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_and_si128(a, high), zero),
+                                                  _mm_cmpeq_epi16(_mm_and_si128(b, high), zero));
+            bytes = _mm_packus_epi16(a, b);
+            plain = static_cast<uint32_t>(_mm_movemask_epi8(_mm_andnot_si128(SpecialSse2<escape>(bytes), ascii)));
+        } else {
+            bytes = _mm_loadu_si128(static_cast<const __m128i*>(source.Address(i)));
+            plain = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(bytes, SpecialSse2<escape>(bytes)))) &
+                    0xFFFF;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), bytes);
+        if (plain != 0xFFFF) {
+            const unsigned count = CountTrailingZeros(~plain);
+            p += count;
+            i += count;
+            if (EscapeInPlace<escape>(p)) {
+                i++;
+                continue;
+            }
+            out = p;
+            return i;
+        }
+        p += 16;
+        i += 16;
+    }
+    out = p;
+    return RunScalar<escape>(source, i, units, out);
+}
+
+#endif  // TRANSCODE_X86
+
+#ifdef TRANSCODE_AVX2
+
+// Comme RunSse2, 32 unités par itération ; les pack AVX2 opèrent par moitié de 128 bits (permute pour l'ordre)
+template <Utf8Escape escape, class Source>
+TRANSCODE_AVX2_TARGET size_t RunAvx2(const Source& source, size_t i, size_t units, char*& out) {
+    char* p = out;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i high = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 32 <= units;) {
+        __m256i bytes;
+        __m256i plainBytes;
+        if constexpr (Source::WIDTH == 2) {
+            const __m256i a = _mm256_loadu_si256(static_cast<const __m256i*>(source.Address(i)));
+            const __m256i b = _mm256_loadu_si256(static_cast<const __m256i*>(source.Address(i + 16)));
+            const __m256i ascii = _mm256_permute4x64_epi64(
+                _mm256_packs_epi16(_mm256_cmpeq_epi16(_mm256_and_si256(a, high), zero),
+                                   _mm256_cmpeq_epi16(_mm256_and_si256(b, high), zero)),
+                0xD8);
+            bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+            plainBytes = ascii;
+        } else {
+            bytes = _mm256_loadu_si256(static_cast<const __m256i*>(source.Address(i)));
+            plainBytes = _mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(-1));
+        }
+        if (escape != Utf8Escape::None) {
+            __m256i special = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'));
+            if (escape == Utf8Escape::Json) {
+                special = _mm256_or_si256(special, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\')));
+                special = _mm256_or_si256(special, _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), bytes));
+            }
+            plainBytes = _mm256_andnot_si256(special, plainBytes);
+        }
+        const uint32_t plain = static_cast<uint32_t>(_mm256_movemask_epi8(plainBytes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), bytes);
+        if (plain != 0xFFFFFFFF) {
+            const unsigned count = CountTrailingZeros(~plain);
+            p += count;
+            i += count;
+            if (EscapeInPlace<escape>(p)) {
+                i++;
+                continue;
+            }
+            out = p;
+            return i;
+        }
+        p += 32;
+        i += 32;
+    }
+    out = p;
+    // Fin en SSE2 : GCC n'émet pas toujours vzeroupper avant cet appel terminal (pénalité de transition)
+    _mm256_zeroupper();
+    return RunSse2<escape>(source, i, units, out);
+}
+
+bool CpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    // OSXSAVE et AVX, puis registres YMM sauvegardés par le système
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif  // TRANSCODE_AVX2
+
+TranscodeKernel DetectKernel() {
+#if defined(TRANSCODE_AVX2)
+    if (CpuHasAvx2()) return TranscodeKernel::Avx2;
+#endif
+#if defined(TRANSCODE_X86)
+    return TranscodeKernel::Sse2;
+#else
+    return TranscodeKernel::Scalar;
+#endif
+}
+
+TranscodeKernel& Active() {
+    static TranscodeKernel kernel = DetectKernel();
+    return kernel;
+}
+
+// Voie rapide jusqu'au premier caractère à traiter, puis caractères un à un jusqu'au prochain ASCII "plain"
+template <TranscodeKernel kernel, Utf8Escape escape, class Source>
+char* Drive(const Source& source, size_t units, char* p) {
+    size_t i = 0;
+    while (i < units) {
+#if defined(TRANSCODE_AVX2)
+        if constexpr (kernel == TranscodeKernel::Avx2) i = RunAvx2<escape>(source, i, units, p);
+#endif
+#if defined(TRANSCODE_X86)
+        if constexpr (kernel == TranscodeKernel::Sse2) i = RunSse2<escape>(source, i, units, p);
+#endif
+        if constexpr (kernel == TranscodeKernel::Scalar) i = RunScalar<escape>(source, i, units, p);
+        do {
+            if (i >= units) return p;
+            p = EmitOne<escape>(source, i, units, p);
+        } while (i < units && !IsPlain<escape>(source[i]));
+    }
+    return p;
+}
+
+template <Utf8Escape escape, class Source>
+char* Transcode(const Source& source, size_t units, char* out) {
+    switch (Active()) {
+#if defined(TRANSCODE_AVX2)
+        case TranscodeKernel::Avx2: return Drive<TranscodeKernel::Avx2, escape>(source, units, out);
+#endif
+#if defined(TRANSCODE_X86)
+        case TranscodeKernel::Sse2: return Drive<TranscodeKernel::Sse2, escape>(source, units, out);
+#endif
+        default: return Drive<TranscodeKernel::Scalar, escape>(source, units, out);
+    }
+}
+
+template <class Source>
+char* Transcode(const Source& source, size_t units, char* out, Utf8Escape escape) {
+    switch (escape) {
+        case Utf8Escape::Csv: return Transcode<Utf8Escape::Csv>(source, units, out);
+        case Utf8Escape::Json: return Transcode<Utf8Escape::Json>(source, units, out);
+        default: return Transcode<Utf8Escape::None>(source, units, out);
+    }
+}
+
+}  // namespace
+
+char* Utf16ToUtf8(const char16_t* text, size_t units, char* out, Utf8Escape escape) {
+    return Transcode(Utf16Source{ text }, units, out, escape);
+}
+
+char* Utf16LeToUtf8(const uint8_t* bytes, size_t units, char* out, Utf8Escape escape) {
+    return Transcode(Utf16LeSource{ bytes }, units, out, escape);
+}
+
+char* Latin1ToUtf8(const uint8_t* bytes, size_t count, char* out, Utf8Escape escape) {
+    return Transcode(Latin1Source{ bytes }, count, out, escape);
+}
+
+void Latin1ToUtf16(const uint8_t* bytes, size_t count, char16_t* out) {
+    size_t i = 0;
+#if defined(TRANSCODE_X86)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#endif
+    for (; i < count; i++) out[i] = static_cast<char16_t>(bytes[i]);
+}
+
+TranscodeKernel ActiveTranscodeKernel() {
+    return Active();
+}
+
+const char* TranscodeKernelName(TranscodeKernel kernel) {
+    switch (kernel) {
+        case TranscodeKernel::Avx2: return "avx2";
+        case TranscodeKernel::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+bool SelectTranscodeKernel(TranscodeKernel kernel) {
+#if !defined(TRANSCODE_X86)
+    if (kernel != TranscodeKernel::Scalar) return false;
+#elif !defined(TRANSCODE_AVX2)
+    if (kernel == TranscodeKernel::Avx2) return false;
+#else
+    if (kernel == TranscodeKernel::Avx2 && !CpuHasAvx2()) return false;
+#endif
+    Active() = kernel;
+    return true;
+}
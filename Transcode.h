@@ -0,0 +1,53 @@
+/*
+ * Transcode - Transcodage en masse des chaînes UTF-16 du store vers UTF-8
+ *
+ * Chaque nom de valeur BAM est un chemin d'exécutable : à l'export, le passage en UTF-8 est l'un des
+ * coûts par ligne les plus lourds. Les noyaux écrivent directement dans un buffer fourni par l'appelant
+ * (ByteBuffer de l'export, std::string) depuis un char16_t*. Les noms de la ruche passent par le store
+ * (Latin1ToUtf16 pour les noms compressés) ; Utf16LeToUtf8 et Latin1ToUtf8 n'existent que pour
+ * bench/BenchTranscode, qui compare les mêmes noyaux sur les octets bruts de la ruche.
+ *
+ * - Voie rapide ASCII : 16 (SSE2) ou 32 (AVX2) unités par itération tant qu'aucune ne sort de l'ASCII ni
+ *   ne demande d'échappement, le premier caractère à traiter est localisé par masque ; le reste unité par
+ *   unité (multi-octets, paires de substitution, échappements)
+ * - Substituts validés : paire complète → 4 octets, substitut isolé → U+FFFD (comme AppendUtf8)
+ * - Échappement optionnel en une passe : CSV (guillemet doublé) ou JSON (\" \\ \n \r \t \u00XX)
+ * - Noyau choisi au premier appel : AVX2 si le processeur (et le système) le permettent, sinon SSE2 sur
+ *   x86 / x64, sinon scalaire ; SelectTranscodeKernel force un noyau (benchmarks)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class Utf8Escape : uint8_t {
+    None,
+    Csv,  // " → "" (champ entre guillemets)
+    Json  // " \ et caractères de contrôle (chaîne JSON)
+};
+
+enum class TranscodeKernel : uint8_t { Scalar, Sse2, Avx2 };
+
+// Octets de sortie à réserver (pire cas) : 3 par unité UTF-16 (une paire donne 4 octets pour 2 unités),
+// 6 en JSON (\u00XX)
+constexpr size_t Utf8MaxBytes(size_t units, Utf8Escape escape = Utf8Escape::None) {
+    return units * (escape == Utf8Escape::Json ? 6 : 3);
+}
+
+// UTF-16 → UTF-8 dans out (Utf8MaxBytes(units, escape) octets disponibles) ; retourne la fin écrite
+char* Utf16ToUtf8(const char16_t* text, size_t units, char* out, Utf8Escape escape = Utf8Escape::None);
+// Idem depuis des octets UTF-16LE non alignés ; benchmark uniquement, aucun appelant dans le parsing ni l'export
+char* Utf16LeToUtf8(const uint8_t* bytes, size_t units, char* out, Utf8Escape escape = Utf8Escape::None);
+// Latin-1 (un octet par caractère) → UTF-8 ; 2 octets au plus par caractère ; benchmark uniquement
+char* Latin1ToUtf8(const uint8_t* bytes, size_t count, char* out, Utf8Escape escape = Utf8Escape::None);
+// Nom compressé → UTF-16 (count unités dans out)
+void Latin1ToUtf16(const uint8_t* bytes, size_t count, char16_t* out);
+
+TranscodeKernel ActiveTranscodeKernel();
+const char* TranscodeKernelName(TranscodeKernel kernel);
+// false si le processeur ne le permet pas (noyau inchangé) ; à appeler avant les workers
+bool SelectTranscodeKernel(TranscodeKernel kernel);
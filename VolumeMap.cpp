@@ -0,0 +1,189 @@
+/*
+ * VolumeMap - Implémentation de la normalisation des chemins de périphérique
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "VolumeMap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+constexpr char16_t DEVICE_PREFIX[] = u"\\Device\\";
+constexpr size_t DEVICE_PREFIX_LENGTH = 8;
+constexpr size_t MBR_IDENTITY_SIZE = 12;
+constexpr size_t GPT_IDENTITY_SIZE = 24;
+
+char16_t UpperAscii(char16_t c) { return c >= u'a' && c <= u'z' ? static_cast<char16_t>(c - 32) : c; }
+
+bool EqualsNoCase(std::u16string_view a, std::u16string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (UpperAscii(a[i]) != UpperAscii(b[i])) return false;
+    }
+    return true;
+}
+
+// "\DosDevices\C:" → 'C', sinon 0
+char16_t DriveLetterOf(const RegfName& name) {
+    static const char PREFIX[] = "\\DosDevices\\";
+    const size_t prefixLength = sizeof(PREFIX) - 1;
+    if (name.Length() != prefixLength + 2 || name.At(prefixLength + 1) != u':') return 0;
+    for (size_t i = 0; i < prefixLength; i++) {
+        if (UpperAscii(name.At(i)) != UpperAscii(static_cast<char16_t>(PREFIX[i]))) return 0;
+    }
+    const char16_t letter = UpperAscii(name.At(prefixLength));
+    return letter >= u'A' && letter <= u'Z' ? letter : 0;
+}
+
+}  // namespace
+
+VolumeMap::VolumeMap() { Clear(); }
+
+void VolumeMap::Clear() {
+    prefixes.clear();
+    mounted.clear();
+    systemLetter = 0;
+    // Redirecteur réseau : \Device\Mup\serveur\partage → \\serveur\partage
+    prefixes.push_back({ u"Mup", u"\\" });
+}
+
+bool VolumeMap::Load(const RegfHive& hive) {
+    Clear();
+    const uint32_t key = hive.OpenKey(hive.RootKey(), "MountedDevices");
+    if (key == REGF_NO_CELL) return false;
+
+    std::vector<uint8_t> data;
+    hive.ForEachValue(key, [&](const RegfValue& value) {
+        if (!hive.ReadValueData(value, data) || data.empty()) return true;
+
+        MountedVolume volume;
+        volume.letter = DriveLetterOf(value.name);
+        if (data.size() == MBR_IDENTITY_SIZE) {
+            volume.kind = VolumeKind::Mbr;
+            volume.diskSignature = RegfRead32(data.data());
+            volume.partitionOffset = RegfRead64(data.data() + 4);
+        } else if (data.size() == GPT_IDENTITY_SIZE && std::memcmp(data.data(), "DMIO:ID:", 8) == 0) {
+            volume.kind = VolumeKind::Gpt;
+        }
+        volume.identity = data;
+        if (volume.letter == u'C') systemLetter = u'C';
+        mounted.push_back(std::move(volume));
+        return true;
+    });
+
+    MapSingleMbrDisk();
+    return true;
+}
+
+// Numérotation HarddiskVolumeN = ordre des partitions sur le disque : fiable seulement si toutes les
+// partitions connues (avec ou sans lettre) appartiennent au même disque MBR
+void VolumeMap::MapSingleMbrDisk() {
+    std::vector<uint64_t> offsets;
+    uint32_t signature = 0;
+    for (const MountedVolume& volume : mounted) {
+        if (volume.kind == VolumeKind::Gpt) return;
+        if (volume.kind != VolumeKind::Mbr) continue;
+        if (!offsets.empty() && volume.diskSignature != signature) return;
+        signature = volume.diskSignature;
+        offsets.push_back(volume.partitionOffset);
+    }
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+    for (const MountedVolume& volume : mounted) {
+        if (volume.kind != VolumeKind::Mbr || !volume.letter) continue;
+        const size_t ordinal =
+            std::lower_bound(offsets.begin(), offsets.end(), volume.partitionOffset) - offsets.begin() + 1;
+        const std::string number = std::to_string(ordinal);
+        std::u16string device = u"HarddiskVolume";
+        device.append(number.begin(), number.end());
+        const char16_t target[] = { volume.letter, u':', 0 };
+        Add(device, target);
+    }
+}
+
+void VolumeMap::Add(std::u16string_view device, std::u16string_view target) {
+    for (Prefix& prefix : prefixes) {
+        if (EqualsNoCase(prefix.device, device)) {
+            prefix.target.assign(target);
+            return;
+        }
+    }
+    prefixes.push_back({ std::u16string(device), std::u16string(target) });
+}
+
+std::u16string_view VolumeMap::SystemDevice(std::u16string_view path) {
+    static constexpr std::u16string_view SYSTEM32 = u"\\Windows\\System32\\";
+    std::u16string_view device;
+    std::u16string_view rest;
+    if (!SplitDevicePath(path, device, rest) || rest.size() <= SYSTEM32.size() ||
+        !EqualsNoCase(rest.substr(0, SYSTEM32.size()), SYSTEM32)) {
+        return {};
+    }
+    return device;
+}
+
+bool VolumeMap::AnchorSystemVolume(const std::vector<std::u16string_view>& paths) {
+    if (!systemLetter) return false;
+
+    std::vector<std::pair<std::u16string_view, size_t>> counts;
+    for (std::u16string_view path : paths) {
+        const std::u16string_view device = SystemDevice(path);
+        if (device.empty()) continue;
+        auto it = std::find_if(counts.begin(), counts.end(),
+                               [&](const auto& count) { return EqualsNoCase(count.first, device); });
+        if (it == counts.end()) counts.emplace_back(device, 1);
+        else it->second++;
+    }
+    if (counts.empty()) return false;
+    std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    // Plusieurs installations à égalité : pas de choix arbitraire
+    if (counts.size() > 1 && counts[0].second == counts[1].second) return false;
+
+    const std::u16string_view device = counts[0].first;
+    const char16_t target[] = { systemLetter, u':', 0 };
+    if (Find(device)) return false;
+    for (const Prefix& prefix : prefixes) {
+        if (EqualsNoCase(prefix.target, target)) return false;
+    }
+    Add(device, target);
+    return true;
+}
+
+const VolumeMap::Prefix* VolumeMap::Find(std::u16string_view device) const {
+    for (const Prefix& prefix : prefixes) {
+        if (EqualsNoCase(prefix.device, device)) return &prefix;
+    }
+    return nullptr;
+}
+
+bool VolumeMap::SplitDevicePath(std::u16string_view path, std::u16string_view& device,
+                                std::u16string_view& rest) {
+    if (path.size() <= DEVICE_PREFIX_LENGTH ||
+        !EqualsNoCase(path.substr(0, DEVICE_PREFIX_LENGTH), DEVICE_PREFIX)) {
+        return false;
+    }
+    size_t end = path.find(u'\\', DEVICE_PREFIX_LENGTH);
+    if (end == std::u16string_view::npos) end = path.size();
+    device = path.substr(DEVICE_PREFIX_LENGTH, end - DEVICE_PREFIX_LENGTH);
+    rest = path.substr(end);
+    return !device.empty();
+}
+
+bool VolumeMap::Normalize(std::u16string_view path, std::u16string& out) const {
+    std::u16string_view device;
+    std::u16string_view rest;
+    if (!SplitDevicePath(path, device, rest)) return false;
+    const Prefix* prefix = Find(device);
+    if (!prefix) return false;
+
+    out.assign(prefix->target);
+    if (rest.empty()) out.push_back(u'\\');
+    out.append(rest);
+    return true;
+}
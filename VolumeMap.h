@@ -0,0 +1,89 @@
+/*
+ * VolumeMap - Chemins de périphérique NT → lettres de lecteur
+ *
+ * BAM enregistre "\Device\HarddiskVolume3\Windows\explorer.exe" ; les analystes et les jointures
+ * avec les autres artefacts attendent "C:\Windows\explorer.exe".
+ *
+ * - Table compacte de préfixes de volume construite une fois par ruche : normaliser un chemin =
+ *   isoler le composant après \Device\, une recherche dans la table, une copie dans un buffer réutilisé
+ * - Hors-ligne : SYSTEM\MountedDevices décodé (\DosDevices\X: et \??\Volume{GUID}) ; données MBR =
+ *   signature de disque + offset de partition, GPT = "DMIO:ID:" + GUID de partition
+ *   * Un seul disque MBR connu : HarddiskVolumeN = N-ième partition par offset croissant
+ *   * Sinon (GPT, plusieurs disques) : les numéros HarddiskVolumeN ne sont pas dans la ruche ;
+ *     le volume dont les chemins passent par \Windows\System32\ reçoit la lettre système
+ *     (C: si MountedDevices la connaît), voir AnchorSystemVolume
+ * - Live : QueryDosDeviceW donne la correspondance exacte, ajoutée par Add
+ * - \Device\Mup\serveur\partage\... → \\serveur\partage\... (UNC), sans dépendre de la ruche
+ *
+ * Un chemin non reconnu reste tel quel ; le chemin brut est toujours conservé à côté.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include "RegfHive.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class VolumeKind : uint8_t {
+    Mbr,     // Signature de disque + offset de partition (12 octets)
+    Gpt,     // "DMIO:ID:" + GUID de partition (24 octets)
+    Device,  // Chaîne d'interface de périphérique (amovibles, CD-ROM...)
+};
+
+// Une valeur de MountedDevices
+struct MountedVolume {
+    char16_t letter = 0;  // 0 : \??\Volume{GUID} sans lettre
+    VolumeKind kind = VolumeKind::Device;
+    uint32_t diskSignature = 0;
+    uint64_t partitionOffset = 0;
+    std::vector<uint8_t> identity;  // Données brutes : même volume = mêmes octets
+};
+
+class VolumeMap {
+public:
+    VolumeMap();
+
+    // Décode SYSTEM\MountedDevices et déduit ce qui peut l'être ; false si la clé est absente
+    bool Load(const RegfHive& hive);
+    void Clear();
+
+    // device = composant après \Device\ (ex. u"HarddiskVolume3"), target = remplacement (ex. u"C:")
+    void Add(std::u16string_view device, std::u16string_view target);
+
+    // Le volume qui porte le plus de chemins \Device\<volume>\Windows\System32\... reçoit la lettre
+    // système, si ni ce volume ni la lettre ne sont déjà attribués. false si rien n'a été ajouté.
+    bool AnchorSystemVolume(const std::vector<std::u16string_view>& paths);
+
+    // Écrit la forme avec lettre dans out (vidé) ; false si aucun préfixe ne correspond
+    bool Normalize(std::u16string_view path, std::u16string& out) const;
+
+    // "\Device\<device>\Windows\System32\..." → device, sinon vide (casse ignorée)
+    static std::u16string_view SystemDevice(std::u16string_view path);
+
+    // "\Device\<device>\<rest>" → device, rest (commence par '\' ou vide)
+    static bool SplitDevicePath(std::u16string_view path, std::u16string_view& device, std::u16string_view& rest);
+
+    const std::vector<MountedVolume>& Mounted() const { return mounted; }
+    size_t PrefixCount() const { return prefixes.size(); }
+    char16_t SystemLetter() const { return systemLetter; }
+
+private:
+    struct Prefix {
+        std::u16string device;
+        std::u16string target;
+    };
+
+    const Prefix* Find(std::u16string_view device) const;
+    void MapSingleMbrDisk();
+
+    std::vector<Prefix> prefixes;
+    std::vector<MountedVolume> mounted;
+    char16_t systemLetter = 0;
+};
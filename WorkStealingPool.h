@@ -0,0 +1,105 @@
+/*
+ * WorkStealingPool - Répartition de tâches hétérogènes sur tous les cœurs
+ *
+ * - Tâches triées par poids décroissant (taille de ruche) puis distribuées en tourniquet
+ * - Chaque worker dépile sa propre file par l'avant (grosses tâches d'abord)
+ * - Un worker à vide vole par l'arrière de la file la plus chargée (petites tâches),
+ *   ce qui garde tous les cœurs occupés même quand les tailles varient d'un facteur 100
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threads = 0)
+        : threadCount(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+    unsigned Threads() const { return threadCount; }
+
+    // fn(size_t task, unsigned worker) pour chaque tâche ; bloque jusqu'à la fin
+    template <class F>
+    void Run(const std::vector<uint64_t>& weights, F&& fn) {
+        const size_t taskCount = weights.size();
+        if (taskCount == 0) return;
+
+        std::vector<size_t> order(taskCount);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return weights[a] > weights[b]; });
+
+        const unsigned workers = static_cast<unsigned>(std::min<size_t>(threadCount, taskCount));
+        std::vector<Queue> queues(workers);
+        for (size_t i = 0; i < taskCount; i++) {
+            queues[i % workers].tasks.push_back(order[i]);
+        }
+
+        auto workerMain = [&](unsigned self) {
+            size_t task;
+            while (PopLocal(queues[self], task) || Steal(queues, self, task)) {
+                fn(task, self);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; w++) {
+            threads.emplace_back(workerMain, w);
+        }
+        workerMain(0);
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    static bool PopLocal(Queue& queue, size_t& task) {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    // Vol par l'arrière de la file la plus longue ; aucune tâche n'est ajoutée
+    // après le démarrage, donc toutes les files vides = travail terminé
+    static bool Steal(std::vector<Queue>& queues, unsigned self, size_t& task) {
+        while (true) {
+            Queue* victim = nullptr;
+            size_t longest = 0;
+            for (unsigned i = 0; i < queues.size(); i++) {
+                if (i == self) continue;
+                std::lock_guard<std::mutex> guard(queues[i].lock);
+                if (queues[i].tasks.size() > longest) {
+                    longest = queues[i].tasks.size();
+                    victim = &queues[i];
+                }
+            }
+            if (!victim) return false;
+
+            std::lock_guard<std::mutex> guard(victim->lock);
+            if (!victim->tasks.empty()) {
+                task = victim->tasks.back();
+                victim->tasks.pop_back();
+                return true;
+            }
+        }
+    }
+
+    unsigned threadCount;
+};
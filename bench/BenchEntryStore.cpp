@@ -0,0 +1,198 @@
+/*
+ * BenchEntryStore - Empreinte mémoire : ancienne BamDamEntry (6 x std::wstring) vs EntryStore
+ *
+ * Usage : BenchEntryStore [lignes] [--legacy | --store]
+ *   sans mode : lance les deux mesures dans deux processus séparés (RSS non restituée sinon)
+ *
+ * Jeu synthétique type flotte : 1 hôte pour 500 lignes, 3 SIDs par hôte,
+ * 1 chemin distinct pour 20 lignes, chemins de 50 à 130 caractères.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "../EntryStore.h"
+#include "../BamDamHive.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Ancienne structure, conservée ici uniquement comme référence de mesure
+struct LegacyBamDamEntry {
+    std::wstring timestamp;
+    std::wstring sid;
+    std::wstring username;
+    std::wstring executablePath;
+    std::wstring source;
+    std::wstring notes;
+    unsigned long long fileTimeRaw;
+};
+
+size_t CurrentRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.WorkingSetSize;
+#else
+    long pages = 0, resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(f);
+    }
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+struct Rng {
+    uint64_t state;
+    uint64_t Next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+struct SyntheticRow {
+    size_t host;
+    size_t sid;
+    size_t path;
+    uint64_t fileTime;
+    bool dam;
+};
+
+const char* const DIRS[] = {
+    "\\Device\\HarddiskVolume3\\Windows\\System32\\",
+    "\\Device\\HarddiskVolume3\\Program Files\\Microsoft Office\\root\\Office16\\",
+    "\\Device\\HarddiskVolume3\\Users\\%s\\AppData\\Local\\Temp\\",
+    "\\Device\\HarddiskVolume3\\Users\\%s\\Downloads\\",
+    "\\Device\\HarddiskVolume3\\Program Files (x86)\\Google\\Chrome\\Application\\",
+};
+
+std::u16string MakePath(size_t id) {
+    Rng rng{ id * 0x9E3779B97F4A7C15ULL + 1 };
+    char user[32];
+    std::snprintf(user, sizeof(user), "user%zu", id % 997);
+    char dir[256];
+    std::snprintf(dir, sizeof(dir), DIRS[rng.Next() % 5], user);
+    std::string path = dir;
+    size_t nameLength = 8 + rng.Next() % 40;
+    for (size_t i = 0; i < nameLength; i++) {
+        path.push_back(static_cast<char>('a' + rng.Next() % 26));
+    }
+    path += ".exe";
+    return std::u16string(path.begin(), path.end());
+}
+
+std::u16string MakeSid(size_t id) {
+    std::string sid = "S-1-5-21-3623811015-3361044348-30300820-" + std::to_string(1000 + id);
+    return std::u16string(sid.begin(), sid.end());
+}
+
+SyntheticRow MakeRow(size_t i, size_t rows) {
+    Rng rng{ i * 0xD1B54A32D192ED03ULL + 7 };
+    SyntheticRow row;
+    row.host = i / 500;
+    row.sid = row.host * 3 + rng.Next() % 3;
+    row.path = rng.Next() % std::max<size_t>(1, rows / 20);
+    row.fileTime = 132500000000000000ULL + rng.Next() % 100000000000000ULL;
+    row.dam = (rng.Next() & 7) == 0;
+    return row;
+}
+
+void RunLegacy(size_t rows) {
+    size_t before = CurrentRss();
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<LegacyBamDamEntry> entries;
+    for (size_t i = 0; i < rows; i++) {
+        SyntheticRow row = MakeRow(i, rows);
+        LegacyBamDamEntry entry;
+        std::u16string path = MakePath(row.path);
+        std::u16string sid = MakeSid(row.sid);
+        entry.fileTimeRaw = row.fileTime;
+        entry.timestamp = FileTimeToStringPrecise(row.fileTime);
+        entry.sid = ToWide(sid);
+        entry.username = L"<Inconnu>";
+        entry.executablePath = ToWide(path);
+        entry.source = row.dam ? L"dam" : L"bam";
+        uint64_t matched = 0;
+        entry.notes = PathClassifier::Default().Match(path, &matched) ? L"Emplacement suspect" : L"";
+        entries.push_back(entry);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    size_t rss = CurrentRss() - before;
+    std::printf("{\"layout\":\"legacy\",\"rows\":%zu,\"rss_bytes\":%zu,\"bytes_per_row\":%.1f,\"build_s\":%.3f}\n",
+                rows, rss, static_cast<double>(rss) / rows, seconds);
+}
+
+void RunStore(size_t rows) {
+    size_t before = CurrentRss();
+    auto t0 = std::chrono::steady_clock::now();
+
+    EntryStore store;
+    uint32_t user = store.users.Intern(u"<Inconnu>");
+    for (size_t i = 0; i < rows; i++) {
+        SyntheticRow row = MakeRow(i, rows);
+        std::u16string path = MakePath(row.path);
+        std::string host = "HOST-" + std::to_string(row.host);
+        uint32_t hostId = store.hosts.Intern(std::u16string(host.begin(), host.end()));
+        uint32_t sidId = store.sids.Intern(MakeSid(row.sid));
+        uint32_t pathId = store.paths.Intern(path);
+        store.Add(hostId, sidId, user, pathId, row.fileTime, row.dam ? EntrySource::Dam : EntrySource::Bam,
+                  PathClassifier::Default().Classify(path, store.matches));
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    size_t rss = CurrentRss() - before;
+    std::printf("{\"layout\":\"store\",\"rows\":%zu,\"rss_bytes\":%zu,\"bytes_per_row\":%.1f,"
+                "\"accounted_bytes\":%zu,\"build_s\":%.3f}\n",
+                rows, rss, static_cast<double>(rss) / rows, store.MemoryBytes(), seconds);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t rows = 10000000;
+    const char* mode = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            mode = argv[i];
+        } else {
+            rows = std::strtoull(argv[i], nullptr, 10);
+        }
+    }
+
+    if (!mode) {
+        std::string self = std::string("\"") + argv[0] + "\" " + std::to_string(rows);
+        int legacy = std::system((self + " --legacy").c_str());
+        int store = std::system((self + " --store").c_str());
+        return legacy == 0 && store == 0 ? 0 : 1;
+    }
+    if (std::strcmp(mode, "--legacy") == 0) {
+        RunLegacy(rows);
+    } else if (std::strcmp(mode, "--store") == 0) {
+        RunStore(rows);
+    } else {
+        std::fprintf(stderr, "Usage : BenchEntryStore [lignes] [--legacy | --store]\n");
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * BenchFileTime - Coût du formatage FILETIME en ns par timestamp
+ *
+ * Usage : BenchFileTime [nombre]
+ *
+ * - legacy  : conversion système + printf + std::wstring (chemin historique)
+ * - single  : FormatFileTime dans un buffer fourni (char / wchar_t)
+ * - column  : FormatFileTimeColumn, timestamps aléatoires puis triés (préfixe de date réutilisé)
+ *
+ * Sortie : une ligne JSON par mesure.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "../FileTimeFormat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+
+volatile size_t sink = 0;
+
+std::wstring LegacyFormat(uint64_t fileTime) {
+#ifdef _WIN32
+    FILETIME ft;
+    ft.dwLowDateTime = static_cast<DWORD>(fileTime & 0xFFFFFFFF);
+    ft.dwHighDateTime = static_cast<DWORD>(fileTime >> 32);
+    SYSTEMTIME st;
+    if (!FileTimeToSystemTime(&ft, &st)) return L"Invalide";
+    wchar_t buf[128];
+    swprintf_s(buf, L"%02d/%02d/%04d %02d:%02d:%02d.%03d",
+               st.wDay, st.wMonth, st.wYear, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
+    return buf;
+#else
+    const int64_t unixSeconds = static_cast<int64_t>(fileTime / FILETIME_TICKS_PER_SECOND) - 11644473600LL;
+    time_t t = static_cast<time_t>(unixSeconds);
+    struct tm st;
+    gmtime_r(&t, &st);
+    wchar_t buf[128];
+    std::swprintf(buf, 128, L"%02d/%02d/%04d %02d:%02d:%02d.%03d", st.tm_mday, st.tm_mon + 1, st.tm_year + 1900,
+                  st.tm_hour, st.tm_min, st.tm_sec, static_cast<int>((fileTime / 10000) % 1000));
+    return buf;
+#endif
+}
+
+template <class F>
+double NsPerItem(size_t count, F&& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return ns / static_cast<double>(count);
+}
+
+void Report(const char* name, const char* variant, size_t count, double ns) {
+    std::printf("{\"bench\":\"filetime\",\"case\":\"%s\",\"variant\":\"%s\",\"count\":%zu,\"ns_per_ts\":%.2f}\n",
+                name, variant, count, ns);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+    std::vector<uint64_t> times(count);
+    uint64_t state = 0x243F6A8885A308D3ULL;
+    for (auto& t : times) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        t = 132000000000000000ULL + state % 20000000000000000ULL;  // ~2019-2082
+    }
+
+    Report("legacy", "wstring_ms", count, NsPerItem(count, [&] {
+        for (uint64_t t : times) sink += LegacyFormat(t).size();
+    }));
+
+    const TimePrecision precisions[] = { TimePrecision::Milliseconds, TimePrecision::Microseconds,
+                                         TimePrecision::Ticks100ns };
+    const char* names[] = { "ms", "us", "100ns" };
+
+    for (int p = 0; p < 3; p++) {
+        TimeFormat format;
+        format.precision = precisions[p];
+
+        Report("single_char", names[p], count, NsPerItem(count, [&] {
+            char buf[FILETIME_TEXT_MAX];
+            for (uint64_t t : times) sink += FormatFileTime(t, format, buf);
+        }));
+
+        Report("single_wchar", names[p], count, NsPerItem(count, [&] {
+            wchar_t buf[FILETIME_TEXT_MAX];
+            for (uint64_t t : times) sink += FormatFileTime(t, format, buf);
+        }));
+    }
+
+    TimeFormat iso;
+    iso.style = TimeStyle::Iso8601;
+    iso.precision = TimePrecision::Ticks100ns;
+    iso.offsetMinutes = 60;
+    Report("single_char", "iso_100ns_offset", count, NsPerItem(count, [&] {
+        char buf[FILETIME_TEXT_MAX];
+        for (uint64_t t : times) sink += FormatFileTime(t, iso, buf);
+    }));
+
+    std::vector<char> column(count * FILETIME_TEXT_MAX);
+    TimeFormat format;
+    Report("column_random", "us", count, NsPerItem(count, [&] {
+        FormatFileTimeColumn(times.data(), count, format, column.data());
+        sink += static_cast<unsigned char>(column[count / 2 * FILETIME_TEXT_MAX]);
+    }));
+
+    std::sort(times.begin(), times.end());
+    Report("column_sorted", "us", count, NsPerItem(count, [&] {
+        FormatFileTimeColumn(times.data(), count, format, column.data());
+        sink += static_cast<unsigned char>(column[count / 2 * FILETIME_TEXT_MAX]);
+    }));
+
+    return sink == 42 ? 1 : 0;
+}
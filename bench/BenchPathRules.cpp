@@ -0,0 +1,146 @@
+/*
+ * BenchPathRules - Débit de classification (chemins/s) selon le nombre de règles
+ *
+ * Usage : BenchPathRules [chemins] [règles max]
+ *
+ * - naive     : chemin replié une fois, puis un find() par règle (équivalent des anciens find en série)
+ * - automaton : PathClassifier, un seul passage Aho-Corasick par chemin
+ *
+ * Règles synthétiques : noms de binaires (name) et fragments de dossiers (contains) de 5 à 14 caractères.
+ * Chemins de 50 à 130 caractères, environ 1 % touchés par une règle.
+ * Sortie : une ligne JSON par mesure.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "../PathRules.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile uint64_t sink = 0;
+
+struct Rng {
+    uint64_t state;
+    uint64_t Next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+std::u16string RandomWord(Rng& rng, size_t minLength, size_t maxLength) {
+    size_t length = minLength + rng.Next() % (maxLength - minLength + 1);
+    std::u16string word;
+    for (size_t i = 0; i < length; i++) {
+        word.push_back(static_cast<char16_t>(u'a' + rng.Next() % 26));
+    }
+    return word;
+}
+
+std::u16string MakePath(Rng& rng, const std::vector<std::u16string>& hits) {
+    static const char16_t* const DIRS[] = { u"Windows\\System32", u"Program Files\\Vendor", u"Users\\bob\\AppData",
+                                            u"Program Files (x86)\\Common Files", u"Windows\\SysWOW64" };
+    std::u16string path = u"\\Device\\HarddiskVolume3\\";
+    path += DIRS[rng.Next() % 5];
+    while (path.size() < 50 + rng.Next() % 60) {
+        path += u'\\';
+        path += RandomWord(rng, 4, 12);
+    }
+    path += u'\\';
+    if (!hits.empty() && rng.Next() % 100 == 0) {
+        path += hits[rng.Next() % hits.size()];
+    } else {
+        path += RandomWord(rng, 5, 14);
+        path += u".exe";
+    }
+    return path;
+}
+
+void Report(const char* variant, size_t rules, size_t states, size_t paths, double seconds, uint64_t hits) {
+    std::printf("{\"bench\":\"path_rules\",\"variant\":\"%s\",\"rules\":%zu,\"states\":%zu,\"paths\":%zu,"
+                "\"paths_per_s\":%.0f,\"ns_per_path\":%.1f,\"matched\":%llu}\n",
+                variant, rules, states, paths, paths / seconds, seconds * 1e9 / paths,
+                static_cast<unsigned long long>(hits));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t pathCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t maxRules = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+
+    Rng rng{ 0x9E3779B97F4A7C15ULL };
+    std::vector<std::u16string> patterns;
+    std::vector<bool> isName;
+    for (size_t i = 0; i < maxRules; i++) {
+        if (i % 2 == 0) {
+            patterns.push_back(RandomWord(rng, 5, 10) + u".exe");
+            isName.push_back(true);
+        } else {
+            patterns.push_back(u"\\" + RandomWord(rng, 5, 12) + u"\\");
+            isName.push_back(false);
+        }
+    }
+
+    for (size_t ruleCount = 1; ruleCount <= maxRules; ruleCount *= 4) {
+        PathClassifier classifier;
+        std::vector<std::u16string> folded;
+        for (size_t r = 0; r < ruleCount; r++) {
+            classifier.AddRule(isName[r] ? RuleKind::Name : RuleKind::Contains, "r" + std::to_string(r), patterns[r],
+                               u"");
+            std::u16string f = patterns[r];
+            for (auto& c : f) c = FoldCase(c);
+            folded.push_back(std::move(f));
+        }
+        classifier.Compile();
+
+        std::vector<std::u16string> hitNames(patterns.begin(), patterns.begin() + ruleCount);
+        Rng pathRng{ 42 };
+        std::vector<std::u16string> paths;
+        paths.reserve(pathCount);
+        for (size_t i = 0; i < pathCount; i++) {
+            paths.push_back(MakePath(pathRng, hitNames));
+        }
+
+        // Référence : repli + un find par règle
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t naiveHits = 0;
+        std::u16string lower;
+        for (const auto& path : paths) {
+            lower = path;
+            for (auto& c : lower) c = FoldCase(c);
+            bool any = false;
+            for (size_t r = 0; r < ruleCount; r++) {
+                size_t pos = lower.find(folded[r]);
+                if (pos == std::u16string::npos) continue;
+                if (isName[r]) {
+                    pos = lower.rfind(folded[r]);
+                    if (pos + folded[r].size() != lower.size() || (pos > 0 && lower[pos - 1] != u'\\')) continue;
+                }
+                any = true;
+            }
+            naiveHits += any;
+        }
+        double naive = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        Report("naive", ruleCount, 0, pathCount, naive, naiveHits);
+
+        t0 = std::chrono::steady_clock::now();
+        uint64_t automatonHits = 0;
+        std::vector<uint64_t> words(classifier.WordCount());
+        for (const auto& path : paths) {
+            automatonHits += classifier.Match(path, words.data());
+        }
+        double automaton = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        Report("automaton", ruleCount, classifier.StateCount(), pathCount, automaton, automatonHits);
+        sink = sink + naiveHits + automatonHits;
+    }
+    return 0;
+}
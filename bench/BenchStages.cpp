@@ -0,0 +1,493 @@
+/*
+ * BenchStages - Temps de chaque étape du traitement sur des ruches synthétiques (HiveGen)
+ *
+ * Usage : BenchStages [--sids N] [--values N] [--path-len min:max] [--skewed] [--dirty ratio]
+ *                     [--deleted ratio] [--reps N] [--out fichier.jsonl]
+ *
+ * Étapes (équivalent dans l'interface entre parenthèses) :
+ *   open          RegfHive::Open, ruche consolidée
+ *   open_replay   RegfHive::Open + application de .LOG1/.LOG2 (si --dirty)
+ *   key_walk      parcours des clés SID et des listes de valeurs (ParseBamDam)
+ *   value_decode  noms + FILETIME de chaque valeur, sans stockage (ParseBamDamKey)
+ *   parse_store   ParseBamDamHive vers un EntryStore, classification comprise
+ *   carve         CarveBamDamHive sur la même ruche avec --deleted valeurs supprimées : recherche dans les
+ *                 cellules libres, validation, dédoublonnage contre les valeurs vivantes (--carve)
+ *   cursor_walk   BamDamCursor : entrées en vues, comptage par SID sans stockage
+ *   stream_chunks StreamBamDamHive par blocs de 4096 lignes, blocs libérés aussitôt (--chunk)
+ *   format_time   FileTimeToStringPrecise ligne par ligne
+ *   format_column FormatFileTimeColumn (chemin des exports)
+ *   sort          EntrySorter, date décroissante : permutation d'affichage (OnSort)
+ *   sort_multi    EntrySorter, utilisateur, chemin puis date décroissante (Maj+clic sur les colonnes)
+ *   aggregate     nombre d'exécutions par utilisateur (OnFilter)
+ *   timeline      TimelineBuilder sur 8 copies de la ruche (hôtes distincts) : tri, encodage des runs,
+ *                 déversement sur disque (budget réduit) et fusion k-voies (--timeline)
+ *   query_index   EntryIndex sur ces 8 hôtes réunis : index temporel, postings, trie des chemins (--query)
+ *   query_eval    requête composée SID + plage de temps + préfixe de chemin + règles, lignes par FILETIME
+ *   case_save     CaseFile::Save de cette flotte et de son index (fichier synchronisé puis renommé)
+ *   case_open     CaseFile::Open : projection, store et index adossés, puis la requête de query_eval
+ *   rarity        RaritySketch sur ces 8 hôtes répartis entre deux sketches (workers), fusion et rapport (--rarity)
+ *   export_*      ExportPipeline CSV / JSON Lines / BDCOL vers un fichier temporaire (OnExport)
+ *   log_enqueue   AsyncLogger::Log côté appelant, vidage sur disque hors mesure (Log)
+ *
+ * Sortie : une ligne JSON de configuration, puis une ligne JSON par étape (min, médiane, moyenne
+ * sur --reps mesures), sur stdout et dans --out. Même graine, mêmes ruches : deux versions
+ * se comparent ligne à ligne.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "HiveGen.h"
+
+#include "../BamDamCarve.h"
+#include "../BamDamHive.h"
+#include "../BamDamStream.h"
+#include "../CaseFile.h"
+#include "../EntryExport.h"
+#include "../EntryQuery.h"
+#include "../EntrySort.h"
+#include "../Rarity.h"
+#include "../Telemetry.h"
+#include "../Timeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+volatile uint64_t sink = 0;
+
+struct Config {
+    HiveGenOptions hive;
+    double deletedRatio = 0.05;  // Ruche de l'étape carve seulement
+    unsigned reps = 20;
+    fs::path out;
+};
+
+struct StageResult {
+    double minMs = 0;
+    double medianMs = 0;
+    double meanMs = 0;
+};
+
+// setup() précède chaque mesure sans être compté
+template <class Setup, class F>
+StageResult Measure(unsigned reps, Setup&& setup, F&& body) {
+    std::vector<double> times;
+    times.reserve(reps);
+    for (unsigned i = 0; i < reps; i++) {
+        setup();
+        auto t0 = std::chrono::steady_clock::now();
+        body();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    std::sort(times.begin(), times.end());
+    StageResult result;
+    result.minMs = times.front();
+    result.medianMs = times[times.size() / 2];
+    for (double t : times) result.meanMs += t;
+    result.meanMs /= static_cast<double>(times.size());
+    return result;
+}
+
+template <class F>
+StageResult Measure(unsigned reps, F&& body) {
+    return Measure(reps, [] {}, body);
+}
+
+class Reporter {
+public:
+    explicit Reporter(const fs::path& path) {
+        if (!path.empty()) file = std::fopen(path.u8string().c_str(), "wb");
+    }
+    ~Reporter() {
+        if (file) std::fclose(file);
+    }
+    bool Ok() const { return file != nullptr; }
+
+    void Line(const std::string& json) {
+        std::printf("%s\n", json.c_str());
+        std::fflush(stdout);
+        if (file) std::fprintf(file, "%s\n", json.c_str());
+    }
+
+    // bytes : volume lu par l'étape (0 si sans objet)
+    void Stage(const char* stage, size_t items, const char* unit, uint64_t bytes, unsigned reps,
+               const StageResult& r) {
+        char line[512];
+        double seconds = r.medianMs / 1000.0;
+        std::snprintf(line, sizeof(line),
+                      "{\"bench\":\"stages\",\"stage\":\"%s\",\"items\":%zu,\"unit\":\"%s\",\"reps\":%u,"
+                      "\"min_ms\":%.4f,\"median_ms\":%.4f,\"mean_ms\":%.4f,\"items_per_s\":%.0f,"
+                      "\"ns_per_item\":%.1f,\"mb_per_s\":%.1f}",
+                      stage, items, unit, reps, r.minMs, r.medianMs, r.meanMs,
+                      seconds > 0 ? items / seconds : 0.0, items ? r.medianMs * 1e6 / items : 0.0,
+                      seconds > 0 && bytes ? bytes / 1048576.0 / seconds : 0.0);
+        Line(line);
+    }
+
+private:
+    FILE* file = nullptr;
+};
+
+const char* CompilerName() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc";
+#else
+    return "inconnu";
+#endif
+}
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage : BenchStages [--sids N] [--values N] [--path-len min:max] [--skewed] [--dirty ratio]\n"
+                 "                    [--deleted ratio] [--reps N] [--out fichier.jsonl]\n");
+}
+
+bool ParseArgs(int argc, char* argv[], Config& config) {
+    config.hive.sidCount = 16;
+    config.hive.valuesPerSid = 1000;
+    config.hive.dirtyRatio = 0.05;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sids" && hasValue) {
+            config.hive.sidCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--values" && hasValue) {
+            config.hive.valuesPerSid = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--path-len" && hasValue) {
+            char* end = nullptr;
+            config.hive.pathMin = static_cast<uint32_t>(std::strtoul(argv[++i], &end, 10));
+            config.hive.pathMax = *end == ':' ? static_cast<uint32_t>(std::strtoul(end + 1, nullptr, 10))
+                                              : config.hive.pathMin;
+        } else if (arg == "--skewed") {
+            config.hive.distribution = PathLengthDistribution::Skewed;
+        } else if (arg == "--dirty" && hasValue) {
+            config.hive.dirtyRatio = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--deleted" && hasValue) {
+            config.deletedRatio = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--reps" && hasValue) {
+            config.reps = std::max(1u, static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--out" && hasValue) {
+            config.out = fs::u8path(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return config.hive.pathMax >= config.hive.pathMin;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Config config;
+    if (!ParseArgs(argc, argv, config)) {
+        PrintUsage();
+        return 2;
+    }
+    Reporter report(config.out);
+    if (!config.out.empty() && !report.Ok()) {
+        std::fprintf(stderr, "Impossible d'écrire %s\n", config.out.u8string().c_str());
+        return 1;
+    }
+
+    // Deux ruches de même contenu : consolidée, et non consolidée avec journaux ; une troisième avec des
+    // valeurs supprimées (carve)
+    std::error_code ec;
+    fs::path dir = fs::temp_directory_path(ec) /
+                   ("bamdam-bench-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(dir / "clean", ec);
+    fs::create_directories(dir / "dirty", ec);
+    fs::create_directories(dir / "deleted", ec);
+    const fs::path cleanPath = dir / "clean" / "SYSTEM";
+    const fs::path dirtyPath = dir / "dirty" / "SYSTEM";
+    const fs::path deletedPath = dir / "deleted" / "SYSTEM";
+
+    HiveGenOptions cleanOptions = config.hive;
+    cleanOptions.dirtyRatio = 0;
+    HiveGenStats cleanStats;
+    HiveGenStats dirtyStats;
+    HiveGenOptions deletedOptions = cleanOptions;
+    deletedOptions.deletedRatio = config.deletedRatio;
+    HiveGenStats deletedStats;
+    std::string error;
+    if (!GenerateSystemHive(cleanPath, cleanOptions, cleanStats, error) ||
+        (config.hive.dirtyRatio > 0 && !GenerateSystemHive(dirtyPath, config.hive, dirtyStats, error)) ||
+        (config.deletedRatio > 0 && !GenerateSystemHive(deletedPath, deletedOptions, deletedStats, error))) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        fs::remove_all(dir, ec);
+        return 1;
+    }
+
+    char line[512];
+    std::snprintf(line, sizeof(line),
+                  "{\"bench\":\"stages\",\"stage\":\"config\",\"sids\":%u,\"values_per_sid\":%u,\"path_min\":%u,"
+                  "\"path_max\":%u,\"distribution\":\"%s\",\"dirty_ratio\":%.3f,\"rows\":%zu,\"hive_bytes\":%llu,"
+                  "\"dirty_pages\":%zu,\"log_bytes\":%llu,\"deleted_ratio\":%.3f,\"deleted_rows\":%zu,\"seed\":%llu,"
+                  "\"compiler\":\"%s\",\"debug\":%s}",
+                  config.hive.sidCount, config.hive.valuesPerSid, config.hive.pathMin, config.hive.pathMax,
+                  config.hive.distribution == PathLengthDistribution::Skewed ? "skewed" : "uniform",
+                  config.hive.dirtyRatio, cleanStats.rows, static_cast<unsigned long long>(cleanStats.hiveBytes),
+                  dirtyStats.dirtyPages, static_cast<unsigned long long>(dirtyStats.logBytes), config.deletedRatio,
+                  deletedStats.deletedRows,
+                  static_cast<unsigned long long>(config.hive.seed), CompilerName(),
+#ifdef NDEBUG
+                  "false"
+#else
+                  "true"
+#endif
+    );
+    report.Line(line);
+
+    const unsigned reps = config.reps;
+    const uint64_t hiveBytes = cleanStats.hiveBytes;
+
+    report.Stage("open", 1, "hive", hiveBytes, reps, Measure(reps, [&] {
+        RegfHive hive;
+        sink = sink + hive.Open(cleanPath, false);
+    }));
+
+    if (config.hive.dirtyRatio > 0) {
+        size_t pages = 0;
+        StageResult replay = Measure(reps, [&] {
+            RegfHive hive;
+            sink = sink + hive.Open(dirtyPath);
+            pages = hive.LogPagesApplied();
+        });
+        report.Stage("open_replay", pages, "pages", dirtyStats.logBytes, reps, replay);
+    }
+
+    RegfHive hive;
+    if (!hive.Open(cleanPath)) {
+        std::fprintf(stderr, "%s\n", hive.LastError().c_str());
+        fs::remove_all(dir, ec);
+        return 1;
+    }
+    const size_t rows = cleanStats.rows;
+
+    report.Stage("key_walk", rows, "values", hiveBytes, reps, Measure(reps, [&] {
+        size_t values = 0;
+        WalkBamDamKeys(hive, [&](EntrySource, uint32_t sidKey, const RegfName&) {
+            hive.ForEachValue(sidKey, [&](const RegfValue&) {
+                values++;
+                return true;
+            });
+            return true;
+        });
+        sink = sink + values;
+    }));
+
+    report.Stage("value_decode", rows, "values", hiveBytes, reps, Measure(reps, [&] {
+        std::u16string path;
+        uint64_t sum = 0;
+        WalkBamDam(hive, [&](EntrySource, const RegfName&, const RegfValue& value) {
+            uint64_t fileTime = 0;
+            if (DecodeBamDamFileTime(value.type, value.data, value.dataSize, fileTime)) {
+                path.clear();
+                value.name.AppendTo(path);
+                sum += fileTime + path.size();
+            }
+            return true;
+        });
+        sink = sink + sum;
+    }));
+
+    const SidResolveFn resolveUser = [](std::u16string_view sid) {
+        return u"user" + std::u16string(sid.substr(sid.rfind(u'-') + 1));
+    };
+    report.Stage("parse_store", rows, "rows", hiveBytes, reps, Measure(reps, [&] {
+        EntryStore store;
+        uint32_t hostId = store.hosts.Intern(u"BENCH-HOST");
+        sink = sink + ParseBamDamHive(hive, store, hostId, resolveUser);
+    }));
+
+    if (config.deletedRatio > 0) {
+        RegfHive deletedHive;
+        if (deletedHive.Open(deletedPath)) {
+            size_t recovered = 0;
+            StageResult carve = Measure(reps, [&] {
+                EntryStore store;
+                uint32_t hostId = store.hosts.Intern(u"BENCH-HOST");
+                recovered = CarveBamDamHive(deletedHive, store, hostId);
+            });
+            report.Stage("carve", recovered, "rows", deletedStats.hiveBytes, reps, carve);
+        }
+    }
+
+    report.Stage("cursor_walk", rows, "values", hiveBytes, reps, Measure(reps, [&] {
+        BamDamCursor cursor(hive);
+        std::vector<size_t> perSid(cursor.KeyCount(), 0);
+        BamDamKeyView key;
+        BamDamEntryView entry;
+        for (size_t k = 0; cursor.NextKey(key); k++) {
+            while (cursor.NextInKey(entry)) perSid[k] += entry.fileTime != 0;
+        }
+        sink = sink + *std::max_element(perSid.begin(), perSid.end());
+    }));
+
+    report.Stage("stream_chunks", rows, "rows", hiveBytes, reps, Measure(reps, [&] {
+        BamDamStreamOptions stream;
+        stream.chunkRows = 4096;
+        stream.resolveUser = resolveUser;
+        size_t chunks = 0;
+        sink = sink + StreamBamDamHive(hive, u"BENCH-HOST", [&](std::unique_ptr<EntryStore>) { chunks++; }, stream);
+        sink = sink + chunks;
+    }));
+
+    EntryStore store;
+    ParseBamDamHive(hive, store, store.hosts.Intern(u"BENCH-HOST"), resolveUser);
+
+    report.Stage("format_time", store.size(), "rows", 0, reps, Measure(reps, [&] {
+        size_t total = 0;
+        for (size_t row = 0; row < store.size(); row++) {
+            total += FileTimeToStringPrecise(store.FileTime(row)).size();
+        }
+        sink = sink + total;
+    }));
+
+    std::vector<uint64_t> fileTimes(store.size());
+    for (size_t row = 0; row < store.size(); row++) fileTimes[row] = store.FileTime(row);
+    std::vector<char> text(store.size() * FILETIME_TEXT_MAX);
+    report.Stage("format_column", store.size(), "rows", 0, reps, Measure(reps, [&] {
+        FormatFileTimeColumn(fileTimes.data(), fileTimes.size(), TimeFormat(), text.data());
+        sink = sink + static_cast<unsigned char>(text[text.size() / 2]);
+    }));
+
+    // OnSort / clic sur les colonnes : permutation d'affichage, le store n'est pas déplacé ; un seul trieur
+    // sur toutes les mesures, comme dans l'interface (rangs des chaînes en cache après le premier tri)
+    EntrySorter sorter;
+    std::vector<uint32_t> order;
+    const std::vector<SortField> byTime = { { SortKey::Time, true } };
+    report.Stage("sort", store.size(), "rows", 0, reps, Measure(reps, [&] {
+        sorter.Sort(store, byTime, order);
+        sink = sink + order[0];
+    }));
+    const std::vector<SortField> byUserPathTime = { { SortKey::User, false }, { SortKey::Path, false },
+                                                    { SortKey::Time, true } };
+    report.Stage("sort_multi", store.size(), "rows", 0, reps, Measure(reps, [&] {
+        sorter.Sort(store, byUserPathTime, order);
+        sink = sink + order[0];
+    }));
+
+    // OnFilter : comptage par identifiant d'utilisateur, puis table triée par nom
+    report.Stage("aggregate", store.size(), "rows", 0, reps, Measure(reps, [&] {
+        std::vector<int> countsById(store.users.Count(), 0);
+        for (size_t i = 0; i < store.size(); i++) countsById[store.UserId(i)]++;
+        std::map<std::u16string, int> userCounts;
+        for (uint32_t id = 0; id < countsById.size(); id++) {
+            if (countsById[id] > 0) userCounts[std::u16string(store.users.View(id))] = countsById[id];
+        }
+        sink = sink + userCounts.size();
+    }));
+
+    // Chronologie de flotte : budget d'environ deux hôtes, donc plusieurs runs sur disque à fusionner
+    constexpr size_t TIMELINE_HOSTS = 8;
+    std::vector<EntryStore> hostStores(TIMELINE_HOSTS);
+    auto reparseHosts = [&] {
+        for (size_t h = 0; h < TIMELINE_HOSTS; h++) {
+            hostStores[h].Clear();
+            const uint32_t hostId = hostStores[h].hosts.Intern(u"BENCH-HOST-" + std::u16string(1, u'0' + h));
+            ParseBamDamHive(hive, hostStores[h], hostId, resolveUser);
+        }
+    };
+    report.Stage("timeline", store.size() * TIMELINE_HOSTS, "rows", 0, reps, Measure(reps, reparseHosts, [&] {
+        TimelineOptions timelineOptions;
+        timelineOptions.memoryBytes = std::max<size_t>(store.size() * 512, 1 << 20);
+        timelineOptions.spillDirectory = dir;
+        TimelineBuilder timeline(timelineOptions);
+        size_t merged = 0;
+        if (timeline.Open()) {
+            for (EntryStore& hostStore : hostStores) timeline.Add(hostStore);
+            timeline.Merge(65536, [&](std::unique_ptr<EntryStore> chunk) { merged += chunk->size(); });
+        }
+        sink = sink + merged;
+    }));
+
+    // Requêtes : index construit une fois sur la flotte des 8 hôtes, puis évaluation seule
+    EntryStore fleet;
+    for (const EntryStore& hostStore : hostStores) fleet.Append(hostStore);
+    EntryIndex index;
+    report.Stage("query_index", fleet.size(), "rows", 0, reps, Measure(reps, [&] {
+        index.Build(fleet);
+        sink = sink + index.NodeCount();
+    }));
+    EntryQuery query;
+    query.Parse("sid:*-1001 time:2020-01-01.. path:\\Users\\*\\AppData\\ not note:\"\"");
+    report.Stage("query_eval", fleet.size(), "rows", 0, reps, Measure(reps, [&] {
+        sink = sink + index.OrderByTime(query.Evaluate(index)).size();
+    }));
+
+    // Cas : enregistré à chaque mesure, puis rouvert (le cache de pages garde le fichier en mémoire)
+    const fs::path casePath = dir / "fleet.bdcase";
+    uint64_t caseBytes = 0;
+    report.Stage("case_save", fleet.size(), "rows", 0, reps, Measure(reps, [&] {
+        CaseFile out;
+        if (out.Save(casePath, fleet, &index)) caseBytes = fs::file_size(casePath, ec);
+    }));
+    report.Stage("case_open", fleet.size(), "rows", caseBytes, reps, Measure(reps, [&] {
+        CaseFile caseFile;
+        EntryStore caseStore;
+        EntryIndex caseIndex;
+        if (caseFile.Open(casePath, caseStore, &caseIndex)) {
+            sink = sink + caseIndex.OrderByTime(query.Evaluate(caseIndex)).size();
+        }
+    }));
+
+    // Rareté : un sketch par worker, hôtes répartis en alternance, fusion puis rapport
+    report.Stage("rarity", fleet.size(), "rows", 0, reps, Measure(reps, [&] {
+        std::vector<RaritySketch> sketches(2);
+        for (size_t h = 0; h < hostStores.size(); h++) sketches[h % 2].Add(hostStores[h]);
+        sketches[0].Merge(sketches[1]);
+        sink = sink + sketches[0].Report().rare.size();
+    }));
+
+    const struct {
+        const char* stage;
+        ExportFormat format;
+        const char* file;
+    } exports[] = {
+        { "export_csv", ExportFormat::Csv, "out.csv" },
+        { "export_jsonl", ExportFormat::JsonLines, "out.jsonl" },
+        { "export_bdcol", ExportFormat::Columnar, "out.bdcol" },
+    };
+    for (const auto& e : exports) {
+        uint64_t bytes = 0;
+        StageResult r = Measure(reps, [&] {
+            ExportPipeline pipeline(e.format);
+            if (pipeline.Open(dir / e.file)) {
+                pipeline.Write(store, 0, store.size(), TimeFormat());
+                pipeline.Close();
+                bytes = pipeline.BytesWritten();
+            }
+        });
+        report.Stage(e.stage, store.size(), "rows", bytes, reps, r);
+    }
+
+    // Anneau assez grand pour une mesure : aucun enregistrement perdu
+    constexpr size_t LOG_RECORDS = 8192;
+    AsyncLogger logger(LOG_RECORDS);
+    if (logger.Open(dir / "bench.log")) {
+        const std::u16string line = u"[OK] HOST-0001  C:\\Collecte\\HOST-0001\\Windows\\System32\\config\\SYSTEM  "
+                                    u"1024 entrées";
+        report.Stage("log_enqueue", LOG_RECORDS, "records", LOG_RECORDS * line.size(), reps,
+                     Measure(reps, [&] { logger.Flush(); }, [&] {
+                         for (size_t i = 0; i < LOG_RECORDS; i++) logger.Log(LogLevel::Info, line);
+                     }));
+        logger.Close();
+    }
+
+    fs::remove_all(dir, ec);
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * BenchTranscode - Débit (Go/s) du transcodage UTF-16 / Latin-1 → UTF-8 par noyau
+ *
+ * Usage : BenchTranscode [chemins]
+ *
+ * - Jeux de chemins : ascii (chemins \Device\HarddiskVolumeN\... usuels), accents (environ 5 % de
+ *   caractères Latin-1 étendus), cjk (noms de fichiers non ASCII), surrogates (paires et substituts isolés)
+ * - Sources : utf16 (StringPool, export), hive (octets UTF-16LE de la ruche), latin1 (noms compressés) ;
+ *   hive et latin1 passent par Utf16LeToUtf8 / Latin1ToUtf8, propres à ce benchmark
+ * - Échappement : none (AppendUtf8), csv, json (sérialiseurs de l'export)
+ * - Noyaux : scalar, sse2, avx2 (ceux que le processeur permet)
+ *
+ * Débit en octets d'entrée par seconde, meilleur de 5 passes.
+ * Sortie : une ligne JSON par mesure.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "../Transcode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile size_t sink = 0;
+
+struct Rng {
+    uint64_t state;
+    uint64_t Next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+enum class Charset { Ascii, Accents, Cjk, Surrogates };
+
+std::u16string RandomPath(Rng& rng, Charset charset) {
+    static const char16_t* const PREFIXES[] = { u"\\Device\\HarddiskVolume3\\Windows\\System32\\",
+                                                u"\\Device\\HarddiskVolume3\\Program Files\\",
+                                                u"\\Device\\HarddiskVolume4\\Users\\" };
+    static const char16_t ACCENTS[] = u"éèàçùêôîÉÀ";
+    std::u16string path = PREFIXES[rng.Next() % 3];
+    const size_t length = 20 + rng.Next() % 60;
+    for (size_t i = 0; i < length; i++) {
+        const uint64_t r = rng.Next();
+        char16_t c = static_cast<char16_t>(u'a' + r % 26);
+        if (r % 12 == 0) c = u'\\';
+        if (charset == Charset::Accents && r % 20 == 1) c = ACCENTS[r / 20 % 10];
+        if (charset == Charset::Cjk && r % 4 != 0) c = static_cast<char16_t>(0x4E00 + r / 4 % 0x5000);
+        if (charset == Charset::Surrogates && r % 10 == 1) {
+            path.push_back(static_cast<char16_t>(0xD83D));
+            c = static_cast<char16_t>(0xDC00 + r / 10 % 0x400);
+        }
+        if (charset == Charset::Surrogates && r % 50 == 2) c = static_cast<char16_t>(0xDC00 + r / 50 % 0x400);
+        path.push_back(c);
+    }
+    path += u".exe";
+    return path;
+}
+
+struct Corpus {
+    std::vector<char16_t> units;  // Chemins bout à bout
+    std::vector<uint8_t> utf16le;
+    std::vector<uint8_t> latin1;  // Unités tronquées à 8 bits (noms compressés)
+    std::vector<size_t> offsets;  // Début de chaque chemin, plus la fin
+};
+
+Corpus MakeCorpus(size_t count, Charset charset) {
+    Rng rng{ 0x243F6A8885A308D3ULL + static_cast<uint64_t>(charset) };
+    Corpus corpus;
+    corpus.offsets.push_back(0);
+    for (size_t i = 0; i < count; i++) {
+        const std::u16string path = RandomPath(rng, charset);
+        corpus.units.insert(corpus.units.end(), path.begin(), path.end());
+        corpus.offsets.push_back(corpus.units.size());
+    }
+    for (char16_t c : corpus.units) {
+        corpus.utf16le.push_back(static_cast<uint8_t>(c & 0xFF));
+        corpus.utf16le.push_back(static_cast<uint8_t>(c >> 8));
+        corpus.latin1.push_back(static_cast<uint8_t>(c & 0xFF));
+    }
+    return corpus;
+}
+
+enum class Source { Utf16, Hive, Latin1 };
+
+// Meilleur temps de 5 passes sur tout le corpus, en secondes ; outBytes : octets UTF-8 produits
+double Run(const Corpus& corpus, Source source, Utf8Escape escape, std::vector<char>& out, size_t& outBytes) {
+    double best = 1e30;
+    for (int pass = 0; pass < 5; pass++) {
+        char* p = out.data();
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i + 1 < corpus.offsets.size(); i++) {
+            const size_t first = corpus.offsets[i];
+            const size_t units = corpus.offsets[i + 1] - first;
+            if (source == Source::Utf16) p = Utf16ToUtf8(corpus.units.data() + first, units, p, escape);
+            if (source == Source::Hive) p = Utf16LeToUtf8(corpus.utf16le.data() + 2 * first, units, p, escape);
+            if (source == Source::Latin1) p = Latin1ToUtf8(corpus.latin1.data() + first, units, p, escape);
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        outBytes = static_cast<size_t>(p - out.data());
+        sink += static_cast<unsigned char>(out[outBytes / 2]);
+    }
+    return best;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    const TranscodeKernel detected = ActiveTranscodeKernel();
+
+    const Charset charsets[] = { Charset::Ascii, Charset::Accents, Charset::Cjk, Charset::Surrogates };
+    const char* charsetNames[] = { "ascii", "accents", "cjk", "surrogates" };
+    const Source sources[] = { Source::Utf16, Source::Hive, Source::Latin1 };
+    const char* sourceNames[] = { "utf16", "hive", "latin1" };
+    const Utf8Escape escapes[] = { Utf8Escape::None, Utf8Escape::Csv, Utf8Escape::Json };
+    const char* escapeNames[] = { "none", "csv", "json" };
+    const TranscodeKernel kernels[] = { TranscodeKernel::Scalar, TranscodeKernel::Sse2, TranscodeKernel::Avx2 };
+
+    for (int c = 0; c < 4; c++) {
+        const Corpus corpus = MakeCorpus(count, charsets[c]);
+        std::vector<char> out(Utf8MaxBytes(corpus.units.size(), Utf8Escape::Json));
+        for (int s = 0; s < 3; s++) {
+            // Noms compressés : seulement pour les jeux représentables en Latin-1
+            if (sources[s] == Source::Latin1 && charsets[c] != Charset::Ascii && charsets[c] != Charset::Accents) {
+                continue;
+            }
+            const size_t inputBytes = corpus.units.size() * (sources[s] == Source::Latin1 ? 1 : 2);
+            for (int e = 0; e < 3; e++) {
+                for (TranscodeKernel kernel : kernels) {
+                    if (!SelectTranscodeKernel(kernel)) continue;
+                    size_t outBytes = 0;
+                    const double seconds = Run(corpus, sources[s], escapes[e], out, outBytes);
+                    std::printf("{\"bench\":\"transcode\",\"case\":\"%s\",\"source\":\"%s\",\"escape\":\"%s\","
+                                "\"kernel\":\"%s\",\"strings\":%zu,\"input_mb\":%.1f,\"output_mb\":%.1f,"
+                                "\"gb_per_s\":%.2f,\"ns_per_string\":%.1f}\n",
+                                charsetNames[c], sourceNames[s], escapeNames[e], TranscodeKernelName(kernel), count,
+                                inputBytes / 1048576.0, outBytes / 1048576.0, inputBytes / seconds / 1e9,
+                                seconds * 1e9 / static_cast<double>(count));
+                }
+            }
+        }
+    }
+    SelectTranscodeKernel(detected);
+    return sink == 42 ? 1 : 0;
+}
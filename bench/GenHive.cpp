@@ -0,0 +1,159 @@
+/*
+ * GenHive - Écrit une flotte de ruches SYSTEM synthétiques (voir HiveGen.h)
+ *
+ * Usage : GenHive [--hosts N] [--sids N] [--values N] [--path-len min:max] [--skewed]
+ *                 [--dirty ratio] [--deleted ratio] [--seed N]
+ *                 [--image [--image-size Mo] [--gpt] [--contiguous]] <dossier>
+ *
+ * Arborescence produite : <dossier>\HOST-0001\Windows\System32\config\SYSTEM (+ .LOG1/.LOG2),
+ * directement utilisable par BamDamBatch. --image écrit en plus <dossier>\HOST-0001.img : image
+ * disque brute dont le volume NTFS contient les mêmes fichiers (voir ImageGen.h).
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "HiveGen.h"
+#include "ImageGen.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage : GenHive [--hosts N] [--sids N] [--values N] [--path-len min:max] [--skewed]\n"
+                 "                [--dirty ratio] [--deleted ratio] [--seed N]\n"
+                 "                [--image [--image-size Mo] [--gpt] [--contiguous]] <dossier>\n"
+                 "  --hosts     nombre de ruches (défaut : 1)\n"
+                 "  --sids      SIDs par service bam/dam (défaut : 8)\n"
+                 "  --values    valeurs par SID (défaut : 200)\n"
+                 "  --path-len  longueur des chemins en caractères (défaut : 40:160)\n"
+                 "  --skewed    majorité de chemins courts au lieu d'une distribution uniforme\n"
+                 "  --dirty     part des valeurs plus récentes dans .LOG1/.LOG2 seulement (défaut : 0)\n"
+                 "  --deleted   part des valeurs supprimées, cellules libérées intactes (défaut : 0)\n"
+                 "  --seed      graine (défaut : 1)\n"
+                 "  --image     écrit aussi HOST-NNNN.img (image disque brute, volume NTFS)\n"
+                 "  --image-size taille de l'image en Mo, fin creuse (défaut : minimale)\n"
+                 "  --gpt       table GPT au lieu de MBR\n"
+                 "  --contiguous fichiers non fragmentés dans l'image\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    HiveGenOptions options;
+    unsigned hosts = 1;
+    fs::path output;
+    bool image = false;
+    NtfsImageOptions imageOptions;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--hosts" && hasValue) {
+            hosts = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--sids" && hasValue) {
+            options.sidCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--values" && hasValue) {
+            options.valuesPerSid = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--path-len" && hasValue) {
+            char* end = nullptr;
+            options.pathMin = static_cast<uint32_t>(std::strtoul(argv[++i], &end, 10));
+            options.pathMax = *end == ':' ? static_cast<uint32_t>(std::strtoul(end + 1, nullptr, 10)) : options.pathMin;
+        } else if (arg == "--skewed") {
+            options.distribution = PathLengthDistribution::Skewed;
+        } else if (arg == "--dirty" && hasValue) {
+            options.dirtyRatio = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--deleted" && hasValue) {
+            options.deletedRatio = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--image") {
+            image = true;
+        } else if (arg == "--image-size" && hasValue) {
+            imageOptions.imageSize = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (arg == "--gpt") {
+            imageOptions.gpt = true;
+        } else if (arg == "--contiguous") {
+            imageOptions.fragment = false;
+        } else if (!arg.empty() && arg[0] != '-' && output.empty()) {
+            output = fs::u8path(arg);
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (output.empty() || hosts == 0 || options.pathMax < options.pathMin) {
+        PrintUsage();
+        return 2;
+    }
+
+    const uint64_t seed = options.seed;
+    HiveGenStats total;
+    unsigned images = 0;
+    uint64_t imageBytes = 0;
+    uint64_t imageWritten = 0;
+    size_t indexDepth = 0;
+    for (unsigned h = 0; h < hosts; h++) {
+        char host[32];
+        std::snprintf(host, sizeof(host), "HOST-%04u", h + 1);
+        fs::path dir = output / host / "Windows" / "System32" / "config";
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+
+        options.seed = seed + h;
+        options.computerName.assign(host, host + std::char_traits<char>::length(host));
+        HiveGenStats stats;
+        std::string error;
+        if (!GenerateSystemHive(dir / "SYSTEM", options, stats, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        total.hiveBytes += stats.hiveBytes;
+        total.logBytes += stats.logBytes;
+        total.rows += stats.rows;
+        total.dirtyRows += stats.dirtyRows;
+        total.dirtyPages += stats.dirtyPages;
+        total.deletedRows += stats.deletedRows;
+
+        if (image) {
+            std::vector<NtfsImageFile> files;
+            for (const char* name : { "SYSTEM", "SYSTEM.LOG1", "SYSTEM.LOG2" }) {
+                std::ifstream in(dir / name, std::ios::binary);
+                if (!in.is_open()) continue;
+                NtfsImageFile file;
+                file.path = u"Windows\\System32\\config\\";
+                file.path.append(name, name + std::char_traits<char>::length(name));
+                file.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                files.push_back(std::move(file));
+            }
+            imageOptions.seed = options.seed;
+            NtfsImageStats imageStats;
+            if (!WriteNtfsImage(output / (std::string(host) + ".img"), files, imageOptions, imageStats, error)) {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            images++;
+            imageBytes += imageStats.imageBytes;
+            imageWritten += imageStats.writtenBytes;
+            indexDepth = imageStats.indexDepth;
+        }
+    }
+
+    std::printf("{\"hosts\":%u,\"rows\":%zu,\"dirty_rows\":%zu,\"dirty_pages\":%zu,\"deleted_rows\":%zu,"
+                "\"hive_bytes\":%llu,\"log_bytes\":%llu,\"images\":%u,\"image_bytes\":%llu,\"image_written\":%llu,"
+                "\"index_depth\":%zu}\n",
+                hosts, total.rows, total.dirtyRows, total.dirtyPages, total.deletedRows,
+                static_cast<unsigned long long>(total.hiveBytes), static_cast<unsigned long long>(total.logBytes),
+                images, static_cast<unsigned long long>(imageBytes), static_cast<unsigned long long>(imageWritten),
+                indexDepth);
+    return 0;
+}
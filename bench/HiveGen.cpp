@@ -0,0 +1,474 @@
+/*
+ * HiveGen - Écriture des cellules, des hbin, du base block et des journaux HvLE
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "HiveGen.h"
+
+#include "../RegfHive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t PAGE_SIZE = 4096;
+constexpr uint32_t HBIN_HEADER_SIZE = 32;
+constexpr uint16_t KEY_HIVE_ENTRY = 0x0004;
+constexpr uint16_t KEY_NO_DELETE = 0x0008;
+constexpr uint16_t KEY_COMP_NAME = 0x0020;
+constexpr uint16_t VALUE_COMP_NAME = 0x0001;
+constexpr uint32_t LOG_TYPE_NEW = 6;
+
+// 01/01/2023 00:00 UTC, FILETIME
+constexpr uint64_t BASE_FILETIME = 133170048000000000ULL;
+constexpr uint64_t FILETIME_YEAR = 365ULL * 24 * 3600 * 10000000ULL;
+
+void Put16(uint8_t* p, uint16_t v) { p[0] = static_cast<uint8_t>(v); p[1] = static_cast<uint8_t>(v >> 8); }
+void Put32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+void Put64(uint8_t* p, uint64_t v) { Put32(p, static_cast<uint32_t>(v)); Put32(p + 4, static_cast<uint32_t>(v >> 32)); }
+
+struct Rng {
+    uint64_t state;
+    uint64_t Next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    double Unit() { return static_cast<double>(Next() >> 11) / 9007199254740992.0; }
+    uint32_t Below(uint32_t n) { return n ? static_cast<uint32_t>(Next() % n) : 0; }
+};
+
+bool IsLatin1(std::u16string_view name) {
+    return std::all_of(name.begin(), name.end(), [](char16_t c) { return c <= 0xFF; });
+}
+
+// Hash des listes "lh" tel que le calcule RegfHive (majuscules ASCII)
+uint32_t LhHash(std::u16string_view name) {
+    uint32_t hash = 0;
+    for (char16_t c : name) {
+        hash = hash * 37 + ((c >= u'a' && c <= u'z') ? c - 32 : c);
+    }
+    return hash;
+}
+
+std::u16string UpperAscii(std::u16string_view name) {
+    std::u16string upper(name);
+    for (auto& c : upper) {
+        if (c >= u'a' && c <= u'z') c = static_cast<char16_t>(c - 32);
+    }
+    return upper;
+}
+
+// Zone hbin en construction : hbin de 4 Ko (plus grands si une cellule l'exige),
+// une cellule ne traverse jamais un hbin
+class RegfWriter {
+public:
+    RegfWriter() { OpenBin(PAGE_SIZE); }
+
+    uint32_t Alloc(size_t payload) {
+        uint32_t size = static_cast<uint32_t>((payload + 4 + 7) & ~size_t(7));
+        if (used + size > binEnd) {
+            CloseBin();
+            OpenBin(std::max<uint32_t>(PAGE_SIZE, (size + HBIN_HEADER_SIZE + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1)));
+        }
+        uint32_t offset = used;
+        Put32(&bins[offset], static_cast<uint32_t>(-static_cast<int32_t>(size)));
+        used += size;
+        return offset;
+    }
+
+    uint8_t* Cell(uint32_t offset) { return &bins[offset + 4]; }
+
+    // Libère une cellule sans effacer son contenu (comme le fait Windows)
+    void Free(uint32_t offset) {
+        Put32(&bins[offset], static_cast<uint32_t>(-static_cast<int32_t>(RegfRead32(&bins[offset]))));
+    }
+
+    uint32_t Value(std::u16string_view name, uint32_t type, const uint8_t* data, uint32_t size) {
+        bool compressed = IsLatin1(name);
+        uint16_t nameBytes = static_cast<uint16_t>(compressed ? name.size() : name.size() * 2);
+        uint32_t dataCell = REGF_NO_CELL;
+        if (size > 4) {
+            dataCell = Alloc(size);
+            std::memcpy(Cell(dataCell), data, size);
+        }
+        uint32_t cell = Alloc(20u + nameBytes);
+        uint8_t* vk = Cell(cell);
+        vk[0] = 'v';
+        vk[1] = 'k';
+        Put16(vk + 2, nameBytes);
+        if (size <= 4) {
+            Put32(vk + 4, size | 0x80000000u);
+            std::memcpy(vk + 8, data, size);
+        } else {
+            Put32(vk + 4, size);
+            Put32(vk + 8, dataCell);
+        }
+        Put32(vk + 12, type);
+        Put16(vk + 16, compressed ? VALUE_COMP_NAME : 0);
+        PutName(vk + 20, name, compressed);
+        return cell;
+    }
+
+    uint32_t Dword(std::u16string_view name, uint32_t value) {
+        uint8_t data[4];
+        Put32(data, value);
+        return Value(name, REGF_TYPE_DWORD, data, 4);
+    }
+
+    uint32_t Binary(std::u16string_view name, const std::vector<uint8_t>& data) {
+        return Value(name, REGF_TYPE_BINARY, data.data(), static_cast<uint32_t>(data.size()));
+    }
+
+    uint32_t String(std::u16string_view name, std::u16string_view text) {
+        std::vector<uint8_t> data((text.size() + 1) * 2, 0);
+        for (size_t i = 0; i < text.size(); i++) Put16(&data[2 * i], text[i]);
+        return Value(name, REGF_TYPE_SZ, data.data(), static_cast<uint32_t>(data.size()));
+    }
+
+    // Les parents des sous-clés sont renseignés ici : construction des feuilles vers la racine
+    uint32_t Key(std::u16string_view name, std::vector<std::pair<std::u16string, uint32_t>> children,
+                 const std::vector<uint32_t>& values, uint64_t lastWrite, bool root = false) {
+        uint32_t subkeyList = REGF_NO_CELL;
+        if (!children.empty()) {
+            std::sort(children.begin(), children.end(),
+                      [](const auto& a, const auto& b) { return UpperAscii(a.first) < UpperAscii(b.first); });
+            subkeyList = Alloc(4 + children.size() * 8);
+            uint8_t* lh = Cell(subkeyList);
+            lh[0] = 'l';
+            lh[1] = 'h';
+            Put16(lh + 2, static_cast<uint16_t>(children.size()));
+            for (size_t i = 0; i < children.size(); i++) {
+                Put32(lh + 4 + i * 8, children[i].second);
+                Put32(lh + 8 + i * 8, LhHash(children[i].first));
+            }
+        }
+        uint32_t valueList = REGF_NO_CELL;
+        if (!values.empty()) {
+            valueList = Alloc(values.size() * 4);
+            for (size_t i = 0; i < values.size(); i++) Put32(Cell(valueList) + i * 4, values[i]);
+        }
+
+        bool compressed = IsLatin1(name);
+        uint16_t nameBytes = static_cast<uint16_t>(compressed ? name.size() : name.size() * 2);
+        uint32_t cell = Alloc(76u + nameBytes);
+        uint8_t* nk = Cell(cell);
+        nk[0] = 'n';
+        nk[1] = 'k';
+        Put16(nk + 2, static_cast<uint16_t>((compressed ? KEY_COMP_NAME : 0) |
+                                            (root ? KEY_HIVE_ENTRY | KEY_NO_DELETE : 0)));
+        Put64(nk + 4, lastWrite);
+        Put32(nk + 16, root ? REGF_NO_CELL : 0);
+        Put32(nk + 20, static_cast<uint32_t>(children.size()));
+        Put32(nk + 28, subkeyList);
+        Put32(nk + 32, REGF_NO_CELL);
+        Put32(nk + 36, static_cast<uint32_t>(values.size()));
+        Put32(nk + 40, valueList);
+        Put32(nk + 44, REGF_NO_CELL);
+        Put32(nk + 48, REGF_NO_CELL);
+        Put16(nk + 72, nameBytes);
+        PutName(nk + 76, name, compressed);
+        for (const auto& child : children) Put32(Cell(child.second) + 16, cell);
+        return cell;
+    }
+
+    // Image complète : base block + hbin
+    std::vector<uint8_t> Finish(uint32_t root, uint32_t primarySequence, uint32_t secondarySequence) {
+        CloseBin();
+        std::vector<uint8_t> image(REGF_BASE_BLOCK_SIZE, 0);
+        uint8_t* header = image.data();
+        std::memcpy(header, "regf", 4);
+        Put32(header + 4, primarySequence);
+        Put32(header + 8, secondarySequence);
+        Put64(header + 12, BASE_FILETIME);
+        Put32(header + 20, 1);  // Version 1.5
+        Put32(header + 24, 5);
+        Put32(header + 32, 1);  // Format : mémoire directe
+        Put32(header + 36, root);
+        Put32(header + 40, static_cast<uint32_t>(bins.size()));
+        Put32(header + 44, 1);
+        Put32(header + 508, RegfBaseBlockChecksum(header));
+        image.insert(image.end(), bins.begin(), bins.end());
+        return image;
+    }
+
+private:
+    static void PutName(uint8_t* p, std::u16string_view name, bool compressed) {
+        for (size_t i = 0; i < name.size(); i++) {
+            if (compressed) p[i] = static_cast<uint8_t>(name[i]);
+            else Put16(p + 2 * i, name[i]);
+        }
+    }
+
+    void OpenBin(uint32_t size) {
+        binStart = static_cast<uint32_t>(bins.size());
+        binEnd = binStart + size;
+        bins.resize(binEnd, 0);
+        std::memcpy(&bins[binStart], "hbin", 4);
+        Put32(&bins[binStart + 4], binStart);
+        Put32(&bins[binStart + 8], size);
+        used = binStart + HBIN_HEADER_SIZE;
+    }
+
+    // Reste du hbin : une cellule libre
+    void CloseBin() {
+        if (used < binEnd) Put32(&bins[used], binEnd - used);
+        used = binEnd;
+    }
+
+    std::vector<uint8_t> bins;
+    uint32_t binStart = 0;
+    uint32_t binEnd = 0;
+    uint32_t used = 0;
+};
+
+class PathMaker {
+public:
+    PathMaker(const HiveGenOptions& options, Rng& rng) : options(options), rng(rng) {}
+
+    std::u16string Make(const std::u16string& user, uint32_t index) {
+        static const char16_t* const DIRS[] = { u"Windows\\System32", u"Program Files\\Vendor",
+                                                u"Program Files (x86)\\Common Files", u"ProgramData\\Package Cache" };
+        std::u16string path = u"\\Device\\HarddiskVolume3\\";
+        if (rng.Unit() < options.suspiciousRatio) {
+            path += u"Users\\" + user + (rng.Below(2) ? u"\\AppData\\Local\\Temp" : u"\\Downloads");
+        } else if (rng.Below(4) == 0) {
+            path += u"Users\\" + user + u"\\AppData\\Local";
+        } else {
+            path += DIRS[rng.Below(4)];
+        }
+
+        // Nom final : mot aléatoire + index (unicité dans la clé SID)
+        std::u16string file = Word(5, 12) + u"_";
+        size_t digits = file.size();
+        for (uint32_t n = index;; n /= 10) {
+            file.insert(file.begin() + static_cast<std::ptrdiff_t>(digits), static_cast<char16_t>(u'0' + n % 10));
+            if (n < 10) break;
+        }
+        file += u".exe";
+
+        size_t target = TargetLength();
+        bool nonLatin = rng.Unit() < options.nonLatinRatio;
+        while (path.size() + 1 + file.size() < target) {
+            path += u'\\';
+            if (nonLatin) {
+                path += Cyrillic(4, 10);
+                nonLatin = false;
+            } else {
+                path += Word(3, 14);
+            }
+        }
+        path += u'\\';
+        path += file;
+        return path;
+    }
+
+private:
+    size_t TargetLength() {
+        uint32_t span = options.pathMax > options.pathMin ? options.pathMax - options.pathMin : 0;
+        double u = rng.Unit();
+        if (options.distribution == PathLengthDistribution::Skewed) u = u * u * u;
+        return options.pathMin + static_cast<size_t>(u * span);
+    }
+
+    std::u16string Word(uint32_t minLength, uint32_t maxLength) {
+        std::u16string word;
+        uint32_t length = minLength + rng.Below(maxLength - minLength + 1);
+        for (uint32_t i = 0; i < length; i++) {
+            char16_t c = static_cast<char16_t>(u'a' + rng.Below(26));
+            word.push_back(i == 0 && rng.Below(2) ? static_cast<char16_t>(c - 32) : c);
+        }
+        return word;
+    }
+
+    std::u16string Cyrillic(uint32_t minLength, uint32_t maxLength) {
+        std::u16string word;
+        uint32_t length = minLength + rng.Below(maxLength - minLength + 1);
+        for (uint32_t i = 0; i < length; i++) word.push_back(static_cast<char16_t>(0x0430 + rng.Below(32)));
+        return word;
+    }
+
+    const HiveGenOptions& options;
+    Rng& rng;
+};
+
+bool WriteFile(const fs::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    return out.is_open() && out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+// Journal format Windows 8.1+ : base block (512 octets), puis une entrée HvLE par lot de pages
+std::vector<uint8_t> BuildLog(const std::vector<uint8_t>& newImage, uint32_t sequence,
+                              const std::vector<uint32_t>& pages) {
+    std::vector<uint8_t> log(newImage.begin(), newImage.begin() + 512);
+    Put32(&log[28], LOG_TYPE_NEW);
+    Put32(&log[508], RegfBaseBlockChecksum(log.data()));
+
+    const uint32_t hbinsSize = static_cast<uint32_t>(newImage.size() - REGF_BASE_BLOCK_SIZE);
+    size_t body = pages.size() * 8 + pages.size() * PAGE_SIZE;
+    size_t size = (40 + body + 511) & ~size_t(511);
+    std::vector<uint8_t> entry(size, 0);
+    std::memcpy(entry.data(), "HvLE", 4);
+    Put32(&entry[4], static_cast<uint32_t>(size));
+    Put32(&entry[12], sequence);
+    Put32(&entry[16], hbinsSize);
+    Put32(&entry[20], static_cast<uint32_t>(pages.size()));
+    for (size_t i = 0; i < pages.size(); i++) {
+        Put32(&entry[40 + i * 8], pages[i]);
+        Put32(&entry[44 + i * 8], PAGE_SIZE);
+        std::memcpy(&entry[40 + pages.size() * 8 + i * PAGE_SIZE],
+                    &newImage[REGF_BASE_BLOCK_SIZE + pages[i]], PAGE_SIZE);
+    }
+    Put64(&entry[24], RegfMarvin32(&entry[40], size - 40));
+    Put64(&entry[32], RegfMarvin32(entry.data(), 32));
+    log.insert(log.end(), entry.begin(), entry.end());
+    return log;
+}
+
+}  // namespace
+
+bool GenerateSystemHive(const fs::path& path, const HiveGenOptions& options, HiveGenStats& stats,
+                        std::string& error) {
+    stats = HiveGenStats();
+    Rng rng{ options.seed * 0x9E3779B97F4A7C15ULL + 1 };
+    PathMaker paths(options, rng);
+    RegfWriter writer;
+
+    // FILETIME à réécrire dans le primaire : cellule de données, ancienne valeur
+    std::vector<std::pair<uint32_t, uint64_t>> dirtyData;
+    std::vector<std::pair<uint32_t, uint64_t>> dirtyKeys;
+    const uint64_t keyTime = BASE_FILETIME + FILETIME_YEAR;
+
+    std::vector<std::pair<std::u16string, uint32_t>> services;
+    for (int service = 0; service < (options.dam ? 2 : 1); service++) {
+        std::vector<std::pair<std::u16string, uint32_t>> sidKeys;
+        for (uint32_t s = 0; s < options.sidCount; s++) {
+            std::u16string sid = u"S-1-5-21-3623811015-3361044348-30300820-";
+            std::u16string rid;
+            for (uint32_t n = 1001 + s; n; n /= 10) rid.insert(rid.begin(), static_cast<char16_t>(u'0' + n % 10));
+            sid += rid;
+            std::u16string user = u"user" + rid;
+
+            std::vector<uint32_t> values;
+            values.push_back(writer.Dword(u"Version", 1));
+            values.push_back(writer.Dword(u"SequenceNumber", 7 + s));
+            bool keyDirty = false;
+            for (uint32_t v = 0; v < options.valuesPerSid; v++) {
+                uint64_t fileTime = BASE_FILETIME + rng.Next() % FILETIME_YEAR;
+                uint8_t data[24] = {};
+                Put64(data, fileTime);
+                uint32_t cell = writer.Value(paths.Make(user, v), REGF_TYPE_BINARY, data, sizeof(data));
+                // Tirage seulement si demandé : les ruches sans suppression restent celles d'avant l'option
+                const bool deleted = options.deletedRatio > 0 && rng.Unit() < options.deletedRatio;
+                if (deleted) {
+                    writer.Free(RegfRead32(writer.Cell(cell) + 8));
+                    writer.Free(cell);
+                    stats.deletedRows++;
+                } else {
+                    values.push_back(cell);
+                    stats.rows++;
+                }
+                // Tirage systématique : à graine égale, ruches consolidée et non consolidée identiques
+                if (rng.Unit() < options.dirtyRatio && !deleted) {
+                    // Primaire : un mois plus tôt ; journal : valeur ci-dessus
+                    uint32_t dataCell = RegfRead32(writer.Cell(cell) + 8);
+                    dirtyData.emplace_back(dataCell, fileTime - FILETIME_YEAR / 12);
+                    keyDirty = true;
+                    stats.dirtyRows++;
+                }
+            }
+            uint32_t key = writer.Key(sid, {}, values, keyTime + s);
+            if (keyDirty) dirtyKeys.emplace_back(key, keyTime - 1);
+            sidKeys.emplace_back(sid, key);
+        }
+        uint32_t userSettings = writer.Key(u"UserSettings", sidKeys, {}, keyTime);
+        uint32_t state = writer.Key(u"State", { { u"UserSettings", userSettings } }, {}, keyTime);
+        services.emplace_back(service == 0 ? u"bam" : u"dam",
+                              writer.Key(service == 0 ? u"bam" : u"dam", { { u"State", state } },
+                                         { writer.Dword(u"Start", 1) }, keyTime));
+    }
+
+    uint32_t servicesKey = writer.Key(u"Services", services, {}, keyTime);
+    uint32_t timeZone = writer.Key(u"TimeZoneInformation", {},
+                                   { writer.Dword(u"Bias", static_cast<uint32_t>(-60)),
+                                     writer.Dword(u"ActiveTimeBias", static_cast<uint32_t>(-60)),
+                                     writer.String(u"TimeZoneKeyName", u"Romance Standard Time") },
+                                   keyTime);
+    uint32_t computerName = writer.Key(u"ComputerName", {}, { writer.String(u"ComputerName", options.computerName) },
+                                       keyTime);
+    uint32_t computerNameParent = writer.Key(u"ComputerName", { { u"ComputerName", computerName } }, {}, keyTime);
+    uint32_t control = writer.Key(u"Control", { { u"TimeZoneInformation", timeZone },
+                                                { u"ComputerName", computerNameParent } }, {}, keyTime);
+    uint32_t controlSet = writer.Key(u"ControlSet001", { { u"Services", servicesKey }, { u"Control", control } }, {},
+                                     keyTime);
+    uint32_t select = writer.Key(u"Select", {}, { writer.Dword(u"Current", 1), writer.Dword(u"Default", 1),
+                                                  writer.Dword(u"LastKnownGood", 1) }, keyTime);
+    // Volume système GPT : C: et son \??\Volume{GUID} partagent l'identité DMIO:ID: (pas de tirage
+    // aléatoire, les autres valeurs de la ruche restent identiques)
+    std::vector<uint8_t> systemVolume = { 'D', 'M', 'I', 'O', ':', 'I', 'D', ':' };
+    for (uint8_t i = 0; i < 16; i++) systemVolume.push_back(static_cast<uint8_t>(0x5A ^ (i * 17)));
+    uint32_t mountedDevices = writer.Key(u"MountedDevices", {},
+                                         { writer.Binary(u"\\DosDevices\\C:", systemVolume),
+                                           writer.Binary(u"\\??\\Volume{5a4b7e69-0f3c-4d2a-9e81-b6c7d0e1f2a3}",
+                                                         systemVolume) },
+                                         keyTime);
+    uint32_t root = writer.Key(u"ROOT", { { u"ControlSet001", controlSet }, { u"Select", select },
+                                          { u"MountedDevices", mountedDevices } }, {}, keyTime, true);
+
+    // Séquences : primaire 12/11 si non consolidée (journaux 11 et 12), sinon 10/10
+    const bool dirty = !dirtyData.empty();
+    std::vector<uint8_t> image = writer.Finish(root, dirty ? 12 : 10, dirty ? 11 : 10);
+
+    std::vector<uint8_t> primary = image;
+    for (const auto& [cell, fileTime] : dirtyData) {
+        Put64(&primary[REGF_BASE_BLOCK_SIZE + cell + 4], fileTime);
+    }
+    for (const auto& [cell, lastWrite] : dirtyKeys) {
+        Put64(&primary[REGF_BASE_BLOCK_SIZE + cell + 4 + 4], lastWrite);
+    }
+
+    if (!WriteFile(path, primary)) {
+        error = "Écriture impossible : " + path.u8string();
+        return false;
+    }
+    stats.hiveBytes = primary.size();
+
+    fs::path logs[2] = { path, path };
+    logs[0] += ".LOG1";
+    logs[1] += ".LOG2";
+    std::error_code ec;
+    if (!dirty) {
+        fs::remove(logs[0], ec);
+        fs::remove(logs[1], ec);
+        return true;
+    }
+
+    // Pages différentes entre primaire et image à jour, réparties sur les deux journaux
+    std::vector<uint32_t> pages;
+    for (size_t offset = REGF_BASE_BLOCK_SIZE; offset < image.size(); offset += PAGE_SIZE) {
+        if (std::memcmp(&image[offset], &primary[offset], PAGE_SIZE) != 0) {
+            pages.push_back(static_cast<uint32_t>(offset - REGF_BASE_BLOCK_SIZE));
+        }
+    }
+    stats.dirtyPages = pages.size();
+    size_t half = (pages.size() + 1) / 2;
+    std::vector<uint32_t> first(pages.begin(), pages.begin() + half);
+    std::vector<uint32_t> second(pages.begin() + half, pages.end());
+    std::vector<uint8_t> log1 = BuildLog(image, 11, first);
+    std::vector<uint8_t> log2 = BuildLog(image, 12, second);
+    if (!WriteFile(logs[0], log1) || !WriteFile(logs[1], log2)) {
+        error = "Écriture des journaux impossible : " + path.u8string();
+        return false;
+    }
+    stats.logBytes = log1.size() + log2.size();
+    return true;
+}
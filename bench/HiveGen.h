@@ -0,0 +1,55 @@
+/*
+ * HiveGen - Générateur de ruches SYSTEM regf synthétiques (benchmarks, jeux de test)
+ *
+ * - Ruche valide pour RegfHive : base block avec checksum, hbin de 4 Ko,
+ *   cellules nk / vk / lh / données, Select\Current, ControlSet001 avec bam et dam
+ * - Nombre de SIDs, de valeurs par SID, distribution des longueurs de chemins paramétrables
+ * - Ruche non consolidée en option : le fichier primaire garde des FILETIME plus anciens,
+ *   les pages récentes sont écrites en entrées HvLE dans <ruche>.LOG1 / .LOG2
+ * - Valeurs supprimées en option : cellules vk et données libérées, absentes des listes de valeurs
+ *   (récupérables par BamDamCarve)
+ * - Déterministe : même graine, mêmes octets
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+enum class PathLengthDistribution : uint8_t {
+    Uniform,  // Uniforme entre pathMin et pathMax
+    Skewed,   // Majorité de chemins courts, longue traîne jusqu'à pathMax
+};
+
+struct HiveGenOptions {
+    uint32_t sidCount = 8;
+    uint32_t valuesPerSid = 200;        // Par SID et par service (bam, dam)
+    uint32_t pathMin = 40;              // Caractères
+    uint32_t pathMax = 160;
+    PathLengthDistribution distribution = PathLengthDistribution::Uniform;
+    double suspiciousRatio = 0.05;      // Chemins dans Temp ou Downloads
+    double nonLatinRatio = 0.02;        // Noms hors Latin-1 (stockés en UTF-16)
+    bool dam = true;
+    double dirtyRatio = 0.0;            // Part des valeurs plus récentes dans les journaux seulement
+    double deletedRatio = 0.0;          // Part des valeurs supprimées (cellules libérées, intactes)
+    std::u16string computerName = u"BENCH-HOST";
+    uint64_t seed = 1;
+};
+
+struct HiveGenStats {
+    uint64_t hiveBytes = 0;
+    uint64_t logBytes = 0;
+    size_t rows = 0;        // Valeurs FILETIME écrites
+    size_t dirtyRows = 0;   // Dont FILETIME plus récent dans les journaux
+    size_t dirtyPages = 0;
+    size_t deletedRows = 0; // Valeurs supprimées, hors rows
+};
+
+// Écrit la ruche (et ses journaux si dirtyRatio > 0) ; message d'erreur dans error
+bool GenerateSystemHive(const std::filesystem::path& path, const HiveGenOptions& options, HiveGenStats& stats,
+                        std::string& error);
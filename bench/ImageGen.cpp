@@ -0,0 +1,631 @@
+/*
+ * ImageGen - Écriture de la table de partitions, du boot sector, de la MFT et des index $I30
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "ImageGen.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t SECTOR_SIZE = 512;
+constexpr uint32_t CLUSTER_SIZE = 4096;
+constexpr uint32_t RECORD_SIZE = 1024;
+constexpr uint32_t BLOCK_SIZE = 4096;
+constexpr uint32_t RECORDS_PER_CLUSTER = CLUSTER_SIZE / RECORD_SIZE;
+constexpr uint64_t VOLUME_OFFSET = 1 << 20;
+constexpr uint64_t MFT_FIRST_RECORDS = 32;  // Premier extent de la MFT ; la suite est ailleurs
+constexpr uint64_t FILLER_RECORD = 39;
+constexpr uint64_t FIRST_USER_RECORD = 40;
+constexpr uint64_t ROOT_RECORD = 5;
+constexpr uint64_t SPARSE = UINT64_MAX;
+constexpr uint16_t UPDATE_SEQUENCE = 0x0001;
+constexpr uint64_t SEQUENCE_NUMBER = uint64_t{ 1 } << 48;
+
+constexpr uint32_t ATTR_ATTRIBUTE_LIST = 0x20;
+constexpr uint32_t ATTR_DATA = 0x80;
+constexpr uint32_t ATTR_INDEX_ROOT = 0x90;
+constexpr uint32_t ATTR_INDEX_ALLOCATION = 0xA0;
+constexpr uint32_t FILE_NAME_DIRECTORY = 0x10000000;
+
+constexpr size_t ROOT_CAPACITY = 560;  // Entrées de $INDEX_ROOT dans un enregistrement de 1 Ko
+constexpr size_t BLOCK_CAPACITY = BLOCK_SIZE - 0x40 - 24;
+
+constexpr char16_t I30[] = u"$I30";
+
+void Put16(uint8_t* p, uint16_t v) { p[0] = static_cast<uint8_t>(v); p[1] = static_cast<uint8_t>(v >> 8); }
+void Put32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+void Put64(uint8_t* p, uint64_t v) { Put32(p, static_cast<uint32_t>(v)); Put32(p + 4, static_cast<uint32_t>(v >> 32)); }
+
+size_t Align8(size_t n) { return (n + 7) & ~size_t{ 7 }; }
+
+uint32_t Crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+char16_t Upcase(char16_t c) { return c >= u'a' && c <= u'z' ? static_cast<char16_t>(c - 32) : c; }
+
+// Ordre de collation de $I30 tel que le lit NtfsImage
+bool NameLess(std::u16string_view a, std::u16string_view b) {
+    const size_t common = std::min(a.size(), b.size());
+    for (size_t i = 0; i < common; i++) {
+        if (Upcase(a[i]) != Upcase(b[i])) return Upcase(a[i]) < Upcase(b[i]);
+    }
+    return a.size() < b.size();
+}
+
+struct Extent {
+    uint64_t vcn;
+    uint64_t lcn;  // SPARSE : extent creux
+    uint64_t length;
+};
+
+struct Item {
+    std::u16string name;
+    uint64_t ref = 0;
+    uint64_t size = 0;
+    bool directory = false;
+    int64_t child = -1;  // Bloc INDX de gauche
+};
+
+struct Directory {
+    std::u16string path;
+    uint64_t record;
+    uint64_t parentRef;
+    std::vector<Item> items;
+};
+
+struct IndexNode {
+    std::vector<Item> items;
+    int64_t lastChild = -1;
+};
+
+// Tableau de mise à jour : les 2 derniers octets de chaque secteur passent dans le tableau
+void ApplyFixup(uint8_t* block, size_t size, uint16_t usaOffset) {
+    const uint16_t count = static_cast<uint16_t>(size / SECTOR_SIZE + 1);
+    Put16(block + 4, usaOffset);
+    Put16(block + 6, count);
+    uint8_t* usa = block + usaOffset;
+    Put16(usa, UPDATE_SEQUENCE);
+    for (size_t i = 1; i < count; i++) {
+        uint8_t* tail = block + i * SECTOR_SIZE - 2;
+        std::memcpy(usa + i * 2, tail, 2);
+        Put16(tail, UPDATE_SEQUENCE);
+    }
+}
+
+unsigned UnsignedBytes(uint64_t v) {
+    unsigned n = 1;
+    while (n < 8 && (v >> (8 * n)) != 0) n++;
+    return n;
+}
+
+unsigned SignedBytes(int64_t v) {
+    unsigned n = 1;
+    while (n < 8) {
+        const int64_t limit = int64_t{ 1 } << (8 * n - 1);
+        if (v >= -limit && v < limit) break;
+        n++;
+    }
+    return n;
+}
+
+std::vector<uint8_t> EncodeRuns(const std::vector<Extent>& extents, size_t first, size_t last) {
+    std::vector<uint8_t> runs;
+    int64_t previous = 0;
+    for (size_t i = first; i < last; i++) {
+        const Extent& extent = extents[i];
+        const unsigned lengthBytes = UnsignedBytes(extent.length);
+        int64_t delta = 0;
+        unsigned offsetBytes = 0;
+        if (extent.lcn != SPARSE) {
+            delta = static_cast<int64_t>(extent.lcn) - previous;
+            offsetBytes = SignedBytes(delta);
+            previous = static_cast<int64_t>(extent.lcn);
+        }
+        runs.push_back(static_cast<uint8_t>(offsetBytes << 4 | lengthBytes));
+        for (unsigned b = 0; b < lengthBytes; b++) runs.push_back(static_cast<uint8_t>(extent.length >> (8 * b)));
+        for (unsigned b = 0; b < offsetBytes; b++) {
+            runs.push_back(static_cast<uint8_t>(static_cast<uint64_t>(delta) >> (8 * b)));
+        }
+    }
+    runs.push_back(0);
+    return runs;
+}
+
+void AppendName(std::vector<uint8_t>& out, size_t at, std::u16string_view name) {
+    for (size_t i = 0; i < name.size(); i++) Put16(out.data() + at + i * 2, name[i]);
+}
+
+void AppendResident(std::vector<uint8_t>& attributes, uint32_t type, std::u16string_view name,
+                    const std::vector<uint8_t>& value, uint16_t id) {
+    const size_t valueOffset = Align8(0x18 + name.size() * 2);
+    const size_t length = Align8(valueOffset + value.size());
+    const size_t at = attributes.size();
+    attributes.resize(at + length, 0);
+    uint8_t* header = attributes.data() + at;
+    Put32(header, type);
+    Put32(header + 4, static_cast<uint32_t>(length));
+    header[9] = static_cast<uint8_t>(name.size());
+    Put16(header + 10, 0x18);
+    Put16(header + 14, id);
+    Put32(header + 0x10, static_cast<uint32_t>(value.size()));
+    Put16(header + 0x14, static_cast<uint16_t>(valueOffset));
+    AppendName(attributes, at + 0x18, name);
+    std::copy(value.begin(), value.end(), attributes.begin() + at + valueOffset);
+}
+
+// Segment [first, last) des extents ; tailles renseignées seulement dans le segment de VCN 0
+void AppendNonResident(std::vector<uint8_t>& attributes, uint32_t type, std::u16string_view name,
+                       const std::vector<Extent>& extents, size_t first, size_t last, uint64_t realSize,
+                       uint16_t id) {
+    const std::vector<uint8_t> runs = EncodeRuns(extents, first, last);
+    const size_t runsOffset = Align8(0x40 + name.size() * 2);
+    const size_t length = Align8(runsOffset + runs.size());
+    const size_t at = attributes.size();
+    attributes.resize(at + length, 0);
+    uint8_t* header = attributes.data() + at;
+    const uint64_t startVcn = extents[first].vcn;
+    const uint64_t endVcn = extents[last - 1].vcn + extents[last - 1].length;
+    Put32(header, type);
+    Put32(header + 4, static_cast<uint32_t>(length));
+    header[8] = 1;
+    header[9] = static_cast<uint8_t>(name.size());
+    Put16(header + 10, 0x40);
+    Put16(header + 14, id);
+    Put64(header + 0x10, startVcn);
+    Put64(header + 0x18, endVcn - 1);
+    Put16(header + 0x20, static_cast<uint16_t>(runsOffset));
+    if (startVcn == 0) {
+        Put64(header + 0x28, (extents.back().vcn + extents.back().length) * CLUSTER_SIZE);
+        Put64(header + 0x30, realSize);
+        Put64(header + 0x38, realSize);
+    }
+    AppendName(attributes, at + 0x40, name);
+    std::copy(runs.begin(), runs.end(), attributes.begin() + at + runsOffset);
+}
+
+bool BuildRecord(uint64_t number, uint16_t flags, uint64_t baseRef, const std::vector<uint8_t>& attributes,
+                 std::vector<uint8_t>& record) {
+    const size_t used = 0x38 + attributes.size() + 8;
+    if (used > RECORD_SIZE) return false;
+    record.assign(RECORD_SIZE, 0);
+    std::memcpy(record.data(), "FILE", 4);
+    Put16(record.data() + 0x10, 1);
+    Put16(record.data() + 0x12, 1);
+    Put16(record.data() + 0x14, 0x38);
+    Put16(record.data() + 0x16, flags);
+    Put32(record.data() + 0x18, static_cast<uint32_t>(used));
+    Put32(record.data() + 0x1C, RECORD_SIZE);
+    Put64(record.data() + 0x20, baseRef);
+    Put32(record.data() + 0x2C, static_cast<uint32_t>(number));
+    std::copy(attributes.begin(), attributes.end(), record.begin() + 0x38);
+    Put32(record.data() + 0x38 + attributes.size(), 0xFFFFFFFF);
+    ApplyFixup(record.data(), RECORD_SIZE, 0x30);
+    return true;
+}
+
+size_t EntrySize(const Item& item, bool hasChild) {
+    return Align8(16 + 0x42 + item.name.size() * 2) + (hasChild ? 8 : 0);
+}
+
+// Entrées d'un nœud + entrée finale ; clé = attribut $FILE_NAME
+std::vector<uint8_t> EncodeNode(const IndexNode& node, uint64_t parentRef) {
+    const bool hasChild = node.lastChild >= 0;
+    std::vector<uint8_t> out;
+    for (const Item& item : node.items) {
+        const size_t keyLength = 0x42 + item.name.size() * 2;
+        const size_t length = EntrySize(item, hasChild);
+        const size_t at = out.size();
+        out.resize(at + length, 0);
+        uint8_t* entry = out.data() + at;
+        Put64(entry, item.ref);
+        Put16(entry + 8, static_cast<uint16_t>(length));
+        Put16(entry + 10, static_cast<uint16_t>(keyLength));
+        Put32(entry + 12, hasChild ? 1 : 0);
+        uint8_t* key = entry + 16;
+        Put64(key, parentRef);
+        Put64(key + 0x28, (item.size + CLUSTER_SIZE - 1) / CLUSTER_SIZE * CLUSTER_SIZE);
+        Put64(key + 0x30, item.size);
+        Put32(key + 0x38, item.directory ? FILE_NAME_DIRECTORY : 0x20);
+        key[0x40] = static_cast<uint8_t>(item.name.size());
+        key[0x41] = 1;  // Espace de noms Win32
+        AppendName(out, at + 16 + 0x42, item.name);
+        if (hasChild) Put64(entry + length - 8, static_cast<uint64_t>(item.child));
+    }
+    const size_t at = out.size();
+    out.resize(at + (hasChild ? 24 : 16), 0);
+    Put16(out.data() + at + 8, static_cast<uint16_t>(hasChild ? 24 : 16));
+    Put32(out.data() + at + 12, hasChild ? 3 : 2);
+    if (hasChild) Put64(out.data() + at + 16, static_cast<uint64_t>(node.lastChild));
+    return out;
+}
+
+size_t NodeSize(const std::vector<Item>& items, bool hasChild) {
+    size_t size = hasChild ? 24 : 16;
+    for (const Item& item : items) size += EntrySize(item, hasChild);
+    return size;
+}
+
+// Arbre B construit par niveaux : chaque niveau découpé en blocs, une entrée séparatrice remonte entre
+// deux blocs voisins. Retourne le nombre de niveaux de blocs ; root reçoit ce qui tient dans l'enregistrement.
+size_t BuildIndex(std::vector<Item> items, IndexNode& root, std::vector<IndexNode>& blocks) {
+    int64_t rightmost = -1;
+    size_t depth = 0;
+    while (NodeSize(items, rightmost >= 0) > ROOT_CAPACITY) {
+        const bool hasChild = rightmost >= 0;
+        std::vector<Item> separators;
+        IndexNode current;
+        for (Item& item : items) {
+            const size_t grown = NodeSize(current.items, hasChild) + EntrySize(item, hasChild);
+            if (!current.items.empty() && grown > BLOCK_CAPACITY) {
+                current.lastChild = item.child;
+                blocks.push_back(std::move(current));
+                current = IndexNode{};
+                item.child = static_cast<int64_t>(blocks.size() - 1);
+                separators.push_back(std::move(item));
+                continue;
+            }
+            current.items.push_back(std::move(item));
+        }
+        current.lastChild = rightmost;
+        blocks.push_back(std::move(current));
+        rightmost = static_cast<int64_t>(blocks.size() - 1);
+        items = std::move(separators);
+        depth++;
+    }
+    root.items = std::move(items);
+    root.lastChild = rightmost;
+    return depth;
+}
+
+class VolumeWriter {
+public:
+    uint64_t Allocate(uint64_t clusters) {
+        const uint64_t lcn = next;
+        next += clusters;
+        volume.resize(next * CLUSTER_SIZE, 0);
+        return lcn;
+    }
+    uint8_t* At(uint64_t lcn) { return volume.data() + lcn * CLUSTER_SIZE; }
+    uint64_t Clusters() const { return next; }
+    const std::vector<uint8_t>& Data() const { return volume; }
+
+private:
+    std::vector<uint8_t> volume;
+    uint64_t next = 0;
+};
+
+// Copie data dans le volume ; fragmenté : trois morceaux placés dans le désordre, clusters nuls creux
+std::vector<Extent> PlaceData(VolumeWriter& volume, const std::vector<uint8_t>& data, bool fragment) {
+    const uint64_t clusters = (data.size() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    std::vector<Extent> extents;
+    auto place = [&](uint64_t firstVcn, uint64_t count) {
+        const uint64_t lcn = volume.Allocate(count);
+        for (uint64_t i = 0; i < count; i++) {
+            const size_t offset = static_cast<size_t>((firstVcn + i) * CLUSTER_SIZE);
+            const size_t size = std::min<size_t>(CLUSTER_SIZE, data.size() - offset);
+            const bool zero = std::all_of(data.begin() + offset, data.begin() + offset + size,
+                                          [](uint8_t b) { return b == 0; });
+            std::memcpy(volume.At(lcn + i), data.data() + offset, size);
+            const uint64_t target = fragment && zero ? SPARSE : lcn + i;
+            if (!extents.empty()) {
+                Extent& last = extents.back();
+                const bool contiguous = target == SPARSE ? last.lcn == SPARSE
+                                                         : last.lcn != SPARSE && last.lcn + last.length == target;
+                if (contiguous && last.vcn + last.length == firstVcn + i) {
+                    last.length++;
+                    continue;
+                }
+            }
+            extents.push_back({ firstVcn + i, target, 1 });
+        }
+    };
+    if (!fragment || clusters < 3) {
+        if (clusters) place(0, clusters);
+        return extents;
+    }
+    const uint64_t cut1 = clusters / 3;
+    const uint64_t cut2 = clusters * 2 / 3;
+    place(cut2, clusters - cut2);
+    volume.Allocate(1);
+    place(0, cut1);
+    volume.Allocate(1);
+    place(cut1, cut2 - cut1);
+    std::sort(extents.begin(), extents.end(), [](const Extent& a, const Extent& b) { return a.vcn < b.vcn; });
+    return extents;
+}
+
+std::vector<std::u16string_view> SplitPath(std::u16string_view path) {
+    std::vector<std::u16string_view> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find(u'\\', start);
+        if (end == std::u16string_view::npos) end = path.size();
+        if (end > start) parts.push_back(path.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+void WritePartitionTable(std::vector<uint8_t>& header, uint64_t imageSectors, uint64_t volumeSectors, bool gpt,
+                         uint64_t seed) {
+    const uint64_t firstLba = VOLUME_OFFSET / SECTOR_SIZE;
+    uint8_t* entry = header.data() + 0x1BE;
+    if (!gpt) {
+        entry[0] = 0x80;
+        entry[4] = 0x07;
+        Put32(entry + 8, static_cast<uint32_t>(firstLba));
+        Put32(entry + 12, static_cast<uint32_t>(std::min<uint64_t>(volumeSectors, 0xFFFFFFFF)));
+        Put32(header.data() + 0x1B8, static_cast<uint32_t>(seed * 2654435761u));
+    } else {
+        entry[4] = 0xEE;
+        Put32(entry + 8, 1);
+        Put32(entry + 12, static_cast<uint32_t>(std::min<uint64_t>(imageSectors - 1, 0xFFFFFFFF)));
+
+        static const uint8_t BASIC_DATA[16] = { 0xA2, 0xA0, 0xD0, 0xEB, 0xE5, 0xB9, 0x33, 0x44,
+                                                0x87, 0xC0, 0x68, 0xB6, 0xB7, 0x26, 0x99, 0xC7 };
+        uint8_t* entries = header.data() + 2 * SECTOR_SIZE;
+        std::memcpy(entries, BASIC_DATA, 16);
+        Put64(entries + 16, seed * 0x9E3779B97F4A7C15ULL);
+        Put64(entries + 24, ~seed);
+        Put64(entries + 32, firstLba);
+        Put64(entries + 40, firstLba + volumeSectors - 1);
+        const char16_t name[] = u"Basic data partition";
+        for (size_t i = 0; name[i]; i++) Put16(entries + 56 + i * 2, name[i]);
+
+        uint8_t* gptHeader = header.data() + SECTOR_SIZE;
+        std::memcpy(gptHeader, "EFI PART", 8);
+        Put32(gptHeader + 8, 0x00010000);
+        Put32(gptHeader + 12, 92);
+        Put64(gptHeader + 24, 1);
+        Put64(gptHeader + 32, imageSectors - 1);
+        Put64(gptHeader + 40, 34);
+        Put64(gptHeader + 48, imageSectors - 34);
+        Put64(gptHeader + 56, seed ^ 0x5A5A5A5A5A5A5A5AULL);
+        Put64(gptHeader + 64, seed + 1);
+        Put64(gptHeader + 0x48, 2);
+        Put32(gptHeader + 0x50, 128);
+        Put32(gptHeader + 0x54, 128);
+        Put32(gptHeader + 0x58, Crc32(entries, 128 * 128));
+        Put32(gptHeader + 16, Crc32(gptHeader, 92));
+    }
+    header[510] = 0x55;
+    header[511] = 0xAA;
+}
+
+}  // namespace
+
+bool WriteNtfsImage(const fs::path& path, const std::vector<NtfsImageFile>& files, const NtfsImageOptions& options,
+                    NtfsImageStats& stats, std::string& error) {
+    stats = NtfsImageStats{};
+    stats.volumeOffset = VOLUME_OFFSET;
+
+    // Arborescence : répertoires créés à la demande, numéros d'enregistrement dans l'ordre de création
+    std::vector<Directory> directories;
+    directories.push_back({ u"", ROOT_RECORD, ROOT_RECORD | SEQUENCE_NUMBER, {} });
+    uint64_t nextRecord = FIRST_USER_RECORD;
+    auto directoryOf = [&](std::u16string_view dirPath) {
+        size_t current = 0;
+        std::u16string prefix;
+        for (std::u16string_view part : SplitPath(dirPath)) {
+            if (!prefix.empty()) prefix.push_back(u'\\');
+            prefix.append(part);
+            auto it = std::find_if(directories.begin(), directories.end(),
+                                   [&](const Directory& d) { return d.path == prefix; });
+            if (it == directories.end()) {
+                const uint64_t parentRef = directories[current].record | SEQUENCE_NUMBER;
+                const uint64_t record = nextRecord++;
+                directories[current].items.push_back({ std::u16string(part), record | SEQUENCE_NUMBER, 0, true });
+                directories.push_back({ prefix, record, parentRef, {} });
+                current = directories.size() - 1;
+            } else {
+                current = static_cast<size_t>(it - directories.begin());
+            }
+        }
+        return current;
+    };
+
+    VolumeWriter volume;
+    volume.Allocate(16);  // Boot sector et réserve
+    const uint64_t mftFirstLcn = volume.Allocate(MFT_FIRST_RECORDS / RECORDS_PER_CLUSTER);
+
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> records;
+    for (const NtfsImageFile& file : files) {
+        const std::u16string_view filePath = file.path;
+        const size_t slash = filePath.rfind(u'\\');
+        const std::u16string_view name = slash == std::u16string_view::npos ? filePath : filePath.substr(slash + 1);
+        const size_t dir = directoryOf(slash == std::u16string_view::npos ? u"" : filePath.substr(0, slash));
+        const uint64_t number = nextRecord++;
+        const uint64_t ref = number | SEQUENCE_NUMBER;
+        directories[dir].items.push_back({ std::u16string(name), ref, file.data.size(), false });
+
+        std::vector<uint8_t> attributes;
+        std::vector<uint8_t> record;
+        if (file.data.size() <= 256) {
+            AppendResident(attributes, ATTR_DATA, u"", file.data, 1);
+        } else {
+            const std::vector<Extent> extents = PlaceData(volume, file.data, options.fragment);
+            if (options.fragment && extents.size() >= 2) {
+                // Seconde moitié des extents dans un enregistrement d'extension
+                const size_t half = extents.size() / 2;
+                const uint64_t extension = nextRecord++;
+                std::vector<uint8_t> list(0x40, 0);
+                for (int i = 0; i < 2; i++) {
+                    uint8_t* entry = list.data() + i * 0x20;
+                    Put32(entry, ATTR_DATA);
+                    Put16(entry + 4, 0x20);
+                    entry[7] = 0x1A;
+                    Put64(entry + 8, i == 0 ? 0 : extents[half].vcn);
+                    Put64(entry + 0x10, (i == 0 ? number : extension) | SEQUENCE_NUMBER);
+                    Put16(entry + 0x18, static_cast<uint16_t>(i + 1));
+                }
+                AppendResident(attributes, ATTR_ATTRIBUTE_LIST, u"", list, 0);
+                AppendNonResident(attributes, ATTR_DATA, u"", extents, 0, half, file.data.size(), 1);
+                std::vector<uint8_t> extensionAttributes;
+                AppendNonResident(extensionAttributes, ATTR_DATA, u"", extents, half, extents.size(),
+                                  file.data.size(), 2);
+                if (!BuildRecord(extension, 0x01, ref, extensionAttributes, record)) {
+                    error = "Enregistrement d'extension trop grand";
+                    return false;
+                }
+                records.emplace_back(extension, std::move(record));
+            } else {
+                AppendNonResident(attributes, ATTR_DATA, u"", extents, 0, extents.size(), file.data.size(), 1);
+            }
+        }
+        if (!BuildRecord(number, 0x01, 0, attributes, record)) {
+            error = "Trop d'extents pour un enregistrement FILE";
+            return false;
+        }
+        records.emplace_back(number, std::move(record));
+    }
+
+    // Entrées de remplissage : toutes désignent le même petit fichier
+    if (options.fillers) {
+        const size_t dir = directoryOf(options.fillerDirectory);
+        for (uint32_t i = 0; i < options.fillers; i++) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "Filler-%05u.dll", i);
+            directories[dir].items.push_back(
+                { std::u16string(name, name + std::strlen(name)), FILLER_RECORD | SEQUENCE_NUMBER, 0, false });
+        }
+        std::vector<uint8_t> attributes;
+        std::vector<uint8_t> record;
+        AppendResident(attributes, ATTR_DATA, u"", {}, 1);
+        BuildRecord(FILLER_RECORD, 0x01, 0, attributes, record);
+        records.emplace_back(FILLER_RECORD, std::move(record));
+    }
+
+    for (Directory& directory : directories) {
+        std::sort(directory.items.begin(), directory.items.end(),
+                  [](const Item& a, const Item& b) { return NameLess(a.name, b.name); });
+        IndexNode root;
+        std::vector<IndexNode> blocks;
+        const size_t depth = BuildIndex(std::move(directory.items), root, blocks);
+        if (directory.path == options.fillerDirectory) stats.indexDepth = depth;
+        const uint64_t selfRef = directory.record | SEQUENCE_NUMBER;
+
+        std::vector<uint8_t> attributes;
+        const std::vector<uint8_t> rootEntries = EncodeNode(root, selfRef);
+        std::vector<uint8_t> rootValue(0x20, 0);
+        Put32(rootValue.data(), 0x30);
+        Put32(rootValue.data() + 4, 1);
+        Put32(rootValue.data() + 8, BLOCK_SIZE);
+        rootValue[12] = BLOCK_SIZE / CLUSTER_SIZE;
+        Put32(rootValue.data() + 0x10, 0x10);
+        Put32(rootValue.data() + 0x14, static_cast<uint32_t>(0x10 + rootEntries.size()));
+        Put32(rootValue.data() + 0x18, static_cast<uint32_t>(0x10 + rootEntries.size()));
+        Put32(rootValue.data() + 0x1C, blocks.empty() ? 0 : 1);
+        rootValue.insert(rootValue.end(), rootEntries.begin(), rootEntries.end());
+        AppendResident(attributes, ATTR_INDEX_ROOT, I30, rootValue, 1);
+
+        if (!blocks.empty()) {
+            const uint64_t lcn = volume.Allocate(blocks.size());
+            for (size_t b = 0; b < blocks.size(); b++) {
+                uint8_t* block = volume.At(lcn + b);
+                const std::vector<uint8_t> entries = EncodeNode(blocks[b], selfRef);
+                std::memcpy(block, "INDX", 4);
+                Put64(block + 0x10, b);
+                Put32(block + 0x18, 0x28);
+                Put32(block + 0x1C, static_cast<uint32_t>(0x28 + entries.size()));
+                Put32(block + 0x20, BLOCK_SIZE - 0x18);
+                Put32(block + 0x24, blocks[b].lastChild >= 0 ? 1 : 0);
+                std::memcpy(block + 0x40, entries.data(), entries.size());
+                ApplyFixup(block, BLOCK_SIZE, 0x28);
+            }
+            const std::vector<Extent> extents = { { 0, lcn, blocks.size() } };
+            AppendNonResident(attributes, ATTR_INDEX_ALLOCATION, I30, extents, 0, 1, blocks.size() * BLOCK_SIZE, 2);
+        }
+        std::vector<uint8_t> record;
+        if (!BuildRecord(directory.record, 0x03, 0, attributes, record)) {
+            error = "Index racine du répertoire trop grand";
+            return false;
+        }
+        records.emplace_back(directory.record, std::move(record));
+    }
+
+    // MFT : 32 premiers enregistrements au début du volume, la suite après les données
+    const uint64_t recordCount = (nextRecord + RECORDS_PER_CLUSTER - 1) / RECORDS_PER_CLUSTER * RECORDS_PER_CLUSTER;
+    const uint64_t secondClusters = (recordCount - MFT_FIRST_RECORDS) / RECORDS_PER_CLUSTER;
+    const uint64_t mftSecondLcn = volume.Allocate(secondClusters);
+    const uint64_t firstClusters = MFT_FIRST_RECORDS / RECORDS_PER_CLUSTER;
+    const std::vector<Extent> mftExtents = { { 0, mftFirstLcn, firstClusters },
+                                             { firstClusters, mftSecondLcn, secondClusters } };
+    {
+        std::vector<uint8_t> attributes;
+        std::vector<uint8_t> record;
+        AppendNonResident(attributes, ATTR_DATA, u"", mftExtents, 0, 2, recordCount * RECORD_SIZE, 1);
+        BuildRecord(0, 0x01, 0, attributes, record);
+        records.emplace_back(0, std::move(record));
+    }
+    for (const auto& [number, record] : records) {
+        const uint64_t lcn = number < MFT_FIRST_RECORDS
+                                 ? mftFirstLcn + number / RECORDS_PER_CLUSTER
+                                 : mftSecondLcn + (number - MFT_FIRST_RECORDS) / RECORDS_PER_CLUSTER;
+        std::memcpy(volume.At(lcn) + (number % RECORDS_PER_CLUSTER) * RECORD_SIZE, record.data(), RECORD_SIZE);
+    }
+
+    // Taille : volume utile, ou toute l'image demandée (fin creuse)
+    const uint64_t tail = options.gpt ? 34 * SECTOR_SIZE : 0;
+    uint64_t imageSize = VOLUME_OFFSET + volume.Clusters() * CLUSTER_SIZE + tail;
+    imageSize = std::max(imageSize, options.imageSize / CLUSTER_SIZE * CLUSTER_SIZE);
+    const uint64_t volumeClusters = (imageSize - VOLUME_OFFSET - tail) / CLUSTER_SIZE;
+    const uint64_t volumeSectors = volumeClusters * (CLUSTER_SIZE / SECTOR_SIZE);
+
+    uint8_t* boot = volume.At(0);
+    const uint8_t jump[3] = { 0xEB, 0x52, 0x90 };
+    std::memcpy(boot, jump, 3);
+    std::memcpy(boot + 3, "NTFS    ", 8);
+    Put16(boot + 0x0B, SECTOR_SIZE);
+    boot[0x0D] = CLUSTER_SIZE / SECTOR_SIZE;
+    boot[0x15] = 0xF8;
+    Put32(boot + 0x1C, static_cast<uint32_t>(VOLUME_OFFSET / SECTOR_SIZE));
+    Put64(boot + 0x28, volumeSectors - 1);
+    Put64(boot + 0x30, mftFirstLcn);
+    Put64(boot + 0x38, mftSecondLcn);
+    boot[0x40] = static_cast<uint8_t>(-10);  // 2^10 = 1024 octets par enregistrement
+    boot[0x44] = BLOCK_SIZE / CLUSTER_SIZE;
+    Put64(boot + 0x48, options.seed * 0x2545F4914F6CDD1DULL);
+    boot[510] = 0x55;
+    boot[511] = 0xAA;
+
+    std::vector<uint8_t> header(VOLUME_OFFSET, 0);
+    WritePartitionTable(header, imageSize / SECTOR_SIZE, volumeSectors, options.gpt, options.seed);
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        out.write(reinterpret_cast<const char*>(volume.Data().data()),
+                  static_cast<std::streamsize>(volume.Data().size()));
+        if (!out) {
+            error = "Écriture impossible : " + path.u8string();
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::resize_file(path, imageSize, ec);
+    if (ec) {
+        error = "Redimensionnement impossible : " + ec.message();
+        return false;
+    }
+    stats.imageBytes = imageSize;
+    stats.writtenBytes = header.size() + volume.Data().size();
+    return true;
+}
@@ -0,0 +1,50 @@
+/*
+ * ImageGen - Images disque brutes synthétiques avec un volume NTFS minimal (vérification de NtfsImage)
+ *
+ * - Table MBR ou GPT (MBR de protection + en-tête et entrées GPT, CRC32 calculés), volume à 1 Mio,
+ *   clusters de 4 Ko, enregistrements FILE de 1 Ko, blocs INDX de 4 Ko, tableaux de mise à jour appliqués
+ * - MFT en deux extents ; répertoires indexés par $I30, entrées de remplissage pour obtenir un arbre B
+ *   à plusieurs niveaux dans le répertoire choisi
+ * - Fichiers fragmentés en option : extents dans le désordre (offsets LCN négatifs), clusters nuls
+ *   écrits en extents creux, seconde moitié des extents dans un enregistrement d'extension désigné par
+ *   $ATTRIBUTE_LIST
+ * - Taille d'image arbitraire : la fin du fichier est creuse (aucun octet écrit au-delà du volume utile)
+ *
+ * Seules les structures lues par NtfsImage sont produites ($STANDARD_INFORMATION, $Bitmap, $LogFile...
+ * sont absents) : ce n'est pas un volume montable.
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct NtfsImageFile {
+    std::u16string path;  // Relatif à la racine du volume, séparé par '\\'
+    std::vector<uint8_t> data;
+};
+
+struct NtfsImageOptions {
+    bool gpt = false;
+    bool fragment = true;
+    std::u16string fillerDirectory = u"Windows\\System32";
+    uint32_t fillers = 3000;  // Entrées de remplissage dans fillerDirectory
+    uint64_t imageSize = 0;   // Octets ; 0 = juste ce qu'il faut
+    uint64_t seed = 1;
+};
+
+struct NtfsImageStats {
+    uint64_t imageBytes = 0;
+    uint64_t volumeOffset = 0;
+    uint64_t writtenBytes = 0;  // Octets réellement écrits (tables + volume utile)
+    size_t indexDepth = 0;      // Niveaux de blocs INDX sous $INDEX_ROOT dans fillerDirectory
+};
+
+bool WriteNtfsImage(const std::filesystem::path& path, const std::vector<NtfsImageFile>& files,
+                    const NtfsImageOptions& options, NtfsImageStats& stats, std::string& error);
@@ -6,19 +6,25 @@ echo ========================================
 echo Building BamDamForensics
 echo ========================================
 
-cl.exe /nologo /W4 /EHsc /O2 /DUNICODE /D_UNICODE ^
+cl.exe /nologo /W4 /EHsc /O2 /std:c++17 /DUNICODE /D_UNICODE ^
     /Fe:BamDamForensics.exe ^
-    BamDamForensics.cpp ^
+    BamDamForensics.cpp MappedFile.cpp RegfHive.cpp BamDamHive.cpp BamDamStream.cpp EntryStore.cpp EntryExport.cpp SidResolver.cpp PathRules.cpp Telemetry.cpp VolumeMap.cpp EntryQuery.cpp CaseFile.cpp Transcode.cpp BamDamCarve.cpp EntrySort.cpp ^
     /link ^
     comctl32.lib shlwapi.lib advapi32.lib user32.lib gdi32.lib shell32.lib
+if %ERRORLEVEL% NEQ 0 goto :failed
 
+cl.exe /nologo /W4 /EHsc /O2 /std:c++17 /DUNICODE /D_UNICODE ^
+    /Fe:BamDamBatch.exe ^
+    BamDamBatch.cpp MappedFile.cpp RegfHive.cpp BamDamHive.cpp BamDamStream.cpp EntryStore.cpp EntryExport.cpp SidResolver.cpp PathRules.cpp SnapshotIndex.cpp Telemetry.cpp VolumeMap.cpp HiveHistory.cpp NtfsImage.cpp Timeline.cpp EntryQuery.cpp CaseFile.cpp Rarity.cpp Transcode.cpp BamDamCarve.cpp IngestWatch.cpp EntrySort.cpp
+
+:failed
 if %ERRORLEVEL% EQU 0 (
     echo.
     echo ========================================
     echo Build successful!
-    echo Executable: BamDamForensics.exe
+    echo Executables: BamDamForensics.exe BamDamBatch.exe
     echo ========================================
-    if exist BamDamForensics.obj del BamDamForensics.obj
+    del /q *.obj 2>nul
 ) else (
     echo.
     echo ========================================
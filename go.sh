@@ -0,0 +1,27 @@
+#!/bin/sh
+# Compilation script for BamDamBatch (Linux / macOS)
+# WinToolsSuite Serie 3 - Forensics Tool #23
+#
+# L'interface graphique (BamDamForensics.cpp) reste Windows uniquement : voir go.bat
+
+echo "========================================"
+echo "Building BamDamBatch"
+echo "========================================"
+
+CXX=${CXX:-g++}
+
+if $CXX -std=c++17 -O2 -Wall -Wextra -pthread \
+    -o BamDamBatch \
+    BamDamBatch.cpp MappedFile.cpp RegfHive.cpp BamDamHive.cpp BamDamStream.cpp EntryStore.cpp EntryExport.cpp SidResolver.cpp PathRules.cpp SnapshotIndex.cpp Telemetry.cpp VolumeMap.cpp HiveHistory.cpp NtfsImage.cpp Timeline.cpp EntryQuery.cpp CaseFile.cpp Rarity.cpp Transcode.cpp BamDamCarve.cpp IngestWatch.cpp EntrySort.cpp; then
+    echo
+    echo "========================================"
+    echo "Build successful!"
+    echo "Executable: BamDamBatch"
+    echo "========================================"
+else
+    echo
+    echo "========================================"
+    echo "Build FAILED!"
+    echo "========================================"
+    exit 1
+fi
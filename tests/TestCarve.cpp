@@ -0,0 +1,73 @@
+/*
+ * TestCarve - CarveBamDamHive (--deleted) : toutes les valeurs supprimées par HiveGen retrouvées, aucune
+ * valeur vivante ni fausse signature rapportée
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../BamDamCarve.h"
+#include "../BamDamHive.h"
+#include "../RegfHive.h"
+#include "../bench/HiveGen.h"
+
+#include <set>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void CheckRecall(const fs::path& hivePath, double deletedRatio, double dirtyRatio, uint64_t seed) {
+    HiveGenOptions options;
+    options.sidCount = 6;
+    options.valuesPerSid = 80;
+    options.nonLatinRatio = 0.1;
+    options.deletedRatio = deletedRatio;
+    options.dirtyRatio = dirtyRatio;
+    options.seed = seed;
+    HiveGenStats stats;
+    std::string error;
+    CHECK(GenerateSystemHive(hivePath, options, stats, error));
+    CHECK(deletedRatio == 0 || stats.deletedRows > 0);
+
+    RegfHive hive;
+    CHECK(hive.Open(hivePath));
+    EntryStore store;
+    const uint32_t host = store.hosts.Intern(u"BENCH-HOST");
+    ParseBamDamHive(hive, store, host);
+    const size_t live = store.size();
+    std::set<std::pair<std::u16string, uint64_t>> liveValues;
+    for (size_t row = 0; row < live; row++) liveValues.emplace(store.Path(row), store.FileTime(row));
+
+    CarveStats carve;
+    const size_t recovered = CarveBamDamHive(hive, store, host, PathClassifier::Default(), &carve);
+    CHECK_EQ(recovered, stats.deletedRows);
+    CHECK_EQ(store.size(), live + recovered);
+    CHECK_EQ(carve.invalidData, uint64_t(0));
+    for (size_t row = live; row < store.size(); row++) {
+        CHECK(store.Source(row) == EntrySource::Recovered);
+        CHECK(store.FileTime(row) != 0);
+        CHECK(!liveValues.count({ std::u16string(store.Path(row)), store.FileTime(row) }));
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::error_code ec;
+    const fs::path directory = fs::temp_directory_path(ec) / "bamdam_test_carve";
+    fs::remove_all(directory, ec);
+    fs::create_directories(directory, ec);
+
+    CheckRecall(directory / "CLEAN", 0.0, 0.0, 3);
+    CheckRecall(directory / "DELETED", 0.15, 0.0, 5);
+    CheckRecall(directory / "DIRTY", 0.15, 0.2, 9);
+
+    fs::remove_all(directory, ec);
+    return TestFailures() ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * TestCaseIndex - CaseFile : index altéré refusé à l'ouverture (bornes des listes, rangs et nœuds du trie)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../CaseFile.h"
+#include "../EntryQuery.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> ReadAll(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void WriteAll(const fs::path& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Écrit value (width octets) à l'octet at de la section name ; false si la section manque
+bool Patch(std::vector<uint8_t>& file, const std::string& name, size_t at, uint32_t value, size_t width = 4) {
+    uint64_t count = 0;
+    uint64_t table = 0;
+    std::memcpy(&count, file.data() + 24, 8);
+    std::memcpy(&table, file.data() + 32, 8);
+    for (uint64_t i = 0; i < count; i++) {
+        const uint8_t* entry = file.data() + table + i * 64;
+        if (std::string(reinterpret_cast<const char*>(entry), strnlen(reinterpret_cast<const char*>(entry), 40)) !=
+            name) {
+            continue;
+        }
+        uint64_t offset = 0;
+        std::memcpy(&offset, entry + 40, 8);
+        if (width == 2) {
+            const uint16_t narrow = static_cast<uint16_t>(value);
+            std::memcpy(file.data() + offset + at, &narrow, 2);
+        } else {
+            std::memcpy(file.data() + offset + at, &value, 4);
+        }
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main() {
+    EntryStore store;
+    const uint32_t host = store.hosts.Intern(u"H1");
+    const uint32_t sid = store.sids.Intern(u"S-1-5-18");
+    const uint32_t user = store.users.Intern(u"SYSTEM");
+    const char16_t* paths[] = {
+        u"C:\\Windows\\System32\\a.exe", u"C:\\Windows\\System32\\b.exe", u"C:\\Users\\bob\\a.exe",
+        u"D:\\tools\\c.exe",
+    };
+    for (uint32_t i = 0; i < 8; i++) {
+        store.Add(host, sid, user, store.paths.Intern(paths[i % 4]), 132000000000000000ULL + i * 1000,
+                  EntrySource::Bam);
+    }
+    EntryIndex built;
+    built.Build(store);
+
+    std::error_code ec;
+    const fs::path good = fs::temp_directory_path(ec) / "bamdam_test_index.bdcase";
+    const fs::path bad = fs::temp_directory_path(ec) / "bamdam_test_index_bad.bdcase";
+    CaseFile writer;
+    CHECK(writer.Save(good, store, &built));
+    const std::vector<uint8_t> original = ReadAll(good);
+
+    {
+        // Cas intact : index adossé, requête de chemin exécutée
+        CaseFile file;
+        EntryStore opened;
+        EntryIndex index;
+        CHECK(file.Open(good, opened, &index));
+        CHECK(file.HasIndex());
+        RowBitmap rows(index.Rows());
+        index.SelectPath(u"C:\\Windows\\System32\\*", rows);
+        CHECK_EQ(rows.Count(), size_t(4));
+    }
+
+    struct Corruption {
+        const char* section;
+        size_t at;
+        uint32_t value;
+        size_t width;
+    };
+    // Nœud 1 (PathNode, 24 octets) : path 0, nameStart 4, nameLength 6, firstChild 8, nextSibling 12,
+    // rankBegin 16, rankEnd 20
+    const Corruption corruptions[] = {
+        { "index.rankRows.rows", 0, 0x7FFFFFF0, 4 },
+        { "index.hostRows.rows", 4, 8, 4 },
+        { "index.hostRows.offsets", 0, 5, 4 },
+        { "index.timeOrder", 0, 8, 4 },
+        { "index.rankPaths", 0, 1000, 4 },
+        { "index.nameRanks.rows", 0, 4, 4 },
+        { "index.nodes", 24 + 0, 1000, 4 },
+        { "index.nodes", 24 + 4, 60, 2 },
+        { "index.nodes", 24 + 8, 1000, 4 },
+        { "index.nodes", 24 + 12, 1, 4 },  // Frère = lui-même : cycle
+        { "index.nodes", 24 + 16, 100, 4 },
+        { "index.nodes", 24 + 20, 5, 4 },
+    };
+    for (const Corruption& corruption : corruptions) {
+        std::vector<uint8_t> bytes = original;
+        CHECK(Patch(bytes, corruption.section, corruption.at, corruption.value, corruption.width));
+        WriteAll(bad, bytes);
+
+        CaseFile file;
+        EntryStore opened;
+        EntryIndex index;
+        const bool accepted = file.Open(bad, opened, &index);
+        if (accepted) std::fprintf(stderr, "accepté : %s +%zu\n", corruption.section, corruption.at);
+        CHECK(!accepted);
+        CHECK(file.LastError().find("Index invalide") != std::string::npos);
+    }
+
+    fs::remove(good, ec);
+    fs::remove(bad, ec);
+    return TestFailures() ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * TestCheck - Vérifications minimales des tests (ctest) : échec affiché, code de sortie non nul
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#pragma once
+
+#include <cstdio>
+
+inline int& TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                     \
+    do {                                                                                     \
+        if (!(condition)) {                                                                  \
+            std::fprintf(stderr, "%s:%d : échec : %s\n", __FILE__, __LINE__, #condition);     \
+            TestFailures()++;                                                                \
+        }                                                                                    \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                           \
+    do {                                                                                     \
+        const auto& checkActual = (actual);                                                  \
+        const auto& checkExpected = (expected);                                              \
+        if (!(checkActual == checkExpected)) {                                               \
+            std::fprintf(stderr, "%s:%d : échec : %s == %s\n", __FILE__, __LINE__, #actual,  \
+                         #expected);                                                         \
+            TestFailures()++;                                                                \
+        }                                                                                    \
+    } while (0)
@@ -0,0 +1,180 @@
+/*
+ * TestEntryQuery - ParseQueryTime (dates valides et refusées) et EntryQuery contre un filtre ligne à ligne
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../EntryQuery.h"
+#include "../FileTimeFormat.h"
+#include "../PathRules.h"
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t DAY = 86400 * FILETIME_TICKS_PER_SECOND;
+constexpr uint64_t MARCH_1_2024 = 133537248000000000ULL;  // 2024-03-01T00:00:00Z
+
+std::u16string Folded(std::u16string_view text) {
+    std::u16string out(text);
+    for (char16_t& c : out) c = FoldCase(c);
+    return out;
+}
+
+bool StartsWith(std::u16string_view text, std::u16string_view prefix) {
+    return Folded(text.substr(0, prefix.size())) == Folded(prefix);
+}
+
+// Composants après le volume (C:, \Device\HarddiskVolumeN, \\serveur\partage)
+std::vector<std::u16string> Components(std::u16string_view path) {
+    size_t start = 0;
+    if (path.size() >= 2 && path[1] == u':') {
+        start = 3;
+    } else if (path.substr(0, 2) == u"\\\\") {
+        start = path.find(u'\\', path.find(u'\\', 2) + 1) + 1;
+    } else {
+        start = path.find(u'\\', 8) + 1;
+    }
+    std::vector<std::u16string> parts;
+    for (size_t end; (end = path.find(u'\\', start)) != std::u16string_view::npos; start = end + 1) {
+        parts.push_back(Folded(path.substr(start, end - start)));
+    }
+    parts.push_back(Folded(path.substr(start)));
+    return parts;
+}
+
+bool InTime(const EntryStore& store, size_t row, uint64_t first, uint64_t end) {
+    const uint64_t time = store.FileTime(row);
+    return time != 0 && time >= first && time < end;
+}
+
+}  // namespace
+
+int main() {
+    // ParseQueryTime : valeur et unité du dernier champ saisi
+    uint64_t time = 0;
+    uint64_t unit = 0;
+    CHECK(ParseQueryTime("2024-03-01", time, unit));
+    CHECK_EQ(time, MARCH_1_2024);
+    CHECK_EQ(unit, DAY);
+    CHECK(ParseQueryTime("2024-03-01T12:34Z", time, unit));
+    CHECK_EQ(time, MARCH_1_2024 + (12 * 60 + 34) * FILETIME_TICKS_PER_MINUTE);
+    CHECK_EQ(unit, FILETIME_TICKS_PER_MINUTE);
+    CHECK(ParseQueryTime("2024-03-01t12:34:56", time, unit));
+    CHECK_EQ(time, MARCH_1_2024 + (12 * 3600 + 34 * 60 + 56) * FILETIME_TICKS_PER_SECOND);
+    CHECK_EQ(unit, FILETIME_TICKS_PER_SECOND);
+    CHECK(ParseQueryTime("2024-03-01T00:00:00.5", time, unit));
+    CHECK_EQ(time, MARCH_1_2024 + FILETIME_TICKS_PER_SECOND / 2);
+    CHECK_EQ(unit, FILETIME_TICKS_PER_SECOND / 10);
+    CHECK(ParseQueryTime("2024-03-01T00:00:00.0000001Z", time, unit));
+    CHECK_EQ(time, MARCH_1_2024 + 1);
+    CHECK_EQ(unit, uint64_t(1));
+    CHECK(ParseQueryTime("1601-01-01", time, unit));
+    CHECK_EQ(time, uint64_t(0));
+    CHECK(ParseQueryTime("2024-02-29", time, unit));
+    const char* rejected[] = {
+        "2023-02-29", "2024-04-31", "2024-13-01", "2024-00-10", "1600-12-31", "2024-3-01", "2024-03-01T24:00",
+        "2024-03-01T12:60", "2024-03-01T12:00:60", "2024-03-01T12:00:00.", "2024-03-01T12", "2024-03-01 ", "",
+    };
+    for (const char* text : rejected) CHECK(!ParseQueryTime(text, time, unit));
+
+    // Store synthétique : volumes, casse, valeurs sans FILETIME
+    EntryStore store;
+    const char16_t* hosts[] = { u"H1", u"h2", u"WS-03" };
+    const char16_t* users[] = { u"alice", u"Bob", u"carol", u"Élodie" };
+    const char16_t* paths[] = {
+        u"C:\\Windows\\System32\\cmd.exe",
+        u"C:\\Windows\\System32\\calc.exe",
+        u"C:\\WINDOWS\\system32\\Drivers\\a.sys",
+        u"C:\\Windows\\SysWOW64\\cmd.exe",
+        u"C:\\Users\\alice\\AppData\\Local\\Temp\\x.exe",
+        u"C:\\Users\\bob\\AppData\\Roaming\\y.exe",
+        u"C:\\Users\\bob\\Downloads\\setup.msi",
+        u"\\Device\\HarddiskVolume3\\Users\\carol\\AppData\\Local\\z.exe",
+        u"\\Device\\HarddiskVolume4\\Tools\\nc.exe",
+        u"\\\\srv\\share\\Users\\dave\\AppData\\w.exe",
+        u"\\\\srv\\share\\tools\\psexec.exe",
+        u"D:\\Games\\game.EXE",
+    };
+    const EntrySource sources[] = { EntrySource::Bam, EntrySource::Dam, EntrySource::Recovered };
+    std::mt19937_64 rng(42);
+    for (size_t row = 0; row < 3000; row++) {
+        const bool invalid = rng() % 20 == 0;
+        const uint64_t fileTime = invalid ? 0 : MARCH_1_2024 - 40 * DAY + rng() % (80 * DAY);
+        store.Add(store.hosts.Intern(hosts[rng() % 3]), store.sids.Intern(u"S-1-5-21-1-2-3-1000"),
+                  store.users.Intern(users[rng() % 4]), store.paths.Intern(paths[rng() % 12]), fileTime,
+                  sources[rng() % 3], ENTRY_NO_MATCH, invalid ? ENTRY_FLAG_INVALID_DATA : 0);
+    }
+    EntryIndex index;
+    index.Build(store);
+
+    const uint64_t week = MARCH_1_2024 + 7 * DAY;  // Fin exclue du 2024-03-07 (unité : jour)
+    const uint64_t january = MARCH_1_2024 - 29 * DAY - 31 * DAY;
+    struct Case {
+        const char* query;
+        std::function<bool(size_t)> expected;
+    };
+    const auto user = [&](size_t row) { return Folded(store.User(row)); };
+    const auto path = [&](size_t row) { return store.NormalizedPath(row); };
+    const auto name = [&](size_t row) { return Components(path(row)).back(); };
+    const Case cases[] = {
+        { "user:alice", [&](size_t row) { return user(row) == u"alice"; } },
+        { "user:BOB", [&](size_t row) { return user(row) == u"bob"; } },
+        { "user:é*", [&](size_t row) { return user(row) == u"élodie"; } },
+        { "user:?a*", [&](size_t row) { return user(row) == u"carol"; } },
+        { "host:h*", [&](size_t row) { return Folded(store.Host(row))[0] == u'h'; } },
+        { "source:dam", [&](size_t row) { return store.Source(row) == EntrySource::Dam; } },
+        { "name:*.exe", [&](size_t row) {
+              const std::u16string file = name(row);
+              return file.size() > 4 && file.substr(file.size() - 4) == u".exe";
+          } },
+        { "name:cmd.exe", [&](size_t row) { return name(row) == u"cmd.exe"; } },
+        { "path:C:\\Windows\\", [&](size_t row) { return StartsWith(path(row), u"C:\\Windows\\"); } },
+        { "path:c:\\windows\\system32\\c",
+          [&](size_t row) { return StartsWith(path(row), u"C:\\Windows\\System32\\c"); } },
+        { "path:\\Users\\*\\AppData\\", [&](size_t row) {
+              const std::vector<std::u16string> parts = Components(path(row));
+              return parts.size() > 3 && parts[0] == u"users" && parts[2] == u"appdata";
+          } },
+        { "path:\\tools\\", [&](size_t row) { return Components(path(row))[0] == u"tools"; } },
+        { "time:2024-03-01..2024-03-07", [&](size_t row) { return InTime(store, row, MARCH_1_2024, week); } },
+        { "time:2024-03-01", [&](size_t row) { return InTime(store, row, MARCH_1_2024, MARCH_1_2024 + DAY); } },
+        { "after:2024-03-01", [&](size_t row) { return InTime(store, row, MARCH_1_2024, UINT64_MAX); } },
+        { "before:2024-01-01T00:00", [&](size_t row) { return InTime(store, row, 1, january); } },
+        { "not time:..2024-02-15", [&](size_t row) { return !InTime(store, row, 1, MARCH_1_2024 - 14 * DAY); } },
+        { "user:alice or host:ws-03 source:bam", [&](size_t row) {
+              return user(row) == u"alice" || (store.Host(row) == u"WS-03" && store.Source(row) == EntrySource::Bam);
+          } },
+        { "(user:bob or user:carol) and not name:c*", [&](size_t row) {
+              return (user(row) == u"bob" || user(row) == u"carol") && name(row)[0] != u'c';
+          } },
+        { "not (source:recovered or path:D:\\)", [&](size_t row) {
+              return store.Source(row) != EntrySource::Recovered && !StartsWith(path(row), u"D:\\");
+          } },
+    };
+    for (const Case& test : cases) {
+        EntryQuery query;
+        CHECK(query.Parse(test.query));
+        const RowBitmap rows = query.Evaluate(index);
+        size_t mismatches = 0;
+        for (size_t row = 0; row < store.size(); row++) {
+            if (rows.Test(static_cast<uint32_t>(row)) != test.expected(row)) mismatches++;
+        }
+        if (mismatches) std::fprintf(stderr, "%s : %zu lignes différentes\n", test.query, mismatches);
+        CHECK_EQ(mismatches, size_t(0));
+    }
+
+    const char* invalid[] = { "", "time:2024-02-30", "(user:a", "user:a)", "bogus:x", "source:usb" };
+    for (const char* text : invalid) {
+        EntryQuery query;
+        CHECK(!query.Parse(text));
+    }
+    return TestFailures() ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * TestEntrySort - EntrySorter contre std::stable_sort (clés combinées, décroissantes, un ou plusieurs threads)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../EntrySort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+char16_t FoldAscii(char16_t c) {
+    return c >= u'a' && c <= u'z' ? static_cast<char16_t>(c - (u'a' - u'A')) : c;
+}
+
+// -1, 0, 1 : casse ASCII ignorée, puis longueur, puis ordinal (ordre documenté de EntrySort)
+int CompareText(std::u16string_view a, std::u16string_view b) {
+    for (size_t i = 0; i < std::min(a.size(), b.size()); i++) {
+        if (FoldAscii(a[i]) != FoldAscii(b[i])) return FoldAscii(a[i]) < FoldAscii(b[i]) ? -1 : 1;
+    }
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    return a == b ? 0 : (a < b ? -1 : 1);
+}
+
+template <class T>
+int CompareValue(T a, T b) {
+    return a == b ? 0 : (a < b ? -1 : 1);
+}
+
+int CompareKey(const EntryStore& store, SortKey key, uint32_t a, uint32_t b) {
+    switch (key) {
+        case SortKey::Host: return CompareText(store.Host(a), store.Host(b));
+        case SortKey::Sid: return CompareText(store.Sid(a), store.Sid(b));
+        case SortKey::User: return CompareText(store.User(a), store.User(b));
+        case SortKey::Path: return CompareText(store.NormalizedPath(a), store.NormalizedPath(b));
+        case SortKey::RawPath: return CompareText(store.Path(a), store.Path(b));
+        case SortKey::Time: return CompareValue(store.FileTime(a), store.FileTime(b));
+        case SortKey::FirstSeen: return CompareValue(store.FirstSeen(a), store.FirstSeen(b));
+        case SortKey::Source:
+            return CompareValue(static_cast<int>(store.Source(a)), static_cast<int>(store.Source(b)));
+    }
+    return 0;
+}
+
+std::vector<uint32_t> Reference(const EntryStore& store, const std::vector<SortField>& fields) {
+    std::vector<uint32_t> order(store.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        for (const SortField& field : fields) {
+            const int order = CompareKey(store, field.key, a, b);
+            if (order != 0) return field.descending ? order > 0 : order < 0;
+        }
+        return false;
+    });
+    return order;
+}
+
+void Fill(EntryStore& store, size_t rows, uint64_t seed) {
+    const char16_t* hosts[] = { u"ws-01", u"WS-01", u"ws-010", u"SRV", u"srv-a", u"Ws-02" };
+    const char16_t* users[] = { u"alice", u"Alice", u"bob", u"Élodie", u"zoé", u"" };
+    const char16_t* paths[] = {
+        u"C:\\Windows\\System32\\cmd.exe", u"c:\\windows\\system32\\CMD.EXE", u"C:\\Users\\bob\\a.exe",
+        u"\\Device\\HarddiskVolume3\\x.exe", u"D:\\b.exe", u"C:\\Users\\bob\\a.exe.bak",
+    };
+    const EntrySource sources[] = { EntrySource::Bam, EntrySource::Dam, EntrySource::Recovered };
+    std::mt19937_64 rng(seed);
+    store.EnableFirstSeen();
+    for (size_t row = 0; row < rows; row++) {
+        // Peu de FILETIME distincts : beaucoup d'égalités, la stabilité compte
+        const uint64_t last = rng() % 17 ? 133000000000000000ULL + (rng() % 50) * 10000000ULL : 0;
+        const uint32_t path = store.paths.Intern(paths[rng() % 6]);
+        const size_t added = store.Add(store.hosts.Intern(hosts[rng() % 6]),
+                                       store.sids.Intern(rng() % 2 ? u"S-1-5-18" : u"S-1-5-21-1-2-3-1001"),
+                                       store.users.Intern(users[rng() % 6]), path, last, sources[rng() % 3],
+                                       ENTRY_NO_MATCH, 0, rng() % 3 ? path : store.paths.Intern(paths[rng() % 6]));
+        store.SetTimes(added, last ? last - (rng() % 4) * 10000000ULL : 0, last, 0);
+    }
+}
+
+}  // namespace
+
+int main() {
+    const char* specs[] = {
+        "", "time", "-time", "host", "host,-time,path", "user,raw", "-source,first,sid", "path,-host,user,time",
+        "-user,-path,-raw,-first,-sid,-host,-source,-time",
+    };
+    const size_t sizes[] = { 0, 1, 7, 1000, 200000 };
+    for (size_t size : sizes) {
+        EntryStore store;
+        Fill(store, size, size + 1);
+        for (unsigned threads : { 1u, 4u }) {
+            EntrySorter sorter(threads);
+            for (const char* spec : specs) {
+                std::vector<SortField> fields;
+                std::string error;
+                if (*spec) CHECK(ParseSortFields(spec, fields, error));  // "" : ordre des lignes
+                std::vector<uint32_t> order;
+                sorter.Sort(store, fields, order);
+                const bool same = order == Reference(store, fields);
+                if (!same) std::fprintf(stderr, "%zu lignes, %u threads, \"%s\" : ordre différent\n", size, threads,
+                                        spec);
+                CHECK(same);
+            }
+        }
+    }
+
+    // Noms de clés : aller-retour, erreurs
+    std::vector<SortField> fields;
+    std::string error;
+    CHECK(ParseSortFields("host,-time,path,raw,sid,user,first,source", fields, error));
+    CHECK_EQ(fields.size(), size_t(8));
+    for (const SortField& field : fields) {
+        std::vector<SortField> again;
+        CHECK(ParseSortFields(SortKeyName(field.key), again, error));
+        CHECK(again.size() == 1 && again[0].key == field.key);
+    }
+    CHECK(fields[1].descending && !fields[0].descending);
+    CHECK(!ParseSortFields("host,bogus", fields, error));
+    CHECK(!error.empty());
+    return TestFailures() ? 1 : 0;
+}
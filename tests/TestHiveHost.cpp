@@ -0,0 +1,38 @@
+/*
+ * TestHiveHost - HiveHostName : dossier de l'hôte d'après le chemin d'une ruche collectée (--history)
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../HiveHistory.h"
+
+#include <string>
+
+namespace fs = std::filesystem;
+
+int main() {
+    const fs::path root = fs::path("collecte") / "H1";
+    const fs::path config = root / "Windows" / "System32" / "config";
+
+    // Ruche vivante et copie RegBack : même hôte, donc un seul groupe --history
+    CHECK_EQ(HiveHostName(config / "SYSTEM"), std::string("H1"));
+    CHECK_EQ(HiveHostName(config / "RegBack" / "SYSTEM"), std::string("H1"));
+    CHECK_EQ(HiveHostName(root / "WINDOWS" / "system32" / "CONFIG" / "regback" / "SYSTEM"), std::string("H1"));
+    CHECK_EQ(HiveHostName(root / "Windows" / "repair" / "SYSTEM"), std::string("H1"));
+    CHECK_EQ(HiveHostName(config / "TxR" / "SYSTEM"), std::string("H1"));
+
+    // Cliché VSS extrait sous le dossier de l'hôte
+    CHECK_EQ(HiveHostName(root / "HarddiskVolumeShadowCopy12" / "Windows" / "System32" / "config" / "SYSTEM"),
+             std::string("H1"));
+
+    // Ruche posée directement dans le dossier de l'hôte ; sans dossier, nom du fichier
+    CHECK_EQ(HiveHostName(root / "SYSTEM"), std::string("H1"));
+    CHECK_EQ(HiveHostName(fs::path("SYSTEM")), std::string("SYSTEM"));
+
+    // Dossier d'hôte dont le nom ne fait que commencer comme un dossier ignoré
+    CHECK_EQ(HiveHostName(fs::path("collecte") / "RegBackup-PC" / "SYSTEM"), std::string("RegBackup-PC"));
+    return TestFailures() ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * TestImageDetect - NtfsImage::LooksLikeImage : images MBR / GPT / volume seul reconnues, ruches saines,
+ * tronquées ou corrompues laissées au parsing de ruche
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../NtfsImage.h"
+#include "../bench/HiveGen.h"
+#include "../bench/ImageGen.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> ReadAll(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void WriteAll(const fs::path& path, const uint8_t* data, size_t size) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+}  // namespace
+
+int main() {
+    std::error_code ec;
+    const fs::path directory = fs::temp_directory_path(ec) / "bamdam_test_image_detect";
+    fs::remove_all(directory, ec);
+    fs::create_directories(directory, ec);
+
+    HiveGenOptions hiveOptions;
+    hiveOptions.sidCount = 2;
+    hiveOptions.valuesPerSid = 20;
+    HiveGenStats hiveStats;
+    std::string error;
+    const fs::path hivePath = directory / "SYSTEM";
+    CHECK(GenerateSystemHive(hivePath, hiveOptions, hiveStats, error));
+    const std::vector<uint8_t> hive = ReadAll(hivePath);
+    CHECK(hive.size() > 8192);
+    CHECK(!NtfsImage::LooksLikeImage(hivePath));
+
+    // Ruche tronquée, en-tête effacé ou écrasé : toujours une ruche, l'erreur viendra de RegfHive
+    const fs::path broken = directory / "broken";
+    WriteAll(broken, hive.data(), 3);
+    CHECK(!NtfsImage::LooksLikeImage(broken));
+    WriteAll(broken, hive.data(), 600);
+    CHECK(!NtfsImage::LooksLikeImage(broken));
+    std::vector<uint8_t> damaged = hive;
+    std::fill(damaged.begin(), damaged.begin() + 4096, uint8_t{ 0 });
+    WriteAll(broken, damaged.data(), damaged.size());
+    CHECK(!NtfsImage::LooksLikeImage(broken));
+    for (size_t i = 0; i < 4096; i++) damaged[i] = static_cast<uint8_t>(i * 7 + 1);
+    WriteAll(broken, damaged.data(), damaged.size());
+    CHECK(!NtfsImage::LooksLikeImage(broken));
+    WriteAll(broken, nullptr, 0);
+    CHECK(!NtfsImage::LooksLikeImage(broken));
+    CHECK(!NtfsImage::LooksLikeImage(directory / "absent"));
+
+    // Images MBR et GPT, puis le volume NTFS seul extrait de la première
+    const std::vector<NtfsImageFile> files = { { u"Windows\\System32\\config\\SYSTEM", hive } };
+    NtfsImageOptions imageOptions;
+    imageOptions.fillers = 50;
+    NtfsImageStats imageStats;
+    const fs::path mbr = directory / "mbr.dd";
+    CHECK(WriteNtfsImage(mbr, files, imageOptions, imageStats, error));
+    CHECK(NtfsImage::LooksLikeImage(mbr));
+    const std::vector<uint8_t> image = ReadAll(mbr);
+    CHECK(imageStats.volumeOffset > 0 && imageStats.volumeOffset < image.size());
+    const fs::path volume = directory / "volume.dd";
+    WriteAll(volume, image.data() + imageStats.volumeOffset, image.size() - imageStats.volumeOffset);
+    CHECK(NtfsImage::LooksLikeImage(volume));
+    imageOptions.gpt = true;
+    const fs::path gpt = directory / "gpt.dd";
+    CHECK(WriteNtfsImage(gpt, files, imageOptions, imageStats, error));
+    CHECK(NtfsImage::LooksLikeImage(gpt));
+    // MBR protecteur effacé : l'en-tête GPT suffit
+    std::vector<uint8_t> bare = ReadAll(gpt);
+    std::fill(bare.begin(), bare.begin() + 512, uint8_t{ 0 });
+    WriteAll(gpt, bare.data(), bare.size());
+    CHECK(NtfsImage::LooksLikeImage(gpt));
+
+    fs::remove_all(directory, ec);
+    return TestFailures() ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * TestIngestLedger - IngestLedger : segment perdu puis redémarrage, le contenu abandonné doit être réexporté
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../IngestWatch.h"
+
+#include <string>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+IngestRecord Record(uint64_t hash, uint64_t signature, const fs::path& path) {
+    IngestRecord record;
+    record.hash = hash;
+    record.signature = signature;
+    record.host = "H1";
+    record.path = path;
+    return record;
+}
+
+}  // namespace
+
+int main() {
+    std::error_code ec;
+    const fs::path file = fs::temp_directory_path(ec) / "bamdam_test_ingest.ledger";
+    fs::remove(file, ec);
+
+    const fs::path live = fs::path("H1") / "SYSTEM";
+    const fs::path copy = fs::path("H1") / "RegBack" / "SYSTEM";
+    const fs::path older = fs::path("H2") / "SYSTEM";
+    const fs::path olderCopy = fs::path("H2") / "RegBack" / "SYSTEM";
+    {
+        IngestLedger ledger;
+        CHECK(ledger.Open(file));
+
+        // Signature retenue avant la remise, comme dans la boucle de --watch
+        // Contenu 0x22 exporté dans un segment validé, puis doublon de ce contenu
+        CHECK(ledger.Claim(0x22));
+        ledger.Remember(older, 2);
+        ledger.AddExported(Record(0x22, 2, older));
+        CHECK(ledger.Commit("segment-1"));
+        CHECK(!ledger.Claim(0x22));
+        ledger.Remember(olderCopy, 3);
+        ledger.AddDuplicate(Record(0x22, 3, olderCopy));
+
+        // Contenu 0x11 remis au segment suivant, sa copie RegBack en doublon, puis segment perdu
+        CHECK(ledger.Claim(0x11));
+        ledger.Remember(live, 1);
+        ledger.AddExported(Record(0x11, 1, live));
+        CHECK(!ledger.Claim(0x11));
+        ledger.Remember(copy, 4);
+        ledger.AddDuplicate(Record(0x11, 4, copy));
+        ledger.Abandon();
+
+        CHECK(!ledger.Unchanged(live, 1));
+        CHECK(!ledger.Unchanged(copy, 4));
+        CHECK(ledger.Unchanged(olderCopy, 3));
+        CHECK_EQ(ledger.PendingExported(), size_t(0));
+
+        // Segment suivant : le doublon de 0x22 est écrit, pas celui du contenu perdu
+        CHECK(ledger.Commit("segment-2"));
+        CHECK_EQ(ledger.Count(), size_t(1));
+    }
+    {
+        // Redémarrage : 0x11 n'est connu ni par sa ruche ni par son doublon, 0x22 reste exporté
+        IngestLedger ledger;
+        CHECK(ledger.Open(file));
+        CHECK_EQ(ledger.Count(), size_t(1));
+        CHECK(!ledger.Unchanged(live, 1));
+        CHECK(!ledger.Unchanged(copy, 4));
+        CHECK(ledger.Unchanged(older, 2));
+        CHECK(ledger.Unchanged(olderCopy, 3));
+        CHECK(!ledger.Claim(0x22));
+        CHECK(ledger.Claim(0x11));
+    }
+    fs::remove(file, ec);
+    return TestFailures() ? 1 : 0;
+}
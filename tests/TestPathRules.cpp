@@ -0,0 +1,72 @@
+/*
+ * TestPathRules - PathClassifier : regex filtrées par leur littéral obligatoire, même résultat que std::wregex
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../PathRules.h"
+
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Règle unique compilée seule : Match doit donner le verdict de la regex sur le chemin entier
+bool Fires(std::u16string_view pattern, std::u16string_view path) {
+    PathClassifier rules;
+    if (!rules.AddRule(RuleKind::Regex, "r", pattern, u"") || !rules.Compile()) return false;
+    uint64_t word = 0;
+    return rules.Match(path, &word) && (word & 1);
+}
+
+bool Reference(std::u16string_view pattern, std::u16string_view path) {
+    const std::wregex regex(ToWide(pattern), std::regex::ECMAScript | std::regex::icase);
+    return std::regex_search(ToWide(path), regex);
+}
+
+}  // namespace
+
+int main() {
+    // Échappements numériques : décodés dans le littéral ou hors du littéral, jamais leurs chiffres seuls
+    const std::u16string patterns[] = {
+        u"evil\\x2Eexe",
+        u"\\\\bad\\u0041pp\\.exe$",
+        u"\\\\tmp\\\\\\x65vil",
+        u"\\u00e9t\\u00E9\\.exe$",
+        u"run\\cJ?dll32",
+        u"abc\\0?def\\.exe",
+        u"(to)\\1ol\\.exe$",
+        u"\\\\[a-f0-9]{16,}\\.exe$",
+        u"\\d{3}setup\\.exe",
+    };
+    const std::u16string paths[] = {
+        u"C:\\tmp\\evil.exe",
+        u"C:\\tmp\\EVIL.EXE",
+        u"C:\\tmp\\evil2Eexe",
+        u"C:\\tmp\\badApp.exe",
+        u"C:\\tmp\\bad0041pp.exe",
+        u"C:\\Users\\été.exe",
+        u"C:\\Windows\\rundll32.exe",
+        u"C:\\x\\abcdef.exe",
+        u"C:\\x\\tootool.exe",
+        u"C:\\x\\0123456789abcdef0.exe",
+        u"C:\\x\\123setup.exe",
+        u"C:\\x\\setup.exe",
+    };
+    for (const std::u16string& pattern : patterns) {
+        for (const std::u16string& path : paths) {
+            CHECK_EQ(Fires(pattern, path), Reference(pattern, path));
+        }
+    }
+
+    // Cas du rapport : règles qui ne se déclenchaient jamais
+    CHECK(Fires(u"evil\\x2Eexe", u"C:\\tmp\\evil.exe"));
+    CHECK(Fires(u"\\\\bad\\u0041pp\\.exe$", u"C:\\tmp\\badApp.exe"));
+    CHECK(!Fires(u"\\\\bad\\u0041pp\\.exe$", u"C:\\tmp\\bad0041pp.exe"));
+    return TestFailures() ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/*
+ * TestRoundTrip - Ruche générée (HiveGen, journaux .LOG1/.LOG2) → ParseBamDamHive → CSV / JSONL relus
+ *
+ * - Journaux rejoués : exactement les valeurs rendues plus récentes par HiveGen changent de FILETIME
+ * - Export : chaque champ relu (guillemets CSV doublés, échappements JSON) redonne le texte du store,
+ *   y compris pour des chemins à guillemets, antislashs, contrôles et caractères hors BMP
+ *
+ * Auteur : WinToolsSuite
+ * License : MIT
+ */
+
+#include "TestCheck.h"
+
+#include "../BamDamHive.h"
+#include "../EntryExport.h"
+#include "../RegfHive.h"
+#include "../bench/HiveGen.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string Utf8(std::u16string_view text) {
+    std::string out;
+    AppendUtf8(out, text);
+    return out;
+}
+
+// Champs d'un enregistrement CSV à partir de pos ; false en fin de texte
+bool ReadCsvRecord(const std::string& text, size_t& pos, std::vector<std::string>& fields) {
+    fields.clear();
+    if (pos >= text.size()) return false;
+    std::string field;
+    bool quoted = false;
+    for (; pos < text.size(); pos++) {
+        const char c = text[pos];
+        if (quoted) {
+            if (c == '"' && pos + 1 < text.size() && text[pos + 1] == '"') {
+                field.push_back('"');
+                pos++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field.push_back(c);
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else if (c == '\n') {
+            pos++;
+            break;
+        } else if (c != '\r') {
+            field.push_back(c);
+        }
+    }
+    fields.push_back(std::move(field));
+    return true;
+}
+
+// Chaîne JSON commençant au guillemet text[pos] ; pos placé après le guillemet fermant
+std::string ReadJsonString(const std::string& text, size_t& pos) {
+    std::u16string units;
+    std::string out;
+    auto flush = [&]() {
+        AppendUtf8(out, units);
+        units.clear();
+    };
+    for (pos++; pos < text.size() && text[pos] != '"'; pos++) {
+        if (text[pos] != '\\') {
+            flush();
+            out.push_back(text[pos]);
+            continue;
+        }
+        const char escaped = text[++pos];
+        if (escaped == 'u') {
+            units.push_back(static_cast<char16_t>(std::strtoul(text.substr(pos + 1, 4).c_str(), nullptr, 16)));
+            pos += 4;
+            continue;
+        }
+        flush();
+        switch (escaped) {
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            default: out.push_back(escaped); break;
+        }
+    }
+    flush();
+    pos++;
+    return out;
+}
+
+// Membres chaîne ou nombre d'un objet JSON plat (tableaux et null : texte brut)
+std::map<std::string, std::string> ReadJsonObject(const std::string& line) {
+    std::map<std::string, std::string> members;
+    size_t pos = line.find('{') + 1;
+    while (pos < line.size() && line[pos] == '"') {
+        const std::string key = ReadJsonString(line, pos);
+        pos++;  // ':'
+        if (line[pos] == '"') {
+            members[key] = ReadJsonString(line, pos);
+        } else {
+            const size_t end = line.find_first_of(line[pos] == '[' ? "]" : ",}", pos);
+            members[key] = line.substr(pos, end - pos + (line[pos] == '[' ? 1 : 0));
+            pos = end + (line[pos] == '[' ? 1 : 0);
+        }
+        if (pos < line.size() && line[pos] == ',') pos++;
+    }
+    return members;
+}
+
+std::string Serialize(ExportFormat format, const EntryStore& store, const TimeFormat& timeFormat) {
+    const std::unique_ptr<EntrySerializer> serializer = EntrySerializer::Create(format);
+    ByteBuffer out;
+    serializer->Begin(out);
+    serializer->BeginStore(store);
+    serializer->Append(store, 0, store.size(), timeFormat, out);
+    serializer->End(out);
+    return std::string(out.data(), out.size());
+}
+
+}  // namespace
+
+int main() {
+    std::error_code ec;
+    const fs::path directory = fs::temp_directory_path(ec) / "bamdam_test_roundtrip";
+    fs::remove_all(directory, ec);
+    fs::create_directories(directory, ec);
+    const fs::path hivePath = directory / "SYSTEM";
+
+    HiveGenOptions options;
+    options.sidCount = 4;
+    options.valuesPerSid = 60;
+    options.nonLatinRatio = 0.1;
+    options.dirtyRatio = 0.25;
+    options.seed = 7;
+    HiveGenStats stats;
+    std::string error;
+    CHECK(GenerateSystemHive(hivePath, options, stats, error));
+    CHECK(stats.dirtyRows > 0);
+
+    // Même ruche lue avec et sans ses journaux
+    EntryStore replayed;
+    EntryStore primary;
+    {
+        RegfHive hive;
+        CHECK(hive.Open(hivePath));
+        CHECK(hive.LogEntriesApplied() > 0);
+        ParseBamDamHive(hive, replayed, replayed.hosts.Intern(u"BENCH-HOST"));
+        RegfHive stale;
+        CHECK(stale.Open(hivePath, false));
+        ParseBamDamHive(stale, primary, primary.hosts.Intern(u"BENCH-HOST"));
+    }
+    CHECK_EQ(replayed.size(), primary.size());
+    size_t valid = 0;
+    std::map<std::pair<std::u16string, std::u16string>, uint64_t> before;
+    for (size_t row = 0; row < primary.size(); row++) {
+        before[{ std::u16string(primary.Sid(row)), std::u16string(primary.Path(row)) }] = primary.FileTime(row);
+    }
+    size_t changed = 0;
+    for (size_t row = 0; row < replayed.size(); row++) {
+        if (replayed.Flags(row) & ENTRY_FLAG_INVALID_DATA) continue;
+        valid++;
+        const auto it = before.find({ std::u16string(replayed.Sid(row)), std::u16string(replayed.Path(row)) });
+        CHECK(it != before.end());
+        if (it == before.end()) continue;
+        if (it->second != replayed.FileTime(row)) {
+            CHECK(it->second < replayed.FileTime(row));
+            changed++;
+        }
+    }
+    CHECK_EQ(valid, stats.rows);
+    CHECK_EQ(changed, stats.dirtyRows);
+
+    // Chemins à échapper ajoutés au store rejoué
+    const uint32_t host = replayed.hosts.Intern(u"H\"1");
+    const uint32_t sid = replayed.sids.Intern(u"S-1-5-21-1-2-3-1001");
+    const uint32_t user = replayed.users.Intern(u"o'\"brien\\");
+    const std::u16string tricky[] = {
+        u"C:\\tmp\\\"quoted\".exe", u"C:\\tmp\\a,b.exe", u"C:\\tmp\\tab\there.exe", u"C:\\tmp\\line\nbreak.exe",
+        u"C:\\tmp\\ctl\x01.exe", u"C:\\tmp\\emoji\xD83D\xDE00.exe", u"C:\\tmp\\\\\\double.exe",
+    };
+    for (size_t i = 0; i < std::size(tricky); i++) {
+        replayed.Add(host, sid, user, replayed.paths.Intern(tricky[i]), 133000000000000000ULL + i, EntrySource::Dam);
+    }
+
+    const TimeFormat timeFormat;
+    const std::string csv = Serialize(ExportFormat::Csv, replayed, timeFormat);
+    size_t pos = csv.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+    std::vector<std::string> fields;
+    CHECK(ReadCsvRecord(csv, pos, fields));  // En-tête
+    size_t row = 0;
+    for (; ReadCsvRecord(csv, pos, fields) && row < replayed.size(); row++) {
+        CHECK_EQ(fields.size(), size_t(8));
+        if (fields.size() != 8) break;
+        CHECK_EQ(fields[0], Utf8(replayed.Host(row)));
+        if (!(replayed.Flags(row) & ENTRY_FLAG_INVALID_DATA)) {
+            char text[FILETIME_TEXT_MAX];
+            FormatFileTime(replayed.FileTime(row), timeFormat, text);
+            CHECK_EQ(fields[1], std::string(text));
+        }
+        CHECK_EQ(fields[2], Utf8(replayed.Sid(row)));
+        CHECK_EQ(fields[3], Utf8(replayed.User(row)));
+        CHECK_EQ(fields[4], Utf8(replayed.Path(row)));
+        CHECK_EQ(fields[5], Utf8(replayed.NormalizedPath(row)));
+        CHECK_EQ(fields[6], Utf8(SourceName(replayed.Source(row))));
+    }
+    CHECK_EQ(row, replayed.size());
+    CHECK_EQ(pos, csv.size());
+
+    const std::string jsonl = Serialize(ExportFormat::JsonLines, replayed, timeFormat);
+    row = 0;
+    for (size_t start = 0; start < jsonl.size() && row < replayed.size(); row++) {
+        const size_t end = jsonl.find('\n', start);
+        const std::map<std::string, std::string> members = ReadJsonObject(jsonl.substr(start, end - start));
+        start = end == std::string::npos ? jsonl.size() : end + 1;
+        CHECK_EQ(members.at("host"), Utf8(replayed.Host(row)));
+        CHECK_EQ(members.at("sid"), Utf8(replayed.Sid(row)));
+        CHECK_EQ(members.at("user"), Utf8(replayed.User(row)));
+        CHECK_EQ(members.at("path"), Utf8(replayed.Path(row)));
+        CHECK_EQ(members.at("normalized_path"), Utf8(replayed.NormalizedPath(row)));
+        if (!(replayed.Flags(row) & ENTRY_FLAG_INVALID_DATA)) {
+            CHECK_EQ(std::strtoull(members.at("filetime").c_str(), nullptr, 10), replayed.FileTime(row));
+        }
+    }
+    CHECK_EQ(row, replayed.size());
+
+    fs::remove_all(directory, ec);
+    return TestFailures() ? 1 : 0;
+}